@@ -0,0 +1,1904 @@
+// ===== HOST BENCHMARK SUITE =====
+// Runs the firmware's decode, parse, UI and output code natively against
+// the stand-ins in host/ and prints numbers worth tracking over time:
+//
+//   1. Decode throughput per WAV format found on the "card", and the
+//      header parser against chunk sizes that run past the end of the file
+//   2. IMA ADPCM: each card WAV encoded in memory, then size, decode rate
+//      against the PCM original, and SNR of the decoded sound against it
+//   3. Sound catalog: index build, open, random access by index, and title
+//      prefix search, for the card's index.csv and a generated
+//      BENCH_LARGE_CATALOG-row one
+//   4. Redraw cost of the main UI changes (CPU, bytes on the bus, SPI time),
+//      including a level meter update against repainting the whole bars,
+//      and drag scrolling against page steps: frame rate and bus bytes per
+//      scrolled pixel, and the bus share of a paced scroll
+//   5. Output-path CPU per mixer block for 1..MIXER_VOICES file voices, and
+//      the PCM conversion kernels against the layout-generic loop; the
+//      level meter's publish cost per block, and mixing with a reader
+//      taking its snapshots flat out on another thread
+//   6. Play path heap: allocations per tap once every sound has played,
+//      with the firmware's voice sources and against reopening each file
+//   7. Sequenced playback: the gap at every transition of a queued
+//      sequence, found in the captured output, against restarting the
+//      next sound when the previous one ends
+//   8. Boot: setup() and loop() up to the first interactive frame, with
+//      the per-phase timeline (it leaves the firmware's tasks up); then a
+//      sound retriggered over and over must still read as stopped once
+//      it ends, and a held tap on a list button: touch-down to playSound()
+//   9. Remote control over a pseudo-terminal, against the booted
+//      firmware: command-to-ACK and command-to-voice-start latency,
+//      sustained commands per second in batched frames, and recovery of
+//      the frame after one with a corrupted length
+//  10. Power governor over a scripted day against a simulated clock: time
+//      in each power state, light sleeps and wakes, whether every tap is
+//      handled at full clock, wake-to-sound per state, and the governor's
+//      own CPU cost per loop() pass and per wake
+//  11. Built-in synth presets rendered to a buffer: length and pitch,
+//      period by period, against the stepped tone sequences of the
+//      original busy-loop player, and render CPU per block
+//  12. Touch task with the resistive interrupt line held low but no touch
+//      read (a press below the controller's pressure threshold): it must
+//      sample every TOUCH_ACTIVE_MS, not spin, and still report the press
+//      once it is read
+//
+// Usage: program [card-dir]   (default "wavs", the sample card)
+//
+// Host times are host times: compare them run to run on one machine, not
+// against the ESP32. Bus bytes and SPI times are exact for the panel
+// traffic the firmware generates. Every result is also printed as a
+// "BENCH,<metric>,<value>,<unit>" line for collecting in a spreadsheet.
+// The exit status is 1 if any section's checks failed.
+
+#include <Arduino.h>
+#include <SD.h>
+#include <TFT_eSPI.h>
+#include <chrono>
+#include <climits>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AudioFileSourcePROGMEM.h"
+#include "AudioFileSourceSD.h"
+#include "AudioOutputI2S.h"
+#include "AudioMixer.h"
+#include "AudioEngine.h"
+#include "AudioGeneratorSynth.h"
+#include "AudioOutputRing.h"
+#include "AudioFileSourceReadAhead.h"
+#include "BootProfile.h"
+#include "HeapStats.h"
+#include "ImaAdpcm.h"
+#include "PcmCache.h"
+#include "PcmKernels.h"
+#include "PcmStream.h"
+#include "PowerGovernor.h"
+#include "RemoteLink.h"
+#include "SoundCatalog.h"
+#include "TouchInput.h"
+#include "UiRenderer.h"
+#include "WavParser.h"
+
+#define BENCH_DECODE_REPEATS  3      // Best of, per file
+#define BENCH_CSV_REPEATS     200
+#define BENCH_LOOKUPS         20000  // Random catalog lookups
+#define BENCH_LARGE_CATALOG   5000   // Rows in the generated index.csv
+#define BENCH_SEARCHES        200    // Titles typed, one to three letters each
+#define BENCH_REDRAW_REPEATS  50
+#define BENCH_OUTPUT_BLOCKS   2000   // Mixer blocks per voice count
+#define BENCH_DRAG_STEP       4      // Pixels the finger moves per drag frame
+#define BENCH_DRAG_MS         16     // Touch sample spacing of the synthetic drag
+#define BENCH_ADPCM_BLOCK     249    // Frames per ADPCM block, as tools/encode_adpcm.py
+#define BENCH_KERNEL_BYTES    49152  // Random PCM per kernel run (divides by every frame size)
+#define BENCH_HEAP_SOUNDS     4      // Sounds tapped in rotation
+#define BENCH_HEAP_WARMUP     4      // Rotations before counting (cache heads filled)
+#define BENCH_HEAP_ROUNDS     10     // Counted rotations
+#define BENCH_HEAP_PASSES     4      // Mixer passes (ring fills) between taps
+#define BENCH_REMOTE_PLAYS    200    // Timed single PLAY frames
+#define BENCH_REMOTE_GAP_MS   5      // Pause between them
+#define BENCH_REMOTE_FRAMES   500    // Batched frames for the throughput run
+#define BENCH_REMOTE_BATCH    12     // PLAY commands per batched frame (a full payload)
+#define BENCH_REMOTE_WINDOW   2      // Batched frames in flight before waiting for an ACK
+#define BENCH_SERIAL_BAUD     115200
+#define BENCH_SEQ_ITEMS       6      // Sounds per sequence (fits the PCM cache)
+#define BENCH_SEQ_GAP         441    // Requested gap of the spaced run (20 ms)
+#define BENCH_SEQ_SEARCH      8192   // Longest gap looked for in the capture
+#define BENCH_METER_PUBLISHES 100000 // Timed publishes of one block
+#define BENCH_POWER_HOURS     24     // Length of the simulated day
+#define BENCH_POWER_PASS_US   1000   // Simulated loop() pass (its delay(1))
+#define BENCH_POWER_SOUND_MS  1500   // Each tap plays this long
+#define BENCH_SYNTH_REPEATS   50     // Timed renders of each preset
+#define BENCH_TAP_HOLD_MS     100    // A quick tap's press
+#define BENCH_TAP_GAP_MS      300    // Past the firmware's tap debounce
+#define BENCH_TOUCH_PIN       50     // Spare host pin for the test touch line
+#define BENCH_TOUCH_HOLD_MS   300    // Line held low without a touch
+
+// Firmware state and UI code from main.cpp
+extern TFT_eSPI tft;
+extern UiRenderer ui;
+extern SoundCatalog catalog;
+extern int scrollOffset;
+extern bool soundListReady;
+extern std::atomic<bool> bootLoaded;
+extern bool showThumbnails;
+extern int trimNext;
+extern int analysisIndex;
+void setup();
+void loop();
+bool initSDCard();
+bool parseIndexCSV();
+void addBeepSound();
+void drawUI();
+void handleTouch(int touchX, int touchY);
+bool listTouch(const TouchEvent &event);
+void stepListScroll();
+void analyzeNextSound();
+void drawMeters(const MixerMeter &m, uint32_t now);
+void playSound(int index);
+extern AudioEngine audio;
+
+// Touch points on the controls the redraw benchmark presses (main.cpp layout)
+#define TAP_VOL_PLUS     255, 18
+#define TAP_VOL_MINUS    205, 18
+#define TAP_SCROLL_DOWN  200, 224
+#define TAP_SCROLL_UP    140, 224
+#define TAP_SOUND_LIST   160, 60
+#define PAGE_BUTTONS     3         // VISIBLE_BUTTONS
+#define PAGE_STEP_PX     (PAGE_BUTTONS * 44)  // Rows of BUTTON_HEIGHT + BUTTON_MARGIN
+#define METER_RECT       10, 28, 175, 6       // Level and playhead bars
+
+static uint64_t nowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// CPU time of the calling thread, which a thread switched out does not add to
+static uint64_t threadNanos() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void result(const char *metric, double value, const char *unit) {
+  printf("BENCH,%s,%.3f,%s\n", metric, value, unit);
+}
+
+// Checks that failed, across all sections: main() exits non-zero if any did
+static int failedChecks = 0;
+
+static bool check(bool ok) {
+  if (!ok) failedChecks++;
+  return ok;
+}
+
+// ===== 1. DECODE THROUGHPUT =====
+struct DecodeTotals {
+  int files = 0;
+  uint64_t bytes = 0;
+  uint64_t frames = 0;       // Source frames
+  uint64_t outSamples = 0;
+  double seconds = 0;        // Best-of decode time, summed over files
+  double audioSeconds = 0;   // Playing time of the decoded material
+};
+
+static std::string formatName(const WavInfo &info) {
+  char name[64];
+  const char *channels = info.channels == 1 ? "mono" : "stereo";
+  if (info.formatTag == WAV_FORMAT_IMA_ADPCM) {
+    snprintf(name, sizeof(name), "IMA ADPCM %s %u Hz", channels, info.sampleRate);
+  } else {
+    snprintf(name, sizeof(name), "%u-bit %s %u Hz", info.bitsPerSample, channels, info.sampleRate);
+  }
+  return name;
+}
+
+static std::vector<std::string> listWavs(const char *dir) {
+  std::vector<std::string> names;
+  DIR *d = opendir(dir);
+  if (d == nullptr) return names;
+  while (struct dirent *e = readdir(d)) {
+    std::string n = e->d_name;
+    if (n.size() > 4 && strcasecmp(n.c_str() + n.size() - 4, ".wav") == 0) names.push_back(n);
+  }
+  closedir(d);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+// Decode one file to the end at outRate (0 = the file's own rate, so only
+// the PCM conversion and downmix run). Returns seconds, or a negative value
+// if the file is not playable.
+static double decodeFile(const std::string &path, uint32_t outRate, WavInfo &info,
+                         uint64_t &outSamples) {
+  static int16_t in[PCM_STREAM_IN_FRAMES];
+  static int32_t acc[MIXER_BLOCK_SAMPLES];
+
+  AudioFileSourceSD src(path.c_str());
+  if (!src.isOpen() || !parseWavHeader(&src, info)) return -1;
+  PcmStream stream;
+  uint64_t t0 = nowNanos();
+  if (!stream.begin(&src, info, outRate ? outRate : info.sampleRate)) return -1;
+  outSamples = 0;
+  int n;
+  do {
+    memset(acc, 0, sizeof(acc));
+    n = stream.render(in, acc, MIXER_BLOCK_SAMPLES, MIXER_UNITY_GAIN);
+    outSamples += n;
+  } while (n == MIXER_BLOCK_SAMPLES);
+  return (nowNanos() - t0) / 1e9;
+}
+
+static void benchDecode(uint32_t outRate, const char *label) {
+  std::vector<std::string> files = listWavs(SD.rootDir());
+  std::map<std::string, DecodeTotals> byFormat;
+
+  for (const std::string &name : files) {
+    std::string path = "/" + name;
+    WavInfo info;
+    uint64_t outSamples = 0;
+    double best = -1;
+    for (int r = 0; r < BENCH_DECODE_REPEATS; r++) {
+      double s = decodeFile(path, outRate, info, outSamples);
+      if (s < 0) break;
+      if (best < 0 || s < best) best = s;
+    }
+    if (best < 0) {
+      printf("  %s: not playable, skipped\n", name.c_str());
+      continue;
+    }
+    DecodeTotals &t = byFormat[formatName(info)];
+    t.files++;
+    t.bytes += info.dataSize;
+    t.frames += info.frameCount;
+    t.outSamples += outSamples;
+    t.seconds += best;
+    t.audioSeconds += (double)info.frameCount / info.sampleRate;
+  }
+
+  printf("\nDecode throughput, %s (best of %d):\n", label, BENCH_DECODE_REPEATS);
+  printf("  %-26s %5s %9s %9s %10s %10s\n", "format", "files", "MB", "MB/s", "Mframes/s", "x realtime");
+  for (auto &kv : byFormat) {
+    const DecodeTotals &t = kv.second;
+    double mbps = t.bytes / 1e6 / t.seconds;
+    double fps = t.frames / 1e6 / t.seconds;
+    double rt = t.audioSeconds / t.seconds;
+    printf("  %-26s %5d %9.2f %9.1f %10.2f %10.0f\n", kv.first.c_str(), t.files,
+           t.bytes / 1e6, mbps, fps, rt);
+
+    char metric[96];
+    snprintf(metric, sizeof(metric), "decode_%s_%s_MBps", outRate ? "resample" : "native", kv.first.c_str());
+    for (char *p = metric; *p; p++) if (*p == ' ') *p = '_';
+    result(metric, mbps, "MB/s");
+  }
+}
+
+// A 16-bit mono header with one chunk of the given id and size after fmt,
+// then `tail` bytes of data
+static std::vector<uint8_t> corruptWav(const char *id, uint32_t size, int tail) {
+  std::vector<uint8_t> f;
+  auto put32 = [&](uint32_t v) { for (int i = 0; i < 4; i++) f.push_back(v >> (8 * i)); };
+  auto tag = [&](const char *t) { f.insert(f.end(), t, t + 4); };
+  tag("RIFF");
+  put32(0);
+  tag("WAVE");
+  tag("fmt ");
+  put32(16);
+  const uint8_t fmt[16] = {1, 0, 1, 0, 0x22, 0x56, 0, 0, 0x44, 0xAC, 0, 0, 2, 0, 16, 0};
+  f.insert(f.end(), fmt, fmt + 16);
+  tag(id);
+  put32(size);
+  f.resize(f.size() + tail, 0);
+  return f;
+}
+
+// Parse in a thread so a walk that never ends is reported, not waited on
+static bool parseReturns(std::vector<uint8_t> &file, WavInfo &info, bool &parsed) {
+  auto state = std::make_shared<std::atomic<int>>(0);  // 1: false, 2: true
+  std::thread([&file, &info, state] {
+    AudioFileSourcePROGMEM mem(file.data(), file.size());
+    WavInfo local;
+    bool ok = parseWavHeader(&mem, local);
+    info = local;
+    *state = ok ? 2 : 1;
+  }).detach();
+  for (int ms = 0; ms < 1000 && *state == 0; ms++) delay(1);
+  parsed = *state == 2;
+  return *state != 0;
+}
+
+static void benchWavCorrupt() {
+  // Kept alive: a parse that hangs still holds them
+  static std::vector<uint8_t> list = corruptWav("LIST", 0xFFFFFFF8, 16);
+  static std::vector<uint8_t> data = corruptWav("data", 0xFFFFFFF0, 100);
+  static WavInfo listInfo, dataInfo;
+  bool listParsed, dataParsed;
+  bool listDone = parseReturns(list, listInfo, listParsed);
+  bool dataDone = parseReturns(data, dataInfo, dataParsed);
+  bool dataClamped = dataDone && dataParsed && dataInfo.dataSize == 100;
+  check(listDone);
+  check(dataClamped);
+  printf("  Corrupt chunk sizes: LIST of 0xFFFFFFF8 %s; data of 0xFFFFFFF0 %s\n",
+         !listDone ? "FAILED (parser hung)" : listParsed ? "parsed" : "rejected",
+         dataClamped ? "cut to the 100 bytes present" : "FAILED (size not cut to the file)");
+  result("wav_corrupt_failed", (listDone ? 0 : 1) + (dataClamped ? 0 : 1), "errors");
+}
+
+// ===== 2. IMA ADPCM =====
+// A WAV file in memory as interleaved 16-bit frames (top bits, like the
+// decoder)
+static bool loadFrames(const std::string &path, WavInfo &info, std::vector<uint8_t> &file,
+                       std::vector<int16_t> &frames) {
+  AudioFileSourceSD src(path.c_str());
+  if (!src.isOpen()) return false;
+  file.resize(src.getSize());
+  if (src.read(file.data(), file.size()) != file.size()) return false;
+  AudioFileSourcePROGMEM mem(file.data(), file.size());
+  if (!parseWavHeader(&mem, info) || info.formatTag != WAV_FORMAT_PCM) return false;
+
+  int bytes = info.bitsPerSample / 8;
+  frames.resize(info.frameCount * info.channels);
+  const uint8_t *p = file.data() + info.dataOffset;
+  for (size_t i = 0; i < frames.size(); i++, p += bytes) {
+    frames[i] = bytes == 1 ? (int16_t)((p[0] - 128) << 8) : (int16_t)(p[bytes - 2] | (p[bytes - 1] << 8));
+  }
+  return true;
+}
+
+// Encode frames as an IMA ADPCM WAV file, laid out as tools/encode_adpcm.py writes it
+static std::vector<uint8_t> encodeAdpcm(const WavInfo &info, const std::vector<int16_t> &frames) {
+  int channels = info.channels;
+  uint32_t count = frames.size() / channels;
+  uint16_t blockAlign = imaBlockAlign(BENCH_ADPCM_BLOCK, channels);
+  std::vector<uint8_t> data;
+  ImaEncoder enc = {};
+  uint8_t block[2 * (IMA_HEADER_BYTES + BENCH_ADPCM_BLOCK / 2)];
+  for (uint32_t f = 0; f < count; f += BENCH_ADPCM_BLOCK) {
+    int n = count - f < BENCH_ADPCM_BLOCK ? count - f : BENCH_ADPCM_BLOCK;
+    int len = imaEncodeBlock(enc, frames.data() + f * channels, n, channels, block);
+    data.insert(data.end(), block, block + len);
+  }
+
+  std::vector<uint8_t> wav;
+  auto put = [&](const void *p, size_t n) {
+    wav.insert(wav.end(), (const uint8_t *)p, (const uint8_t *)p + n);
+  };
+  auto put16 = [&](uint16_t v) { put(&v, 2); };
+  auto put32 = [&](uint32_t v) { put(&v, 4); };
+  put("RIFF", 4);
+  put32(4 + 28 + 12 + 8 + data.size());
+  put("WAVEfmt ", 8);
+  put32(20);
+  put16(WAV_FORMAT_IMA_ADPCM);
+  put16(channels);
+  put32(info.sampleRate);
+  put32((uint64_t)info.sampleRate * blockAlign / BENCH_ADPCM_BLOCK);
+  put16(blockAlign);
+  put16(4);
+  put16(2);
+  put16(BENCH_ADPCM_BLOCK);
+  put("fact", 4);
+  put32(4);
+  put32(count);
+  put("data", 4);
+  put32(data.size());
+  put(data.data(), data.size());
+  return wav;
+}
+
+// Decode a WAV image at its own rate; returns the best-of time in seconds
+// and the mono output
+static double decodeImage(const std::vector<uint8_t> &wav, std::vector<int16_t> &out) {
+  static int16_t in[PCM_STREAM_IN_FRAMES];
+  int32_t acc[MIXER_BLOCK_SAMPLES];
+  double best = -1;
+  for (int r = 0; r <= BENCH_DECODE_REPEATS; r++) {
+    AudioFileSourcePROGMEM src(wav.data(), wav.size());
+    WavInfo info;
+    PcmStream stream;
+    if (!parseWavHeader(&src, info) || !stream.begin(&src, info, info.sampleRate)) return -1;
+    bool keep = r == BENCH_DECODE_REPEATS;  // Untimed pass that collects the output
+    out.clear();
+    uint64_t t0 = nowNanos();
+    int n;
+    do {
+      memset(acc, 0, sizeof(acc));
+      n = stream.render(in, acc, MIXER_BLOCK_SAMPLES, MIXER_UNITY_GAIN);
+      if (keep) out.insert(out.end(), acc, acc + n);
+    } while (n == MIXER_BLOCK_SAMPLES);
+    double s = (nowNanos() - t0) / 1e9;
+    if (!keep && (best < 0 || s < best)) best = s;
+  }
+  return best;
+}
+
+static void benchAdpcm() {
+  std::vector<std::string> files = listWavs(SD.rootDir());
+  printf("\nIMA ADPCM, card WAVs encoded in %d-frame blocks, decoded at their own rate (best of %d):\n",
+         BENCH_ADPCM_BLOCK, BENCH_DECODE_REPEATS);
+  printf("  %-10s %-26s %9s %9s %6s %10s %10s %7s\n", "file", "source", "PCM KB", "ADPCM KB",
+         "ratio", "PCM Mf/s", "ADPCM Mf/s", "SNR dB");
+
+  uint64_t pcmBytes = 0, adpcmBytes = 0, frameTotal = 0;
+  double pcmSeconds = 0, adpcmSeconds = 0, snrMin = 1e9, snrSum = 0;
+  int count = 0;
+  for (const std::string &name : files) {
+    WavInfo info;
+    std::vector<uint8_t> pcmWav;
+    std::vector<int16_t> frames, ref, dec;
+    if (!loadFrames("/" + name, info, pcmWav, frames)) continue;
+    std::vector<uint8_t> adpcmWav = encodeAdpcm(info, frames);
+    double pcmS = decodeImage(pcmWav, ref);
+    double adpcmS = decodeImage(adpcmWav, dec);
+    if (!check(pcmS > 0 && adpcmS > 0 && ref.size() == dec.size())) {
+      printf("  %-10s decode FAILED\n", name.c_str());
+      continue;
+    }
+
+    double signal = 0, noise = 0;
+    for (size_t i = 0; i < ref.size(); i++) {
+      double e = (double)ref[i] - dec[i];
+      signal += (double)ref[i] * ref[i];
+      noise += e * e;
+    }
+    double snr = 10 * log10(signal / (noise > 0 ? noise : 1));
+    double ratio = (double)info.dataSize / (adpcmWav.size() - 60);
+    double frameCount = info.frameCount;
+    printf("  %-10s %-26s %9.1f %9.1f %5.2fx %10.2f %10.2f %7.1f\n", name.c_str(),
+           formatName(info).c_str(), info.dataSize / 1024.0, (adpcmWav.size() - 60) / 1024.0, ratio,
+           frameCount / 1e6 / pcmS, frameCount / 1e6 / adpcmS, snr);
+
+    pcmBytes += info.dataSize;
+    adpcmBytes += adpcmWav.size() - 60;
+    frameTotal += info.frameCount;
+    pcmSeconds += pcmS;
+    adpcmSeconds += adpcmS;
+    snrMin = snr < snrMin ? snr : snrMin;
+    snrSum += snr;
+    count++;
+  }
+  if (count == 0) return;
+
+  printf("  %d files: %.2fx smaller, decode %.2f vs %.2f Mframes/s, SNR %.1f dB min, %.1f dB mean\n",
+         count, (double)pcmBytes / adpcmBytes, frameTotal / 1e6 / adpcmSeconds,
+         frameTotal / 1e6 / pcmSeconds, snrMin, snrSum / count);
+  result("adpcm_size_ratio", (double)pcmBytes / adpcmBytes, "x");
+  result("adpcm_decode_Mframes_per_s", frameTotal / 1e6 / adpcmSeconds, "Mframes/s");
+  result("adpcm_pcm_decode_Mframes_per_s", frameTotal / 1e6 / pcmSeconds, "Mframes/s");
+  result("adpcm_snr_min_db", snrMin, "dB");
+  result("adpcm_snr_mean_db", snrSum / count, "dB");
+}
+
+// ===== 3. SOUND CATALOG =====
+// Average us per call of `op` over `runs` calls
+template <typename F>
+static double timeRuns(int runs, F op) {
+  uint64_t t0 = nowNanos();
+  for (int r = 0; r < runs; r++) op(r);
+  return (nowNanos() - t0) / 1e3 / runs;
+}
+
+// Random get() over the whole list (nearly every one a window load), then
+// get() within one page, the UI's steady state
+static void benchLookups(SoundCatalog &c, const char *label, const char *metric) {
+  uint32_t seed = 1;
+  int bad = 0;
+  double randomUs = timeRuns(BENCH_LOOKUPS, [&](int) {
+    seed = seed * 1103515245 + 12345;
+    if (c.get((seed >> 8) % c.count()) == nullptr) bad++;
+  });
+  int page = c.count() / 2;
+  c.prefetch(page, 3);
+  double pageUs = timeRuns(BENCH_LOOKUPS, [&](int r) {
+    if (c.get(page + r % 3) == nullptr) bad++;
+  });
+  check(bad == 0);
+
+  printf("  %-10s %6d sounds, %5u RAM bytes, random get %.2f us, page get %.3f us%s\n", label,
+         c.count(), (unsigned)sizeof(c), randomUs, pageUs, bad ? " (FAILED lookups)" : "");
+  char m[64];
+  snprintf(m, sizeof(m), "catalog_%s_random_get_us", metric);
+  result(m, randomUs, "us");
+  snprintf(m, sizeof(m), "catalog_%s_page_get_us", metric);
+  result(m, pageUs, "us");
+}
+
+// Searches as the keypad issues them: the first one to three letters of a
+// random title, each narrowed from the previous letter's range. Every
+// result is checked against a scan of the whole title table, whose cost
+// is reported alongside.
+static void benchSearch(SoundCatalog &c, const char *label, const char *metric) {
+  int titles = c.count() - c.builtins();
+  std::vector<CatalogTitle> all(titles);
+  int got = 0;
+  uint64_t t0 = nowNanos();
+  while (got < titles) {
+    int n = c.readTitles(got, 64, &all[got]);
+    if (n == 0) break;
+    got += n;
+  }
+  double readAllUs = (nowNanos() - t0) / 1e3;
+  bool ok = got == titles;
+  for (int i = 1; ok && i < titles; i++) ok = strcasecmp(all[i - 1].title, all[i].title) <= 0;
+  if (!check(ok) || titles == 0) {
+    printf("  %-10s title table %s\n", label, ok ? "empty" : "FAILED");
+    return;
+  }
+
+  uint32_t seed = 7;
+  int searches = 0, bad = 0;
+  uint64_t nanos = 0;
+  for (int q = 0; q < BENCH_SEARCHES; q++) {
+    seed = seed * 1103515245 + 12345;
+    const char *title = all[(seed >> 8) % titles].title;
+    char query[4] = "";
+    int first = 0, end = titles;
+    for (int len = 1; len <= 3 && title[len - 1]; len++) {
+      query[len - 1] = title[len - 1];
+      query[len] = '\0';
+      t0 = nowNanos();
+      c.findPrefix(query, first, end, first, end);
+      nanos += nowNanos() - t0;
+      searches++;
+
+      int expect = 0;
+      for (const CatalogTitle &t : all) expect += strncasecmp(t.title, query, len) == 0;
+      if (end - first != expect || strncasecmp(all[first].title, query, len) != 0) bad++;
+    }
+  }
+  double searchUs = nanos / 1e3 / searches;
+  check(bad == 0);
+  printf("  %-10s %6d titles, prefix search %.2f us (scan of the table %.0f us)%s\n", label,
+         titles, searchUs, readAllUs, bad ? " (FAILED searches)" : "");
+  char m[64];
+  snprintf(m, sizeof(m), "catalog_%s_search_us", metric);
+  result(m, searchUs, "us");
+}
+
+// Write a BENCH_LARGE_CATALOG-row index.csv into a fresh card directory
+static std::string makeLargeCard() {
+  char dir[] = "/tmp/bench_card_XXXXXX";
+  if (mkdtemp(dir) == nullptr) return "";
+  FILE *f = fopen((std::string(dir) + "/index.csv").c_str(), "w");
+  if (f == nullptr) return "";
+  // Titles spread over the alphabet, like a real library
+  static const char *const words[] = {
+    "Airhorn", "Bell", "Chime", "Drum", "Echo", "Fanfare", "Gong", "Horn", "Impact",
+    "Jingle", "Knock", "Laser", "Marimba", "Noise", "Organ", "Pop", "Quack", "Rain",
+    "Siren", "Thunder", "Uplifter", "Vinyl", "Whoosh", "Xylophone", "Yell", "Zap",
+  };
+  fprintf(f, "filename,title\n");
+  uint32_t seed = 3;
+  for (int i = 0; i < BENCH_LARGE_CATALOG; i++) {
+    seed = seed * 1103515245 + 12345;
+    fprintf(f, "%04d.wav,%s %s %d\n", i, words[(seed >> 8) % 26], words[(seed >> 16) % 26], i);
+  }
+  fclose(f);
+  return dir;
+}
+
+static void benchCatalog() {
+  std::string card = SD.rootDir();
+  std::string index = card + "/catalog.idx";
+  bool ok = true;
+
+  Serial.setQuiet(true);
+  addBeepSound();
+  double buildUs = timeRuns(BENCH_CSV_REPEATS / 10, [&](int) {
+    remove(index.c_str());
+    ok &= parseIndexCSV();
+  });
+  double openUs = timeRuns(BENCH_CSV_REPEATS, [&](int) { ok &= parseIndexCSV(); });
+  soundListReady = ok;  // What loop() does once the boot task has loaded it
+  Serial.setQuiet(false);
+  check(ok);
+
+  int entries = catalog.count() - catalog.builtins();
+  printf("\nSound catalog, index.csv with %d entries: %s\n", entries, ok ? "ok" : "FAILED");
+  printf("  %.1f us per index build, %.1f us per open of a current index\n", buildUs, openUs);
+  result("catalog_build_us", buildUs, "us");
+  result("catalog_open_us", openUs, "us");
+  benchLookups(catalog, "card", "card");
+  benchSearch(catalog, "card", "card");
+
+  // Same code over a library far larger than the card's
+  std::string large = makeLargeCard();
+  if (large.empty()) return;
+  static SoundCatalog big;
+  SD.setRoot(large.c_str());
+  CatalogCsvSource source(SD, "/index.csv");
+  Serial.setQuiet(true);
+  uint64_t t0 = nowNanos();
+  ok = big.open(SD, "/catalog.idx", source);
+  double bigBuildMs = (nowNanos() - t0) / 1e6;
+  Serial.setQuiet(false);
+  SD.setRoot(card.c_str());
+  if (!check(ok)) {
+    printf("  Generated catalog FAILED\n");
+    return;
+  }
+  printf("  %d-row index.csv: index built in %.1f ms\n", BENCH_LARGE_CATALOG, bigBuildMs);
+  result("catalog_large_build_ms", bigBuildMs, "ms");
+  benchLookups(big, "generated", "large");
+  benchSearch(big, "generated", "large");
+  remove((large + "/index.csv").c_str());
+  remove((large + "/catalog.idx").c_str());
+  rmdir(large.c_str());
+}
+
+// ===== 4. REDRAW COST =====
+struct RedrawCost {
+  double cpuMicros = 0;      // Host time: widget updates plus rendering
+  double renderMicros = 0;   // Of which spent in UiRenderer::render()
+  double busBytes = 0;       // Panel traffic including address windows
+  double strips = 0;
+};
+
+// Run a UI change and render it to the panel, averaged over repeats.
+// `change` is called with the repeat number so it can alternate states,
+// gapMs after the previous one (untimed).
+template <typename F>
+static RedrawCost measureRedraw(F change, uint32_t gapMs = 0) {
+  RedrawCost c;
+  ui.flush();
+  Serial.setQuiet(true);
+  for (int r = 0; r < BENCH_REDRAW_REPEATS; r++) {
+    if (gapMs > 0) delay(gapMs);
+    uint64_t bytes0 = tft.busBytes();
+    uint64_t t0 = nowNanos();
+    change(r);
+    ui.flush();
+    c.cpuMicros += (nowNanos() - t0) / 1e3;
+    c.renderMicros += ui.lastFrame().renderMicros;
+    c.busBytes += tft.busBytes() - bytes0;
+    c.strips += ui.lastFrame().strips;
+  }
+  Serial.setQuiet(false);
+  c.cpuMicros /= BENCH_REDRAW_REPEATS;
+  c.renderMicros /= BENCH_REDRAW_REPEATS;
+  c.busBytes /= BENCH_REDRAW_REPEATS;
+  c.strips /= BENCH_REDRAW_REPEATS;
+  return c;
+}
+
+static void printRedraw(const char *name, const char *metric, const RedrawCost &c) {
+  double spiMicros = c.busBytes * 8 / (SPI_FREQUENCY / 1e6);
+  printf("  %-16s %8.1f %8.1f %7.1f %9.0f %9.0f\n", name, c.cpuMicros, c.renderMicros,
+         c.strips, c.busBytes, spiMicros);
+  char m[64];
+  snprintf(m, sizeof(m), "redraw_%s_cpu_us", metric);
+  result(m, c.cpuMicros, "us");
+  snprintf(m, sizeof(m), "redraw_%s_bus_bytes", metric);
+  result(m, c.busBytes, "bytes");
+  snprintf(m, sizeof(m), "redraw_%s_spi_us", metric);
+  result(m, spiMicros, "us");
+}
+
+// A finger dragging the list up BENCH_DRAG_STEP pixels per frame through
+// the firmware's gesture code, then released into a fling that settles on
+// a row. Bus cost per scrolled pixel is compared with page steps, which
+// move a page of rows per redraw; the frame rate is what the SPI
+// bus allows (on the ESP32 the DMA overlaps composing the next strip), and
+// the bus share what is left busy at the UI_SCROLL_FRAME_MS pace. Needs a
+// build with LIST_DRAG_SCROLL (the native environment's).
+static void benchScroll(const RedrawCost &page) {
+  uint32_t t = micros();
+  TouchEvent ev = {TOUCH_DOWN, TAP_SOUND_LIST, t};
+  Serial.setQuiet(true);
+  if (!listTouch(ev)) {
+    Serial.setQuiet(false);
+    printf("\nDrag scrolling: off in this build (LIST_DRAG_SCROLL 0), skipped\n");
+    return;
+  }
+  ev.type = TOUCH_MOVE;
+  ev.y -= 10;  // Past the slop: the list goes into the scroll view
+  ev.micros = t += BENCH_DRAG_MS * 1000;
+  listTouch(ev);
+  stepListScroll();
+  ui.flush();
+  Serial.setQuiet(false);
+  if (!check(ui.scrollViewActive())) {
+    printf("\nDrag scrolling: scroll view FAILED\n");
+    return;
+  }
+
+  RedrawCost drag = measureRedraw([&](int) {
+    ev.y -= BENCH_DRAG_STEP;
+    ev.micros = t += BENCH_DRAG_MS * 1000;
+    listTouch(ev);
+    stepListScroll();
+  }, UI_SCROLL_FRAME_MS);
+
+  // Frames that pushed only changed lines and columns must leave the panel
+  // as a full repaint of the view would
+  size_t panelPixels = (size_t)tft.width() * tft.height();
+  std::vector<uint16_t> partial(tft.frame(), tft.frame() + panelPixels);
+  ui.invalidateRows();
+  ui.flush();
+  bool same = check(memcmp(partial.data(), tft.frame(), panelPixels * sizeof(uint16_t)) == 0);
+
+  // Release while moving, then let it coast and settle
+  ev.type = TOUCH_UP;
+  listTouch(ev);
+  int frames = 0;
+  Serial.setQuiet(true);
+  while (ui.scrollViewActive() && frames < 2000) {
+    delay(UI_SCROLL_FRAME_MS);
+    stepListScroll();
+    ui.flush();
+    frames++;
+  }
+  Serial.setQuiet(false);
+  check(!ui.scrollViewActive());
+
+  double pagePixels = PAGE_STEP_PX;
+  double dragSpi = drag.busBytes * 8 / (SPI_FREQUENCY / 1e6);
+  double busShare = min(dragSpi / (UI_SCROLL_FRAME_MS * 1000.0), 1.0);
+  printf("\nDrag scrolling (%d px per frame, rows from the row cache):\n", BENCH_DRAG_STEP);
+  printRedraw("drag frame", "drag", drag);
+  printf("  %.0f bus bytes per scrolled pixel dragging, %.0f with page steps; "
+         "panel %s a full repaint\n", drag.busBytes / BENCH_DRAG_STEP,
+         page.busBytes / pagePixels, same ? "matches" : "FAILED to match");
+  printf("  SPI-bound frame rate %.0f fps (%.0f px/s at this step)\n", 1e6 / dragSpi,
+         1e6 / dragSpi * BENCH_DRAG_STEP);
+  printf("  Paced to a frame per %d ms: bus busy %.0f%% of the time, the rest left to the card\n",
+         UI_SCROLL_FRAME_MS, busShare * 100);
+  printf("  Fling settled after %d frames at offset %d%s\n", frames, scrollOffset,
+         ui.scrollViewActive() ? " (FAILED to settle)" : "");
+  result("scroll_drag_bytes_per_px", drag.busBytes / BENCH_DRAG_STEP, "bytes");
+  result("scroll_page_bytes_per_px", page.busBytes / pagePixels, "bytes");
+  result("scroll_drag_fps", 1e6 / dragSpi, "fps");
+  result("scroll_bus_share", busShare * 100, "%");
+
+  scrollOffset = 0;
+  drawUI();
+  ui.flush();
+}
+
+// The firmware's idle analysis pass over the card, one call per loop()
+// pass: trim points and the thumbnail envelope of every WAV. The longest
+// call is what it can hold up a loop() pass by.
+static void benchThumbnails() {
+  Serial.setQuiet(true);
+  trimNext = 0;
+  int calls = 0;
+  double totalMicros = 0, maxMicros = 0;
+  while (trimNext < catalog.count() || analysisIndex >= 0) {
+    uint64_t t0 = nowNanos();
+    analyzeNextSound();
+    double us = (nowNanos() - t0) / 1e3;
+    totalMicros += us;
+    maxMicros = std::max(maxMicros, us);
+    calls++;
+  }
+  Serial.setQuiet(false);
+
+  int thumbs = 0;
+  SoundEntry e;
+  for (int i = 0; i < catalog.count(); i++) {
+    if (catalog.read(i, e) && e.thumb.durationMs > 0) thumbs++;
+  }
+  printf("\nThumbnail pass (%d frames per step): %d of %d sounds in %d loop() calls, "
+         "%.1f ms in all, longest call %.0f us\n", WAV_ENVELOPE_STEP_FRAMES, thumbs,
+         catalog.count(), calls, totalMicros / 1e3, maxMicros);
+  result("thumbnail_pass_ms", totalMicros / 1e3, "ms");
+  result("thumbnail_step_max_us", maxMicros, "us");
+}
+
+static void benchRedraw() {
+  tft.init();
+  tft.setRotation(1);
+  Serial.setQuiet(true);
+  ui.begin(&tft, TFT_BLACK);
+  drawUI();
+  ui.flush();
+  Serial.setQuiet(false);
+  benchThumbnails();
+
+  printf("\nRedraw cost (%dx%d panel, SPI at %.0f MHz, average of %d):\n", tft.width(),
+         tft.height(), SPI_FREQUENCY / 1e6, BENCH_REDRAW_REPEATS);
+  printf("  %-16s %8s %8s %7s %9s %9s\n", "change", "cpu us", "render", "strips", "bus bytes", "spi us");
+
+  auto pageChange = [](int r) {
+    if (r % 2 == 0) handleTouch(TAP_SCROLL_DOWN);
+    else handleTouch(TAP_SCROLL_UP);
+  };
+  printRedraw("full screen", "full", measureRedraw([](int) { drawUI(); }));
+  printRedraw("page change", "page", measureRedraw(pageChange));
+  printRedraw("volume step", "volume", measureRedraw([](int r) {
+    if (r % 2 == 0) handleTouch(TAP_VOL_PLUS);
+    else handleTouch(TAP_VOL_MINUS);
+  }));
+
+  // Pages of card sounds only, so every button has a thumbnail, then the
+  // same pages without
+  scrollOffset = catalog.builtins();
+  drawUI();
+  RedrawCost thumbPage = measureRedraw(pageChange);
+  printRedraw("page, thumbs", "page_thumbs", thumbPage);
+  showThumbnails = false;
+  drawUI();
+  RedrawCost plainPage = measureRedraw(pageChange);
+  printRedraw("page, no thumbs", "page_plain", plainPage);
+  showThumbnails = true;
+  scrollOffset = 0;
+  drawUI();
+  ui.flush();
+  benchScroll(measureRedraw([](int r) {
+    if (r % 2 == 0) handleTouch(TAP_SCROLL_DOWN);
+    else handleTouch(TAP_SCROLL_UP);
+  }));
+
+  printf("  Thumbnails: %+.1f us CPU per page (%+.1f us per button), %+.0f bus bytes\n",
+         thumbPage.cpuMicros - plainPage.cpuMicros,
+         (thumbPage.cpuMicros - plainPage.cpuMicros) / PAGE_BUTTONS,
+         thumbPage.busBytes - plainPage.busBytes);
+  result("redraw_thumbnail_cost_us", thumbPage.cpuMicros - plainPage.cpuMicros, "us");
+
+  // Meter updates as loop() makes them while a 2 s sound plays: a level
+  // that jumps and falls back, a playhead a refresh further on each time.
+  // The same updates repainting both bars whole are what a plain widget
+  // would cost.
+  auto meterChange = [](int r) {
+    MixerMeter m = {(uint32_t)r + 1, 0, 0, 5, 0, 2 * MIXER_SAMPLE_RATE};
+    m.level = m.peak = (uint16_t)(r % 8 == 0 ? 30000 : 30000 >> (r % 8));
+    m.played = (uint32_t)r * MIXER_SAMPLE_RATE * 33 / 1000;
+    drawMeters(m, r * 33);
+  };
+  RedrawCost meterStep = measureRedraw(meterChange);
+  printRedraw("meter step", "meter", meterStep);
+  RedrawCost meterWhole = measureRedraw([&](int r) {
+    meterChange(r);
+    ui.invalidate(METER_RECT);
+  });
+  printRedraw("meter, whole bars", "meter_whole", meterWhole);
+  MixerMeter silent = {0, 0, 0, -1, 0, 0};
+  drawMeters(silent, 0);
+  ui.flush();
+
+  printf("\n");
+  ui.benchmark(ui.widgetAt(TAP_SOUND_LIST));
+}
+
+// ===== 5. OUTPUT PATH =====
+// The mixer's level meter: the cost of publishing a block's snapshot, and
+// four voices mixed with and without a reader on another thread taking
+// snapshots as fast as it can. The writer never waits for the reader, so
+// the mix time should not move; it is the mixing thread's own CPU time,
+// as on a single-core host the threads take turns. Every snapshot read
+// must be whole (a level below its block's peak would be a torn one) and
+// newer than or the same as the one before.
+static void benchMeter(AudioMixer &mixer, AudioOutputRing &ring,
+                       const std::vector<std::string> &files) {
+  int16_t block[MIXER_BLOCK_SAMPLES];
+  for (int i = 0; i < MIXER_BLOCK_SAMPLES; i++) block[i] = (int16_t)((i * 2654435761u) >> 16);
+  uint64_t t0 = nowNanos();
+  for (int i = 0; i < BENCH_METER_PUBLISHES; i++) mixer.publishMeter(block, MIXER_BLOCK_SAMPLES);
+  double publishNs = (double)(nowNanos() - t0) / BENCH_METER_PUBLISHES;
+
+  std::atomic<bool> reading(false), stop(false);
+  std::atomic<uint64_t> reads(0), fresh(0), torn(0), backwards(0);
+  std::thread reader([&] {
+    MixerMeter m;
+    uint32_t lastBlock = 0;
+    while (!stop.load()) {
+      if (!reading.load(std::memory_order_relaxed)) {
+        std::this_thread::yield();
+        continue;
+      }
+      if (mixer.readMeter(m)) fresh++;
+      reads++;
+      if (m.level < m.peak) torn++;
+      if ((int32_t)(m.block - lastBlock) < 0) backwards++;
+      lastBlock = m.block;
+    }
+  });
+
+  double mixMicros[2];
+  double readSeconds = 0;
+  for (int pass = 0; pass < 2; pass++) {
+    uint64_t mixNs = 0, samples = 0;
+    uint64_t target = (uint64_t)BENCH_OUTPUT_BLOCKS * MIXER_BLOCK_SAMPLES;
+    int next = 0;
+    Serial.setQuiet(true);
+    reading = pass == 1;
+    uint64_t start = nowNanos();
+    while (samples < target) {
+      for (int v = 0; v < MIXER_VOICES; v++) {
+        if (mixer.isPlaying(v)) continue;
+        std::string path = "/" + files[next++ % files.size()];
+        mixer.playFile(v, path.c_str(), MIXER_UNITY_GAIN / 4);
+      }
+      uint64_t t1 = threadNanos();
+      mixer.loop();
+      mixNs += threadNanos() - t1;
+      samples += ring.drain();
+    }
+    if (pass == 1) readSeconds = (nowNanos() - start) / 1e9;
+    reading = false;
+    mixer.stopAll();
+    while (mixer.loop() || ring.drain() > 0) {}
+    Serial.setQuiet(false);
+    mixMicros[pass] = mixNs / 1e3 / ((double)samples / MIXER_BLOCK_SAMPLES);
+  }
+  stop = true;
+  reader.join();
+
+  double budgetNs = 1e9 * MIXER_BLOCK_SAMPLES / MIXER_SAMPLE_RATE;
+  printf("\nLevel meter (snapshot per %d-sample block):\n", MIXER_BLOCK_SAMPLES);
+  printf("  Publish: %.0f ns per block (%.4f%% of the block's real time)\n", publishNs,
+         100 * publishNs / budgetNs);
+  printf("  Mixing %d voices: %.2f us per block alone, %.2f us with a reader (%+.1f%%)\n",
+         MIXER_VOICES, mixMicros[0], mixMicros[1],
+         100 * (mixMicros[1] - mixMicros[0]) / mixMicros[0]);
+  printf("  Reader: %.1f M reads/s, %llu new snapshots, %llu torn, %llu out of order\n",
+         reads / readSeconds / 1e6, (unsigned long long)fresh.load(),
+         (unsigned long long)torn.load(), (unsigned long long)backwards.load());
+  result("meter_publish_ns", publishNs, "ns");
+  result("meter_mix_us_per_block", mixMicros[0], "us");
+  result("meter_mix_with_reader_us_per_block", mixMicros[1], "us");
+  result("meter_torn_snapshots", torn + backwards, "count");
+}
+
+static void benchOutput() {
+  std::vector<std::string> files = listWavs(SD.rootDir());
+  if (files.empty()) {
+    printf("\nOutput path: no WAVs on the card, skipped\n");
+    return;
+  }
+
+  static AudioFileSourceSD sources[MIXER_VOICES];
+  static AudioFileSource *sourcePtrs[MIXER_VOICES];
+  for (int i = 0; i < MIXER_VOICES; i++) sourcePtrs[i] = &sources[i];
+
+  AudioOutputI2S i2s;
+  i2s.captureLimit = 0;
+  AudioOutputRing ring;
+  ring.setSink(&i2s);
+  AudioMixer mixer;
+  mixer.begin(&ring, sourcePtrs);
+
+  double budgetMicros = 1e6 * MIXER_BLOCK_SAMPLES / MIXER_SAMPLE_RATE;
+  printf("\nOutput path per %d-sample block (budget %.0f us), file voices from the card:\n",
+         MIXER_BLOCK_SAMPLES, budgetMicros);
+  printf("  %6s %9s %9s %9s %8s\n", "voices", "mix us", "drain us", "total us", "budget");
+
+  for (int n = 1; n <= MIXER_VOICES; n++) {
+    uint64_t mixNs = 0, drainNs = 0, samples = 0;
+    uint64_t target = (uint64_t)BENCH_OUTPUT_BLOCKS * MIXER_BLOCK_SAMPLES;
+    int next = 0;
+    Serial.setQuiet(true);
+    while (samples < target) {
+      // (Re)start any voice that ran out, outside the timed region
+      for (int v = 0; v < n; v++) {
+        if (mixer.isPlaying(v)) continue;
+        std::string path = "/" + files[next++ % files.size()];
+        mixer.playFile(v, path.c_str(), MIXER_UNITY_GAIN / 4);
+      }
+      uint64_t t0 = nowNanos();
+      mixer.loop();
+      uint64_t t1 = nowNanos();
+      int moved = ring.drain();
+      uint64_t t2 = nowNanos();
+      mixNs += t1 - t0;
+      drainNs += t2 - t1;
+      samples += moved;
+    }
+    mixer.stopAll();
+    while (mixer.loop() || ring.drain() > 0) {}
+    Serial.setQuiet(false);
+
+    double blocks = (double)samples / MIXER_BLOCK_SAMPLES;
+    double mix = mixNs / 1e3 / blocks;
+    double drain = drainNs / 1e3 / blocks;
+    printf("  %6d %9.2f %9.2f %9.2f %7.2f%%\n", n, mix, drain, mix + drain,
+           100 * (mix + drain) / budgetMicros);
+    char m[48];
+    snprintf(m, sizeof(m), "output_%dvoice_us_per_block", n);
+    result(m, mix + drain, "us");
+  }
+  if (ring.underruns() > 0) printf("  (%u ring underruns)\n", ring.underruns());
+  benchMeter(mixer, ring, files);
+
+  printf("\n");
+  mixer.benchmark();
+
+  // The kernel table mixer.benchmark() printed, as tracked metrics
+  alignas(4) static uint8_t kernelData[BENCH_KERNEL_BYTES];
+  uint32_t seed = 99;
+  for (uint8_t &b : kernelData) {
+    seed = seed * 1103515245 + 12345;
+    b = seed >> 24;
+  }
+  const char *pathNames[3] = {"generic", "convert", "fused"};
+  for (int bytes = 1; bytes <= 3; bytes++) {
+    for (int channels = 1; channels <= 2; channels++) {
+      for (int path = 0; path < 3; path++) {
+        uint32_t c = pcmKernelCycles(kernelData, sizeof(kernelData), bytes, channels,
+                                     (PcmKernelPath)path);
+        char m[64];
+        snprintf(m, sizeof(m), "kernel_%dbit_%s_%s_cycles_per_sample", bytes * 8,
+                 channels == 1 ? "mono" : "stereo", pathNames[path]);
+        result(m, c / 100.0, "cycles");
+      }
+    }
+  }
+}
+
+// ===== 6. PLAY PATH HEAP =====
+static PcmCache heapCache;
+static AudioFileSourceSD heapCacheFill;
+
+// Tap every sound in turn, `rounds` times, mixing a few passes after each
+// tap; returns the allocations made
+static uint32_t tapRounds(AudioMixer &mixer, AudioOutputRing &ring,
+                          const std::vector<std::string> &paths, int rounds) {
+  uint32_t before = heapAllocations();
+  for (int r = 0; r < rounds; r++) {
+    for (size_t t = 0; t < paths.size(); t++) {
+      mixer.playFile(t, paths[t].c_str(), MIXER_UNITY_GAIN / 4);
+      for (int p = 0; p < BENCH_HEAP_PASSES; p++) {
+        mixer.loop();
+        ring.drain();
+        heapCache.service();
+      }
+    }
+  }
+  return heapAllocations() - before;
+}
+
+// Allocations for the first rotation (cold) and per tap after warm-up, with
+// the PCM cache attached as in the firmware
+static void allocsPerTap(AudioFileSource **sources, const std::vector<std::string> &paths,
+                         double &cold, double &steady) {
+  AudioOutputI2S i2s;
+  i2s.captureLimit = 0;
+  AudioOutputRing ring;
+  ring.setSink(&i2s);
+  AudioMixer mixer;
+  mixer.begin(&ring, sources);
+  mixer.setCache(&heapCache);
+  for (size_t t = 0; t < paths.size(); t++) heapCache.invalidate(t);
+
+  Serial.setQuiet(true);
+  cold = (double)tapRounds(mixer, ring, paths, 1) / paths.size();
+  tapRounds(mixer, ring, paths, BENCH_HEAP_WARMUP - 1);
+  steady = (double)tapRounds(mixer, ring, paths, BENCH_HEAP_ROUNDS) /
+           (BENCH_HEAP_ROUNDS * paths.size());
+  mixer.stopAll();
+  while (mixer.loop() || ring.drain() > 0) {}
+  Serial.setQuiet(false);
+}
+
+static void benchHeap() {
+  std::vector<std::string> files = listWavs(SD.rootDir());
+  if (files.empty()) {
+    printf("\nPlay path heap: no WAVs on the card, skipped\n");
+    return;
+  }
+  std::vector<std::string> paths;
+  for (size_t i = 0; i < files.size() && paths.size() < BENCH_HEAP_SOUNDS; i++) {
+    paths.push_back("/" + files[i]);
+  }
+  if (!heapCache.begin(&heapCacheFill)) return;
+
+  // The firmware's voices: read-ahead sources reserved up front, filter
+  // tables built, files held open between plays
+  static AudioFileSourceReadAhead heldFiles[MIXER_VOICES];
+  static AudioFileSourceSD plainFiles[MIXER_VOICES];
+  AudioFileSource *held[MIXER_VOICES], *plain[MIXER_VOICES];
+  for (int i = 0; i < MIXER_VOICES; i++) {
+    heldFiles[i].reserve();
+    held[i] = &heldFiles[i];
+    plain[i] = &plainFiles[i];
+  }
+  PcmStream::reserveFilters(MIXER_SAMPLE_RATE);
+
+  double heldCold, heldSteady, plainCold, plainSteady;
+  allocsPerTap(held, paths, heldCold, heldSteady);
+  allocsPerTap(plain, paths, plainCold, plainSteady);
+
+  printf("\nPlay path heap, %d sounds tapped in rotation (allocations per tap):\n",
+         (int)paths.size());
+  printf("  %-32s %8s %8s\n", "voice sources", "first", "steady");
+  printf("  %-32s %8.2f %8.2f\n", "read-ahead, files held open", heldCold, heldSteady);
+  printf("  %-32s %8.2f %8.2f\n", "AudioFileSourceSD, open per play", plainCold, plainSteady);
+  result("heap_allocs_per_tap_first", heldCold, "allocs");
+  result("heap_allocs_per_tap_steady", heldSteady, "allocs");
+  result("heap_allocs_per_tap_reopen", plainSteady, "allocs");
+}
+
+// ===== 7. SEQUENCED PLAYBACK =====
+// A mixer of its own feeding a capturing output. Each sound is first
+// played alone; in the sequence's output, every sound after the first
+// must then match its solo run sample for sample, at the smallest gap
+// after the previous one's end. So the gaps are measured in the output,
+// not taken from the mixer's own count.
+static AudioFileSourceSD seqSources[MIXER_VOICES];
+static AudioFileSource *seqSourcePtrs[MIXER_VOICES];
+static PcmCache seqCache;
+static AudioFileSourceSD seqCacheFill;
+
+struct SeqRig {
+  AudioOutputI2S i2s;
+  AudioOutputRing ring;
+  AudioMixer mixer;
+
+  explicit SeqRig(PcmCache *cache) {
+    i2s.captureLimit = 120 * MIXER_SAMPLE_RATE;
+    ring.setSink(&i2s);
+    mixer.begin(&ring, seqSourcePtrs);
+    mixer.setCache(cache);
+  }
+
+  // Mix and drain until every voice has ended and the ring is empty
+  void run() {
+    for (;;) {
+      bool active = mixer.loop();
+      int moved = ring.drain();
+      if (cache() != nullptr) seqCache.service();
+      if (!active && moved == 0) break;
+    }
+  }
+  PcmCache *cache() { return cacheUsed; }
+  PcmCache *cacheUsed = nullptr;
+};
+
+// Each sound played alone, cut to its length from a plain decode
+static std::vector<std::vector<int16_t>> soloRuns(SeqRig &rig, const std::vector<std::string> &paths) {
+  std::vector<std::vector<int16_t>> solo;
+  for (size_t k = 0; k < paths.size(); k++) {
+    WavInfo info;
+    uint64_t length = 0;
+    decodeFile(paths[k], MIXER_SAMPLE_RATE, info, length);
+    rig.i2s.clearCapture();
+    rig.mixer.playFile(k, paths[k].c_str(), MIXER_UNITY_GAIN / 2);
+    rig.run();
+    const std::vector<int16_t> &out = rig.i2s.samples();
+    solo.emplace_back(out.begin(), out.begin() + std::min<size_t>(length, out.size()));
+  }
+  return solo;
+}
+
+// Gap before each sound after the first, in samples; -1 where it was not found
+static std::vector<int> findGaps(const std::vector<int16_t> &out,
+                                 const std::vector<std::vector<int16_t>> &solo) {
+  std::vector<int> gaps;
+  size_t pos = solo[0].size();
+  bool lost = !std::equal(solo[0].begin(), solo[0].end(), out.begin());
+  for (size_t k = 1; k < solo.size(); k++) {
+    int found = -1;
+    for (int d = 0; !lost && d <= BENCH_SEQ_SEARCH && pos + d + solo[k].size() <= out.size(); d++) {
+      if (std::equal(solo[k].begin(), solo[k].end(), out.begin() + pos + d)) {
+        found = d;
+        break;
+      }
+    }
+    gaps.push_back(found);
+    lost = found < 0;
+    pos += found + solo[k].size();
+  }
+  return gaps;
+}
+
+// Gaps beyond the requested one; returns the largest (-1: a sound was not found)
+static int printGaps(const char *label, const std::vector<int> &gaps, int requested) {
+  int gapless = 0, extraMax = INT_MIN;
+  double extraTotal = 0;
+  for (int g : gaps) {
+    if (!check(g >= 0)) {
+      printf("  %-34s sound not found in the output\n", label);
+      return -1;
+    }
+    gapless += g == requested;
+    extraTotal += g - requested;
+    extraMax = std::max(extraMax, g - requested);
+  }
+  printf("  %-34s %11d %8d %10.1f %10d %9.2f\n", label, (int)gaps.size(), gapless,
+         extraTotal / gaps.size(), extraMax, extraMax * 1e3 / MIXER_SAMPLE_RATE);
+  return extraMax;
+}
+
+static void benchSequence() {
+  std::vector<std::string> files = listWavs(SD.rootDir());
+  if (files.size() < 2) {
+    printf("\nSequenced playback: fewer than two WAVs on the card, skipped\n");
+    return;
+  }
+  std::vector<std::string> paths;
+  for (size_t i = 0; i < files.size() && paths.size() < BENCH_SEQ_ITEMS; i++) {
+    paths.push_back("/" + files[i]);
+  }
+  for (int i = 0; i < MIXER_VOICES; i++) seqSourcePtrs[i] = &seqSources[i];
+
+  Serial.setQuiet(true);
+  SeqRig plain(nullptr);
+  std::vector<std::vector<int16_t>> solo = soloRuns(plain, paths);
+
+  // Restarted from outside the mixer the moment the previous sound ends,
+  // the best a loop() reacting to end events could do
+  plain.i2s.clearCapture();
+  for (size_t k = 0; k < paths.size(); k++) {
+    plain.mixer.playFile(k, paths[k].c_str(), MIXER_UNITY_GAIN / 2);
+    while (plain.mixer.isPlaying(k)) {
+      plain.mixer.loop();
+      plain.ring.drain();
+    }
+  }
+  plain.run();
+  std::vector<int> chained = findGaps(plain.i2s.samples(), solo);
+
+  std::vector<int> sequenced[2];
+  const int requested[2] = {0, BENCH_SEQ_GAP};
+  for (int r = 0; r < 2; r++) {
+    plain.i2s.clearCapture();
+    for (size_t k = 0; k < paths.size(); k++) {
+      plain.mixer.queueFile(k, paths[k].c_str(), MIXER_UNITY_GAIN / 2, nullptr, requested[r]);
+    }
+    plain.run();
+    sequenced[r] = findGaps(plain.i2s.samples(), solo);
+  }
+
+  // With every head cached: pre-roll and hand-off from RAM, the files
+  // opened behind the heads
+  std::vector<int> cachedGaps;
+  if (seqCache.begin(&seqCacheFill)) {
+    SeqRig cached(&seqCache);
+    cached.cacheUsed = &seqCache;
+    for (size_t k = 0; k < paths.size(); k++) seqCache.request(k, paths[k].c_str());
+    while (!seqCache.idle()) seqCache.service();
+    std::vector<std::vector<int16_t>> cachedSolo = soloRuns(cached, paths);
+    cached.i2s.clearCapture();
+    for (size_t k = 0; k < paths.size(); k++) {
+      cached.mixer.queueFile(k, paths[k].c_str(), MIXER_UNITY_GAIN / 2, nullptr, 0);
+    }
+    cached.run();
+    cachedGaps = findGaps(cached.i2s.samples(), cachedSolo);
+  }
+  Serial.setQuiet(false);
+
+  printf("\nSequenced playback, %d sounds from the card (gaps found in the captured output):\n",
+         (int)paths.size());
+  printf("  %-34s %11s %8s %10s %10s %9s\n", "", "transitions", "on time", "late avg",
+         "late max", "max ms");
+  int chainedMax = printGaps("restarted on voice end", chained, 0);
+  int seqMax = printGaps("sequence, back to back", sequenced[0], 0);
+  char label[48];
+  snprintf(label, sizeof(label), "sequence, %d-sample gaps", BENCH_SEQ_GAP);
+  int spacedMax = printGaps(label, sequenced[1], BENCH_SEQ_GAP);
+  int cachedMax = cachedGaps.empty() ? 0 : printGaps("sequence, cached heads", cachedGaps, 0);
+  printf("  Late: samples beyond the requested gap. Restarting on voice end waits for the next\n"
+         "  block at best; on the board the event round trip and the file open add to it.\n");
+  result("sequence_late_max_samples", std::max(std::max(seqMax, spacedMax), cachedMax), "samples");
+  result("sequence_restart_late_max_samples", chainedMax, "samples");
+}
+
+// ===== 8. BOOT =====
+static void benchBoot() {
+  soundListReady = false;
+  bootLoaded = false;
+  scrollOffset = 0;
+
+  Serial.setQuiet(true);
+  uint32_t t0 = micros();
+  setup();
+  uint32_t setupMicros = micros() - t0;
+  while (!bootProfile.interactive() && micros() - t0 < 10000000) loop();
+  Serial.setQuiet(false);
+
+  printf("\n");
+  bootProfile.printTimeline();
+  if (!check(bootProfile.interactive())) {
+    printf("  Boot FAILED: no interactive frame within 10 s\n");
+    return;
+  }
+  double interactiveMs = (bootProfile.timeToInteractive() - t0) / 1e3;
+  printf("  setup() returned after %.1f ms, first interactive frame %.1f ms after it began\n",
+         setupMicros / 1e3, interactiveMs);
+  result("boot_setup_ms", setupMicros / 1e3, "ms");
+  result("boot_interactive_ms", interactiveMs, "ms");
+  Serial.setQuiet(true);  // The firmware's tasks keep running until exit
+}
+
+// A retriggered sound restarts on its voice without an end event; the
+// engine's playing set must still drop it when it ends, and keep room for
+// other sounds
+static bool runLoopUntil(bool (*done)(), uint32_t timeoutMs) {
+  uint32_t t0 = millis();
+  while (!done()) {
+    if (millis() - t0 > timeoutMs) return false;
+    loop();
+  }
+  return true;
+}
+
+static void benchRetrigger() {
+  if (!bootProfile.interactive() || catalog.count() < 2) return;
+  const int sound = 0, other = 1;  // Built-in beep and siren
+  for (int i = 0; i < 2 * MIXER_VOICES; i++) {
+    playSound(sound);
+    runLoopUntil([]() { return audio.isPlaying(0); }, 1000);
+  }
+  runLoopUntil([]() { return !audio.isBusy(); }, 5000);
+  bool stale = audio.isPlaying(sound);
+  playSound(other);
+  bool tracked = runLoopUntil([]() { return audio.isPlaying(1); }, 1000);
+  audio.stopAll();
+  runLoopUntil([]() { return !audio.isBusy(); }, 5000);
+  check(!stale);
+  check(tracked);
+
+  printf("  Retrigger: %d plays of one sound; after it ended it reads %s, the next sound %s\n",
+         2 * MIXER_VOICES, stale ? "still playing (FAILED)" : "stopped",
+         tracked ? "is tracked" : "is NOT tracked (FAILED)");
+  result("retrigger_stale", (stale ? 1 : 0) + (tracked ? 0 : 1), "errors");
+}
+
+// A BENCH_TAP_HOLD_MS tap on a list button through the gesture code, as
+// loop() dispatches it: with drag scrolling it plays on release, so the
+// press adds to the tap's latency
+static void benchListTap() {
+  if (!bootProfile.interactive()) return;
+  Serial.setQuiet(true);
+  runLoopUntil([]() { return !audio.isBusy(); }, 5000);
+  delay(BENCH_TAP_GAP_MS);
+  uint32_t t0 = micros(), played = 0;
+  TouchEvent ev = {TOUCH_DOWN, TAP_SOUND_LIST, t0};
+  if (!listTouch(ev)) {
+    handleTouch(TAP_SOUND_LIST);
+    played = micros();
+  }
+  delay(BENCH_TAP_HOLD_MS);
+  ev.type = TOUCH_UP;
+  ev.micros = micros();
+  if (listTouch(ev) && played == 0) played = micros();
+  audio.stopAll();
+  runLoopUntil([]() { return !audio.isBusy(); }, 5000);
+  Serial.setQuiet(false);
+
+  double ms = check(played != 0) ? (played - t0) / 1e3 : -1;
+  printf("  List tap held %d ms: playSound() %.1f ms after touch-down (%s)\n", BENCH_TAP_HOLD_MS,
+         ms, played == 0 ? "never, FAILED" : played - t0 >= BENCH_TAP_HOLD_MS * 1000u
+                                              ? "on release, drag scrolling on"
+                                              : "on touch-down");
+  result("list_tap_to_play_ms", ms, "ms");
+}
+
+// ===== 9. REMOTE CONTROL =====
+// Client end of the pty: sends frames and reads the board's replies,
+// skipping its log text as tools/sound_remote.py does
+struct RemoteClient {
+  int fd;
+  RemoteParser parser;
+  uint8_t seq = 0;
+
+  void send(const uint8_t *payload, int len) {
+    uint8_t frame[REMOTE_MAX_PAYLOAD + REMOTE_FRAME_OVERHEAD];
+    writeAll(frame, remoteEncode(++seq, payload, len, frame));
+  }
+
+  void writeAll(const uint8_t *bytes, int n) {
+    for (int off = 0; off < n;) {
+      ssize_t w = write(fd, bytes + off, n - off);
+      if (w > 0) off += w;
+    }
+  }
+
+  // Next frame within timeoutMs; false on timeout
+  bool receive(int timeoutMs) {
+    uint64_t end = nowNanos() + (uint64_t)timeoutMs * 1000000;
+    for (;;) {
+      uint8_t c;
+      while (read(fd, &c, 1) == 1) {
+        if (parser.feed(c) == REMOTE_PARSE_FRAME) return true;
+      }
+      uint64_t now = nowNanos();
+      if (now >= end) return false;
+      struct pollfd p = {fd, POLLIN, 0};
+      poll(&p, 1, (int)((end - now) / 1000000) + 1);
+    }
+  }
+};
+
+static double percentile(std::vector<double> v, double p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+static void remoteLatency(RemoteClient &client, int sounds, std::vector<double> &ackUs,
+                          std::vector<double> &startUs, int &lost) {
+  for (int i = 0; i < BENCH_REMOTE_PLAYS; i++) {
+    int index = i % sounds;
+    uint8_t cmd[5] = {REMOTE_PLAY, (uint8_t)index, (uint8_t)(index >> 8), 0, 0};
+    uint64_t t0 = nowNanos();
+    client.send(cmd, sizeof(cmd));
+    bool acked = false, started = false;
+    while ((!acked || !started) && client.receive(1000)) {
+      const uint8_t *p = client.parser.payload();
+      if (p[0] == REMOTE_ACK && client.parser.seq() == client.seq && !acked) {
+        acked = true;
+        ackUs.push_back((nowNanos() - t0) / 1e3);
+      } else if (p[0] == REMOTE_STARTED && (p[1] | (p[2] << 8)) == index && !started) {
+        started = true;
+        startUs.push_back((nowNanos() - t0) / 1e3);
+      }
+    }
+    if (!acked || !started) lost++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(BENCH_REMOTE_GAP_MS));
+  }
+}
+
+// A frame whose length byte was corrupted upwards, so it takes the next
+// frame's sync byte, then a STATUS frame. True if the board still answers
+// the STATUS frame, with a reply of the documented size, and rejects the
+// bad one.
+static bool remoteResync(RemoteClient &client) {
+  uint8_t vol[2] = {REMOTE_VOLUME, 1};
+  uint8_t status[1] = {REMOTE_STATUS};
+  uint8_t bytes[2 * (REMOTE_FRAME_OVERHEAD + 2)];
+  int n = remoteEncode(++client.seq, vol, sizeof(vol), bytes);
+  uint8_t badSeq = client.seq;
+  bytes[1]++;
+  n += remoteEncode(++client.seq, status, sizeof(status), bytes + n);
+  client.writeAll(bytes, n);
+
+  bool rejected = false, reply = false, acked = false;
+  while (!acked && client.receive(1000)) {
+    const uint8_t *p = client.parser.payload();
+    if (p[0] == REMOTE_ACK && client.parser.seq() == badSeq) rejected = p[1] == REMOTE_BAD_CRC;
+    if (client.parser.seq() != client.seq) continue;
+    if (p[0] == REMOTE_STATUS_REPLY) reply = client.parser.length() == 15;
+    if (p[0] == REMOTE_ACK) acked = p[1] == REMOTE_OK;
+  }
+  return rejected && reply && acked;
+}
+
+// Batched PLAY frames, at most BENCH_REMOTE_WINDOW unacknowledged; returns
+// commands per second and counts frames not acknowledged as OK
+static double remoteThroughput(RemoteClient &client, int sounds, int &failed) {
+  uint8_t batch[BENCH_REMOTE_BATCH * 5];
+  int sent = 0, acked = 0, next = 0;
+  uint64_t t0 = nowNanos();
+  while (acked < BENCH_REMOTE_FRAMES) {
+    if (sent < BENCH_REMOTE_FRAMES && sent - acked < BENCH_REMOTE_WINDOW) {
+      for (int k = 0; k < BENCH_REMOTE_BATCH; k++, next++) {
+        uint8_t *c = batch + 5 * k;
+        c[0] = REMOTE_PLAY;
+        c[1] = (next % sounds) & 0xFF;
+        c[2] = (next % sounds) >> 8;
+        c[3] = c[4] = 0;
+      }
+      client.send(batch, sizeof(batch));
+      sent++;
+      continue;
+    }
+    if (!client.receive(1000)) {
+      failed += sent - acked;
+      break;
+    }
+    const uint8_t *p = client.parser.payload();
+    if (p[0] == REMOTE_ACK) {
+      acked++;
+      if (p[1] != REMOTE_OK) failed++;
+    }
+  }
+  double seconds = (nowNanos() - t0) / 1e9;
+  return acked * BENCH_REMOTE_BATCH / seconds;
+}
+
+static void benchRemote() {
+  if (!bootProfile.interactive()) return;
+
+  // The firmware's end is the master, as the board's UART; the client opens
+  // the terminal side in raw mode like a serial port
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    printf("\nRemote control: no pseudo-terminal, skipped\n");
+    return;
+  }
+  RemoteClient client;
+  client.fd = open(ptsname(master), O_RDWR | O_NOCTTY | O_NONBLOCK);
+  struct termios tio;
+  tcgetattr(client.fd, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(client.fd, TCSANOW, &tio);
+  Serial.attach(master);
+
+  // loop() keeps running here while the client thread drives the link
+  int sounds = catalog.count();
+  std::vector<double> ackUs, startUs;
+  int lost = 0, failed = 0;
+  double cmdsPerSec = 0;
+  bool resync = false;
+  std::atomic<bool> done(false);
+  std::thread driver([&]() {
+    uint8_t vol[2] = {REMOTE_VOLUME, 1};
+    client.send(vol, sizeof(vol));   // Quiet, and makes the link active
+    client.receive(1000);
+    resync = remoteResync(client);
+    remoteLatency(client, sounds, ackUs, startUs, lost);
+    cmdsPerSec = remoteThroughput(client, sounds, failed);
+    done = true;
+  });
+  while (!done) loop();
+  driver.join();
+  Serial.attach(-1);
+  close(client.fd);
+  close(master);
+  check(resync);
+  check(lost == 0);
+  check(failed == 0);
+
+  // On the wire every byte takes 10 bits; a command frame also waits for
+  // its own transfer
+  double wireBytesPerSec = BENCH_SERIAL_BAUD / 10.0;
+  double frameWireUs = (5 + REMOTE_FRAME_OVERHEAD) * 1e6 / wireBytesPerSec;
+  double batchedWire = wireBytesPerSec / (BENCH_REMOTE_BATCH * 5 + REMOTE_FRAME_OVERHEAD) *
+                       BENCH_REMOTE_BATCH;
+  double singleWire = wireBytesPerSec / (5 + REMOTE_FRAME_OVERHEAD);
+
+  printf("\nRemote control over a pty, %d sounds (%d single PLAY frames, %d lost):\n",
+         sounds, BENCH_REMOTE_PLAYS, lost);
+  printf("  %-26s %9s %9s %9s\n", "", "p50 us", "p99 us", "max us");
+  printf("  %-26s %9.0f %9.0f %9.0f\n", "command to ACK", percentile(ackUs, 0.5),
+         percentile(ackUs, 0.99), percentile(ackUs, 1.0));
+  printf("  %-26s %9.0f %9.0f %9.0f\n", "command to voice start", percentile(startUs, 0.5),
+         percentile(startUs, 0.99), percentile(startUs, 1.0));
+  printf("  Frame after one with a corrupted length: %s\n",
+         resync ? "found, answered" : "FAILED (lost)");
+  printf("  A PLAY frame adds %.0f us on the wire at %d baud\n", frameWireUs, BENCH_SERIAL_BAUD);
+  printf("  Sustained: %.0f commands/s in %d-command frames (%d not OK); the wire at %d baud "
+         "carries %.0f/s batched, %.0f/s one per frame\n",
+         cmdsPerSec, BENCH_REMOTE_BATCH, failed, BENCH_SERIAL_BAUD, batchedWire, singleWire);
+  result("remote_resync_lost", resync ? 0 : 1, "frames");
+  result("remote_ack_p50_us", percentile(ackUs, 0.5), "us");
+  result("remote_start_p50_us", percentile(startUs, 0.5), "us");
+  result("remote_start_p99_us", percentile(startUs, 0.99), "us");
+  result("remote_cmds_per_s", cmdsPerSec, "cmds/s");
+  result("remote_wire_cmds_per_s_batched", batchedWire, "cmds/s");
+}
+
+// ===== 10. POWER GOVERNOR =====
+// A second governor on a simulated clock. Its hooks record the clock and
+// backlight, and light sleep jumps the clock to the next tap (a touch
+// wake) or the end of the slice. Each pass of the simulated loop() does
+// what the firmware's does: hands a due tap to activity(), reports the
+// voice start on the next pass, and calls service(), busy while the
+// sound plays.
+struct PowerSim {
+  uint64_t now = 0;                  // us; the governor sees it wrap at 32 bits
+  std::vector<uint64_t> taps;
+  size_t next = 0;
+  uint32_t mhz = 0;
+  uint8_t backlight = 0;
+};
+static PowerSim powerSim;
+
+static uint32_t simClock() { return (uint32_t)powerSim.now; }
+static void simSetCpu(uint32_t mhz) { powerSim.mhz = mhz; }
+static void simBacklight(uint8_t duty) { powerSim.backlight = duty; }
+static uint8_t simSleep(uint32_t maxMs) {
+  uint64_t until = powerSim.now + maxMs * 1000ull;
+  if (powerSim.next < powerSim.taps.size() && powerSim.taps[powerSim.next] < until) {
+    powerSim.now = std::max(powerSim.now, powerSim.taps[powerSim.next]);
+    return POWER_WAKE_TOUCH;
+  }
+  powerSim.now = until;
+  return POWER_WAKE_TIMER;
+}
+
+// Three one-hour sessions of taps 2..120 s apart, and two stray night taps
+static std::vector<uint64_t> powerScript() {
+  const uint64_t hour = 3600000000ull;
+  std::vector<uint64_t> taps = {2 * hour, 3 * hour + hour / 2};
+  uint32_t seed = 7;
+  const int sessions[3] = {9, 13, 19};
+  for (int h : sessions) {
+    for (uint64_t t = h * hour; t < (h + 1) * hour;) {
+      taps.push_back(t);
+      seed = seed * 1103515245 + 12345;
+      t += (2 + (seed >> 16) % 119) * 1000000ull;
+    }
+  }
+  std::sort(taps.begin(), taps.end());
+  return taps;
+}
+
+static void benchPower() {
+  powerSim = PowerSim();
+  powerSim.taps = powerScript();
+  PowerGovernor gov;
+  PowerHooks hooks = {simClock, simSetCpu, simBacklight, simSleep};
+  Serial.setQuiet(true);
+  gov.begin(hooks);
+
+  const uint64_t end = BENCH_POWER_HOURS * 3600000000ull;
+  uint64_t soundEnd = 0;
+  bool starting = false;
+  int tapsBelowFull = 0, soundsBelowFull = 0, litWhileAsleep = 0;
+  uint64_t passes = 0, serviceNs = 0, wakeNs = 0, wakeNsMax = 0;
+  int wakes = 0;
+  while (powerSim.now < end) {
+    passes++;
+    if (starting) {
+      if (powerSim.mhz != POWER_FULL_MHZ) soundsBelowFull++;
+      gov.soundStarted();
+      starting = false;
+    }
+    if (powerSim.next < powerSim.taps.size() && powerSim.taps[powerSim.next] <= powerSim.now) {
+      bool low = gov.state() != POWER_ACTIVE;
+      uint64_t t0 = nowNanos();
+      gov.activity();
+      uint64_t ns = nowNanos() - t0;
+      if (low) {
+        wakes++;
+        wakeNs += ns;
+        wakeNsMax = std::max(wakeNsMax, ns);
+      }
+      if (powerSim.mhz != POWER_FULL_MHZ) tapsBelowFull++;
+      powerSim.next++;
+      starting = true;
+      soundEnd = powerSim.now + BENCH_POWER_SOUND_MS * 1000ull;
+    }
+    uint64_t t0 = nowNanos();
+    gov.service(starting || powerSim.now < soundEnd, true);
+    serviceNs += nowNanos() - t0;
+    if (gov.state() == POWER_SLEEP && powerSim.backlight != 0) litWhileAsleep++;
+    if (gov.state() != POWER_SLEEP) powerSim.now += BENCH_POWER_PASS_US;
+  }
+  Serial.setQuiet(false);
+
+  const char *names[POWER_STATES] = {"active", "dimmed", "dark", "light sleep"};
+  double total = 0;
+  for (int st = 0; st < POWER_STATES; st++) total += gov.stateMicros((PowerState)st);
+  printf("\nPower governor, a simulated %d h day of %d taps (%d ms sounds); "
+         "dim %d s, dark %d s, sleep %d s idle:\n",
+         BENCH_POWER_HOURS, (int)powerSim.taps.size(), BENCH_POWER_SOUND_MS,
+         POWER_DIM_MS / 1000, POWER_DARK_MS / 1000, POWER_SLEEP_MS / 1000);
+  printf("  %-12s %10s %7s %12s %12s\n", "", "hours", "share", "sounds", "wake to snd");
+  for (int st = 0; st < POWER_STATES; st++) {
+    PowerState ps = (PowerState)st;
+    char wake[24] = "-";
+    if (gov.soundCount(ps) > 0) {
+      snprintf(wake, sizeof(wake), "%.1f/%.1f ms", gov.soundAvgMicros(ps) / 1e3,
+               gov.soundMaxMicros(ps) / 1e3);
+    }
+    printf("  %-12s %10.2f %6.1f%% %12u %12s\n", names[st], gov.stateMicros(ps) / 3.6e9,
+           gov.stateMicros(ps) * 100.0 / total, gov.soundCount(ps), wake);
+  }
+  printf("  Wake to sound: avg/max from the first activity (the wake, out of sleep) to the\n"
+         "  voice start, in %d us loop() passes; a state's sounds are those whose tap found it\n",
+         BENCH_POWER_PASS_US);
+  printf("  Light sleeps: %u (%u touch wakes, %u timer); %llu loop() passes against %llu awake\n",
+         gov.sleeps(), gov.wakes(POWER_WAKE_TOUCH), gov.wakes(POWER_WAKE_TIMER),
+         (unsigned long long)passes, (unsigned long long)(end / BENCH_POWER_PASS_US));
+  printf("  Taps handled below full clock: %d, voices started below it: %d, "
+         "backlight lit asleep: %d passes\n",
+         tapsBelowFull, soundsBelowFull, litWhileAsleep);
+  check(tapsBelowFull == 0 && soundsBelowFull == 0 && litWhileAsleep == 0);
+  printf("  Governor CPU: service() %.0f ns per pass, activity() out of a low state "
+         "%.0f ns avg, %.0f ns max (host)\n",
+         (double)serviceNs / passes, wakes ? (double)wakeNs / wakes : 0.0, (double)wakeNsMax);
+  result("power_active_pct", gov.stateMicros(POWER_ACTIVE) * 100.0 / total, "%");
+  result("power_sleep_pct", gov.stateMicros(POWER_SLEEP) * 100.0 / total, "%");
+  result("power_wake_to_sound_sleep_ms", gov.soundAvgMicros(POWER_SLEEP) / 1e3, "ms");
+  result("power_wake_to_sound_active_ms", gov.soundAvgMicros(POWER_ACTIVE) / 1e3, "ms");
+  result("power_taps_below_full_clock", tapsBelowFull + soundsBelowFull, "taps");
+  result("power_service_ns", (double)serviceNs / passes, "ns");
+}
+
+// ===== 11. SYNTH PRESETS =====
+// The tones the firmware played before the synth, one entry per
+// playTone() call of its busy loops (0 Hz: the delay() between notes)
+struct ToneStep {
+  int hz;
+  int ms;
+};
+
+static std::vector<ToneStep> originalTones(const SynthPreset *preset, int &stepHz) {
+  std::vector<ToneStep> t;
+  stepHz = 0;
+  if (preset == &SYNTH_PRESET_BEEP) {
+    t.push_back({1000, 200});
+  } else if (preset == &SYNTH_PRESET_SIREN) {
+    stepHz = 20;
+    for (int cycle = 0; cycle < 2; cycle++) {
+      for (int f = 400; f <= 800; f += 20) t.push_back({f, 15});
+      for (int f = 800; f >= 400; f -= 20) t.push_back({f, 15});
+    }
+  } else if (preset == &SYNTH_PRESET_CHIME) {
+    const int notes[] = {523, 659, 784, 1047};
+    const int ms[] = {100, 100, 100, 250};
+    for (int i = 0; i < 4; i++) {
+      t.push_back({notes[i], ms[i]});
+      t.push_back({0, 30});
+    }
+  } else if (preset == &SYNTH_PRESET_LASER) {
+    stepHz = 50;
+    for (int f = 2000; f >= 200; f -= 50) t.push_back({f, 8});
+  }
+  return t;
+}
+
+// Original pitch at time ms, -1 past the end
+static int toneAt(const std::vector<ToneStep> &tones, double ms) {
+  for (const ToneStep &s : tones) {
+    if (ms < s.ms) return s.hz;
+    ms -= s.ms;
+  }
+  return -1;
+}
+
+// Render to the end: the synth's stepped sweeps are glides over the same
+// span, so a period may be off by up to one step of the original sweep
+// (plus 1%); silences must stay silent
+static void benchSynthPreset(const SynthPreset *preset) {
+  AudioGeneratorSynth synth;
+  int16_t block[SYNTH_BLOCK_SAMPLES];
+  std::vector<int16_t> pcm;
+  synth.start(preset, SYNTH_SAMPLE_RATE);
+  int n, blocks = 0;
+  while ((n = synth.render(block, SYNTH_BLOCK_SAMPLES)) > 0) {
+    pcm.insert(pcm.end(), block, block + n);
+    blocks++;
+  }
+  uint64_t t0 = nowNanos();
+  for (int r = 0; r < BENCH_SYNTH_REPEATS; r++) {
+    synth.start(preset, SYNTH_SAMPLE_RATE);
+    while (synth.render(block, SYNTH_BLOCK_SAMPLES) > 0) {}
+  }
+  double blockUs = (nowNanos() - t0) / 1e3 / BENCH_SYNTH_REPEATS / blocks;
+
+  int stepHz;
+  std::vector<ToneStep> tones = originalTones(preset, stepHz);
+  int totalMs = 0;
+  for (const ToneStep &s : tones) totalMs += s.ms;
+  double renderedMs = pcm.size() * 1000.0 / SYNTH_SAMPLE_RATE;
+
+  // Rising zero crossings, interpolated, with hysteresis so the rounding
+  // noise of a fading tail does not count; each period is checked at its
+  // middle
+  const double msPerSample = 1000.0 / SYNTH_SAMPLE_RATE;
+  double last = -1, worstHz = 0;
+  int periods = 0, off = 0, loudRest = 0;
+  bool armed = false;
+  for (size_t i = 1; i < pcm.size(); i++) {
+    double ms = i * msPerSample;  // Rests checked 1 ms clear of their edges
+    if (toneAt(tones, ms - 1) == 0 && toneAt(tones, ms + 1) == 0 && abs(pcm[i]) > 1) loudRest++;
+    if (pcm[i] < -256) armed = true;
+    if (!armed || !(pcm[i - 1] < 0 && pcm[i] > 0)) continue;
+    armed = false;
+    double at = i - 1 + (double)-pcm[i - 1] / (pcm[i] - pcm[i - 1]);
+    if (last >= 0) {
+      double mid = (last + at) / 2 * msPerSample;
+      int want = toneAt(tones, mid);
+      int before = toneAt(tones, last * msPerSample), after = toneAt(tones, at * msPerSample);
+      if (want > 0 && before > 0 && after > 0) {  // Not across a rest
+        double got = SYNTH_SAMPLE_RATE / (at - last);
+        double err = fabs(got - want);
+        periods++;
+        if (err > worstHz) worstHz = err;
+        if (err > stepHz + want * 0.01) off++;
+      }
+    }
+    last = at;
+  }
+
+  bool ok = check(off == 0 && loudRest == 0 && fabs(renderedMs - totalMs) <= 1.0);
+  double blockPlayUs = SYNTH_BLOCK_SAMPLES * 1e6 / SYNTH_SAMPLE_RATE;
+  printf("  %-6s %6.1f %6d %8d %8.1f %8d %9.2f %8.3f%%  %s\n", preset->name, renderedMs, totalMs,
+         periods, worstHz, stepHz, blockUs, blockUs * 100 / blockPlayUs, ok ? "ok" : "FAILED");
+  std::string metric = std::string("synth_") + preset->name;
+  for (char &c : metric) c = tolower(c);
+  result((metric + "_pitch_err_max_hz").c_str(), worstHz, "Hz");
+  result((metric + "_block_us").c_str(), blockUs, "us");
+  result((metric + "_failed").c_str(), ok ? 0 : 1, "presets");
+}
+
+static void benchSynth() {
+  printf("\nSynth presets at %d Hz against the original tone sequences (%d-sample blocks):\n",
+         SYNTH_SAMPLE_RATE, SYNTH_BLOCK_SAMPLES);
+  printf("  %-6s %6s %6s %8s %8s %8s %9s %9s\n", "", "ms", "orig", "periods", "max err",
+         "step Hz", "us/block", "budget");
+  const SynthPreset *presets[] = {&SYNTH_PRESET_BEEP, &SYNTH_PRESET_SIREN, &SYNTH_PRESET_CHIME,
+                                  &SYNTH_PRESET_LASER};
+  for (const SynthPreset *p : presets) benchSynthPreset(p);
+  printf("  Max err: worst period's pitch against the original's note at that time (Hz); a\n"
+         "  glide may be off by one step of the original sweep. Budget: share of a block's\n"
+         "  playing time\n");
+}
+
+// ===== 12. LIGHT TOUCH =====
+static std::atomic<uint32_t> lightReads(0);
+static std::atomic<bool> lightPressed(false);
+
+static bool readLightTouch(int &x, int &y) {
+  lightReads++;
+  x = 100;
+  y = 100;
+  return lightPressed;
+}
+
+static void benchTouch() {
+  // Its own instance on a spare pin; the firmware's stays untouched
+  static TouchInput light;
+  Serial.setQuiet(true);
+  light.begin(readLightTouch, nullptr, BENCH_TOUCH_PIN, true);
+  Serial.setQuiet(false);
+  delay(20);
+
+  uint32_t before = lightReads;
+  uint64_t t0 = nowNanos();
+  hostSetPin(BENCH_TOUCH_PIN, LOW);
+  delay(BENCH_TOUCH_HOLD_MS);
+  uint32_t held = lightReads - before;
+  double heldMs = (nowNanos() - t0) / 1e6;
+
+  // Pressed harder: one touch-down while the line stays low
+  lightPressed = true;
+  delay(5 * TOUCH_ACTIVE_MS);
+  TouchEvent ev;
+  bool downSeen = false;
+  while (light.poll(ev)) downSeen |= ev.type == TOUCH_DOWN;
+  lightPressed = false;
+  hostSetPin(BENCH_TOUCH_PIN, HIGH);
+  delay(5 * TOUCH_ACTIVE_MS);
+  while (light.poll(ev)) {}
+
+  // Released: the task sleeps on the interrupt again
+  before = lightReads;
+  delay(BENCH_TOUCH_HOLD_MS);
+  uint32_t idle = lightReads - before;
+
+  double expected = heldMs / TOUCH_ACTIVE_MS;
+  bool ok = check(held <= 2 * expected + 2 && held >= 1 && downSeen && idle == 0);
+  printf("\nTouch line held low with no touch read, %.0f ms:\n", heldMs);
+  printf("  %u reads (%.0f expected at %d ms), then %s touch-down once pressed, "
+         "%u reads idle after the release%s\n",
+         held, expected, TOUCH_ACTIVE_MS, downSeen ? "a" : "NO", idle, ok ? "" : " (FAILED)");
+  result("touch_held_reads_per_s", held * 1000.0 / heldMs, "reads/s");
+  result("touch_held_failed", ok ? 0 : 1, "errors");
+}
+
+int main(int argc, char **argv) {
+  const char *card = argc > 1 ? argv[1] : "wavs";
+  SD.setRoot(card);
+  Serial.setQuiet(true);
+  bool mounted = initSDCard();
+  Serial.setQuiet(false);
+  if (!mounted) {
+    fprintf(stderr, "Card directory '%s' not found\n", card);
+    return 1;
+  }
+  printf("Sound board host benchmarks, card: %s\n", card);
+
+  benchDecode(0, "decode only (source rate)");
+  benchDecode(AUDIO_SAMPLE_RATE, "decode and resample to the output rate");
+  benchWavCorrupt();
+  benchAdpcm();
+  benchCatalog();
+  benchRedraw();
+  benchOutput();
+  benchHeap();
+  benchSequence();
+  benchBoot();
+  benchRetrigger();
+  benchListTap();
+  benchRemote();
+  benchPower();
+  benchSynth();
+  benchTouch();
+  if (failedChecks > 0) {
+    printf("\n%d checks FAILED\n", failedChecks);
+    return 1;
+  }
+  return 0;
+}
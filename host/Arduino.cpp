@@ -0,0 +1,260 @@
+#include "Arduino.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+// ===== TIME =====
+static const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+
+static uint64_t nanosSinceBoot() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long millis() { return nanosSinceBoot() / 1000000; }
+unsigned long micros() { return nanosSinceBoot() / 1000; }
+
+void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void delayMicroseconds(uint32_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+void yield() { std::this_thread::yield(); }
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+uint32_t EspClass::getCycleCount() {
+  return (uint32_t)(nanosSinceBoot() * 240 / 1000);
+}
+
+// ===== GPIO =====
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+void digitalWrite(uint8_t pin, uint8_t val) { (void)pin; (void)val; }
+#define HOST_PINS 64
+static std::atomic<uint8_t> pinLow[HOST_PINS];     // Inputs idle high
+static void (*pinIsr[HOST_PINS])();
+static int pinIsrMode[HOST_PINS];
+
+int digitalRead(uint8_t pin) { return pin < HOST_PINS && pinLow[pin] ? LOW : HIGH; }
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {
+  if (pin >= HOST_PINS) return;
+  pinIsr[pin] = isr;
+  pinIsrMode[pin] = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin < HOST_PINS) pinIsr[pin] = nullptr;
+}
+
+void hostSetPin(uint8_t pin, int level) {
+  if (pin >= HOST_PINS || (digitalRead(pin) == level)) return;
+  pinLow[pin] = level == LOW;
+  int edge = level == LOW ? FALLING : RISING;
+  if (pinIsr[pin] != nullptr && (pinIsrMode[pin] == edge || pinIsrMode[pin] == CHANGE)) pinIsr[pin]();
+}
+
+// ===== CLOCK AND PWM =====
+static uint32_t cpuMhz = 240;
+bool setCpuFrequencyMhz(uint32_t mhz) { cpuMhz = mhz; return true; }
+uint32_t getCpuFrequencyMhz() { return cpuMhz; }
+uint32_t ledcSetup(uint8_t channel, uint32_t freq, uint8_t bits) { (void)channel; (void)bits; return freq; }
+void ledcAttachPin(uint8_t pin, uint8_t channel) { (void)pin; (void)channel; }
+void ledcWrite(uint8_t channel, uint32_t duty) { (void)channel; (void)duty; }
+
+// ===== HEAP =====
+void *heap_caps_malloc(size_t size, uint32_t caps) { (void)caps; return malloc(size); }
+void heap_caps_free(void *ptr) { free(ptr); }
+
+// libstdc++ is a shared library here, out of reach of the linker's malloc
+// wrap (on the ESP32 it is linked in and its new already calls malloc), so
+// new goes through malloc explicitly for HEAP_COUNT_ALLOCS to see it
+void *operator new(size_t size) {
+  void *p = malloc(size ? size : 1);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+// ===== STRING =====
+int String::indexOf(char c) const {
+  size_t p = str.find(c);
+  return p == std::string::npos ? -1 : (int)p;
+}
+
+String String::substring(unsigned int from) const {
+  return from >= str.size() ? String() : String(str.substr(from));
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if (from > to) std::swap(from, to);
+  if (from >= str.size()) return String();
+  return String(str.substr(from, to - from));
+}
+
+void String::trim() {
+  size_t b = str.find_first_not_of(" \t\r\n");
+  if (b == std::string::npos) {
+    str.clear();
+    return;
+  }
+  size_t e = str.find_last_not_of(" \t\r\n");
+  str = str.substr(b, e - b + 1);
+}
+
+// ===== SERIAL =====
+// Attached to a port, everything goes to it (quiet only silences stdout);
+// the mutex keeps one call's bytes together, as the UART driver does
+static std::mutex serialLock;
+
+void HardwareSerial::out(const void *data, size_t len) {
+  std::lock_guard<std::mutex> hold(serialLock);
+  if (port >= 0) {
+    const uint8_t *p = (const uint8_t *)data;
+    while (len > 0) {
+      ssize_t n = ::write(port, p, len);
+      if (n <= 0) return;
+      p += n;
+      len -= n;
+    }
+  } else if (!quiet) {
+    fwrite(data, 1, len, stdout);
+  }
+}
+
+int HardwareSerial::printf(const char *fmt, ...) {
+  char buf[512];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (n > 0) out(buf, std::min<size_t>(n, sizeof(buf) - 1));
+  return n;
+}
+
+size_t HardwareSerial::print(const char *s) {
+  out(s, strlen(s));
+  return strlen(s);
+}
+
+size_t HardwareSerial::println(const char *s) {
+  size_t n = print(s);
+  return n + print("\n");
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  out(&c, 1);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t len) {
+  out(buf, len);
+  return len;
+}
+
+void HardwareSerial::feed(const char *s) {
+  input.erase(0, inputPos);
+  inputPos = 0;
+  input += s;
+}
+
+void HardwareSerial::attach(int fd) {
+  port = fd;
+  if (fd >= 0) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+int HardwareSerial::available() {
+  if (port >= 0 && inputPos == input.size()) {
+    // Whatever the port holds, without waiting
+    uint8_t buf[256];
+    ssize_t n = ::read(port, buf, sizeof(buf));
+    if (n > 0) {
+      input.assign((const char *)buf, n);
+      inputPos = 0;
+    }
+  }
+  return (int)(input.size() - inputPos);
+}
+
+int HardwareSerial::read() {
+  if (inputPos == input.size() && available() == 0) return -1;
+  return (uint8_t)input[inputPos++];
+}
+
+// ===== FREERTOS =====
+// A task is a detached thread with a notification counter
+struct HostTask {
+  std::mutex lock;
+  std::condition_variable wake;
+  uint32_t notifications = 0;
+  BaseType_t core = 1;                       // loop() runs on core 1
+};
+
+static thread_local HostTask *currentTask = nullptr;
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core) {
+  (void)name; (void)stack; (void)priority;
+  HostTask *task = new HostTask();
+  task->core = core;
+  if (handle != nullptr) *handle = task;
+  std::thread([task, fn, arg] {
+    currentTask = task;
+    fn(arg);
+  }).detach();
+  return pdPASS;
+}
+
+void xTaskNotifyGive(TaskHandle_t task) {
+  if (task == nullptr) return;
+  std::lock_guard<std::mutex> guard(task->lock);
+  task->notifications++;
+  task->wake.notify_one();
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {
+  xTaskNotifyGive(task);
+  if (woken != nullptr) *woken = pdFALSE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+  if (currentTask == nullptr) currentTask = new HostTask();  // Main thread
+  HostTask *task = currentTask;
+  std::unique_lock<std::mutex> guard(task->lock);
+  auto ready = [task] { return task->notifications > 0; };
+  if (ticks == portMAX_DELAY) {
+    task->wake.wait(guard, ready);
+  } else {
+    task->wake.wait_for(guard, std::chrono::milliseconds(ticks), ready);
+  }
+  uint32_t value = task->notifications;
+  if (clear) task->notifications = 0;
+  else if (value > 0) task->notifications--;
+  return value;
+}
+
+void vTaskDelay(TickType_t ticks) { delay(ticks); }
+TickType_t xTaskGetTickCount() { return millis(); }
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) { (void)task; return 0; }
+
+void vTaskDelete(TaskHandle_t task) {
+  if (task == nullptr) pthread_exit(nullptr);
+}
+
+BaseType_t xPortGetCoreID() {
+  return currentTask != nullptr ? currentTask->core : 1;
+}
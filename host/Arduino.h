@@ -0,0 +1,174 @@
+#pragma once
+
+// ===== HOST STAND-IN: ARDUINO CORE AND FREERTOS =====
+// Just enough of the ESP32 Arduino core for the firmware sources to build
+// and run natively (the `native` PlatformIO environment). Time comes from
+// the host's steady clock, tasks are std::threads, Serial is stdout, GPIO
+// outputs do nothing and inputs read high unless hostSetPin() drives them. ESP.getCycleCount() counts host time in 240 MHz cycles so
+// the firmware's cycle budgets read the same on both.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdarg.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH    1
+#define LOW     0
+#define INPUT   0x01
+#define OUTPUT  0x03
+#define INPUT_PULLUP 0x05
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+
+#define IRAM_ATTR
+#define PROGMEM
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// ===== TIME =====
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+// ===== GPIO =====
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+#define digitalPinToInterrupt(p) (p)
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void detachInterrupt(uint8_t pin);
+// Host only: drive an input pin's level, running its interrupt on the edge
+void hostSetPin(uint8_t pin, int level);
+
+// ===== CLOCK AND PWM =====
+// The CPU clock setting is only remembered; host time does not scale with it
+bool setCpuFrequencyMhz(uint32_t mhz);
+uint32_t getCpuFrequencyMhz();
+uint32_t ledcSetup(uint8_t channel, uint32_t freq, uint8_t bits);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcWrite(uint8_t channel, uint32_t duty);
+
+// ===== HEAP =====
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+void *heap_caps_malloc(size_t size, uint32_t caps);
+void heap_caps_free(void *ptr);
+
+// ===== STRING =====
+class String {
+  public:
+    String() {}
+    String(const char *s) : str(s ? s : "") {}
+    String(const std::string &s) : str(s) {}
+
+    const char *c_str() const { return str.c_str(); }
+    unsigned int length() const { return str.size(); }
+    int indexOf(char c) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    void trim();
+    bool operator==(const char *s) const { return str == s; }
+    String &operator+=(char c) { str += c; return *this; }
+
+  private:
+    std::string str;
+};
+
+// ===== SERIAL =====
+class HardwareSerial {
+  public:
+    void begin(unsigned long baud) { (void)baud; }
+    int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+    size_t print(const char *s);
+    size_t println(const char *s = "");
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buf, size_t len);
+    int available();
+    int read();
+    int availableForWrite() { return 256; }
+    void flush() { fflush(stdout); }
+
+    // Host only: drop output (around timed loops) and feed console input
+    void setQuiet(bool q) { quiet = q; }
+    void feed(const char *input);
+
+    // Host only: use a file descriptor (a pty) as the port, both ways, as
+    // the USB serial link; -1 goes back to stdout and feed()
+    void attach(int fd);
+
+  private:
+    void out(const void *data, size_t len);
+
+    bool quiet = false;
+    int port = -1;
+    std::string input;
+    size_t inputPos = 0;
+};
+
+extern HardwareSerial Serial;
+
+// ===== ESP =====
+class EspClass {
+  public:
+    uint32_t getCycleCount();
+    uint32_t getCpuFreqMHz() { return 240; }
+    uint32_t getFreeHeap() { return 320 * 1024; }
+    uint32_t getMinFreeHeap() { return 320 * 1024; }
+    uint32_t getMaxAllocHeap() { return 110 * 1024; }
+};
+
+extern EspClass ESP;
+
+// ===== FREERTOS =====
+struct HostTask;
+typedef HostTask *TaskHandle_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdPASS             1
+#define pdFAIL             0
+#define pdTRUE             1
+#define pdFALSE            0
+#define portMAX_DELAY      0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(ms))
+#define portYIELD_FROM_ISR(woken) (void)(woken)
+
+// Critical sections are a spinlock; there are no interrupts to mask
+struct portMUX_TYPE {
+  std::atomic_flag flag = ATOMIC_FLAG_INIT;
+};
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux) while ((mux)->flag.test_and_set(std::memory_order_acquire)) {}
+#define portEXIT_CRITICAL(mux)  (mux)->flag.clear(std::memory_order_release)
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core);
+void xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+void vTaskDelete(TaskHandle_t task);         // nullptr only: ends the calling task
+BaseType_t xPortGetCoreID();                 // Pinned core; 1 for the main thread
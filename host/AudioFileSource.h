@@ -0,0 +1,24 @@
+#pragma once
+
+// ===== HOST STAND-IN: ESP8266Audio AudioFileSource =====
+
+#include <Arduino.h>
+#include "AudioStatus.h"
+
+class AudioFileSource {
+  public:
+    AudioFileSource() {}
+    virtual ~AudioFileSource() {}
+    virtual bool open(const char *filename) { (void)filename; return false; }
+    virtual uint32_t read(void *data, uint32_t len) { (void)data; (void)len; return 0; }
+    virtual uint32_t readNonBlock(void *data, uint32_t len) { return read(data, len); }
+    virtual bool seek(int32_t pos, int dir) { (void)pos; (void)dir; return false; }
+    virtual bool close() { return false; }
+    virtual bool isOpen() { return false; }
+    virtual uint32_t getSize() { return 0; }
+    virtual uint32_t getPos() { return 0; }
+    virtual bool loop() { return true; }
+
+  protected:
+    AudioStatus cb;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+// ===== HOST STAND-IN: ESP8266Audio AudioFileSourcePROGMEM =====
+
+#include "AudioFileSource.h"
+
+class AudioFileSourcePROGMEM : public AudioFileSource {
+  public:
+    AudioFileSourcePROGMEM() {}
+    AudioFileSourcePROGMEM(const void *data, uint32_t len) { open(data, len); }
+
+    bool open(const void *data, uint32_t len) {
+      progmemData = (const uint8_t *)data;
+      progmemLen = len;
+      filePointer = 0;
+      opened = true;
+      return true;
+    }
+    virtual uint32_t read(void *data, uint32_t len) override {
+      if (!opened) return 0;
+      if (len > progmemLen - filePointer) len = progmemLen - filePointer;
+      memcpy(data, progmemData + filePointer, len);
+      filePointer += len;
+      return len;
+    }
+    virtual bool seek(int32_t pos, int dir) override {
+      int32_t target = dir == SEEK_SET ? pos : dir == SEEK_CUR ? (int32_t)filePointer + pos
+                                                               : (int32_t)progmemLen + pos;
+      if (!opened || target < 0 || (uint32_t)target > progmemLen) return false;
+      filePointer = target;
+      return true;
+    }
+    virtual bool close() override { opened = false; return true; }
+    virtual bool isOpen() override { return opened; }
+    virtual uint32_t getSize() override { return opened ? progmemLen : 0; }
+    virtual uint32_t getPos() override { return opened ? filePointer : 0; }
+
+  private:
+    bool opened = false;
+    const uint8_t *progmemData = nullptr;
+    uint32_t progmemLen = 0;
+    uint32_t filePointer = 0;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+// ===== HOST STAND-IN: ESP8266Audio AudioFileSourceSD =====
+
+#include <SD.h>
+#include "AudioFileSource.h"
+
+class AudioFileSourceSD : public AudioFileSource {
+  public:
+    AudioFileSourceSD() {}
+    AudioFileSourceSD(const char *filename) { open(filename); }
+
+    virtual bool open(const char *filename) override {
+      f = SD.open(filename, FILE_READ);
+      return f;
+    }
+    virtual uint32_t read(void *data, uint32_t len) override { return f.read((uint8_t *)data, len); }
+    virtual bool seek(int32_t pos, int dir) override {
+      if (!f) return false;
+      if (dir == SEEK_SET) return f.seek(pos);
+      if (dir == SEEK_CUR) return f.seek(f.position() + pos);
+      if (dir == SEEK_END) return f.seek(f.size() + pos);
+      return false;
+    }
+    virtual bool close() override { f.close(); return true; }
+    virtual bool isOpen() override { return f; }
+    virtual uint32_t getSize() override { return f ? f.size() : 0; }
+    virtual uint32_t getPos() override { return f ? f.position() : 0; }
+
+  private:
+    File f;
+};
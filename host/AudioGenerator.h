@@ -0,0 +1,29 @@
+#pragma once
+
+// ===== HOST STAND-IN: ESP8266Audio AudioGenerator =====
+
+#include <Arduino.h>
+#include "AudioStatus.h"
+#include "AudioFileSource.h"
+#include "AudioOutput.h"
+
+class AudioGenerator {
+  public:
+    AudioGenerator() { lastSample[0] = lastSample[1] = 0; }
+    virtual ~AudioGenerator() {}
+    virtual bool begin(AudioFileSource *source, AudioOutput *output) {
+      (void)source; (void)output;
+      return false;
+    }
+    virtual bool loop() { return false; }
+    virtual bool stop() { return false; }
+    virtual bool isRunning() { return false; }
+    virtual void desync() {}
+
+  protected:
+    bool running = false;
+    AudioFileSource *file = nullptr;
+    AudioOutput *output = nullptr;
+    int16_t lastSample[2];
+    AudioStatus cb;
+};
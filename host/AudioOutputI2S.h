@@ -0,0 +1,46 @@
+#pragma once
+
+// ===== HOST STAND-IN: ESP8266Audio AudioOutputI2S =====
+// A capture sink instead of the I2S driver: every sample is accepted
+// (there is no DMA to fill up) and the left channel is kept, up to
+// captureLimit samples, for inspection or writing out.
+
+#include <vector>
+#include "AudioOutput.h"
+
+class AudioOutputI2S : public AudioOutput {
+  public:
+    enum : int {
+      EXTERNAL_I2S = 0,
+      INTERNAL_DAC = 1,
+      INTERNAL_PDM = 2,
+    };
+
+    AudioOutputI2S(int port = 0, int outputMode = EXTERNAL_I2S, int dmaBufCount = 8, int useApll = 0) {
+      (void)port; (void)outputMode; (void)dmaBufCount; (void)useApll;
+    }
+    bool SetOutputModeMono(bool mono) { monoOut = mono; return true; }
+    virtual bool begin() override { running = true; starts++; return true; }
+    virtual bool ConsumeSample(int16_t sample[2]) override {
+      if (captured.size() < captureLimit) captured.push_back(sample[LEFTCHANNEL]);
+      consumed++;
+      return true;
+    }
+    virtual bool stop() override { running = false; return true; }
+
+    // Host only
+    bool isRunning() const { return running; }
+    uint32_t rate() const { return hertz; }
+    const std::vector<int16_t> &samples() const { return captured; }
+    uint64_t samplesConsumed() const { return consumed; }
+    uint32_t startCount() const { return starts; }
+    void clearCapture() { captured.clear(); }
+    size_t captureLimit = 10 * 44100;
+
+  private:
+    bool monoOut = false;
+    bool running = false;
+    std::vector<int16_t> captured;
+    uint64_t consumed = 0;
+    uint32_t starts = 0;
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+// ===== HOST STAND-IN: ESP8266Audio =====
+// The library's base classes with the same virtual interface as 1.9.8,
+// minus the status callbacks, which the firmware does not use.
+
+class AudioStatus {
+  public:
+    AudioStatus() {}
+};
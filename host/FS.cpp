@@ -0,0 +1,84 @@
+#include "FS.h"
+#include "SD.h"
+
+#include <sys/stat.h>
+
+SDFS SD;
+
+namespace fs {
+
+File::File(FILE *f) : handle(f, [](FILE *p) { fclose(p); }) {}
+
+size_t File::read(uint8_t *buf, size_t len) {
+  return handle ? fread(buf, 1, len, handle.get()) : 0;
+}
+
+int File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+size_t File::write(const uint8_t *buf, size_t len) {
+  return handle ? fwrite(buf, 1, len, handle.get()) : 0;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  int whence = mode == SeekCur ? SEEK_CUR : mode == SeekEnd ? SEEK_END : SEEK_SET;
+  return handle && fseek(handle.get(), (long)pos, whence) == 0;
+}
+
+size_t File::position() const {
+  return handle ? (size_t)ftell(handle.get()) : 0;
+}
+
+size_t File::size() const {
+  if (!handle) return 0;
+  struct stat st;
+  return fstat(fileno(handle.get()), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+time_t File::getLastWrite() {
+  if (!handle) return 0;
+  struct stat st;
+  return fstat(fileno(handle.get()), &st) == 0 ? st.st_mtime : 0;
+}
+
+String File::readStringUntil(char terminator) {
+  std::string s;
+  int c;
+  while ((c = read()) >= 0 && c != terminator) s += (char)c;
+  return String(s);
+}
+
+void File::flush() {
+  if (handle) fflush(handle.get());
+}
+
+File FS::open(const char *path, const char *mode) {
+  const char *m = mode[0] == 'w' ? "w+b" : mode[0] == 'a' ? "a+b" : mode[1] == '+' ? "r+b" : "rb";
+  FILE *f = fopen(hostPath(path).c_str(), m);
+  return f ? File(f) : File();
+}
+
+bool FS::exists(const char *path) {
+  struct stat st;
+  return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char *path) {
+  return ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char *from, const char *to) {
+  return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+}  // namespace fs
+
+bool SDFS::begin(uint8_t ssPin, SPIClass &spi, uint32_t frequency, const char *mountpoint,
+                 uint8_t maxFiles, bool formatIfEmpty) {
+  (void)ssPin; (void)spi; (void)frequency; (void)mountpoint; (void)maxFiles; (void)formatIfEmpty;
+  struct stat st;
+  mounted = stat(root.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+  return mounted;
+}
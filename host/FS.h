@@ -0,0 +1,65 @@
+#pragma once
+
+// ===== HOST STAND-IN: FILESYSTEM =====
+// fs::FS over a host directory: "/index.csv" is <root>/index.csv. Files
+// are shared stdio handles, so copies of a File refer to one open file as
+// they do on the device.
+
+#include <Arduino.h>
+#include <memory>
+#include <time.h>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode {
+  SeekSet = 0,
+  SeekCur = 1,
+  SeekEnd = 2,
+};
+
+class File {
+  public:
+    File() {}
+    explicit File(FILE *f);
+
+    operator bool() const { return (bool)handle; }
+    size_t read(uint8_t *buf, size_t len);
+    int read();
+    size_t write(const uint8_t *buf, size_t len);
+    size_t write(uint8_t c) { return write(&c, 1); }
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    time_t getLastWrite();
+    int available() { return (int)(size() - position()); }
+    String readStringUntil(char terminator);
+    void flush();
+    void close() { handle.reset(); }
+
+  private:
+    std::shared_ptr<FILE> handle;
+};
+
+class FS {
+  public:
+    // Host only: directory standing in for the card's root
+    void setRoot(const char *dir) { root = dir; }
+    const char *rootDir() const { return root.c_str(); }
+
+    File open(const char *path, const char *mode = FILE_READ);
+    bool exists(const char *path);
+    bool remove(const char *path);
+    bool rename(const char *from, const char *to);
+
+  protected:
+    std::string hostPath(const char *path) const { return root + path; }
+    std::string root = ".";
+};
+
+}  // namespace fs
+
+using fs::File;
@@ -0,0 +1,27 @@
+#pragma once
+
+// ===== HOST STAND-IN: SD CARD =====
+// The card is a host directory (FS::setRoot()); begin() fails if it does
+// not exist, like a missing card.
+
+#include <FS.h>
+#include <SPI.h>
+
+#define CARD_NONE    0
+#define CARD_MMC     1
+#define CARD_SD      2
+#define CARD_SDHC    3
+#define CARD_UNKNOWN 4
+
+class SDFS : public fs::FS {
+  public:
+    bool begin(uint8_t ssPin, SPIClass &spi, uint32_t frequency = 4000000,
+               const char *mountpoint = "/sd", uint8_t maxFiles = 5, bool formatIfEmpty = false);
+    uint8_t cardType() { return mounted ? CARD_SDHC : CARD_NONE; }
+    uint64_t cardSize() { return mounted ? 8ULL << 30 : 0; }
+
+  private:
+    bool mounted = false;
+};
+
+extern SDFS SD;
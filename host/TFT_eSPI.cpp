@@ -0,0 +1,252 @@
+#include "TFT_eSPI.h"
+
+#define ADDR_WINDOW_BYTES 11   // CASET + 4, PASET + 4, RAMWR
+
+static inline uint16_t swap16(uint16_t c) { return (uint16_t)((c >> 8) | (c << 8)); }
+
+TFT_eSPI::TFT_eSPI(int16_t w, int16_t h) {
+  fb = nullptr;
+  _width = panelW = w;
+  _height = panelH = h;
+  storeSwapped = false;
+  countBus = true;
+  bytesSent = 0;
+  vpX = vpY = vpOffX = vpOffY = 0;
+  vpW = w;
+  vpH = h;
+  textFg = TFT_WHITE;
+  textBg = TFT_BLACK;
+  textFill = false;
+  textDatum = TL_DATUM;
+  textSize = 1;
+  swapBytes = false;
+}
+
+TFT_eSPI::~TFT_eSPI() {
+  free(fb);
+}
+
+void TFT_eSPI::allocFrame(int16_t w, int16_t h) {
+  free(fb);
+  fb = (uint16_t *)calloc((size_t)w * h, sizeof(uint16_t));
+  _width = w;
+  _height = h;
+  resetViewport();
+}
+
+void TFT_eSPI::init() {
+  allocFrame(panelW, panelH);
+}
+
+void TFT_eSPI::setRotation(uint8_t r) {
+  if (r & 1) allocFrame(panelH, panelW);
+  else allocFrame(panelW, panelH);
+}
+
+// ===== VIEWPORT =====
+void TFT_eSPI::setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool vpDatum) {
+  vpX = max<int32_t>(x, 0);
+  vpY = max<int32_t>(y, 0);
+  vpW = min<int32_t>(x + w, _width) - vpX;
+  vpH = min<int32_t>(y + h, _height) - vpY;
+  vpOffX = vpDatum ? x : 0;
+  vpOffY = vpDatum ? y : 0;
+}
+
+void TFT_eSPI::resetViewport() {
+  vpX = vpY = vpOffX = vpOffY = 0;
+  vpW = _width;
+  vpH = _height;
+}
+
+// ===== PRIMITIVES =====
+// Every primitive ends up here: one clipped rectangle, one address window
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  if (fb == nullptr) return;
+  x += vpOffX;
+  y += vpOffY;
+  int32_t x0 = max(x, vpX), y0 = max(y, vpY);
+  int32_t x1 = min(x + w, vpX + vpW), y1 = min(y + h, vpY + vpH);
+  if (x0 >= x1 || y0 >= y1) return;
+
+  uint16_t c = storeSwapped ? swap16(color) : (uint16_t)color;
+  for (int32_t row = y0; row < y1; row++) {
+    uint16_t *p = fb + (size_t)row * _width;
+    for (int32_t col = x0; col < x1; col++) p[col] = c;
+  }
+  if (countBus) bytesSent += ADDR_WINDOW_BYTES + 2ULL * (x1 - x0) * (y1 - y0);
+}
+
+void TFT_eSPI::span(int32_t x, int32_t y, int32_t w, uint16_t color) {
+  fillRect(x, y, w, 1, color);
+}
+
+void TFT_eSPI::fillScreen(uint32_t color) {
+  fillRect(-vpOffX, -vpOffY, _width, _height, color);
+}
+
+void TFT_eSPI::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) {
+  fillRect(x, y, w, 1, color);
+}
+
+void TFT_eSPI::drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) {
+  fillRect(x, y, 1, h, color);
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color) {
+  fillRect(x, y, 1, 1, color);
+}
+
+void TFT_eSPI::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  drawFastHLine(x, y, w, color);
+  drawFastHLine(x, y + h - 1, w, color);
+  drawFastVLine(x, y + 1, h - 2, color);
+  drawFastVLine(x + w - 1, y + 1, h - 2, color);
+}
+
+// Horizontal inset of a radius-r corner on its dy-th line from the edge
+static int32_t cornerInset(int32_t r, int32_t dy) {
+  int32_t d = r - dy;
+  return r - (int32_t)sqrtf((float)(r * r - d * d));
+}
+
+void TFT_eSPI::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color) {
+  r = min(r, min(w, h) / 2);
+  fillRect(x, y + r, w, h - 2 * r, color);
+  for (int32_t dy = 0; dy < r; dy++) {
+    int32_t in = cornerInset(r, dy);
+    span(x + in, y + dy, w - 2 * in, color);
+    span(x + in, y + h - 1 - dy, w - 2 * in, color);
+  }
+}
+
+void TFT_eSPI::drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color) {
+  r = min(r, min(w, h) / 2);
+  drawFastHLine(x + r, y, w - 2 * r, color);
+  drawFastHLine(x + r, y + h - 1, w - 2 * r, color);
+  drawFastVLine(x, y + r, h - 2 * r, color);
+  drawFastVLine(x + w - 1, y + r, h - 2 * r, color);
+  for (int32_t dy = 1; dy < r; dy++) {
+    // Run from this line's inset to the previous line's, so the arc has no gaps
+    int32_t in = cornerInset(r, dy);
+    int32_t len = max<int32_t>(1, cornerInset(r, dy - 1) - in);
+    span(x + in, y + dy, len, color);
+    span(x + w - in - len, y + dy, len, color);
+    span(x + in, y + h - 1 - dy, len, color);
+    span(x + w - in - len, y + h - 1 - dy, len, color);
+  }
+}
+
+// ===== TEXT =====
+// Placeholder 5x7 glyphs: a fixed pattern per character, so text costs
+// about what the GLCD font does without carrying the font table
+static uint8_t glyphColumn(char c, int col) {
+  if (c == ' ') return 0;
+  uint32_t h = (uint8_t)c * 2654435761u + col * 40503u;
+  return (uint8_t)((h >> 13) & 0x7F) | 0x41;
+}
+
+int16_t TFT_eSPI::drawString(const char *s, int32_t x, int32_t y) {
+  int32_t w = textWidth(s);
+  int32_t h = fontHeight();
+  switch (textDatum) {
+    case TC_DATUM: x -= w / 2; break;
+    case TR_DATUM: x -= w; break;
+    case ML_DATUM: y -= h / 2; break;
+    case MC_DATUM: x -= w / 2; y -= h / 2; break;
+    case MR_DATUM: x -= w; y -= h / 2; break;
+    case BL_DATUM: y -= h; break;
+    case BC_DATUM: x -= w / 2; y -= h; break;
+    case BR_DATUM: x -= w; y -= h; break;
+    default: break;
+  }
+
+  int32_t sz = textSize;
+  for (const char *p = s; *p; p++, x += 6 * sz) {
+    if (textFill) fillRect(x, y, 6 * sz, 8 * sz, textBg);
+    for (int col = 0; col < 5; col++) {
+      uint8_t bits = glyphColumn(*p, col);
+      for (int row = 0; row < 7; row++) {
+        if (bits & (1 << row)) fillRect(x + col * sz, y + row * sz, sz, sz, textFg);
+      }
+    }
+  }
+  return w;
+}
+
+// ===== IMAGES =====
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data) {
+  if (fb == nullptr) return;
+  x += vpOffX;
+  y += vpOffY;
+  int32_t x0 = max(x, vpX), y0 = max(y, vpY);
+  int32_t x1 = min(x + w, vpX + vpW), y1 = min(y + h, vpY + vpH);
+  if (x0 >= x1 || y0 >= y1) return;
+
+  for (int32_t row = y0; row < y1; row++) {
+    const uint16_t *src = data + (size_t)(row - y) * w + (x0 - x);
+    uint16_t *dst = fb + (size_t)row * _width + x0;
+    for (int32_t col = x0; col < x1; col++) {
+      // Without swapBytes the data is sent in memory order, i.e. swapped
+      uint16_t c = swapBytes ? *src : swap16(*src);
+      *dst++ = storeSwapped ? swap16(c) : c;
+      src++;
+    }
+  }
+  if (countBus) bytesSent += ADDR_WINDOW_BYTES + 2ULL * (x1 - x0) * (y1 - y0);
+}
+
+void TFT_eSPI::pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data,
+                            uint16_t *buffer) {
+  (void)buffer;
+  pushImage(x, y, w, h, data);
+}
+
+// ===== HOST ONLY =====
+uint16_t TFT_eSPI::readPixel(int32_t x, int32_t y) const {
+  if (fb == nullptr || x < 0 || y < 0 || x >= _width || y >= _height) return 0;
+  uint16_t c = fb[(size_t)y * _width + x];
+  return storeSwapped ? swap16(c) : c;
+}
+
+uint32_t TFT_eSPI::busMicros() const {
+  return (uint32_t)(bytesSent * 8 * 1000000ULL / SPI_FREQUENCY);
+}
+
+bool TFT_eSPI::writePpm(const char *path) const {
+  FILE *f = fopen(path, "wb");
+  if (f == nullptr) return false;
+  fprintf(f, "P6\n%d %d\n255\n", _width, _height);
+  for (int32_t y = 0; y < _height; y++) {
+    for (int32_t x = 0; x < _width; x++) {
+      uint16_t c = readPixel(x, y);
+      uint8_t rgb[3] = {(uint8_t)((c >> 8) & 0xF8), (uint8_t)((c >> 3) & 0xFC), (uint8_t)(c << 3)};
+      fwrite(rgb, 1, 3, f);
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+// ===== SPRITES =====
+TFT_eSprite::TFT_eSprite(TFT_eSPI *p) : TFT_eSPI(0, 0), parent(p) {
+  storeSwapped = true;
+  countBus = false;  // RAM only
+}
+
+void *TFT_eSprite::createSprite(int16_t w, int16_t h, uint8_t frames) {
+  (void)frames;
+  allocFrame(w, h);
+  return fb;
+}
+
+void TFT_eSprite::deleteSprite() {
+  free(fb);
+  fb = nullptr;
+  _width = _height = 0;
+  resetViewport();
+}
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y) {
+  if (fb != nullptr) parent->pushImage(x, y, _width, _height, fb);
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+// ===== HOST STAND-IN: TFT_eSPI =====
+// The panel is an in-memory RGB565 framebuffer. The drawing calls the
+// firmware uses write real pixels (text is drawn with placeholder glyphs of
+// the GLCD font's 6x8 cell), honour the viewport, and count the bytes they
+// would send over SPI (pixels plus an address window per run), so redraw
+// cost can be compared in bus traffic as well as CPU time. DMA transfers
+// complete immediately.
+//
+// TFT_eSprite keeps its pixels byte-swapped like the real library, so a
+// sprite buffer pushed with pushImage() lands on the panel unchanged.
+
+#include <Arduino.h>
+
+#ifndef TFT_WIDTH
+#define TFT_WIDTH  240
+#endif
+#ifndef TFT_HEIGHT
+#define TFT_HEIGHT 320
+#endif
+#ifndef SPI_FREQUENCY
+#define SPI_FREQUENCY 40000000    // Bus clock busMicros() assumes
+#endif
+
+#define TL_DATUM 0
+#define TC_DATUM 1
+#define TR_DATUM 2
+#define ML_DATUM 3
+#define MC_DATUM 4
+#define MR_DATUM 5
+#define BL_DATUM 6
+#define BC_DATUM 7
+#define BR_DATUM 8
+
+#define TFT_BLACK 0x0000
+#define TFT_WHITE 0xFFFF
+
+class TFT_eSPI {
+  public:
+    TFT_eSPI(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT);
+    virtual ~TFT_eSPI();
+
+    void init();
+    void setRotation(uint8_t r);
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+
+    void fillScreen(uint32_t color);
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color);
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color);
+    void drawPixel(int32_t x, int32_t y, uint32_t color);
+    void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color);
+    void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color);
+
+    void setTextColor(uint16_t fg) { textFg = fg; textFill = false; }
+    void setTextColor(uint16_t fg, uint16_t bg) { textFg = fg; textBg = bg; textFill = true; }
+    void setTextDatum(uint8_t d) { textDatum = d; }
+    void setTextSize(uint8_t s) { textSize = s > 0 ? s : 1; }
+    int16_t textWidth(const char *s) const { return 6 * textSize * strlen(s); }
+    int16_t fontHeight() const { return 8 * textSize; }
+    int16_t drawString(const char *s, int32_t x, int32_t y);
+
+    void setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool vpDatum = true);
+    void resetViewport();
+
+    void startWrite() {}
+    void endWrite() {}
+    bool initDMA(bool ctrlCs = false) { (void)ctrlCs; return true; }
+    bool dmaBusy() { return false; }
+    void dmaWait() {}
+    void setSwapBytes(bool swap) { swapBytes = swap; }
+    bool getSwapBytes() const { return swapBytes; }
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data);
+    void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data,
+                      uint16_t *buffer = nullptr);
+
+    // Host only
+    uint16_t readPixel(int32_t x, int32_t y) const;
+    const uint16_t *frame() const { return fb; }
+    uint64_t busBytes() const { return bytesSent; }
+    uint32_t busMicros() const;           // busBytes() at SPI_FREQUENCY
+    bool writePpm(const char *path) const;
+
+  protected:
+    void allocFrame(int16_t w, int16_t h);
+    void span(int32_t x, int32_t y, int32_t w, uint16_t color);
+
+    uint16_t *fb;
+    int16_t _width, _height;
+    int16_t panelW, panelH;               // Rotation 0
+    bool storeSwapped;                    // Sprite memory layout
+    bool countBus;                        // Panel: account SPI traffic
+    uint64_t bytesSent;
+
+    int32_t vpX, vpY, vpW, vpH;           // Clip window
+    int32_t vpOffX, vpOffY;               // Origin shift when vpDatum
+
+    uint16_t textFg, textBg;
+    bool textFill;
+    uint8_t textDatum;
+    uint8_t textSize;
+    bool swapBytes;
+};
+
+class TFT_eSprite : public TFT_eSPI {
+  public:
+    explicit TFT_eSprite(TFT_eSPI *parent);
+
+    void *createSprite(int16_t w, int16_t h, uint8_t frames = 1);
+    void deleteSprite();
+    bool created() const { return fb != nullptr; }
+    void *setColorDepth(int8_t bits) { (void)bits; return fb; }  // 16-bit only
+    void *getPointer() { return fb; }
+    void fillSprite(uint32_t color) { fillRect(0, 0, _width, _height, color); }
+    void pushSprite(int32_t x, int32_t y);
+
+  private:
+    TFT_eSPI *parent;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+// ===== HOST STAND-IN: I2C =====
+// An empty bus: every address NACKs, so probes find no device.
+
+#include <Arduino.h>
+
+class TwoWire {
+  public:
+    bool begin(int sda = -1, int scl = -1, uint32_t freq = 0) {
+      (void)sda; (void)scl; (void)freq;
+      return true;
+    }
+    void setClock(uint32_t freq) { (void)freq; }
+    void beginTransmission(uint8_t address) { (void)address; }
+    uint8_t endTransmission(bool stop = true) { (void)stop; return 2; }  // Address NACK
+    size_t write(uint8_t data) { (void)data; return 1; }
+    uint8_t requestFrom(uint8_t address, uint8_t count) { (void)address; (void)count; return 0; }
+    int available() { return 0; }
+    int read() { return -1; }
+};
+
+extern TwoWire Wire;
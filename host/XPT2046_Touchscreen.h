@@ -0,0 +1,30 @@
+#pragma once
+
+// ===== HOST STAND-IN: XPT2046 RESISTIVE TOUCH =====
+// Reports whatever press() last set, in raw controller units.
+
+#include <Arduino.h>
+#include <SPI.h>
+
+class TS_Point {
+  public:
+    TS_Point() : x(0), y(0), z(0) {}
+    TS_Point(int16_t x, int16_t y, int16_t z) : x(x), y(y), z(z) {}
+    int16_t x, y, z;
+};
+
+class XPT2046_Touchscreen {
+  public:
+    XPT2046_Touchscreen(uint8_t cs, uint8_t tirq = 255) { (void)cs; (void)tirq; }
+    bool begin(SPIClass &spi) { (void)spi; return true; }
+    void setRotation(uint8_t r) { (void)r; }
+    bool touched() { return point.z > 0; }
+    TS_Point getPoint() { return point; }
+
+    // Host only
+    void press(int16_t rawX, int16_t rawY, int16_t z = 1000) { point = TS_Point(rawX, rawY, z); }
+    void release() { point = TS_Point(); }
+
+  private:
+    TS_Point point;
+};
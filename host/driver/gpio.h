@@ -0,0 +1,30 @@
+#pragma once
+
+// ===== HOST STAND-IN: GPIO DRIVER =====
+// The interrupt and wake-up settings the firmware changes around light
+// sleep; they do nothing.
+
+#include <esp_sleep.h>
+
+typedef int gpio_num_t;
+
+typedef enum {
+  GPIO_INTR_DISABLE = 0,
+  GPIO_INTR_POSEDGE,
+  GPIO_INTR_NEGEDGE,
+  GPIO_INTR_ANYEDGE,
+  GPIO_INTR_LOW_LEVEL,
+  GPIO_INTR_HIGH_LEVEL,
+} gpio_int_type_t;
+
+inline esp_err_t gpio_intr_enable(gpio_num_t pin) { (void)pin; return ESP_OK; }
+inline esp_err_t gpio_intr_disable(gpio_num_t pin) { (void)pin; return ESP_OK; }
+inline esp_err_t gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t type) {
+  (void)pin; (void)type;
+  return ESP_OK;
+}
+inline esp_err_t gpio_wakeup_enable(gpio_num_t pin, gpio_int_type_t type) {
+  (void)pin; (void)type;
+  return ESP_OK;
+}
+inline esp_err_t gpio_wakeup_disable(gpio_num_t pin) { (void)pin; return ESP_OK; }
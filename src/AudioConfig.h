@@ -0,0 +1,8 @@
+#pragma once
+
+// ===== AUDIO PIPELINE CONFIGURATION =====
+// Shared by the synth, mixer and PCM cache. Everything downstream of the
+// decoders runs at this fixed mono rate so the I2S clock is never changed.
+#ifndef AUDIO_SAMPLE_RATE
+#define AUDIO_SAMPLE_RATE 22050
+#endif
@@ -0,0 +1,279 @@
+#include "AudioEngine.h"
+#include "HeapStats.h"
+#include "LatencyTrace.h"
+
+AudioEngine *AudioEngine::instance = nullptr;
+
+AudioEngine::AudioEngine() {
+  mixer = nullptr;
+  cache = nullptr;
+  mixHandle = outputHandle = nullptr;
+  posted = 0;
+  processed = 0;
+  for (int i = 0; i < MIXER_VOICES; i++) playingTags[i] = -1;
+  activeVoices = 0;
+  commandDrops = eventDrops = 0;
+  mixMicrosMax = 0;
+}
+
+bool AudioEngine::begin(AudioOutput *sink, AudioMixer *m, PcmCache *c) {
+  if (sink == nullptr || m == nullptr) return false;
+  ringOut.setSink(sink);
+  mixer = m;
+  cache = c;
+  instance = this;
+  mixer->setVoiceEndCallback(onVoiceEnd);
+  mixer->setVoiceStartCallback(onVoiceStart);
+
+  if (xTaskCreatePinnedToCore(mixTask, "audioMix", AUDIO_MIX_TASK_STACK, this,
+                              AUDIO_MIX_TASK_PRIORITY, &mixHandle, AUDIO_TASK_CORE) != pdPASS ||
+      xTaskCreatePinnedToCore(outputTask, "audioOut", AUDIO_OUTPUT_TASK_STACK, this,
+                              AUDIO_OUTPUT_TASK_PRIORITY, &outputHandle, AUDIO_TASK_CORE) != pdPASS) {
+    Serial.println("ERROR: Could not start audio tasks");
+    return false;
+  }
+  Serial.printf("Audio tasks on core %d, ring %d samples (%d ms)\n", AUDIO_TASK_CORE,
+                AUDIO_RING_SAMPLES, AUDIO_RING_SAMPLES * 1000 / AUDIO_SAMPLE_RATE);
+  return true;
+}
+
+// ===== COMMANDS (UI side) =====
+bool AudioEngine::post(AudioCommand &cmd) {
+  if (!commands.push(cmd)) {
+    commandDrops++;
+    return false;
+  }
+  posted++;
+  if (mixHandle != nullptr) xTaskNotifyGive(mixHandle);
+  return true;
+}
+
+// A zeroed command of the type, for tag
+static AudioCommand command(uint8_t type, int tag = 0) {
+  AudioCommand cmd = {};
+  cmd.type = type;
+  cmd.tag = (int16_t)tag;
+  return cmd;
+}
+
+static void setPath(AudioCommand &cmd, const char *path, const WavTrim *trim) {
+  strncpy(cmd.path, path, PCM_CACHE_PATH_LEN - 1);
+  cmd.path[PCM_CACHE_PATH_LEN - 1] = '\0';
+  cmd.trim.startFrame = trim ? trim->startFrame : 0;
+  cmd.trim.endFrame = trim ? trim->endFrame : 0;
+}
+
+bool AudioEngine::playFile(int tag, const char *path, uint16_t gain, const WavTrim *trim) {
+  AudioCommand cmd = command(AUDIO_CMD_PLAY_FILE, tag);
+  cmd.gain = gain;
+  setPath(cmd, path, trim);
+  return post(cmd);
+}
+
+bool AudioEngine::playSynth(int tag, const SynthPreset *preset, uint16_t gain) {
+  AudioCommand cmd = command(AUDIO_CMD_PLAY_SYNTH, tag);
+  cmd.gain = gain;
+  cmd.preset = preset;
+  return post(cmd);
+}
+
+bool AudioEngine::queueFile(int tag, const char *path, uint16_t gain, const WavTrim *trim,
+                            uint32_t gap) {
+  AudioCommand cmd = command(AUDIO_CMD_QUEUE_FILE, tag);
+  cmd.gain = gain;
+  setPath(cmd, path, trim);
+  cmd.gap = gap;
+  return post(cmd);
+}
+
+bool AudioEngine::queueSynth(int tag, const SynthPreset *preset, uint16_t gain, uint32_t gap) {
+  AudioCommand cmd = command(AUDIO_CMD_QUEUE_SYNTH, tag);
+  cmd.gain = gain;
+  cmd.preset = preset;
+  cmd.gap = gap;
+  return post(cmd);
+}
+
+bool AudioEngine::stop(int tag) {
+  AudioCommand cmd = command(AUDIO_CMD_STOP, tag);
+  return post(cmd);
+}
+
+bool AudioEngine::stopAll() {
+  AudioCommand cmd = command(AUDIO_CMD_STOP_ALL);
+  return post(cmd);
+}
+
+bool AudioEngine::setVolume(uint16_t gain) {
+  AudioCommand cmd = command(AUDIO_CMD_VOLUME);
+  cmd.gain = gain;
+  return post(cmd);
+}
+
+bool AudioEngine::requestCache(int tag, const char *path, const WavTrim *trim) {
+  AudioCommand cmd = command(AUDIO_CMD_CACHE_REQUEST, tag);
+  setPath(cmd, path, trim);
+  return post(cmd);
+}
+
+bool AudioEngine::invalidateCache(int tag) {
+  AudioCommand cmd = command(AUDIO_CMD_CACHE_INVALIDATE, tag);
+  return post(cmd);
+}
+
+bool AudioEngine::runBenchmark() {
+  AudioCommand cmd = command(AUDIO_CMD_BENCHMARK);
+  return post(cmd);
+}
+
+bool AudioEngine::isPlaying(int tag) const {
+  if (tag < 0) return false;
+  for (int i = 0; i < MIXER_VOICES; i++) {
+    if (playingTags[i].load() == tag) return true;
+  }
+  return false;
+}
+
+bool AudioEngine::isBusy() const {
+  return processed.load(std::memory_order_acquire) != posted ||
+         activeVoices.load() > 0 || ringOut.isRunning();
+}
+
+// ===== MIXER TASK =====
+void AudioEngine::mixTask(void *arg) {
+  ((AudioEngine *)arg)->mixLoop();
+}
+
+void AudioEngine::postEvent(uint8_t type, int tag) {
+  // One slot per playing sound, so any tag (sound index) can be tracked. A
+  // retriggered sound starts again without ending, and a sequence can
+  // start a sound another voice still plays, so a start takes a slot only
+  // for a new tag, and an end frees it once no voice plays the tag.
+  bool track = tag >= 0 && (type == AUDIO_EVENT_START ? !isPlaying(tag) : !mixer->isPlaying(tag));
+  int16_t match = type == AUDIO_EVENT_START ? -1 : tag;
+  for (int i = 0; i < MIXER_VOICES && track; i++) {
+    if (playingTags[i].load() == match) {
+      playingTags[i].store(type == AUDIO_EVENT_START ? tag : -1);
+      break;
+    }
+  }
+  AudioEvent ev = {type, (int16_t)tag};
+  if (!events.push(ev)) eventDrops++;
+}
+
+// Runs in the mixer task (voice finished, stolen or stopped)
+void AudioEngine::onVoiceEnd(int tag) {
+  instance->postEvent(AUDIO_EVENT_END, tag);
+}
+
+// Runs in the mixer task (a sequence item started, possibly mid-block)
+void AudioEngine::onVoiceStart(int tag) {
+  instance->postEvent(AUDIO_EVENT_START, tag);
+}
+
+void AudioEngine::runCommand(const AudioCommand &cmd) {
+  int voice;
+  uint32_t allocs;
+  switch (cmd.type) {
+    case AUDIO_CMD_PLAY_FILE:
+      latencyTrace.mark(TRACE_MIX_COMMAND);
+      allocs = heapAllocations();
+      voice = mixer->playFile(cmd.tag, cmd.path, cmd.gain, &cmd.trim);
+      heapStats.recordPlay(heapAllocations() - allocs);
+      postEvent(voice >= 0 ? AUDIO_EVENT_START : AUDIO_EVENT_END, cmd.tag);
+      break;
+    case AUDIO_CMD_PLAY_SYNTH:
+      latencyTrace.mark(TRACE_MIX_COMMAND);
+      allocs = heapAllocations();
+      voice = mixer->playSynth(cmd.tag, cmd.preset, cmd.gain);
+      heapStats.recordPlay(heapAllocations() - allocs);
+      postEvent(voice >= 0 ? AUDIO_EVENT_START : AUDIO_EVENT_END, cmd.tag);
+      break;
+    case AUDIO_CMD_QUEUE_FILE:
+      // The mixer posts the start itself, when the item's turn comes
+      if (!mixer->queueFile(cmd.tag, cmd.path, cmd.gain, &cmd.trim, cmd.gap)) {
+        postEvent(AUDIO_EVENT_END, cmd.tag);
+      }
+      break;
+    case AUDIO_CMD_QUEUE_SYNTH:
+      if (!mixer->queueSynth(cmd.tag, cmd.preset, cmd.gain, cmd.gap)) {
+        postEvent(AUDIO_EVENT_END, cmd.tag);
+      }
+      break;
+    case AUDIO_CMD_STOP:
+      mixer->stopTag(cmd.tag);
+      break;
+    case AUDIO_CMD_STOP_ALL:
+      mixer->stopAll();
+      break;
+    case AUDIO_CMD_VOLUME:
+      mixer->setMasterGain(cmd.gain);
+      break;
+    case AUDIO_CMD_CACHE_REQUEST:
+      if (cache != nullptr) cache->request(cmd.tag, cmd.path, &cmd.trim);
+      break;
+    case AUDIO_CMD_CACHE_INVALIDATE:
+      if (cache != nullptr) cache->invalidate(cmd.tag);
+      break;
+    case AUDIO_CMD_BENCHMARK:
+      mixer->benchmark();
+      break;
+  }
+}
+
+void AudioEngine::mixLoop() {
+  for (;;) {
+    AudioCommand cmd;
+    while (commands.pop(cmd)) {
+      runCommand(cmd);
+      activeVoices.store(mixer->activeVoices());
+      processed.fetch_add(1, std::memory_order_release);
+    }
+
+    // Render until the ring is full (or every voice has ended)
+    uint32_t allocs = heapAllocations();
+    uint32_t t0 = micros();
+    bool active = mixer->loop();
+    uint32_t dt = micros() - t0;
+    if (dt > mixMicrosMax) mixMicrosMax = dt;
+    activeVoices.store(mixer->activeVoices());
+
+    if (cache != nullptr) cache->service();
+    heapStats.recordPass(heapAllocations() - allocs);
+
+    // Sleep until the output frees room or a command arrives; keep ticking
+    // while playing or while cache heads are still being decoded
+    bool work = active || (cache != nullptr && !cache->idle());
+    ulTaskNotifyTake(pdTRUE, work ? 1 : portMAX_DELAY);
+  }
+}
+
+// ===== OUTPUT TASK =====
+void AudioEngine::outputTask(void *arg) {
+  ((AudioEngine *)arg)->outputLoop();
+}
+
+void AudioEngine::outputLoop() {
+  for (;;) {
+    if (ringOut.drain() > 0 && ringOut.space() >= MIXER_BLOCK_SAMPLES) {
+      xTaskNotifyGive(mixHandle);  // Room for another block
+    }
+    vTaskDelay(1);
+  }
+}
+
+// ===== STATISTICS =====
+void AudioEngine::printStats() {
+  uint32_t minFill = ringOut.minFill();
+  Serial.printf("Audio: ring %d samples, fill %u now, worst %u (%u ms of %d ms)\n",
+                AUDIO_RING_SAMPLES, (uint32_t)ringOut.fill(), minFill,
+                minFill * 1000 / AUDIO_SAMPLE_RATE, AUDIO_RING_SAMPLES * 1000 / AUDIO_SAMPLE_RATE);
+  Serial.printf("  Underruns: %u, output starts: %u, longest mixer pass: %u us\n",
+                ringOut.underruns(), ringOut.sinkStarts(), mixMicrosMax);
+  Serial.printf("  Dropped: %u commands, %u events; stack free: mix %u, out %u bytes\n",
+                commandDrops, eventDrops,
+                (uint32_t)uxTaskGetStackHighWaterMark(mixHandle),
+                (uint32_t)uxTaskGetStackHighWaterMark(outputHandle));
+  ringOut.resetStats();
+  mixMicrosMax = 0;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "AudioConfig.h"
+#include "AudioMixer.h"
+#include "AudioOutputRing.h"
+#include "PcmCache.h"
+#include "SpscRing.h"
+
+// ===== AUDIO ENGINE =====
+// Runs the decode/mix pipeline in two FreeRTOS tasks pinned to the core
+// that does not run loop(), so touch polling, serial output and TFT redraws
+// can no longer starve the I2S DMA:
+//
+//   mixer task   executes commands, renders the mixer into an
+//                AudioOutputRing and services the PCM cache
+//   output task  drains the ring into the I2S output every tick
+//
+// The UI side only posts commands and reads back events and a few status
+// words. Commands and events travel through SPSC rings, so every post and
+// poll must come from loop() (the single UI producer/consumer).
+
+#ifndef AUDIO_TASK_CORE
+#define AUDIO_TASK_CORE 0           // Arduino's loop() runs on core 1
+#endif
+#define AUDIO_MIX_TASK_PRIORITY     4
+#define AUDIO_OUTPUT_TASK_PRIORITY  5
+#define AUDIO_MIX_TASK_STACK        6144
+#define AUDIO_OUTPUT_TASK_STACK     2048
+#define AUDIO_COMMAND_QUEUE         16
+#define AUDIO_EVENT_QUEUE           32
+
+enum AudioCommandType : uint8_t {
+  AUDIO_CMD_PLAY_FILE = 0,
+  AUDIO_CMD_PLAY_SYNTH,
+  AUDIO_CMD_STOP,
+  AUDIO_CMD_STOP_ALL,
+  AUDIO_CMD_VOLUME,
+  AUDIO_CMD_CACHE_REQUEST,
+  AUDIO_CMD_CACHE_INVALIDATE,
+  AUDIO_CMD_BENCHMARK,
+  AUDIO_CMD_QUEUE_FILE,
+  AUDIO_CMD_QUEUE_SYNTH,
+};
+
+struct AudioCommand {
+  uint8_t type;
+  int16_t tag;
+  uint16_t gain;                    // Q15
+  const SynthPreset *preset;
+  WavTrim trim;
+  char path[PCM_CACHE_PATH_LEN];
+  uint32_t gap;                     // Sequence items: output samples after the previous one
+};
+
+enum AudioEventType : uint8_t {
+  AUDIO_EVENT_START = 0,            // A voice started playing tag (a tap or a sequence item)
+  AUDIO_EVENT_END,                  // tag finished, was stolen or failed to start
+};
+
+struct AudioEvent {
+  uint8_t type;
+  int16_t tag;
+};
+
+class AudioEngine {
+  public:
+    AudioEngine();
+
+    // The output the mixer must be begun with (before begin() is called)
+    AudioOutput *output() { return &ringOut; }
+
+    // Start the tasks; sink is the real output (e.g. AudioOutputI2S)
+    bool begin(AudioOutput *sink, AudioMixer *mixer, PcmCache *cache);
+
+    // UI side: post a command. Returns false if the queue is full.
+    bool playFile(int tag, const char *path, uint16_t gain, const WavTrim *trim = nullptr);
+    bool playSynth(int tag, const SynthPreset *preset, uint16_t gain);
+    // Append to the gapless sequence (see AudioMixer); gap in output samples
+    bool queueFile(int tag, const char *path, uint16_t gain, const WavTrim *trim, uint32_t gap);
+    bool queueSynth(int tag, const SynthPreset *preset, uint16_t gain, uint32_t gap);
+    bool stop(int tag);
+    bool stopAll();
+    bool setVolume(uint16_t gain);
+    bool requestCache(int tag, const char *path, const WavTrim *trim = nullptr);
+    bool invalidateCache(int tag);
+    bool runBenchmark();
+
+    // UI side: next voice start/end event, if any
+    bool pollEvent(AudioEvent &event) { return events.pop(event); }
+
+    // Tag playing, as of the last processed command or voice end
+    bool isPlaying(int tag) const;
+
+    // Commands pending, voices playing, or the output still draining
+    bool isBusy() const;
+
+    // Voices playing, as of the last processed command or mixer pass
+    int voicesPlaying() const { return activeVoices.load(); }
+
+    // Print ring/underrun/task statistics and start a new measurement window
+    void printStats();
+
+  private:
+    static void mixTask(void *arg);
+    static void outputTask(void *arg);
+    static void onVoiceEnd(int tag);
+    static void onVoiceStart(int tag);
+
+    bool post(AudioCommand &cmd);
+    void runCommand(const AudioCommand &cmd);
+    void postEvent(uint8_t type, int tag);
+    void mixLoop();
+    void outputLoop();
+
+    static AudioEngine *instance;
+
+    AudioMixer *mixer;
+    PcmCache *cache;
+    AudioOutputRing ringOut;
+    TaskHandle_t mixHandle;
+    TaskHandle_t outputHandle;
+
+    SpscRing<AudioCommand, AUDIO_COMMAND_QUEUE> commands;
+    SpscRing<AudioEvent, AUDIO_EVENT_QUEUE> events;
+    uint32_t posted;                      // Written by the UI only
+    std::atomic<uint32_t> processed;      // Written by the mixer task only
+    std::atomic<int16_t> playingTags[MIXER_VOICES];  // -1 = free; mixer task writes
+    std::atomic<int> activeVoices;
+
+    uint32_t commandDrops;
+    volatile uint32_t eventDrops;
+    volatile uint32_t mixMicrosMax;       // Longest mixer pass (render + SD reads)
+};
@@ -0,0 +1,191 @@
+#include "AudioFileSourceBank.h"
+
+static uint16_t readLE16(const uint8_t *p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t readLE32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void writeLE16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void writeLE32(uint8_t *p, uint32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = (v >> (8 * i)) & 0xFF;
+}
+
+// ===== SOUND BANK =====
+SoundBank::SoundBank() {
+  opened = false;
+  entryCount = 0;
+  version = 0;
+  entrySize = BANK_ENTRY_SIZE;
+  rate = 0;
+  tableOffset = 0;
+  stringsOffset = 0;
+  filePos = 0;
+}
+
+bool SoundBank::open(fs::FS &fs, const char *path) {
+  file = fs.open(path, FILE_READ);
+  if (!file) return false;
+
+  uint8_t h[BANK_HEADER_SIZE];
+  if (file.read(h, sizeof(h)) != sizeof(h) || memcmp(h, BANK_MAGIC, 4) != 0) {
+    Serial.printf("ERROR: %s is not a sound bank\n", path);
+    file.close();
+    return false;
+  }
+  version = readLE16(h + 4);
+  uint16_t bits = readLE16(h + 12);
+  uint16_t channels = readLE16(h + 14);
+  if (version < 1 || version > BANK_VERSION || bits != 16 || channels != 1) {
+    Serial.printf("ERROR: Unsupported bank v%u (%u bit, %u ch)\n", version, bits, channels);
+    file.close();
+    return false;
+  }
+  entryCount = readLE16(h + 6);
+  rate = readLE32(h + 8);
+  tableOffset = readLE32(h + 16);
+  stringsOffset = readLE32(h + 20);
+  entrySize = version >= 2 ? BANK_ENTRY_SIZE + WAV_THUMB_COLUMNS : BANK_ENTRY_SIZE;
+  filePos = file.position();
+  opened = true;
+
+  Serial.printf("Sound bank %s: %d sounds @ %u Hz%s\n", path, entryCount, rate,
+                version < 2 ? " (v1: no thumbnails, rebuild with tools/build_bank.py)" : "");
+  return true;
+}
+
+bool SoundBank::entry(int index, SoundBankEntry &e) {
+  uint8_t raw[BANK_ENTRY_SIZE];
+  if (index < 0 || index >= entryCount ||
+      read(tableOffset + index * entrySize, raw, sizeof(raw)) != sizeof(raw)) {
+    return false;
+  }
+  e.dataOffset = readLE32(raw);
+  e.dataSize = readLE32(raw + 4);
+  e.titleOffset = readLE32(raw + 8);
+  e.titleLen = readLE16(raw + 12);
+  e.flags = readLE16(raw + 14);
+  memcpy(e.filename, raw + 16, BANK_NAME_LEN);
+  e.filename[BANK_NAME_LEN - 1] = '\0';
+  return true;
+}
+
+bool SoundBank::thumb(int index, WavThumb &t) {
+  SoundBankEntry e;
+  if (!entry(index, e)) return false;
+  memset(&t, 0, sizeof(t));
+  t.durationMs = (uint64_t)e.dataSize / 2 * 1000 / rate;
+  if (version < 2) return true;
+  return read(tableOffset + index * entrySize + BANK_ENTRY_SIZE, t.wave, sizeof(t.wave)) ==
+         sizeof(t.wave);
+}
+
+int SoundBank::find(const char *filename) {
+  if (filename[0] == '/') filename++;
+  SoundBankEntry e;
+  for (int i = 0; i < entryCount && entry(i, e); i++) {
+    if (strcasecmp(e.filename, filename) == 0) return i;
+  }
+  return -1;
+}
+
+bool SoundBank::readTitle(const SoundBankEntry &e, char *dst, size_t len) {
+  if (len == 0) return false;
+  size_t n = e.titleLen < len - 1 ? e.titleLen : len - 1;
+  n = read(stringsOffset + e.titleOffset, dst, n);
+  dst[n] = '\0';
+  return true;
+}
+
+uint32_t SoundBank::read(uint32_t offset, void *dst, uint32_t len) {
+  if (offset != filePos) {
+    if (!file.seek(offset)) return 0;
+    filePos = offset;
+  }
+  uint32_t got = file.read((uint8_t *)dst, len);
+  filePos += got;
+  return got;
+}
+
+// ===== BANK FILE SOURCE =====
+AudioFileSourceBank::AudioFileSourceBank() {
+  bank = nullptr;
+  opened = false;
+  dataOffset = dataSize = pos = 0;
+}
+
+bool AudioFileSourceBank::open(const char *filename) {
+  opened = false;
+  if (bank == nullptr || !bank->isOpen()) return false;
+  int index = filename[0] == '#' ? atoi(filename + 1) : bank->find(filename);
+  SoundBankEntry e;
+  if (!bank->entry(index, e)) return false;
+
+  dataOffset = e.dataOffset;
+  dataSize = e.dataSize;
+  pos = 0;
+
+  // Canonical PCM header describing the bank's mono 16-bit data
+  uint32_t rate = bank->sampleRate();
+  memcpy(header, "RIFF", 4);
+  writeLE32(header + 4, 36 + dataSize);
+  memcpy(header + 8, "WAVEfmt ", 8);
+  writeLE32(header + 16, 16);
+  writeLE16(header + 20, 1);         // PCM
+  writeLE16(header + 22, 1);         // Mono
+  writeLE32(header + 24, rate);
+  writeLE32(header + 28, rate * 2);  // Byte rate
+  writeLE16(header + 32, 2);         // Block align
+  writeLE16(header + 34, 16);        // Bits per sample
+  memcpy(header + 36, "data", 4);
+  writeLE32(header + 40, dataSize);
+
+  opened = true;
+  return true;
+}
+
+uint32_t AudioFileSourceBank::read(void *data, uint32_t len) {
+  if (!opened) return 0;
+  uint8_t *dst = (uint8_t *)data;
+  uint32_t done = 0;
+
+  if (pos < sizeof(header)) {
+    uint32_t n = sizeof(header) - pos;
+    if (n > len) n = len;
+    memcpy(dst, header + pos, n);
+    pos += n;
+    done += n;
+  }
+
+  uint32_t end = sizeof(header) + dataSize;
+  if (done < len && pos < end) {
+    uint32_t n = len - done;
+    if (n > end - pos) n = end - pos;
+    uint32_t got = bank->read(dataOffset + pos - sizeof(header), dst + done, n);
+    pos += got;
+    done += got;
+  }
+  return done;
+}
+
+bool AudioFileSourceBank::seek(int32_t offset, int dir) {
+  int32_t target;
+  if (dir == SEEK_SET) target = offset;
+  else if (dir == SEEK_CUR) target = (int32_t)pos + offset;
+  else if (dir == SEEK_END) target = (int32_t)getSize() + offset;
+  else return false;
+  if (target < 0 || (uint32_t)target > getSize()) return false;
+  pos = target;
+  return true;
+}
+
+bool AudioFileSourceBank::close() {
+  opened = false;
+  return true;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include "AudioFileSource.h"
+#include "WavParser.h"
+
+// ===== SOUND BANK =====
+// Reader for the packed bank built by tools/build_bank.py: one file with a
+// sector-aligned table of sounds whose sample data is already mono 16-bit
+// PCM at the device output rate. The bank is opened once at boot and every
+// voice reads from that single handle, so playing a sound needs no FAT
+// lookup, no file open and no header parse from the card. Version 2 banks
+// append each sound's thumbnail envelope to its table entry; version 1
+// banks still play, with duration-only thumbnails.
+
+#define BANK_MAGIC       "SBNK"
+#define BANK_VERSION     2
+#define BANK_NAME_LEN    16
+#define BANK_HEADER_SIZE 28
+#define BANK_ENTRY_SIZE  32      // Version 1; version 2 adds WAV_THUMB_COLUMNS
+
+struct SoundBankEntry {
+  uint32_t dataOffset;     // Sector-aligned offset of the PCM data
+  uint32_t dataSize;
+  uint32_t titleOffset;    // Into the string table
+  uint16_t titleLen;
+  uint16_t flags;
+  char filename[BANK_NAME_LEN];
+};
+
+class SoundBank {
+  public:
+    SoundBank();
+    bool open(fs::FS &fs, const char *path);
+    bool isOpen() const { return opened; }
+
+    int count() const { return entryCount; }
+    uint32_t sampleRate() const { return rate; }
+    // Entries are read from the card on demand, one table read each, so
+    // the bank's size does not cost RAM
+    bool entry(int index, SoundBankEntry &e);
+    int find(const char *filename);   // Linear scan of the table
+    bool readTitle(const SoundBankEntry &e, char *dst, size_t len);
+    // Duration and, from a version 2 bank, the envelope of entry `index`
+    bool thumb(int index, WavThumb &t);
+
+    // Read from the shared handle; seeks only when the position differs
+    uint32_t read(uint32_t offset, void *dst, uint32_t len);
+
+  private:
+    fs::File file;
+    bool opened;
+    int entryCount;
+    uint16_t version;
+    uint16_t entrySize;
+    uint32_t rate;
+    uint32_t tableOffset;
+    uint32_t stringsOffset;
+    uint32_t filePos;
+};
+
+// ===== BANK FILE SOURCE =====
+// AudioFileSource over one bank entry. A canonical 44-byte WAV header is
+// synthesized in RAM in front of the data, so the mixer and PCM cache use
+// the bank exactly like a WAV file. open() takes "#<n>" for entry n (the
+// catalog's paths, no table search) or the sound's filename as listed in
+// index.csv (a leading '/' is ignored).
+class AudioFileSourceBank : public AudioFileSource {
+  public:
+    AudioFileSourceBank();
+    void setBank(SoundBank *b) { bank = b; }
+
+    virtual bool open(const char *filename) override;
+    virtual uint32_t read(void *data, uint32_t len) override;
+    virtual bool seek(int32_t pos, int dir) override;
+    virtual bool close() override;
+    virtual bool isOpen() override { return opened; }
+    virtual uint32_t getSize() override { return sizeof(header) + dataSize; }
+    virtual uint32_t getPos() override { return pos; }
+
+  private:
+    SoundBank *bank;
+    bool opened;
+    uint32_t dataOffset;
+    uint32_t dataSize;
+    uint32_t pos;            // Includes the synthesized header
+    uint8_t header[44];
+};
@@ -0,0 +1,235 @@
+#include "AudioFileSourceReadAhead.h"
+
+TaskHandle_t AudioFileSourceReadAhead::reader = nullptr;
+SpscRing<AudioFileSourceReadAhead::Block *, READAHEAD_QUEUE> AudioFileSourceReadAhead::requests;
+
+std::atomic<uint32_t> AudioFileSourceReadAhead::statBytes(0);
+std::atomic<uint32_t> AudioFileSourceReadAhead::statReads(0);
+std::atomic<uint32_t> AudioFileSourceReadAhead::statReadMicros(0);
+std::atomic<uint32_t> AudioFileSourceReadAhead::statReadMicrosMax(0);
+uint32_t AudioFileSourceReadAhead::statStalls = 0;
+uint32_t AudioFileSourceReadAhead::statStallMicros = 0;
+uint32_t AudioFileSourceReadAhead::statSyncReads = 0;
+uint32_t AudioFileSourceReadAhead::statReopens = 0;
+uint32_t AudioFileSourceReadAhead::statWindowStart = 0;
+
+AudioFileSourceReadAhead::AudioFileSourceReadAhead() {
+  opened = false;
+  size = pos = filePos = 0;
+  heldPath[0] = '\0';
+  for (int i = 0; i < 2; i++) {
+    blocks[i].owner = this;
+    blocks[i].data = nullptr;
+    blocks[i].offset = blocks[i].len = 0;
+    blocks[i].state = BLOCK_EMPTY;
+  }
+}
+
+// ===== READER TASK =====
+bool AudioFileSourceReadAhead::startReader(int core) {
+  if (reader != nullptr) return true;
+  statWindowStart = millis();
+  if (xTaskCreatePinnedToCore(readerTask, "sdRead", READAHEAD_TASK_STACK, nullptr,
+                              READAHEAD_TASK_PRIORITY, &reader, core) != pdPASS) {
+    reader = nullptr;
+    Serial.println("ERROR: Could not start SD read-ahead task");
+    return false;
+  }
+  return true;
+}
+
+void AudioFileSourceReadAhead::readerTask(void *arg) {
+  (void)arg;
+  for (;;) {
+    Block *b;
+    while (requests.pop(b)) {
+      b->owner->loadBlock(*b, b->offset);
+      b->state.store(BLOCK_READY, std::memory_order_release);
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+}
+
+void AudioFileSourceReadAhead::recordRead(uint32_t bytes, uint32_t us) {
+  statBytes.fetch_add(bytes);
+  statReads.fetch_add(1);
+  statReadMicros.fetch_add(us);
+  if (us > statReadMicrosMax.load()) statReadMicrosMax.store(us);
+}
+
+// Read one block from the card. Runs in the reader task for prefetches and
+// in the caller's task for synchronous loads, never both for one file.
+void AudioFileSourceReadAhead::loadBlock(Block &b, uint32_t offset) {
+  uint32_t t0 = micros();
+  b.offset = offset;
+  b.len = 0;
+  if (filePos == offset || file.seek(offset)) {
+    b.len = file.read(b.data, READAHEAD_BLOCK);
+    filePos = offset + b.len;
+  } else {
+    filePos = UINT32_MAX;  // Unknown; the next load seeks
+  }
+  recordRead(b.len, micros() - t0);
+}
+
+// ===== FILE SOURCE =====
+bool AudioFileSourceReadAhead::reserve() {
+  if (blocks[0].data != nullptr) return true;
+  uint8_t *buf = (uint8_t *)malloc(2 * READAHEAD_BLOCK);
+  if (buf == nullptr) {
+    Serial.println("ERROR: Read-ahead buffer allocation failed");
+    return false;
+  }
+  blocks[0].data = buf;
+  blocks[1].data = buf + READAHEAD_BLOCK;
+  return true;
+}
+
+bool AudioFileSourceReadAhead::open(const char *filename) {
+  close();
+  if (!reserve()) return false;
+  pos = 0;
+
+  // The file this source last played: still open, blocks still valid
+  if (heldPath[0] != '\0' && strcmp(heldPath, filename) == 0) {
+    statReopens++;
+    opened = true;
+    return true;
+  }
+
+  release();
+  file = SD.open(filename, FILE_READ);
+  if (!file) return false;
+  size = file.size();
+  filePos = 0;
+  if (strlen(filename) < READAHEAD_PATH_LEN) strcpy(heldPath, filename);
+  opened = true;
+  return true;
+}
+
+// Wait until the reader task holds none of this source's blocks
+void AudioFileSourceReadAhead::waitIdle() {
+  uint32_t t0 = micros();
+  bool waited = false;
+  for (int i = 0; i < 2; i++) {
+    while (blocks[i].state.load(std::memory_order_acquire) == BLOCK_QUEUED) {
+      waited = true;
+      vTaskDelay(1);
+    }
+  }
+  if (waited) {
+    statStalls++;
+    statStallMicros += micros() - t0;
+  }
+}
+
+AudioFileSourceReadAhead::Block *AudioFileSourceReadAhead::blockFor(uint32_t offset) {
+  uint32_t base = offset - offset % READAHEAD_BLOCK;
+  Block &b = blocks[(base / READAHEAD_BLOCK) & 1];
+
+  if (b.state.load(std::memory_order_acquire) == BLOCK_QUEUED) {
+    waitIdle();  // Prefetch in flight; for this block unless we just seeked
+  }
+  if (b.state.load(std::memory_order_relaxed) == BLOCK_READY && b.offset == base) return &b;
+
+  // Not prefetched (first read or after a seek): load it here
+  waitIdle();
+  loadBlock(b, base);
+  b.state.store(BLOCK_READY, std::memory_order_relaxed);
+  statSyncReads++;
+  return &b;
+}
+
+// Queue the block at offset into its buffer unless it is there already
+void AudioFileSourceReadAhead::prefetch(uint32_t offset) {
+  if (reader == nullptr || offset >= size) return;
+  Block &b = blocks[(offset / READAHEAD_BLOCK) & 1];
+  uint8_t state = b.state.load(std::memory_order_acquire);
+  if (state == BLOCK_QUEUED || (state == BLOCK_READY && b.offset == offset)) return;
+
+  b.offset = offset;
+  b.state.store(BLOCK_QUEUED, std::memory_order_release);
+  if (!requests.push(&b)) {
+    b.state.store(BLOCK_EMPTY, std::memory_order_relaxed);  // Loaded on demand instead
+    return;
+  }
+  xTaskNotifyGive(reader);
+}
+
+uint32_t AudioFileSourceReadAhead::read(void *data, uint32_t len) {
+  if (!opened) return 0;
+  uint8_t *dst = (uint8_t *)data;
+  uint32_t done = 0;
+
+  while (done < len && pos < size) {
+    Block *b = blockFor(pos);
+    if (pos >= b->offset + b->len) break;  // Short read from the card
+
+    uint32_t n = b->offset + b->len - pos;
+    if (n > len - done) n = len - done;
+    memcpy(dst + done, b->data + (pos - b->offset), n);
+    pos += n;
+    done += n;
+
+    // Consuming this buffer; refill the other one with what follows
+    prefetch(b->offset + READAHEAD_BLOCK);
+  }
+  return done;
+}
+
+bool AudioFileSourceReadAhead::seek(int32_t offset, int dir) {
+  if (!opened) return false;
+  int32_t target;
+  if (dir == SEEK_SET) target = offset;
+  else if (dir == SEEK_CUR) target = (int32_t)pos + offset;
+  else if (dir == SEEK_END) target = (int32_t)size + offset;
+  else return false;
+  if (target < 0 || (uint32_t)target > size) return false;
+  pos = target;  // Blocks are (re)loaded lazily by the next read
+  return true;
+}
+
+bool AudioFileSourceReadAhead::close() {
+  if (!opened) return true;
+  waitIdle();
+  opened = false;
+  if (heldPath[0] == '\0') release();  // Path too long to hold
+  return true;
+}
+
+// Close the file for real (the reader is idle: close() waited for it)
+void AudioFileSourceReadAhead::release() {
+  if (file) file.close();
+  heldPath[0] = '\0';
+  blocks[0].state = blocks[1].state = BLOCK_EMPTY;
+}
+
+// ===== STATISTICS =====
+void AudioFileSourceReadAhead::printStats() {
+  uint32_t ms = millis() - statWindowStart;
+  if (ms == 0) ms = 1;
+  uint32_t bytes = statBytes.load();
+  uint32_t reads = statReads.load();
+  uint32_t readUs = statReadMicros.load();
+
+  // Throughput while the card is actually transferring, against the rate
+  // one 44.1 kHz 16-bit stereo voice consumes (176400 B/s)
+  uint32_t peakKBs = readUs ? (uint32_t)((uint64_t)bytes * 1000000 / readUs / 1024) : 0;
+  uint32_t busy = readUs / (ms * 10);
+
+  Serial.printf("SD read-ahead: %u KB/s over %u ms, %u reads (%u KB blocks)\n",
+                (uint32_t)((uint64_t)bytes * 1000 / ms / 1024), ms, reads, READAHEAD_BLOCK / 1024);
+  Serial.printf("  Read latency avg %u us (max %u), card busy %u%%\n",
+                reads ? readUs / reads : 0, statReadMicrosMax.load(), busy);
+  Serial.printf("  Card delivers %u KB/s when reading: room for ~%u stereo 44.1 kHz voices\n",
+                peakKBs, peakKBs * 1024 / 176400);
+  Serial.printf("  Stalls: %u (%u ms waiting), loads after seeks: %u, held-file reopens: %u\n",
+                statStalls, statStallMicros / 1000, statSyncReads, statReopens);
+
+  statBytes = 0;
+  statReads = 0;
+  statReadMicros = 0;
+  statReadMicrosMax = 0;
+  statStalls = statStallMicros = statSyncReads = statReopens = 0;
+  statWindowStart = millis();
+}
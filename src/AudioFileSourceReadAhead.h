@@ -0,0 +1,103 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SD.h>
+#include <atomic>
+#include "AudioFileSource.h"
+#include "SpscRing.h"
+
+// ===== READ-AHEAD SD FILE SOURCE =====
+// Drop-in replacement for AudioFileSourceSD that turns the decoders' small
+// reads into few large ones. Each source owns two READAHEAD_BLOCK buffers
+// at block-aligned (so sector-aligned) file offsets: while one is being
+// consumed, the other is refilled with the next block by a shared
+// low-priority reader task, so SPI transfers overlap with mixing instead of
+// happening inside it.
+//
+// A read that finds its block not ready yet waits for the reader (a stall)
+// or, after a seek, reads the block itself. All sources must be used from a
+// single task (the audio engine's mixer task); the reader task is the only
+// other party and touches a file only while it owns one of its blocks.
+//
+// close() keeps the file open, and open() of the same path takes it back
+// with whatever its blocks still hold: replaying a sound needs no FS open
+// (nor the heap allocations that come with one) and usually no card read.
+
+#ifndef READAHEAD_BLOCK
+#define READAHEAD_BLOCK 4096        // Bytes per buffer; multiple of 512
+#endif
+#define READAHEAD_QUEUE        8
+#define READAHEAD_TASK_PRIORITY 3   // Below the mixer, so reads fill its idle time
+#define READAHEAD_TASK_STACK   3072
+#define READAHEAD_PATH_LEN     24   // Longer paths are closed, not held
+
+class AudioFileSourceReadAhead : public AudioFileSource {
+  public:
+    AudioFileSourceReadAhead();
+
+    // Start the shared reader task (once, after SD.begin())
+    static bool startReader(int core);
+
+    // Allocate the buffers now rather than on the first open() (at boot,
+    // so no play allocates)
+    bool reserve();
+
+    virtual bool open(const char *filename) override;
+    virtual uint32_t read(void *data, uint32_t len) override;
+    virtual bool seek(int32_t pos, int dir) override;
+    virtual bool close() override;
+    virtual bool isOpen() override { return opened; }
+    virtual uint32_t getSize() override { return size; }
+    virtual uint32_t getPos() override { return pos; }
+
+    // SD throughput, read latency, reader busy time, stalls and held-file
+    // reopens across all sources since the last call; printing starts a
+    // new window
+    static void printStats();
+
+  private:
+    enum BlockState : uint8_t {
+      BLOCK_EMPTY = 0,
+      BLOCK_QUEUED,               // Owned by the reader task
+      BLOCK_READY,
+    };
+
+    struct Block {
+      AudioFileSourceReadAhead *owner;
+      uint8_t *data;
+      uint32_t offset;            // File offset, multiple of READAHEAD_BLOCK
+      uint32_t len;
+      std::atomic<uint8_t> state;
+    };
+
+    static void readerTask(void *arg);
+    static void recordRead(uint32_t bytes, uint32_t us);
+
+    void loadBlock(Block &b, uint32_t offset);
+    Block *blockFor(uint32_t offset);
+    void prefetch(uint32_t offset);
+    void waitIdle();
+    void release();
+
+    File file;
+    bool opened;
+    uint32_t size;
+    uint32_t pos;
+    uint32_t filePos;             // Where the next file.read() will start
+    Block blocks[2];
+    char heldPath[READAHEAD_PATH_LEN];  // File kept open after close(); "" = none
+
+    static TaskHandle_t reader;
+    static SpscRing<Block *, READAHEAD_QUEUE> requests;
+
+    // Statistics
+    static std::atomic<uint32_t> statBytes;       // Both tasks read from the card
+    static std::atomic<uint32_t> statReads;
+    static std::atomic<uint32_t> statReadMicros;
+    static std::atomic<uint32_t> statReadMicrosMax;
+    static uint32_t statStalls;
+    static uint32_t statStallMicros;
+    static uint32_t statSyncReads;
+    static uint32_t statReopens;
+    static uint32_t statWindowStart;
+};
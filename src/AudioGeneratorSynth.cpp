@@ -0,0 +1,259 @@
+#include "AudioGeneratorSynth.h"
+
+// ===== PRESETS =====
+// Pitch sequences match the original busy-loop tone player:
+//   Beep  - 1000 Hz for 200 ms
+//   Siren - two cycles of 400->800->400 Hz in 20 Hz steps of 15 ms
+//   Chime - C5 E5 G5 C6 (100/100/100/250 ms) with 30 ms gaps
+//   Laser - 2000->200 Hz in 50 Hz steps of 8 ms
+// The stepped sweeps are rendered as continuous glides over the same span.
+
+static const SynthSegment beepSegments[] = {
+  {1000, 1000, 200},
+};
+
+static const SynthSegment sirenSegments[] = {
+  {400, 800, 21 * 15}, {800, 400, 21 * 15},
+  {400, 800, 21 * 15}, {800, 400, 21 * 15},
+};
+
+static const SynthSegment chimeSegments[] = {
+  {523, 523, 100}, {0, 0, 30},
+  {659, 659, 100}, {0, 0, 30},
+  {784, 784, 100}, {0, 0, 30},
+  {1047, 1047, 250}, {0, 0, 30},
+};
+
+static const SynthSegment laserSegments[] = {
+  {2000, 200, 37 * 8},
+};
+
+#define SEGMENTS(a) a, (uint8_t)(sizeof(a) / sizeof(a[0]))
+
+const SynthPreset SYNTH_PRESET_BEEP  = {"Beep",  SEGMENTS(beepSegments),  2, 5};
+const SynthPreset SYNTH_PRESET_SIREN = {"Siren", SEGMENTS(sirenSegments), 5, 10};
+const SynthPreset SYNTH_PRESET_CHIME = {"Chime", SEGMENTS(chimeSegments), 2, 8};
+const SynthPreset SYNTH_PRESET_LASER = {"Laser", SEGMENTS(laserSegments), 1, 5};
+
+// ===== BAND-LIMITED WAVETABLES =====
+// One square-wave table per octave. Table t is used for tones whose highest
+// pitch is below SYNTH_TABLE_BASE_HZ << t, and only contains the odd
+// harmonics that stay under Nyquist at that pitch.
+#define SYNTH_TABLE_SIZE    256
+#define SYNTH_TABLE_COUNT   7
+#define SYNTH_TABLE_BASE_HZ 125
+#define SYNTH_PEAK          27000   // Leaves headroom under int16 full scale
+
+static int16_t wavetables[SYNTH_TABLE_COUNT][SYNTH_TABLE_SIZE];
+static uint32_t wavetableRate = 0;
+
+static void buildWavetables(uint32_t sampleRate) {
+  if (wavetableRate == sampleRate) return;
+
+  static float acc[SYNTH_TABLE_SIZE];
+  for (int t = 0; t < SYNTH_TABLE_COUNT; t++) {
+    uint32_t topHz = (uint32_t)SYNTH_TABLE_BASE_HZ << t;
+    float peak = 0.0f;
+    for (int i = 0; i < SYNTH_TABLE_SIZE; i++) {
+      float x = 2.0f * (float)M_PI * i / SYNTH_TABLE_SIZE;
+      float s = 0.0f;
+      for (uint32_t k = 1; k * topHz < sampleRate / 2; k += 2) {
+        s += sinf(k * x) / k;
+      }
+      acc[i] = s;
+      if (fabsf(s) > peak) peak = fabsf(s);
+    }
+    float scale = (peak > 0.0f) ? SYNTH_PEAK / peak : 0.0f;
+    for (int i = 0; i < SYNTH_TABLE_SIZE; i++) {
+      wavetables[t][i] = (int16_t)lrintf(acc[i] * scale);
+    }
+  }
+  wavetableRate = sampleRate;
+}
+
+static const int16_t* wavetableFor(uint32_t topHz) {
+  for (int t = 0; t < SYNTH_TABLE_COUNT - 1; t++) {
+    if (topHz < ((uint32_t)SYNTH_TABLE_BASE_HZ << t)) return wavetables[t];
+  }
+  return wavetables[SYNTH_TABLE_COUNT - 1];
+}
+
+// ===== GENERATOR =====
+AudioGeneratorSynth::AudioGeneratorSynth() {
+  running = false;
+  file = nullptr;
+  output = nullptr;
+  preset = nullptr;
+  rate = SYNTH_SAMPLE_RATE;
+  segIndex = 0;
+  segSamples = segPos = 0;
+  segIsRest = true;
+  attackSamples = releaseSamples = 0;
+  phase = 0;
+  phaseInc = phaseIncStep = 0;
+  table = nullptr;
+  blockLen = blockPos = 0;
+  blockCount = renderMicros = renderMicrosPeak = 0;
+}
+
+bool AudioGeneratorSynth::begin(AudioFileSource *source, AudioOutput *output) {
+  (void)source;
+  (void)output;
+  return false;
+}
+
+bool AudioGeneratorSynth::begin(const SynthPreset *p, AudioOutput *out) {
+  if (p == nullptr || out == nullptr) return false;
+  output = out;
+  start(p, SYNTH_SAMPLE_RATE);
+
+  output->SetRate(rate);
+  output->SetBitsPerSample(16);
+  output->SetChannels(1);
+  if (!output->begin()) return false;
+
+  running = true;
+  return true;
+}
+
+void AudioGeneratorSynth::start(const SynthPreset *p, uint32_t sampleRate) {
+  buildWavetables(sampleRate);
+  preset = p;
+  rate = sampleRate;
+  segIndex = 0;
+  segSamples = segPos = 0;
+  phase = 0;
+  blockLen = blockPos = 0;
+  blockCount = renderMicros = renderMicrosPeak = 0;
+
+  // Prime the first segment; an empty preset renders nothing
+  segIndex = (uint8_t)-1;
+  if (!nextSegment()) preset = nullptr;
+}
+
+// Advance to the next segment. Returns false when the preset is finished.
+bool AudioGeneratorSynth::nextSegment() {
+  segIndex++;
+  if (preset == nullptr || segIndex >= preset->segmentCount) return false;
+
+  const SynthSegment &seg = preset->segments[segIndex];
+  segSamples = (uint32_t)seg.durationMs * rate / 1000;
+  segPos = 0;
+  segIsRest = (seg.startHz == 0);
+
+  if (segIsRest) {
+    phase = 0;  // Next tone starts on a zero crossing
+    phaseInc = phaseIncStep = 0;
+    attackSamples = releaseSamples = 0;
+    return true;
+  }
+
+  // Envelope only where the tone meets silence; back-to-back tones glide
+  bool prevIsTone = segIndex > 0 && preset->segments[segIndex - 1].startHz != 0;
+  bool nextIsTone = segIndex + 1 < preset->segmentCount &&
+                    preset->segments[segIndex + 1].startHz != 0;
+  attackSamples = prevIsTone ? 0 : (uint32_t)preset->attackMs * rate / 1000;
+  releaseSamples = nextIsTone ? 0 : (uint32_t)preset->releaseMs * rate / 1000;
+  if (attackSamples + releaseSamples > segSamples) {
+    attackSamples = releaseSamples = segSamples / 2;
+  }
+
+  int64_t startInc = ((int64_t)seg.startHz << 48) / rate;
+  int64_t endInc = ((int64_t)seg.endHz << 48) / rate;
+  phaseInc = startInc;
+  phaseIncStep = (segSamples > 0) ? (endInc - startInc) / (int64_t)segSamples : 0;
+  table = wavetableFor(seg.startHz > seg.endHz ? seg.startHz : seg.endHz);
+  return true;
+}
+
+int AudioGeneratorSynth::render(int16_t *dst, int maxSamples) {
+  int n = 0;
+  while (n < maxSamples && preset != nullptr) {
+    if (segPos >= segSamples) {
+      if (!nextSegment()) {
+        preset = nullptr;
+        break;
+      }
+      continue;
+    }
+
+    int count = maxSamples - n;
+    if ((uint32_t)count > segSamples - segPos) count = segSamples - segPos;
+
+    if (segIsRest) {
+      memset(dst + n, 0, count * sizeof(int16_t));
+      n += count;
+      segPos += count;
+      continue;
+    }
+
+    for (int i = 0; i < count; i++) {
+      uint32_t idx = phase >> 24;
+      int32_t frac = (phase >> 8) & 0xFFFF;
+      int32_t a = table[idx];
+      int32_t b = table[(idx + 1) & (SYNTH_TABLE_SIZE - 1)];
+      int32_t s = a + (((b - a) * frac) >> 16);
+
+      uint32_t pos = segPos + i;
+      if (pos < attackSamples) {
+        s = s * (int32_t)pos / (int32_t)attackSamples;
+      } else if (pos + releaseSamples >= segSamples) {
+        s = s * (int32_t)(segSamples - pos) / (int32_t)(releaseSamples + 1);
+      }
+      dst[n + i] = (int16_t)s;
+
+      phase += (uint32_t)(phaseInc >> 16);
+      phaseInc += phaseIncStep;
+    }
+    n += count;
+    segPos += count;
+  }
+  return n;
+}
+
+uint32_t AudioGeneratorSynth::samplesLeft() const {
+  if (preset == nullptr) return 0;
+  uint32_t left = segSamples - segPos;
+  for (int i = segIndex + 1; i < preset->segmentCount; i++) {
+    left += (uint32_t)preset->segments[i].durationMs * rate / 1000;
+  }
+  return left;
+}
+
+bool AudioGeneratorSynth::loop() {
+  if (!running) return false;
+
+  while (true) {
+    if (blockPos >= blockLen) {
+      uint32_t t0 = micros();
+      blockLen = render(block, SYNTH_BLOCK_SAMPLES);
+      uint32_t dt = micros() - t0;
+      blockPos = 0;
+      if (blockLen == 0) {
+        stop();
+        return false;
+      }
+      blockCount++;
+      renderMicros += dt;
+      if (dt > renderMicrosPeak) renderMicrosPeak = dt;
+    }
+
+    // Push until the output's DMA buffers are full, then yield
+    while (blockPos < blockLen) {
+      lastSample[AudioOutput::LEFTCHANNEL] = block[blockPos];
+      lastSample[AudioOutput::RIGHTCHANNEL] = block[blockPos];
+      if (!output->ConsumeSample(lastSample)) return true;
+      blockPos++;
+    }
+  }
+}
+
+bool AudioGeneratorSynth::stop() {
+  if (running && output != nullptr) {
+    output->stop();
+  }
+  running = false;
+  preset = nullptr;
+  blockLen = blockPos = 0;
+  return true;
+}
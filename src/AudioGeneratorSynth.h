@@ -0,0 +1,90 @@
+#pragma once
+
+#include <Arduino.h>
+#include "AudioGenerator.h"
+#include "AudioConfig.h"
+
+// ===== SYNTH VOICE =====
+// Sample-based synthesizer for the built-in sounds. A preset is a short list
+// of segments; each segment is either a tone (optionally sweeping linearly
+// from startHz to endHz) or a rest (startHz == 0). Tones are rendered by a
+// phase-accumulator oscillator reading band-limited square wavetables, with
+// a short attack/release envelope wherever a tone starts or stops so that
+// note boundaries do not click.
+//
+// The generator renders PCM in blocks and pushes it through the same
+// AudioOutput as WAV playback, so loop() returns immediately and the rest
+// of the sketch keeps running while a sound plays.
+
+#define SYNTH_SAMPLE_RATE   AUDIO_SAMPLE_RATE
+#define SYNTH_BLOCK_SAMPLES 128
+
+struct SynthSegment {
+  uint16_t startHz;     // 0 = rest
+  uint16_t endHz;       // Same as startHz for a steady tone
+  uint16_t durationMs;
+};
+
+struct SynthPreset {
+  const char* name;
+  const SynthSegment* segments;
+  uint8_t segmentCount;
+  uint8_t attackMs;     // Fade-in where a tone follows silence
+  uint8_t releaseMs;    // Fade-out where a tone is followed by silence
+};
+
+extern const SynthPreset SYNTH_PRESET_BEEP;
+extern const SynthPreset SYNTH_PRESET_SIREN;
+extern const SynthPreset SYNTH_PRESET_CHIME;
+extern const SynthPreset SYNTH_PRESET_LASER;
+
+class AudioGeneratorSynth : public AudioGenerator {
+  public:
+    AudioGeneratorSynth();
+    virtual ~AudioGeneratorSynth() override {};
+
+    // The synth has no file source; use begin(preset, output) instead.
+    virtual bool begin(AudioFileSource *source, AudioOutput *output) override;
+    bool begin(const SynthPreset *preset, AudioOutput *output);
+    virtual bool loop() override;
+    virtual bool stop() override;
+    virtual bool isRunning() override { return running; }
+
+    // Hardware-independent render core: prepares a preset and renders up to
+    // maxSamples mono 16-bit samples. Returns the number written; 0 means
+    // the preset is finished.
+    void start(const SynthPreset *preset, uint32_t sampleRate);
+    int render(int16_t *dst, int maxSamples);
+    // Samples render() has still to produce
+    uint32_t samplesLeft() const;
+
+    // Render cost of the most recent preset, for tuning
+    uint32_t blocksRendered() const { return blockCount; }
+    uint32_t renderMicrosTotal() const { return renderMicros; }
+    uint32_t renderMicrosMax() const { return renderMicrosPeak; }
+
+  private:
+    bool nextSegment();
+
+    const SynthPreset *preset;
+    uint32_t rate;
+    uint8_t segIndex;
+    uint32_t segSamples;      // Length of the current segment
+    uint32_t segPos;          // Samples rendered in the current segment
+    bool segIsRest;
+    uint32_t attackSamples;   // 0 when the segment continues a previous tone
+    uint32_t releaseSamples;  // 0 when the segment runs into another tone
+
+    uint32_t phase;           // Oscillator phase, full turn = 2^32
+    int64_t phaseInc;         // Phase increment in Q16 (per sample << 16)
+    int64_t phaseIncStep;     // Sweep: change of phaseInc per sample
+    const int16_t *table;     // Wavetable chosen for the segment's top pitch
+
+    int16_t block[SYNTH_BLOCK_SAMPLES];
+    int blockLen;
+    int blockPos;
+
+    uint32_t blockCount;
+    uint32_t renderMicros;
+    uint32_t renderMicrosPeak;
+};
@@ -0,0 +1,795 @@
+#include "AudioMixer.h"
+#include "EventLog.h"
+#include "ImaAdpcm.h"
+#include "LatencyTrace.h"
+#include "AudioFileSourcePROGMEM.h"
+
+AudioMixer::AudioMixer() {
+  output = nullptr;
+  sources = nullptr;
+  cache = nullptr;
+  onVoiceEnd = nullptr;
+  onVoiceStart = nullptr;
+  outputRunning = false;
+  nextSerial = 1;  // Voices never used (serial 0) are the least recent
+  masterGain = MIXER_UNITY_GAIN;
+  settleGain();
+  memset(voices, 0, sizeof(voices));
+  memset(voicePath, 0, sizeof(voicePath));
+  outPos = outLen = 0;
+  samplesOut = 0;
+  samplesRendered = 0;
+  seqHead = seqLen = 0;
+  seqVoice = prerollVoice = -1;
+  prerollPos = prerollLen = 0;
+  prerollEnds = false;
+  seqWaiting = false;
+  seqTransitions = seqGapless = seqGapMax = seqGapTotal = 0;
+  meterBlocks = 0;
+  meterLevel = 0;
+}
+
+bool AudioMixer::begin(AudioOutput *out, AudioFileSource **srcs) {
+  if (out == nullptr) return false;
+  output = out;
+  sources = srcs;
+  return true;
+}
+
+// ===== MASTER GAIN =====
+void AudioMixer::setMasterGain(uint16_t gain) {
+  masterGain = gain;
+  if (!outputRunning) settleGain();  // Nothing audible to glide from
+}
+
+// Jump to the target gain, ending any ramp
+void AudioMixer::settleGain() {
+  rampTarget = masterGain;
+  rampGain = (int32_t)masterGain << MIXER_RAMP_FRAC;
+  rampStep = 0;
+  rampLeft = 0;
+}
+
+// ===== VOICE ALLOCATION =====
+int AudioMixer::allocVoice(int tag, const char *path) {
+  // Retrigger: restart the voice already playing this sound
+  for (int i = 0; i < MIXER_VOICES; i++) {
+    if (voices[i].kind != VOICE_IDLE && voices[i].kind != VOICE_PREROLL && voices[i].tag == tag) {
+      MixerVoiceEndCB cb = onVoiceEnd;
+      onVoiceEnd = nullptr;  // Same sound keeps playing, no end event
+      releaseVoice(i);
+      onVoiceEnd = cb;
+      return i;
+    }
+  }
+
+  int idle = freeVoice(path);
+  if (idle >= 0) return idle;
+
+  // None free: steal the oldest (a pre-rolled sequence item is kept)
+  int oldest = -1;
+  for (int i = 0; i < MIXER_VOICES; i++) {
+    if (voices[i].kind == VOICE_PREROLL) continue;
+    if (oldest < 0 || (int32_t)(voices[i].serial - voices[oldest].serial) < 0) oldest = i;
+  }
+  LOG_INFO("Mixer: stealing voice %d (tag %d)", oldest, voices[oldest].tag);
+  releaseVoice(oldest);
+  return oldest;
+}
+
+// A free voice whose source last played this file still holds it open;
+// else the free voice used least recently, so the files of recent sounds
+// stay held. -1 if every voice is busy.
+int AudioMixer::freeVoice(const char *path) {
+  if (path != nullptr) {
+    for (int i = 0; i < MIXER_VOICES; i++) {
+      if (voices[i].kind == VOICE_IDLE && strcmp(voicePath[i], path) == 0) return i;
+    }
+  }
+
+  int idle = -1;
+  for (int i = 0; i < MIXER_VOICES; i++) {
+    if (voices[i].kind == VOICE_IDLE &&
+        (idle < 0 || (int32_t)(voices[i].serial - voices[idle].serial) < 0)) idle = i;
+  }
+  return idle;
+}
+
+void AudioMixer::releaseVoice(int slot) {
+  MixerVoice &v = voices[slot];
+  if (v.kind == VOICE_IDLE) return;
+  bool started = v.kind != VOICE_PREROLL;
+  if (v.ownsSource && v.stream.src != nullptr) v.stream.src->close();
+  if (v.cached != nullptr && cache != nullptr) cache->release(v.cached);
+  v.kind = VOICE_IDLE;
+  v.stream.src = nullptr;
+  v.cached = nullptr;
+
+  // A pre-rolled item is dropped; the playing one cut short ends the sequence
+  if (slot == prerollVoice) {
+    prerollVoice = -1;
+    prerollPos = prerollLen = 0;
+  }
+  if (slot == seqVoice) {
+    seqVoice = -1;
+    clearSequence();
+  }
+  if (started && onVoiceEnd != nullptr) onVoiceEnd(v.tag);
+}
+
+// tap: a play request that a latency trace may be following
+void AudioMixer::startVoice(int slot, int tag, uint8_t kind, uint16_t gain, uint32_t startMicros,
+                            bool tap) {
+  MixerVoice &v = voices[slot];
+  v.tag = tag;
+  v.gain = gain;
+  v.serial = nextSerial++;
+  v.startMicros = startMicros;
+  v.firstRendered = 0;
+  v.traced = tap && latencyTrace.claimVoice();
+  v.kind = kind;
+  v.played = 0;
+  v.length = voiceSamplesLeft(slot);
+
+  if (!outputRunning) {
+    output->SetRate(MIXER_SAMPLE_RATE);
+    output->SetBitsPerSample(16);
+    output->SetChannels(1);
+    outputRunning = output->begin();
+  }
+}
+
+static bool openWav(AudioFileSource *src, PcmStream &stream, const WavTrim *trim) {
+  WavInfo info;
+  if (!parseWavHeader(src, info)) {
+    LOG_ERROR("Mixer: unsupported or corrupt WAV header");
+    return false;
+  }
+  latencyTrace.mark(TRACE_WAV_HEADER);
+  if (!stream.begin(src, info, MIXER_SAMPLE_RATE, trim)) return false;
+  latencyTrace.mark(TRACE_STREAM_BEGIN);
+  LOG_DEBUG("WAV: %u Hz, %u ch, %u bit, %u data bytes",
+            info.sampleRate, info.channels, info.bitsPerSample, stream.bytesLeft);
+  return true;
+}
+
+int AudioMixer::playFile(int tag, const char *path, uint16_t gain, const WavTrim *trim) {
+  if (sources == nullptr) return -1;
+  uint32_t t0 = micros();
+  int slot = allocVoice(tag, path);
+  int kind = loadFile(slot, tag, path, trim);
+  if (kind < 0) return -1;
+  startVoice(slot, tag, kind, gain, t0);
+  return slot;
+}
+
+// Set a voice up to play a file; returns the kind it plays as, or -1.
+// Cache hit: the decoded head plays first, the file is opened by
+// openPending().
+int AudioMixer::loadFile(int slot, int tag, const char *path, const WavTrim *trim) {
+  PcmCacheEntry *entry = (cache != nullptr) ? cache->acquire(tag) : nullptr;
+  MixerVoice &v = voices[slot];
+  v.ownsSource = 1;
+  v.stream.src = nullptr;
+  strncpy(voicePath[slot], path, PCM_CACHE_PATH_LEN - 1);
+  voicePath[slot][PCM_CACHE_PATH_LEN - 1] = '\0';
+
+  if (entry != nullptr) {
+    v.cached = entry;
+    v.cachePos = 0;
+    v.cacheHit = 1;
+    return VOICE_CACHED;
+  }
+
+  AudioFileSource *src = sources[slot];
+  if (!src->open(path)) {
+    LOG_ERROR("Could not open %s", path);
+    return -1;
+  }
+  latencyTrace.mark(TRACE_FILE_OPEN);
+  if (!openWav(src, v.stream, trim)) {
+    src->close();
+    return -1;
+  }
+  v.cached = nullptr;
+  v.cacheHit = 0;
+
+  // Hot sound: keep its head around for next time
+  if (cache != nullptr) cache->request(tag, path, trim);
+  return VOICE_WAV;
+}
+
+int AudioMixer::playSource(int tag, AudioFileSource *src, uint16_t gain) {
+  int slot = allocVoice(tag);
+  MixerVoice &v = voices[slot];
+  if (!openWav(src, v.stream, nullptr)) return -1;
+  v.ownsSource = 0;
+  v.cached = nullptr;
+  v.cacheHit = 0;
+  startVoice(slot, tag, VOICE_WAV, gain, micros());
+  return slot;
+}
+
+int AudioMixer::playSynth(int tag, const SynthPreset *preset, uint16_t gain) {
+  int slot = allocVoice(tag);
+  synths[slot].start(preset, MIXER_SAMPLE_RATE);
+
+  MixerVoice &v = voices[slot];
+  v.stream.src = nullptr;
+  v.ownsSource = 0;
+  v.cached = nullptr;
+  v.cacheHit = 0;
+  startVoice(slot, tag, VOICE_SYNTH, gain, micros());
+  return slot;
+}
+
+void AudioMixer::stopTag(int tag) {
+  for (int i = 0; i < MIXER_VOICES; i++) {
+    if (voices[i].kind != VOICE_IDLE && voices[i].tag == tag) releaseVoice(i);
+  }
+}
+
+void AudioMixer::stopAll() {
+  clearSequence();
+  for (int i = 0; i < MIXER_VOICES; i++) releaseVoice(i);
+}
+
+bool AudioMixer::isPlaying(int tag) const {
+  for (int i = 0; i < MIXER_VOICES; i++) {
+    if (voices[i].kind != VOICE_IDLE && voices[i].kind != VOICE_PREROLL &&
+        voices[i].tag == tag) return true;
+  }
+  return false;
+}
+
+int AudioMixer::activeVoices() const {
+  int n = 0;
+  for (int i = 0; i < MIXER_VOICES; i++) {
+    if (voices[i].kind != VOICE_IDLE && voices[i].kind != VOICE_PREROLL) n++;
+  }
+  return n;
+}
+
+// Open the files behind cached heads so streaming can take over when the
+// head runs out. Called with the output DMA topped up, so the SD open
+// overlaps with buffered audio instead of delaying the first sample.
+void AudioMixer::openPending() {
+  for (int i = 0; i < MIXER_VOICES; i++) {
+    MixerVoice &v = voices[i];
+    if (v.kind != VOICE_CACHED || v.cached->complete || v.stream.src != nullptr) continue;
+
+    AudioFileSource *src = sources[i];
+    if (!src->open(voicePath[i]) || !src->seek(v.cached->resumeOffset, SEEK_SET)) {
+      LOG_ERROR("Could not resume %s", voicePath[i]);
+      src->close();
+      v.cached->complete = true;  // Play the head only
+      continue;
+    }
+    v.stream = v.cached->resume;
+    v.stream.src = src;
+  }
+}
+
+// ===== SEQUENCE =====
+bool AudioMixer::queueFile(int tag, const char *path, uint16_t gain, const WavTrim *trim,
+                           uint32_t gap) {
+  if (sources == nullptr) return false;
+  MixerSequenceItem item = {};
+  item.tag = (int16_t)tag;
+  item.gain = gain;
+  item.gap = gap;
+  item.trim.startFrame = trim ? trim->startFrame : 0;
+  item.trim.endFrame = trim ? trim->endFrame : 0;
+  strncpy(item.path, path, PCM_CACHE_PATH_LEN - 1);
+  item.path[PCM_CACHE_PATH_LEN - 1] = '\0';
+  return enqueue(item);
+}
+
+bool AudioMixer::queueSynth(int tag, const SynthPreset *preset, uint16_t gain, uint32_t gap) {
+  MixerSequenceItem item = {};
+  item.tag = (int16_t)tag;
+  item.gain = gain;
+  item.gap = gap;
+  item.preset = preset;
+  return enqueue(item);
+}
+
+bool AudioMixer::enqueue(const MixerSequenceItem &item) {
+  if (seqVoice >= 0 || prerollVoice >= 0 || seqWaiting || seqLen > 0) {
+    if (seqLen == MIXER_SEQUENCE_LEN) return false;
+    seqQueue[(seqHead + seqLen) % MIXER_SEQUENCE_LEN] = item;
+    seqLen++;
+    return true;
+  }
+
+  // Idle sequence: the first item plays now, as a tap would
+  int slot = item.preset != nullptr ? playSynth(item.tag, item.preset, item.gain)
+                                    : playFile(item.tag, item.path, item.gain, &item.trim);
+  if (slot < 0) return false;
+  seqVoice = slot;
+  if (onVoiceStart != nullptr) onVoiceStart(item.tag);
+  return true;
+}
+
+// Open the next item on a free voice and render its first block, so the
+// hand-off reads nothing from the card. Called with the output topped up.
+// Items that fail to open are skipped.
+void AudioMixer::prerollNext() {
+  while (seqLen > 0 && prerollVoice < 0 && prerollPos >= prerollLen) {
+    const MixerSequenceItem &item = seqQueue[seqHead];
+    int slot = freeVoice(item.preset != nullptr ? nullptr : item.path);
+    if (slot < 0) return;  // Every voice busy; next pass
+    seqHead = (seqHead + 1) % MIXER_SEQUENCE_LEN;
+    seqLen--;
+
+    MixerVoice &v = voices[slot];
+    int kind;
+    if (item.preset != nullptr) {
+      synths[slot].start(item.preset, MIXER_SAMPLE_RATE);
+      v.stream.src = nullptr;
+      v.ownsSource = 0;
+      v.cached = nullptr;
+      v.cacheHit = 0;
+      kind = VOICE_SYNTH;
+    } else {
+      kind = loadFile(slot, item.tag, item.path, &item.trim);
+      if (kind < 0) continue;
+    }
+
+    // Rendered with the voice's own kind, then parked until handOff()
+    v.tag = item.tag;
+    v.gain = item.gain;
+    v.kind = kind;
+    v.firstRendered = 1;
+    v.traced = 0;
+    memset(preroll, 0, sizeof(preroll));
+    prerollLen = renderVoice(slot, preroll, MIXER_BLOCK_SAMPLES);
+    prerollPos = 0;
+    prerollEnds = prerollLen < MIXER_BLOCK_SAMPLES;
+    prerollKind = kind;
+    prerollGap = item.gap;
+    v.kind = VOICE_PREROLL;
+    prerollVoice = slot;
+  }
+}
+
+// The playing item ran out `pos` samples into the block being rendered
+void AudioMixer::endItem(int pos) {
+  seqEndedTag = voices[seqVoice].tag;
+  seqEndedAt = samplesRendered + pos;
+  seqVoice = -1;
+  seqWaiting = true;
+}
+
+// Start the pre-rolled item in this block if its gap ends here, from that
+// sample; if it was not ready in time, from the start of the block
+void AudioMixer::handOff(int32_t *acc, int samples) {
+  while (seqWaiting && prerollVoice >= 0) {
+    int32_t at = (int32_t)(seqEndedAt + prerollGap - samplesRendered);
+    if (at >= samples) return;
+    if (at < 0) at = 0;
+
+    uint32_t late = samplesRendered + at - seqEndedAt - prerollGap;
+    seqTransitions++;
+    if (late == 0) seqGapless++;
+    seqGapTotal += late;
+    if (late > seqGapMax) seqGapMax = late;
+    LOG_INFO("Sequence: %d -> %d, gap %u samples (%u requested)", seqEndedTag,
+             voices[prerollVoice].tag, prerollGap + late, prerollGap);
+
+    int slot = prerollVoice;
+    MixerVoice &v = voices[slot];
+    prerollVoice = -1;
+    seqWaiting = false;
+    seqVoice = slot;
+    startVoice(slot, v.tag, prerollKind, v.gain, micros(), false);
+    v.firstRendered = 1;  // In the pre-roll
+    v.length += prerollLen;
+    if (onVoiceStart != nullptr) onVoiceStart(v.tag);
+
+    int n = renderVoice(slot, acc + at, samples - at);
+    v.played += n;
+    if (n < samples - at) {
+      endItem(at + n);
+      releaseVoice(slot);
+    }
+  }
+
+  // Nothing left to play after the item that ended
+  if (seqWaiting && seqLen == 0 && prerollVoice < 0) seqWaiting = false;
+}
+
+void AudioMixer::clearSequence() {
+  seqLen = 0;
+  seqWaiting = false;
+  if (prerollVoice >= 0) releaseVoice(prerollVoice);
+  prerollPos = prerollLen = 0;
+}
+
+void AudioMixer::printSequenceStats() {
+  uint32_t transitions = seqTransitions;
+  Serial.printf("Sequence: %u transitions, %u gapless; beyond the requested gaps: "
+                "avg %u, max %u samples (%u us)\n",
+                transitions, seqGapless, transitions ? seqGapTotal / transitions : 0, seqGapMax,
+                (uint32_t)((uint64_t)seqGapMax * 1000000 / MIXER_SAMPLE_RATE));
+  Serial.printf("  Queued: %u of %d, next item %s\n", seqLen, MIXER_SEQUENCE_LEN,
+                prerollVoice >= 0 ? "pre-rolled" : "not pre-rolled");
+  seqTransitions = seqGapless = seqGapMax = seqGapTotal = 0;
+}
+
+// ===== RENDERING =====
+int AudioMixer::renderCached(int slot, int32_t *acc, int samples, int32_t gain) {
+  MixerVoice &v = voices[slot];
+  PcmCacheEntry *e = v.cached;
+
+  // The head's ADPCM blocks are decoded into the voice's decode buffer,
+  // which the stream only needs once the head has run out
+  int16_t *pcm = voiceIn[slot];
+  int n = 0;
+  while (n < samples && v.cachePos < e->samples) {
+    uint32_t block = v.cachePos / PCM_CACHE_BLOCK_SAMPLES;
+    uint32_t pos = v.cachePos % PCM_CACHE_BLOCK_SAMPLES;
+    if (pos == 0) {
+      imaDecodeBlock(e->adpcm + block * PCM_CACHE_BLOCK_BYTES, PCM_CACHE_BLOCK_BYTES, 1, pcm);
+    }
+    uint32_t k = PCM_CACHE_BLOCK_SAMPLES - pos;
+    if (k > e->samples - v.cachePos) k = e->samples - v.cachePos;
+    if (k > (uint32_t)(samples - n)) k = samples - n;
+    for (uint32_t i = 0; i < k; i++) {
+      acc[n + i] += ((int32_t)pcm[pos + i] * gain) >> 15;
+    }
+    n += k;
+    v.cachePos += k;
+  }
+  if (n == samples) return n;
+
+  // Head exhausted: hand over to the file stream
+  bool resumable = !e->complete && v.stream.src != nullptr;
+  cache->release(e);
+  v.cached = nullptr;
+  if (!resumable) return n;
+  v.kind = VOICE_WAV;
+  return n + v.stream.render(voiceIn[slot], acc + n, samples - n, gain);
+}
+
+int AudioMixer::renderSynth(int slot, int32_t *acc, int samples, int32_t gain) {
+  int16_t tmp[MIXER_BLOCK_SAMPLES];
+  int n = synths[slot].render(tmp, samples);
+  for (int i = 0; i < n; i++) {
+    acc[i] += ((int32_t)tmp[i] * gain) >> 15;
+  }
+  return n;
+}
+
+// Mix one voice into acc; returns the samples it produced. The current
+// sequence item plays out its pre-rolled block first (until then no other
+// item is pre-rolled, as they share the buffer).
+int AudioMixer::renderVoice(int slot, int32_t *acc, int samples) {
+  MixerVoice &v = voices[slot];
+  int32_t gain = v.gain;
+  int n = 0;
+  if (slot == seqVoice && prerollVoice < 0 && prerollPos < prerollLen) {
+    n = prerollLen - prerollPos;
+    if (n > samples) n = samples;
+    for (int i = 0; i < n; i++) acc[i] += preroll[prerollPos + i];
+    prerollPos += n;
+    if (n == samples || prerollEnds) return n;
+  }
+
+  switch (v.kind) {
+    case VOICE_WAV:    n += v.stream.render(voiceIn[slot], acc + n, samples - n, gain); break;
+    case VOICE_CACHED: n += renderCached(slot, acc + n, samples - n, gain); break;
+    case VOICE_SYNTH:  n += renderSynth(slot, acc + n, samples - n, gain); break;
+    default:           return 0;
+  }
+  if (!v.firstRendered) {
+    v.firstRendered = 1;
+    if (v.traced) latencyTrace.firstRender(samplesOut);  // Block starts at the next sample out
+    if (cache != nullptr && v.kind != VOICE_SYNTH) {
+      cache->recordFirstSample(v.cacheHit, micros() - v.startMicros);
+    }
+  }
+  return n;
+}
+
+void AudioMixer::render(int16_t *dst, int samples) {
+  int32_t acc[MIXER_BLOCK_SAMPLES];
+  if (samples > MIXER_BLOCK_SAMPLES) samples = MIXER_BLOCK_SAMPLES;
+  memset(acc, 0, samples * sizeof(int32_t));
+
+  for (int i = 0; i < MIXER_VOICES; i++) {
+    if (voices[i].kind == VOICE_IDLE || voices[i].kind == VOICE_PREROLL) continue;
+    int n = renderVoice(i, acc, samples);
+    voices[i].played += n;
+    if (n < samples) {
+      if (i == seqVoice) endItem(n);
+      releaseVoice(i);
+    }
+  }
+  if (seqWaiting) handOff(acc, samples);
+
+  // The master gain scales the sum, so a volume change is one ramp for all
+  // voices: a linear glide per sample instead of a step between blocks
+  if (masterGain != rampTarget) {
+    rampTarget = masterGain;
+    rampStep = (((int32_t)rampTarget << MIXER_RAMP_FRAC) - rampGain) / MIXER_GAIN_RAMP;
+    rampLeft = MIXER_GAIN_RAMP;
+  }
+  for (int i = 0; i < samples; i++) {
+    if (rampLeft > 0) {
+      rampGain = --rampLeft > 0 ? rampGain + rampStep : (int32_t)rampTarget << MIXER_RAMP_FRAC;
+    }
+    int32_t s = (int32_t)(((int64_t)acc[i] * (rampGain >> MIXER_RAMP_FRAC)) >> 15);
+    if (s > 32767) s = 32767;
+    else if (s < -32768) s = -32768;
+    dst[i] = (int16_t)s;
+  }
+  samplesRendered += samples;
+  publishMeter(dst, samples);
+}
+
+// Output samples a voice has still to play, from its current state
+uint32_t AudioMixer::voiceSamplesLeft(int slot) const {
+  const MixerVoice &v = voices[slot];
+  switch (v.kind) {
+    case VOICE_WAV:
+      return v.stream.samplesLeft();
+    case VOICE_CACHED:
+      return v.cached->samples - v.cachePos +
+             (v.cached->complete ? 0 : v.cached->resume.samplesLeft());
+    case VOICE_SYNTH:
+      return synths[slot].samplesLeft();
+    default:
+      return 0;
+  }
+}
+
+// ===== LEVEL METER =====
+void AudioMixer::publishMeter(const int16_t *block, int samples) {
+  int32_t peak = 0;
+  for (int i = 0; i < samples; i++) {
+    int32_t s = block[i] < 0 ? -block[i] : block[i];
+    if (s > peak) peak = s;
+  }
+  if (peak > 32767) peak = 32767;
+  if (samples > 0) {
+    uint16_t fallen = (uint16_t)(((uint32_t)meterLevel * MIXER_METER_RELEASE) >> 15);
+    meterLevel = peak > fallen ? peak : fallen;
+    meterBlocks++;
+  } else {
+    meterLevel = 0;  // Output stopped
+  }
+
+  // The playhead follows the voice started last
+  int newest = -1;
+  for (int i = 0; i < MIXER_VOICES; i++) {
+    if (voices[i].kind == VOICE_IDLE || voices[i].kind == VOICE_PREROLL) continue;
+    if (newest < 0 || (int32_t)(voices[i].serial - voices[newest].serial) > 0) newest = i;
+  }
+
+  MixerMeter &m = meter.back();
+  m.block = meterBlocks;
+  m.peak = peak;
+  m.level = meterLevel;
+  m.tag = newest >= 0 ? voices[newest].tag : -1;
+  m.played = newest >= 0 ? voices[newest].played : 0;
+  m.length = newest >= 0 ? voices[newest].length : 0;
+  meter.publish();
+}
+
+bool AudioMixer::readMeter(MixerMeter &m) {
+  bool fresh = meter.update();
+  m = meter.front();
+  return fresh;
+}
+
+bool AudioMixer::loop() {
+  if (!outputRunning) return false;
+
+  while (true) {
+    if (outPos >= outLen) {
+      // A sequence waiting out a gap keeps the output running; one whose
+      // next item is not open yet opens it now, late
+      if (activeVoices() == 0 && seqWaiting) prerollNext();
+      if (activeVoices() == 0 && prerollVoice < 0) {
+        clearSequence();
+        output->stop();
+        outputRunning = false;
+        settleGain();
+        publishMeter(nullptr, 0);
+        return false;
+      }
+      render(outBlock, MIXER_BLOCK_SAMPLES);
+      outPos = 0;
+      outLen = MIXER_BLOCK_SAMPLES;
+    }
+
+    // Push until the output's DMA buffers are full, then yield
+    while (outPos < outLen) {
+      int16_t s[2] = {outBlock[outPos], outBlock[outPos]};
+      if (!output->ConsumeSample(s)) {
+        openPending();
+        prerollNext();
+        return true;
+      }
+      outPos++;
+      samplesOut++;
+    }
+  }
+}
+
+// ===== BENCHMARK =====
+// Mixes in-memory 44.1 kHz stereo WAV voices alternating with synth voices,
+// so the figures exclude SD access time.
+#define BENCH_FRAMES 4096
+#define BENCH_BLOCKS 64
+
+static void writeBenchHeader(uint8_t *h, uint32_t dataBytes) {
+  const uint32_t rate = 44100;
+  memcpy(h, "RIFF", 4);
+  uint32_t riffSize = 36 + dataBytes;
+  memcpy(h + 4, &riffSize, 4);
+  memcpy(h + 8, "WAVEfmt ", 8);
+  const uint32_t fmtSize = 16;
+  const uint16_t fmt[2] = {WAV_FORMAT_PCM, 2};
+  const uint32_t byteRate = rate * 4;
+  const uint16_t align[2] = {4, 16};
+  memcpy(h + 16, &fmtSize, 4);
+  memcpy(h + 20, fmt, 4);
+  memcpy(h + 24, &rate, 4);
+  memcpy(h + 28, &byteRate, 4);
+  memcpy(h + 32, align, 4);
+  memcpy(h + 36, "data", 4);
+  memcpy(h + 40, &dataBytes, 4);
+}
+
+void AudioMixer::benchmark() {
+  if (outputRunning) {
+    Serial.println("Mixer benchmark: stop playback first");
+    return;
+  }
+
+  uint32_t dataBytes = BENCH_FRAMES * 4;
+  uint8_t *wavData = (uint8_t *)malloc(44 + dataBytes);
+  if (wavData == nullptr) {
+    Serial.println("Mixer benchmark: out of memory");
+    return;
+  }
+  writeBenchHeader(wavData, dataBytes);
+  uint32_t seed = 12345;
+  for (uint32_t i = 44; i < 44 + dataBytes; i++) {
+    seed = seed * 1103515245 + 12345;
+    wavData[i] = seed >> 24;
+  }
+
+  MixerVoiceEndCB savedCB = onVoiceEnd;
+  onVoiceEnd = nullptr;
+  AudioFileSourcePROGMEM benchSources[MIXER_VOICES];
+  int16_t block[MIXER_BLOCK_SAMPLES];
+  uint32_t cpuHz = ESP.getCpuFreqMHz() * 1000000UL;
+  uint32_t budget = (uint32_t)((uint64_t)cpuHz * MIXER_BLOCK_SAMPLES / MIXER_SAMPLE_RATE);
+
+  Serial.printf("Mixer benchmark: %d samples/block @ %d Hz, budget %u cycles/block\n",
+                MIXER_BLOCK_SAMPLES, MIXER_SAMPLE_RATE, budget);
+
+  for (int n = 1; n <= MIXER_VOICES; n++) {
+    uint32_t cycles = 0;
+    uint32_t worst = 0;
+    for (int b = 0; b < BENCH_BLOCKS; b++) {
+      // (Re)start any voice that ran out, outside the timed region
+      for (int i = 0; i < n; i++) {
+        if (voices[i].kind != VOICE_IDLE) continue;
+        if (i % 2 == 0) {
+          benchSources[i].open(wavData, 44 + dataBytes);
+          playSource(100 + i, &benchSources[i], MIXER_UNITY_GAIN / 4);
+        } else {
+          playSynth(100 + i, &SYNTH_PRESET_SIREN, MIXER_UNITY_GAIN / 4);
+        }
+      }
+      uint32_t t0 = ESP.getCycleCount();
+      render(block, MIXER_BLOCK_SAMPLES);
+      uint32_t dt = ESP.getCycleCount() - t0;
+      cycles += dt;
+      if (dt > worst) worst = dt;
+    }
+    uint32_t avg = cycles / BENCH_BLOCKS;
+    Serial.printf("  %d voice(s): avg %u cycles/block (%u%% of budget), worst %u\n",
+                  n, avg, (uint32_t)((uint64_t)avg * 100 / budget), worst);
+    if (n == MIXER_VOICES) benchmarkMeter(block);
+    stopAll();
+  }
+
+  // playSource() starts the output; nothing was pushed, so just stop it
+  output->stop();
+  outputRunning = false;
+  onVoiceEnd = savedCB;
+
+  benchmarkResampler(wavData, 44 + dataBytes);
+  benchmarkKernels(wavData + 44, dataBytes);
+  free(wavData);
+}
+
+// What render() adds per block for the level meter, with every voice
+// playing (the playhead scan's worst case)
+void AudioMixer::benchmarkMeter(const int16_t *block) {
+  uint32_t cpuHz = ESP.getCpuFreqMHz() * 1000000UL;
+  uint32_t budget = (uint32_t)((uint64_t)cpuHz * MIXER_BLOCK_SAMPLES / MIXER_SAMPLE_RATE);
+  uint32_t t0 = ESP.getCycleCount();
+  for (int b = 0; b < BENCH_BLOCKS; b++) publishMeter(block, MIXER_BLOCK_SAMPLES);
+  uint32_t avg = (ESP.getCycleCount() - t0) / BENCH_BLOCKS;
+  uint32_t milliPercent = (uint32_t)((uint64_t)avg * 100000 / budget);
+  Serial.printf("  Level meter: %u cycles/block (%u.%03u%% of budget)\n", avg,
+                milliPercent / 1000, milliPercent % 1000);
+}
+
+// Decode + downmix + rate conversion of the 44.1 kHz stereo test data, per
+// output sample: anti-alias FIR against plain linear interpolation (the
+// previous path). Voice 0's decode buffer is free once all voices stopped.
+void AudioMixer::benchmarkResampler(const uint8_t *wav, uint32_t len) {
+  const char *names[2] = {"linear", "FIR"};
+  int32_t acc[MIXER_BLOCK_SAMPLES];
+
+  Serial.printf("Resampler: 44100 Hz stereo -> %d Hz mono, %d-tap FIR\n",
+                MIXER_SAMPLE_RATE, PCM_FIR_TAPS);
+  for (int mode = 0; mode < 2; mode++) {
+    AudioFileSourcePROGMEM src;
+    src.open(wav, len);
+    WavInfo info;
+    PcmStream stream;
+    if (!parseWavHeader(&src, info) || !stream.begin(&src, info, MIXER_SAMPLE_RATE)) return;
+    if (mode == 0) stream.fir = nullptr;
+
+    uint32_t cycles = 0;
+    uint32_t produced = 0;
+    int n;
+    do {
+      memset(acc, 0, sizeof(acc));
+      uint32_t t0 = ESP.getCycleCount();
+      n = stream.render(voiceIn[0], acc, MIXER_BLOCK_SAMPLES, MIXER_UNITY_GAIN);
+      cycles += ESP.getCycleCount() - t0;
+      produced += n;
+    } while (n == MIXER_BLOCK_SAMPLES);
+
+    uint32_t perSample100 = produced ? (uint32_t)((uint64_t)cycles * 100 / produced) : 0;
+    Serial.printf("  %-6s %u.%02u cycles/sample (%u samples)\n", names[mode],
+                  perSample100 / 100, perSample100 % 100, produced);
+  }
+
+  // The I2S driver moves one 32-bit frame per sample even in mono mode
+  uint32_t dmaFixed = MIXER_SAMPLE_RATE * 4;
+  uint32_t dmaSource = 44100 * 4;
+  Serial.printf("  I2S DMA: %u B/s at %d Hz vs %u B/s at 44100 Hz (%u%% less)\n",
+                dmaFixed, MIXER_SAMPLE_RATE, dmaSource, 100 - dmaFixed * 100 / dmaSource);
+}
+
+// Source bytes to gained samples in the accumulator, per layout: the
+// layout-generic loop, the specialized convert kernel (both followed by a
+// gain pass, as on the resampling paths) and the fused convert-and-gain
+// kernel of the passthrough path
+void AudioMixer::benchmarkKernels(const uint8_t *data, uint32_t len) {
+  static const uint8_t layouts[][2] = {{1, 1}, {1, 2}, {2, 1}, {2, 2}, {3, 1}, {3, 2}};
+
+  Serial.println("PCM kernels: cycles/sample to gained mono samples");
+  Serial.printf("  %-16s %8s %8s %8s\n", "layout", "generic", "convert", "fused");
+  for (const uint8_t *l : layouts) {
+    uint32_t c[3];
+    for (int path = 0; path < 3; path++) {
+      c[path] = pcmKernelCycles(data, len, l[0], l[1], (PcmKernelPath)path);
+    }
+    Serial.printf("  %2d-bit %-9s %5u.%02u %5u.%02u %5u.%02u\n", l[0] * 8, l[1] == 1 ? "mono" : "stereo",
+                  c[0] / 100, c[0] % 100, c[1] / 100, c[1] % 100, c[2] / 100, c[2] % 100);
+  }
+
+  // Any bytes are valid ADPCM, so the same data times the block decoder
+  for (int channels = 1; channels <= 2; channels++) {
+    const uint32_t blockAlign = imaBlockAlign(PCM_CACHE_BLOCK_SAMPLES, channels);
+    uint32_t samples = 0;
+    uint32_t t0 = ESP.getCycleCount();
+    for (uint32_t off = 0; off + blockAlign <= len; off += blockAlign) {
+      samples += imaDecodeBlock(data + off, blockAlign, channels, voiceIn[0]);
+    }
+    uint32_t c = samples ? (uint32_t)((uint64_t)(ESP.getCycleCount() - t0) * 100 / samples) : 0;
+    Serial.printf("  IMA ADPCM %-6s %5u.%02u cycles/sample to mono (block decoder)\n",
+                  channels == 1 ? "mono" : "stereo", c / 100, c % 100);
+  }
+}
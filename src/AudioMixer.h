@@ -0,0 +1,235 @@
+#pragma once
+
+#include <Arduino.h>
+#include "AudioFileSource.h"
+#include "AudioOutput.h"
+#include "AudioConfig.h"
+#include "AudioGeneratorSynth.h"
+#include "PcmCache.h"
+#include "PcmStream.h"
+#include "TripleBuffer.h"
+#include "WavParser.h"
+
+// ===== POLYPHONIC MIXER =====
+// Fixed-point software mixer that sums up to MIXER_VOICES sources (WAV
+// streams and synth presets) into a single mono stream at a fixed output
+// rate. Voice state lives in a flat array that the render loop walks once
+// per block; WAV sources are converted to the output rate by PcmStream, the
+// sum is scaled by the master gain and saturated to 16 bits.
+//
+// When every voice is busy a new sound steals a voice: a voice already
+// playing the same tag is restarted, otherwise the oldest voice is reused.
+// Among free voices, one that last played the same file is preferred, as
+// its source may still hold the file open (AudioFileSourceReadAhead); else
+// the one used least recently.
+//
+// With a PcmCache attached, playFile() starts from the cached head when
+// there is one and opens the file to stream the remainder while the head
+// plays; sounds that miss are queued for caching.
+//
+// A sequence plays queued sounds back to back (queueFile()/queueSynth()),
+// each after an optional gap of silence counted in output samples. While
+// one item plays, the next is opened on a free voice and its first block
+// rendered ahead (pre-roll), with the output topped up as for
+// openPending(). When the playing item runs out mid-block, the next one is
+// mixed in from the sample its gap ends, so the hand-off needs no SD
+// access. The gap at every transition is measured in output samples and
+// logged. A pre-rolled voice is silent and is never stolen or retriggered;
+// stopping or stealing the playing item's voice ends the sequence.
+//
+// After every block the mixer publishes a MixerMeter (the block's peak, a
+// falling peak level for a meter, and the playhead of the newest voice)
+// through a triple buffer, for the UI on the other core: publishing is a
+// scan of the block and one atomic exchange, never a wait on the reader.
+
+#ifndef MIXER_VOICES
+#define MIXER_VOICES 4
+#endif
+
+#define MIXER_SAMPLE_RATE    AUDIO_SAMPLE_RATE
+#define MIXER_BLOCK_SAMPLES  128
+#define MIXER_UNITY_GAIN     32768   // Q15
+#ifndef MIXER_GAIN_RAMP
+#define MIXER_GAIN_RAMP      256     // Samples a master gain change glides over (~12 ms)
+#endif
+#define MIXER_RAMP_FRAC      12      // Extra fraction bits of the ramped gain
+#define MIXER_SEQUENCE_LEN   16      // Sequence items queued and not started yet
+#ifndef MIXER_METER_RELEASE
+#define MIXER_METER_RELEASE  32333   // Meter level kept per block, Q15 (falls ~20 dB/s)
+#endif
+
+enum MixerVoiceKind : uint8_t {
+  VOICE_IDLE = 0,
+  VOICE_WAV,
+  VOICE_CACHED,     // Playing a cached head, streaming resumes afterwards
+  VOICE_SYNTH,
+  VOICE_PREROLL,    // Next sequence item, first block rendered, not audible yet
+};
+
+struct MixerVoice {
+  uint8_t kind;
+  uint8_t ownsSource;      // Source comes from the mixer's pool
+  uint8_t cacheHit;        // Started from the PCM cache (for statistics)
+  uint8_t firstRendered;   // First block has been rendered
+  uint8_t traced;          // Voice of the tap being latency-traced
+  int16_t tag;             // Caller's id (sound index)
+  uint16_t gain;           // Q15
+  uint32_t serial;         // Start order, for oldest-voice stealing
+  uint32_t startMicros;    // Play request time, for time-to-first-sample
+  uint32_t played;         // Output samples mixed since it started
+  uint32_t length;         // ... and in all, as estimated at the start
+  PcmStream stream;        // WAV decode state
+  PcmCacheEntry *cached;   // Head being played (VOICE_CACHED)
+  uint32_t cachePos;
+};
+
+struct MixerSequenceItem {
+  int16_t tag;
+  uint16_t gain;           // Q15
+  uint32_t gap;            // Output samples of silence after the previous item
+  const SynthPreset *preset;  // nullptr: a file
+  WavTrim trim;
+  char path[PCM_CACHE_PATH_LEN];
+};
+
+// Level and playhead after a block, as published to the UI
+struct MixerMeter {
+  uint32_t block;          // Blocks rendered since boot (0: none yet)
+  uint16_t peak;           // Largest sample magnitude in the block, after the master gain
+  uint16_t level;          // Peak, falling by MIXER_METER_RELEASE per block
+  int16_t tag;             // Newest playing voice, -1 if none
+  uint32_t played;         // Its output samples so far
+  uint32_t length;         // ... and in all (0 if unknown)
+};
+
+// Called when a voice finishes or is stolen
+typedef void (*MixerVoiceEndCB)(int tag);
+// Called when a sequence item starts playing
+typedef void (*MixerVoiceStartCB)(int tag);
+
+class AudioMixer {
+  public:
+    AudioMixer();
+
+    // sources: MIXER_VOICES file sources (e.g. AudioFileSourceSD) reused
+    // by playFile(); may be nullptr if only playSource()/playSynth() are used.
+    bool begin(AudioOutput *output, AudioFileSource **sources);
+    void setVoiceEndCallback(MixerVoiceEndCB cb) { onVoiceEnd = cb; }
+    void setVoiceStartCallback(MixerVoiceStartCB cb) { onVoiceStart = cb; }
+    void setCache(PcmCache *c) { cache = c; }
+
+    // Overall volume (Q15), applied to the sum of the voices. Voices already
+    // playing glide to it over MIXER_GAIN_RAMP samples from the next block.
+    void setMasterGain(uint16_t gain);
+
+    // Start a sound; returns the voice slot or -1 on error. A trim limits
+    // playback to the sound's audible span.
+    int playFile(int tag, const char *path, uint16_t gain, const WavTrim *trim = nullptr);
+    int playSource(int tag, AudioFileSource *src, uint16_t gain);
+    int playSynth(int tag, const SynthPreset *preset, uint16_t gain);
+    void stopTag(int tag);
+    void stopAll();
+
+    // Append a sound to the sequence; it starts `gap` output samples after
+    // the previous item ends, or now if the sequence is idle. Returns false
+    // if the queue is full or the sound could not be started now.
+    bool queueFile(int tag, const char *path, uint16_t gain, const WavTrim *trim, uint32_t gap);
+    bool queueSynth(int tag, const SynthPreset *preset, uint16_t gain, uint32_t gap);
+
+    // Transitions, how many were gapless, and the gaps beyond the ones
+    // requested; starts a new measurement window
+    void printSequenceStats();
+
+    bool isPlaying(int tag) const;
+    int activeVoices() const;
+
+    // Level meter and playhead: the newest snapshot, for one reader (loop()).
+    // Returns false if it is the one the last call returned.
+    bool readMeter(MixerMeter &m);
+    // Mixer task: publish the snapshot for a block just rendered (render()
+    // calls this; the output's stop publishes silence with no block)
+    void publishMeter(const int16_t *block, int samples);
+
+    // Render and push to the output until it accepts no more samples.
+    // Returns false once every voice has finished and the output is stopped.
+    bool loop();
+
+    // Mix one block without touching the output (also used by benchmark())
+    void render(int16_t *dst, int samples);
+
+    // Print cycles per block for 1..MIXER_VOICES voices against the
+    // real-time budget of one block at MIXER_SAMPLE_RATE, then the cost of
+    // rate conversion and of the PCM conversion kernels per output sample
+    void benchmark();
+
+  private:
+    int allocVoice(int tag, const char *path = nullptr);
+    int freeVoice(const char *path);
+    void releaseVoice(int slot);
+    void startVoice(int slot, int tag, uint8_t kind, uint16_t gain, uint32_t startMicros,
+                    bool tap = true);
+    int loadFile(int slot, int tag, const char *path, const WavTrim *trim);
+    void openPending();
+    void settleGain();
+    bool enqueue(const MixerSequenceItem &item);
+    void prerollNext();
+    void endItem(int pos);
+    void handOff(int32_t *acc, int samples);
+    void clearSequence();
+    int renderVoice(int slot, int32_t *acc, int samples);
+    uint32_t voiceSamplesLeft(int slot) const;
+    int renderCached(int slot, int32_t *acc, int samples, int32_t gain);
+    int renderSynth(int slot, int32_t *acc, int samples, int32_t gain);
+    void benchmarkMeter(const int16_t *block);
+    void benchmarkResampler(const uint8_t *wav, uint32_t len);
+    void benchmarkKernels(const uint8_t *data, uint32_t len);
+
+    AudioOutput *output;
+    AudioFileSource **sources;
+    PcmCache *cache;
+    MixerVoiceEndCB onVoiceEnd;
+    MixerVoiceStartCB onVoiceStart;
+    bool outputRunning;
+    uint32_t nextSerial;
+    uint16_t masterGain;     // Target
+    uint16_t rampTarget;     // masterGain the current ramp heads for
+    int32_t rampGain;        // Applied gain, Q15 << MIXER_RAMP_FRAC
+    int32_t rampStep;        // Per sample while rampLeft > 0
+    int rampLeft;
+
+    MixerVoice voices[MIXER_VOICES];
+    int16_t voiceIn[MIXER_VOICES][PCM_STREAM_IN_FRAMES];
+    char voicePath[MIXER_VOICES][PCM_CACHE_PATH_LEN];  // Last file played per voice
+    AudioGeneratorSynth synths[MIXER_VOICES];
+
+    int16_t outBlock[MIXER_BLOCK_SAMPLES];
+    int outPos;
+    int outLen;
+    uint32_t samplesOut;     // Handed to the output since boot
+    uint32_t samplesRendered;  // Mixed since boot; sequence timeline
+
+    // Sequence
+    MixerSequenceItem seqQueue[MIXER_SEQUENCE_LEN];
+    uint8_t seqHead, seqLen;
+    int seqVoice;            // Voice playing the current item, -1 none
+    int prerollVoice;        // Voice holding the next item, -1 none
+    uint8_t prerollKind;     // What it plays as once handed over
+    uint32_t prerollGap;
+    int32_t preroll[MIXER_BLOCK_SAMPLES];  // Its first block, gained
+    int prerollPos, prerollLen;
+    bool prerollEnds;        // The whole sound fit in that block
+    bool seqWaiting;         // An item ended, the next has not started
+    uint32_t seqEndedAt;     // samplesRendered when it ended
+    int16_t seqEndedTag;
+
+    // Level meter
+    TripleBuffer<MixerMeter> meter;
+    uint32_t meterBlocks;
+    uint16_t meterLevel;
+
+    // Sequence statistics
+    volatile uint32_t seqTransitions;
+    volatile uint32_t seqGapless;      // Next item started on its sample
+    volatile uint32_t seqGapMax;       // Samples later than requested
+    volatile uint32_t seqGapTotal;
+};
@@ -0,0 +1,80 @@
+#include "AudioOutputRing.h"
+#include "LatencyTrace.h"
+
+AudioOutputRing::AudioOutputRing() {
+  sink = nullptr;
+  sinkRate = 0;
+  wantRunning = false;
+  sinkRunning = false;
+  resetRequested = false;
+  primed = dry = false;
+  underrunCount = 0;
+  minFillSeen = AUDIO_RING_SAMPLES;
+  startCount = 0;
+  samplesOut = 0;
+}
+
+bool AudioOutputRing::begin() {
+  // hertz was set by SetRate() just before; the release store publishes it
+  wantRunning.store(true, std::memory_order_release);
+  return true;
+}
+
+bool AudioOutputRing::ConsumeSample(int16_t sample[2]) {
+  return ring.push(sample[LEFTCHANNEL]);  // Mono pipeline
+}
+
+bool AudioOutputRing::stop() {
+  wantRunning.store(false, std::memory_order_release);
+  return true;
+}
+
+int AudioOutputRing::drain() {
+  if (resetRequested.exchange(false)) {
+    underrunCount = 0;
+    minFillSeen = AUDIO_RING_SAMPLES;
+  }
+
+  bool want = wantRunning.load(std::memory_order_acquire);
+  if (!sinkRunning.load(std::memory_order_relaxed)) {
+    if (!want || sink == nullptr) return 0;
+    // The device rate is fixed, so the I2S clock is programmed only once
+    if (hertz != sinkRate) {
+      sink->SetRate(hertz);
+      sink->SetBitsPerSample(16);
+      sink->SetChannels(1);
+      sinkRate = hertz;
+    }
+    if (!sink->begin()) return 0;
+    sinkRunning.store(true);
+    primed = dry = false;
+    startCount++;
+  }
+
+  // Fill level at the moment the DMA asks for more: the worst case is how
+  // close the mixer came to letting the DAC run dry
+  uint32_t level = ring.available();
+  if (level >= AUDIO_RING_PRIME) primed = true;
+  if (primed && want) {
+    if (level < minFillSeen) minFillSeen = level;
+    if (level == 0 && !dry) underrunCount++;
+    dry = (level == 0);
+  }
+
+  int moved = 0;
+  while (const int16_t *s = ring.peek()) {
+    int16_t frame[2] = {*s, *s};
+    if (!sink->ConsumeSample(frame)) break;
+    ring.drop();
+    moved++;
+  }
+  samplesOut += moved;
+  latencyTrace.outputProgress(samplesOut);
+
+  // Playback ended and everything rendered has been handed to the DMA
+  if (!want && ring.available() == 0) {
+    sink->stop();
+    sinkRunning.store(false);
+  }
+  return moved;
+}
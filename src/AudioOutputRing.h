@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "AudioOutput.h"
+#include "SpscRing.h"
+
+// ===== RING BUFFER OUTPUT =====
+// AudioOutput that the mixer writes into instead of the I2S driver. Samples
+// go into a lock-free SPSC ring; drain(), called from the output task,
+// moves them into the real output until its DMA buffers are full. The ring
+// is the cushion that lets the mixer stall on an SD read (or be preempted)
+// without the DAC running dry.
+//
+// begin()/stop() from the mixer only record the wanted state; the output
+// task starts the real output when samples arrive and stops it once the
+// ring has drained after stop().
+
+#ifndef AUDIO_RING_SAMPLES
+#define AUDIO_RING_SAMPLES 2048     // ~93 ms at 22050 Hz
+#endif
+#define AUDIO_RING_PRIME   (AUDIO_RING_SAMPLES / 2)  // Fill that arms underrun detection
+
+class AudioOutputRing : public AudioOutput {
+  public:
+    AudioOutputRing();
+    void setSink(AudioOutput *out) { sink = out; }
+
+    // Producer side (mixer task)
+    virtual bool begin() override;
+    virtual bool ConsumeSample(int16_t sample[2]) override;
+    virtual bool stop() override;
+
+    // Consumer side (output task): returns the number of samples moved
+    int drain();
+
+    bool isRunning() const { return wantRunning.load() || sinkRunning.load(); }
+    size_t fill() const { return ring.available(); }
+    size_t space() const { return ring.space(); }
+
+    // Statistics, written by the output task
+    uint32_t underruns() const { return underrunCount; }
+    uint32_t minFill() const { return minFillSeen; }
+    uint32_t sinkStarts() const { return startCount; }
+    void resetStats() { resetRequested.store(true); }
+
+  private:
+    AudioOutput *sink;
+    uint32_t sinkRate;     // Rate the real output was last configured for
+    SpscRing<int16_t, AUDIO_RING_SAMPLES> ring;
+    std::atomic<bool> wantRunning;
+    std::atomic<bool> sinkRunning;
+    std::atomic<bool> resetRequested;
+    bool primed;       // Ring has filled once since the output started
+    bool dry;          // Ring was empty on the previous drain
+
+    volatile uint32_t underrunCount;
+    volatile uint32_t minFillSeen;
+    volatile uint32_t startCount;
+    uint32_t samplesOut;   // Handed to the real output since boot
+};
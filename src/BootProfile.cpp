@@ -0,0 +1,81 @@
+#include "BootProfile.h"
+
+BootProfile bootProfile;
+
+static portMUX_TYPE bootLock = portMUX_INITIALIZER_UNLOCKED;
+
+#define BOOT_BAR_WIDTH 40
+
+BootProfile::BootProfile() {
+  memset(phases, 0, sizeof(phases));
+  count = 0;
+  frameAt = interactiveAt = 0;
+}
+
+// ===== RECORDING =====
+int BootProfile::begin(const char *name) {
+  uint32_t now = micros();
+  int id = -1;
+  portENTER_CRITICAL(&bootLock);
+  if (count < BOOT_PHASES) {
+    id = count++;
+    phases[id].name = name;
+    phases[id].start = now;
+    phases[id].end = 0;
+    phases[id].core = xPortGetCoreID();
+  }
+  portEXIT_CRITICAL(&bootLock);
+  return id;
+}
+
+void BootProfile::end(int id) {
+  uint32_t now = micros();
+  if (id < 0 || id >= BOOT_PHASES) return;
+  portENTER_CRITICAL(&bootLock);
+  phases[id].end = max<uint32_t>(now, phases[id].start + 1);
+  portEXIT_CRITICAL(&bootLock);
+}
+
+void BootProfile::firstFrame() {
+  if (frameAt == 0) frameAt = micros();
+}
+
+void BootProfile::firstInteractive() {
+  if (interactiveAt == 0) interactiveAt = micros();
+}
+
+// ===== REPORT =====
+void BootProfile::printTimeline() {
+  BootPhase snap[BOOT_PHASES];
+  portENTER_CRITICAL(&bootLock);
+  int n = count;
+  memcpy(snap, phases, sizeof(snap));
+  portEXIT_CRITICAL(&bootLock);
+
+  // Bars span the first phase's start to the last stamp
+  uint32_t frame = frameAt, ready = interactiveAt;
+  uint32_t first = n > 0 ? snap[0].start : 0;
+  uint32_t last = max(frame, ready);
+  for (int i = 0; i < n; i++) last = max(last, snap[i].end ? snap[i].end : snap[i].start);
+  uint32_t scale = (last - first) / BOOT_BAR_WIDTH + 1;
+
+  Serial.printf("Boot timeline (ms since reset, one column = %.2f ms):\n", scale / 1000.0);
+  Serial.printf("  %-16s %4s %8s %8s\n", "phase", "core", "start", "took");
+  for (int i = 0; i < n; i++) {
+    const BootPhase &p = snap[i];
+    char bar[BOOT_BAR_WIDTH + 1];
+    int from = (p.start - first) / scale;
+    int to = p.end ? (p.end - 1 - first) / scale : from;
+    for (int c = 0; c < BOOT_BAR_WIDTH; c++) bar[c] = c < from ? ' ' : c <= to ? '#' : '\0';
+    bar[BOOT_BAR_WIDTH] = '\0';
+    if (p.end) {
+      Serial.printf("  %-16s %4u %8.1f %8.1f |%s\n", p.name, p.core, p.start / 1000.0,
+                    (p.end - p.start) / 1000.0, bar);
+    } else {
+      Serial.printf("  %-16s %4u %8.1f  running |%s\n", p.name, p.core, p.start / 1000.0, bar);
+    }
+  }
+  Serial.printf("  First frame at %.1f ms, first interactive frame at ", frame / 1000.0);
+  if (ready) Serial.printf("%.1f ms\n", ready / 1000.0);
+  else Serial.println("(not yet)");
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ===== BOOT PROFILE =====
+// Timeline of the startup phases: each phase records its start and end
+// (micros() since reset) and the core it ran on, so phases that run in
+// parallel show up as overlapping spans. Two milestones are stamped once:
+// the first frame on the panel (the UI shell) and the first interactive
+// frame (sound buttons drawn and the touch task running). The time to
+// the interactive frame is the number boot work is judged by.
+//
+// Any task may record phases (a short spinlock); not from ISRs.
+
+#define BOOT_PHASES 16
+
+struct BootPhase {
+  const char *name;                 // String literal
+  uint32_t start;
+  uint32_t end;                     // 0 while running
+  uint8_t core;
+};
+
+class BootProfile {
+  public:
+    BootProfile();
+
+    // Start a phase; returns its id for end() (-1 when the table is full)
+    int begin(const char *name);
+    void end(int id);
+
+    void firstFrame();
+    void firstInteractive();
+    bool interactive() const { return interactiveAt != 0; }
+    // Reset to the first interactive frame, in microseconds (0 until then)
+    uint32_t timeToInteractive() const { return interactiveAt; }
+
+    // Phases in start order, with an ASCII bar per phase on a common scale
+    void printTimeline();
+
+  private:
+    BootPhase phases[BOOT_PHASES];
+    int count;
+    volatile uint32_t frameAt;
+    volatile uint32_t interactiveAt;
+};
+
+extern BootProfile bootProfile;
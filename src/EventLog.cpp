@@ -0,0 +1,127 @@
+#include "EventLog.h"
+
+EventLog eventLog;
+
+static portMUX_TYPE producerLock = portMUX_INITIALIZER_UNLOCKED;
+static const char levelTag[] = "-EWID";
+
+EventLog::EventLog() {
+  task = nullptr;
+  statWritten = statDropped = 0;
+  reportedDropped = 0;
+  statMaxFill = 0;
+}
+
+bool EventLog::begin() {
+  if (xTaskCreatePinnedToCore(drainTask, "log", EVENT_LOG_TASK_STACK, this,
+                              EVENT_LOG_TASK_PRIORITY, &task, EVENT_LOG_TASK_CORE) != pdPASS) {
+    task = nullptr;
+    Serial.println("ERROR: Could not start log task");
+    return false;
+  }
+  Serial.printf("Event log: %d records, level %d\n", EVENT_LOG_RECORDS, EVENT_LOG_LEVEL);
+  return true;
+}
+
+// ===== PRODUCERS =====
+void EventLog::put(EventLogRecord &r, const char *s) {
+  if (s == nullptr) s = "(null)";
+  size_t room = EVENT_LOG_TEXT - r.textLen;
+  if (room == 0) return;
+  size_t n = strnlen(s, room - 1);
+  memcpy(r.text + r.textLen, s, n);
+  r.text[r.textLen + n] = '\0';
+  r.textLen += n + 1;
+}
+
+// Several tasks log, the ring takes one producer: serialize them for the
+// length of one record copy
+void EventLog::push(const EventLogRecord &r) {
+  portENTER_CRITICAL(&producerLock);
+  bool ok = ring.push(r);
+  if (ok) {
+    statWritten++;
+  } else {
+    statDropped++;
+  }
+  portEXIT_CRITICAL(&producerLock);
+}
+
+// ===== DRAIN TASK =====
+void EventLog::drainTask(void *arg) {
+  EventLog *self = (EventLog *)arg;
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(EVENT_LOG_DRAIN_MS));
+    self->drain();
+  }
+}
+
+void EventLog::drain() {
+  uint32_t fill = ring.available();
+  if (fill > statMaxFill) statMaxFill = fill;
+
+  EventLogRecord r;
+  while (ring.pop(r)) print(r);
+
+  uint32_t dropped = statDropped;
+  if (dropped != reportedDropped) {
+    Serial.printf("[log] %u records dropped (ring full)\n", dropped - reportedDropped);
+    reportedDropped = dropped;
+  }
+}
+
+// Expand the record's format one conversion at a time, taking integers and
+// strings from their own lists. Length modifiers are dropped: every integer
+// argument was stored as 32 bits.
+void EventLog::print(const EventLogRecord &r) {
+  char line[160];
+  int len = snprintf(line, sizeof(line), "[%5u.%06u] %c ", r.micros / 1000000, r.micros % 1000000,
+                     levelTag[r.level < sizeof(levelTag) - 1 ? r.level : 0]);
+  int arg = 0;
+  const char *text = r.text;
+  const char *textEnd = r.text + r.textLen;
+
+  for (const char *p = r.fmt; *p && len < (int)sizeof(line) - 1; ) {
+    if (*p != '%') {
+      line[len++] = *p++;
+      continue;
+    }
+    if (p[1] == '%') {
+      line[len++] = '%';
+      p += 2;
+      continue;
+    }
+
+    char spec[16];
+    int n = 0;
+    spec[n++] = *p++;
+    while (*p && strchr("-+ #0123456789.", *p) && n < (int)sizeof(spec) - 2) spec[n++] = *p++;
+    while (*p && strchr("hlzjt", *p)) p++;
+    char conv = *p ? *p++ : 's';
+    spec[n++] = conv;
+    spec[n] = '\0';
+
+    size_t room = sizeof(line) - len;
+    int w;
+    if (conv == 's') {
+      const char *s = text < textEnd ? text : "?";
+      if (text < textEnd) text += strlen(text) + 1;
+      w = snprintf(line + len, room, spec, s);
+    } else if (strchr("diouxXc", conv)) {
+      w = snprintf(line + len, room, spec, arg < r.argc ? r.args[arg] : 0);
+      arg++;
+    } else {
+      w = snprintf(line + len, room, "?");
+    }
+    if (w > 0) len += min<int>(w, room - 1);
+  }
+  line[len++] = '\n';
+  Serial.write((const uint8_t *)line, len);
+}
+
+// ===== STATISTICS =====
+void EventLog::printStats() {
+  Serial.printf("Event log: %u records, %u dropped, ring high water %u/%d, level %d\n",
+                statWritten, statDropped, statMaxFill, EVENT_LOG_RECORDS, EVENT_LOG_LEVEL);
+  statMaxFill = 0;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <Arduino.h>
+#include <type_traits>
+#include "SpscRing.h"
+
+// ===== DEFERRED EVENT LOG =====
+// Replaces Serial.printf on the hot paths (touch, play, mixer). A LOG_*()
+// call only copies a compact binary record into a preallocated ring: a
+// timestamp, the format string's address, up to EVENT_LOG_ARGS integer
+// arguments and the text of any string arguments. A low-priority task
+// formats and prints the records later, so a full UART FIFO stalls that
+// task instead of the tap-to-sound path.
+//
+// Arguments must be integers (at most 32 bits) or C strings; the format
+// must be a string literal. Levels above EVENT_LOG_LEVEL compile to
+// nothing, arguments included. When the ring is full records are dropped
+// and counted, and the drain task reports the count.
+//
+// Any task may log (producers take a short spinlock); not from ISRs.
+
+#define EVENT_LOG_NONE   0
+#define EVENT_LOG_ERROR  1
+#define EVENT_LOG_WARN   2
+#define EVENT_LOG_INFO   3
+#define EVENT_LOG_DEBUG  4
+
+#ifndef EVENT_LOG_LEVEL
+#define EVENT_LOG_LEVEL  EVENT_LOG_INFO
+#endif
+#ifndef EVENT_LOG_RECORDS
+#define EVENT_LOG_RECORDS 64        // Ring size (power of two)
+#endif
+#define EVENT_LOG_ARGS        6     // Integer arguments per record
+#define EVENT_LOG_TEXT        48    // String argument bytes per record, NULs included
+#define EVENT_LOG_DRAIN_MS    20
+#define EVENT_LOG_TASK_CORE   0
+#define EVENT_LOG_TASK_PRIORITY 1   // Below everything but idle
+#define EVENT_LOG_TASK_STACK  3072
+
+struct EventLogRecord {
+  uint32_t micros;
+  const char *fmt;
+  uint8_t level;
+  uint8_t argc;
+  uint8_t textLen;
+  int32_t args[EVENT_LOG_ARGS];
+  char text[EVENT_LOG_TEXT];        // String arguments, NUL-separated
+};
+
+class EventLog {
+  public:
+    EventLog();
+    bool begin();
+
+    template <typename... A>
+    void write(uint8_t level, const char *fmt, A... args) {
+      EventLogRecord r;
+      r.micros = micros();
+      r.fmt = fmt;
+      r.level = level;
+      r.argc = 0;
+      r.textLen = 0;
+      pack(r, args...);
+      push(r);
+    }
+
+    uint32_t dropped() const { return statDropped; }
+    void printStats();
+
+  private:
+    static void pack(EventLogRecord &r) { (void)r; }
+    template <typename T, typename... A>
+    static void pack(EventLogRecord &r, T first, A... rest) {
+      put(r, first);
+      pack(r, rest...);
+    }
+    template <typename T>
+    static void put(EventLogRecord &r, T v) {
+      static_assert((std::is_integral<T>::value || std::is_enum<T>::value) &&
+                        sizeof(T) <= sizeof(int32_t),
+                    "Log arguments must be integers of at most 32 bits or C strings");
+      if (r.argc < EVENT_LOG_ARGS) r.args[r.argc++] = (int32_t)v;
+    }
+    static void put(EventLogRecord &r, const char *s);
+    static void put(EventLogRecord &r, char *s) { put(r, (const char *)s); }
+
+    void push(const EventLogRecord &r);
+    static void drainTask(void *arg);
+    void drain();
+    void print(const EventLogRecord &r);
+
+    SpscRing<EventLogRecord, EVENT_LOG_RECORDS> ring;
+    TaskHandle_t task;
+
+    volatile uint32_t statWritten;
+    volatile uint32_t statDropped;
+    uint32_t reportedDropped;       // Drain task: drops already reported
+    uint32_t statMaxFill;
+};
+
+extern EventLog eventLog;
+
+// Never called: lets the compiler check arguments against the format
+static inline void eventLogCheck(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static inline void eventLogCheck(const char *fmt, ...) { (void)fmt; }
+
+#define EVENT_LOG_WRITE(level, ...) \
+  do { if (false) eventLogCheck(__VA_ARGS__); eventLog.write(level, __VA_ARGS__); } while (0)
+
+#if EVENT_LOG_LEVEL >= EVENT_LOG_ERROR
+#define LOG_ERROR(...) EVENT_LOG_WRITE(EVENT_LOG_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do {} while (0)
+#endif
+#if EVENT_LOG_LEVEL >= EVENT_LOG_WARN
+#define LOG_WARN(...)  EVENT_LOG_WRITE(EVENT_LOG_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...)  do {} while (0)
+#endif
+#if EVENT_LOG_LEVEL >= EVENT_LOG_INFO
+#define LOG_INFO(...)  EVENT_LOG_WRITE(EVENT_LOG_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...)  do {} while (0)
+#endif
+#if EVENT_LOG_LEVEL >= EVENT_LOG_DEBUG
+#define LOG_DEBUG(...) EVENT_LOG_WRITE(EVENT_LOG_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while (0)
+#endif
@@ -0,0 +1,83 @@
+#include "HeapStats.h"
+
+HeapStats heapStats;
+
+static std::atomic<uint32_t> allocCount(0);
+
+// ===== ALLOCATION COUNTER =====
+#ifdef HEAP_COUNT_ALLOCS
+// Every malloc/calloc/realloc in the image lands here first
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  allocCount.fetch_add(1, std::memory_order_relaxed);
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+  allocCount.fetch_add(1, std::memory_order_relaxed);
+  return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+  allocCount.fetch_add(1, std::memory_order_relaxed);
+  return __real_realloc(ptr, size);
+}
+}
+#endif
+
+uint32_t heapAllocations() {
+  return allocCount.load(std::memory_order_relaxed);
+}
+
+HeapStats::HeapStats() {
+  steadyBase = 0;
+  steady = false;
+  plays = allocatingPlays = playAllocsMax = 0;
+  allocatingPasses = passAllocs = 0;
+}
+
+void HeapStats::markSteady() {
+  if (steady) return;
+  steadyBase = heapAllocations();
+  steady = true;
+}
+
+void HeapStats::recordPlay(uint32_t allocs) {
+  plays++;
+  if (allocs == 0) return;
+  allocatingPlays++;
+  if (allocs > playAllocsMax) playAllocsMax = allocs;
+}
+
+void HeapStats::recordPass(uint32_t allocs) {
+  if (allocs == 0) return;
+  allocatingPasses++;
+  passAllocs += allocs;
+}
+
+// ===== REPORT =====
+void HeapStats::printStats() {
+  uint32_t total = heapAllocations();
+  Serial.printf("Heap: %u bytes free (min %u), largest free block %u\n",
+                ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap());
+#ifdef HEAP_COUNT_ALLOCS
+  if (steady) {
+    Serial.printf("  Allocations: %u since boot, %u since the first interactive frame\n",
+                  total, total - steadyBase);
+  } else {
+    Serial.printf("  Allocations: %u since boot (still booting)\n", total);
+  }
+  Serial.printf("  Plays: %u, %u allocated (most in one play: %u); mixer passes: %u "
+                "allocated, %u allocations\n",
+                plays, allocatingPlays, playAllocsMax, allocatingPasses, passAllocs);
+#else
+  (void)total;
+  Serial.println("  Allocation count off (build with HEAP_COUNT_ALLOCS)");
+#endif
+  plays = allocatingPlays = playAllocsMax = 0;
+  allocatingPasses = passAllocs = 0;
+}
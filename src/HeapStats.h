@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// ===== HEAP TELEMETRY =====
+// Evidence that the board's steady state leaves the heap alone: free heap,
+// its low-water mark and largest free block (fragmentation), and a count
+// of allocations since boot. Everything the play path needs (voices,
+// file sources and their read-ahead buffers, decode buffers, filter
+// tables, the cache arena) is allocated at boot; after the first
+// interactive frame the count should only move when a loose WAV is opened
+// through the FS layer: the first play of a sound on a voice, a cache
+// fill, the one-off silence analysis. A sound bank (tools/build_bank.py)
+// is opened once, so with one nothing allocates.
+//
+// The count needs HEAP_COUNT_ALLOCS and the linker wrapping malloc,
+// calloc and realloc (-Wl,--wrap=..., see platformio.ini); operator new
+// comes through malloc. Allocations newlib makes internally (stdio FILE
+// buffers) and heap_caps_malloc() calls are not seen. Without the flag
+// the count reads 0.
+//
+// The mixer task brackets each play command and each mixer pass (where
+// cache hits open their files and the cache fills), so the report names
+// the side that allocated. Any task's allocations in such a window are
+// counted with it.
+
+class HeapStats {
+  public:
+    HeapStats();
+
+    // loop(): boot is over, later allocations are the steady state
+    void markSteady();
+
+    // Mixer task: allocations made while starting a sound, and during a
+    // render and cache service pass
+    void recordPlay(uint32_t allocs);
+    void recordPass(uint32_t allocs);
+
+    // Heap state, allocations since boot and since steady state, and the
+    // play and pass counts, which then start a new window
+    void printStats();
+
+  private:
+    uint32_t steadyBase;              // Allocation count at markSteady()
+    volatile bool steady;
+    volatile uint32_t plays;
+    volatile uint32_t allocatingPlays;
+    volatile uint32_t playAllocsMax;
+    volatile uint32_t allocatingPasses;
+    volatile uint32_t passAllocs;
+};
+
+// Allocations since boot (0 without HEAP_COUNT_ALLOCS)
+uint32_t heapAllocations();
+
+extern HeapStats heapStats;
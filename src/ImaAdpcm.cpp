@@ -0,0 +1,136 @@
+#include "ImaAdpcm.h"
+
+static const int16_t stepTable[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+  253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+  1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+  3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+  11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+  32767
+};
+
+static const int8_t indexTable[16] = {
+  -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+struct ImaChannel {
+  int32_t pred;
+  int32_t index;
+};
+
+static inline void readHeader(const uint8_t *p, ImaChannel &c) {
+  c.pred = (int16_t)(p[0] | (p[1] << 8));
+  c.index = p[2] > 88 ? 88 : p[2];
+}
+
+// Apply one nibble to the channel state; returns the new sample
+static inline int32_t expand(ImaChannel &c, uint32_t nibble) {
+  int32_t step = stepTable[c.index];
+  int32_t diff = step >> 3;
+  if (nibble & 4) diff += step;
+  if (nibble & 2) diff += step >> 1;
+  if (nibble & 1) diff += step >> 2;
+  int32_t pred = (nibble & 8) ? c.pred - diff : c.pred + diff;
+  if (pred > 32767) pred = 32767;
+  else if (pred < -32768) pred = -32768;
+  c.pred = pred;
+  int32_t index = c.index + indexTable[nibble];
+  c.index = index < 0 ? 0 : (index > 88 ? 88 : index);
+  return pred;
+}
+
+// ===== DECODER =====
+int imaDecodeBlock(const uint8_t *block, uint32_t bytes, int channels, int16_t *out) {
+  if (bytes < (uint32_t)channels * IMA_HEADER_BYTES) return 0;
+
+  if (channels == 1) {
+    ImaChannel c;
+    readHeader(block, c);
+    int16_t *o = out;
+    *o++ = c.pred;
+    for (const uint8_t *p = block + IMA_HEADER_BYTES, *end = block + bytes; p < end; p++) {
+      *o++ = expand(c, *p & 15);
+      *o++ = expand(c, *p >> 4);
+    }
+    return o - out;
+  }
+
+  // Stereo: left's 8 samples of a group go to out, right's are averaged in
+  ImaChannel l, r;
+  readHeader(block, l);
+  readHeader(block + IMA_HEADER_BYTES, r);
+  out[0] = (l.pred + r.pred) >> 1;
+  int groups = (bytes - 2 * IMA_HEADER_BYTES) / 8;
+  const uint8_t *p = block + 2 * IMA_HEADER_BYTES;
+  int16_t *o = out + 1;
+  for (int g = 0; g < groups; g++, p += 8, o += 8) {
+    for (int k = 0; k < 4; k++) {
+      o[2 * k] = expand(l, p[k] & 15);
+      o[2 * k + 1] = expand(l, p[k] >> 4);
+    }
+    for (int k = 0; k < 4; k++) {
+      o[2 * k] = (o[2 * k] + expand(r, p[4 + k] & 15)) >> 1;
+      o[2 * k + 1] = (o[2 * k + 1] + expand(r, p[4 + k] >> 4)) >> 1;
+    }
+  }
+  return 1 + groups * 8;
+}
+
+// ===== ENCODER =====
+// Nibble that brings the predictor closest to s, applied as the decoder will
+static inline uint8_t compress(ImaChannel &c, int32_t s) {
+  int32_t step = stepTable[c.index];
+  int32_t diff = s - c.pred;
+  uint8_t nibble = 0;
+  if (diff < 0) {
+    nibble = 8;
+    diff = -diff;
+  }
+  if (diff >= step) {
+    nibble |= 4;
+    diff -= step;
+  }
+  step >>= 1;
+  if (diff >= step) {
+    nibble |= 2;
+    diff -= step;
+  }
+  step >>= 1;
+  if (diff >= step) nibble |= 1;
+  expand(c, nibble);
+  return nibble;
+}
+
+int imaEncodeBlock(ImaEncoder &enc, const int16_t *in, int samples, int channels, uint8_t *out) {
+  if (samples < 1) return 0;
+  int groups = (samples - 1 + 7) / 8;
+  uint8_t *p = out + channels * IMA_HEADER_BYTES;
+
+  for (int ch = 0; ch < channels; ch++) {
+    ImaChannel c;
+    c.pred = in[ch];
+    c.index = enc.index[ch];
+    uint8_t *h = out + ch * IMA_HEADER_BYTES;
+    h[0] = c.pred & 0xFF;
+    h[1] = (c.pred >> 8) & 0xFF;
+    h[2] = c.index;
+    h[3] = 0;
+
+    // Nibbles of this channel; past the end the last sample repeats
+    for (int g = 0; g < groups; g++) {
+      uint8_t *q = p + (g * channels + ch) * 4;
+      for (int k = 0; k < 8; k += 2) {
+        int i0 = 1 + g * 8 + k;
+        int i1 = i0 + 1;
+        if (i0 >= samples) i0 = samples - 1;
+        if (i1 >= samples) i1 = samples - 1;
+        uint8_t lo = compress(c, in[i0 * channels + ch]);
+        uint8_t hi = compress(c, in[i1 * channels + ch]);
+        q[k / 2] = lo | (hi << 4);
+      }
+    }
+    enc.index[ch] = c.index;
+  }
+  return channels * (IMA_HEADER_BYTES + groups * 4);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ===== IMA ADPCM =====
+// 4-bit IMA (DVI) ADPCM in the WAV block layout. Each block starts with a
+// 4-byte header per channel (first sample, step index) and decodes on its
+// own; nibbles follow low nibble first, for stereo in groups of 4 bytes
+// (8 samples) per channel. One sample takes 4 bits instead of 16 or 24.
+//
+// The decoder turns a whole block into mono 16-bit (stereo averaged) in
+// one pass. The encoder is used by the PCM cache to keep heads compressed
+// and by the host tools; it matches tools/encode_adpcm.py.
+
+#define IMA_HEADER_BYTES 4   // Per channel
+
+// Samples per channel in a full block of blockAlign bytes
+inline int imaBlockSamples(int blockAlign, int channels) {
+  return (blockAlign / channels - IMA_HEADER_BYTES) * 2 + 1;
+}
+
+// Block bytes for `samples` per channel (samples - 1 a multiple of 8)
+inline int imaBlockAlign(int samples, int channels) {
+  return channels * (IMA_HEADER_BYTES + (samples - 1) / 2);
+}
+
+// Encoder state carried from block to block: only the step index, as each
+// block header restarts the predictor
+struct ImaEncoder {
+  uint8_t index[2];
+};
+
+// Decode a block of `bytes` bytes (a short last block decodes its complete
+// sample groups). Returns the number of mono samples written to out.
+int imaDecodeBlock(const uint8_t *block, uint32_t bytes, int channels, int16_t *out);
+
+// Encode `samples` interleaved frames as one block, padding the last
+// group with silence. Returns the block's length in bytes.
+int imaEncodeBlock(ImaEncoder &enc, const int16_t *in, int samples, int channels, uint8_t *out);
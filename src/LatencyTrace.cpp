@@ -0,0 +1,160 @@
+#include "LatencyTrace.h"
+
+LatencyTrace latencyTrace;
+
+static portMUX_TYPE traceLock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const stageNames[TRACE_STAGES] = {
+  "touch irq", "touch read", "handleTouch", "playSound", "mixer command",
+  "file open", "wav header", "stream begin", "first render", "first output",
+};
+
+LatencyTrace::LatencyTrace() {
+  memset(stamps, 0, sizeof(stamps));
+  stamped = 0;
+  active = false;
+  voiceClaimed = false;
+  waitingOutput = false;
+  outputTarget = 0;
+  memset(stages, 0, sizeof(stages));
+  memset(&total, 0, sizeof(total));
+  abandoned = 0;
+}
+
+// ===== TRACE POINTS =====
+void LatencyTrace::begin(TraceStage stage, uint32_t micros) {
+  portENTER_CRITICAL(&traceLock);
+  if (active) abandoned++;
+  stamped = 1 << stage;
+  stamps[stage] = micros;
+  active = true;
+  voiceClaimed = false;
+  waitingOutput.store(false, std::memory_order_relaxed);
+  portEXIT_CRITICAL(&traceLock);
+}
+
+void LatencyTrace::beginIfIdle(TraceStage stage) {
+  uint32_t now = micros();
+  bool fresh = false;
+  portENTER_CRITICAL(&traceLock);
+  if (active) {
+    for (int s = 0; s < TRACE_STAGES; s++) {
+      if (stamped & (1 << s)) {
+        fresh = now - stamps[s] < TRACE_STALE_MS * 1000UL;
+        break;
+      }
+    }
+  }
+  portEXIT_CRITICAL(&traceLock);
+  if (!fresh) begin(stage, now);
+}
+
+void LatencyTrace::markAt(TraceStage stage, uint32_t micros) {
+  portENTER_CRITICAL(&traceLock);
+  if (active && !(stamped & (1 << stage))) {
+    stamps[stage] = micros;
+    stamped |= 1 << stage;
+  }
+  portEXIT_CRITICAL(&traceLock);
+}
+
+bool LatencyTrace::claimVoice() {
+  bool claimed = false;
+  portENTER_CRITICAL(&traceLock);
+  if (active && (stamped & (1 << TRACE_MIX_COMMAND)) && !voiceClaimed) {
+    voiceClaimed = claimed = true;
+  }
+  portEXIT_CRITICAL(&traceLock);
+  return claimed;
+}
+
+void LatencyTrace::firstRender(uint32_t index) {
+  uint32_t now = micros();
+  portENTER_CRITICAL(&traceLock);
+  if (active && voiceClaimed && !(stamped & (1 << TRACE_FIRST_RENDER))) {
+    stamps[TRACE_FIRST_RENDER] = now;
+    stamped |= 1 << TRACE_FIRST_RENDER;
+    outputTarget = index;
+    waitingOutput.store(true, std::memory_order_release);
+  }
+  portEXIT_CRITICAL(&traceLock);
+}
+
+// Runs in the output task: stamp the last stage and fold the trace into
+// the histograms
+void LatencyTrace::finish() {
+  uint32_t now = micros();
+  portENTER_CRITICAL(&traceLock);
+  if (active && waitingOutput.load(std::memory_order_relaxed)) {
+    stamps[TRACE_FIRST_OUTPUT] = now;
+    stamped |= 1 << TRACE_FIRST_OUTPUT;
+
+    int first = -1, prev = -1;
+    for (int s = 0; s < TRACE_STAGES; s++) {
+      if (!(stamped & (1 << s))) continue;
+      if (prev < 0) first = s;
+      else add(stages[s], stamps[s] - stamps[prev]);
+      prev = s;
+    }
+    add(total, stamps[TRACE_FIRST_OUTPUT] - stamps[first]);
+    active = false;
+    waitingOutput.store(false, std::memory_order_relaxed);
+  }
+  portEXIT_CRITICAL(&traceLock);
+}
+
+// ===== HISTOGRAMS =====
+// Exact below 4 us, then four buckets per power of two
+int LatencyTrace::bucketOf(uint32_t us) {
+  if (us < 4) return us;
+  int octave = 31 - __builtin_clz(us);
+  int b = (octave - 1) * 4 + ((us >> (octave - 2)) & 3);
+  return b < TRACE_BUCKETS ? b : TRACE_BUCKETS - 1;
+}
+
+// Largest value that falls in bucket b
+uint32_t LatencyTrace::bucketTop(int b) {
+  if (b < 4) return b;
+  int octave = b / 4 + 1;
+  uint32_t width = 1UL << (octave - 2);
+  return (4 + b % 4) * width + width - 1;
+}
+
+void LatencyTrace::add(TraceHistogram &h, uint32_t us) {
+  uint16_t &n = h.buckets[bucketOf(us)];
+  if (n < UINT16_MAX) n++;
+  h.count++;
+  if (us > h.max) h.max = us;
+}
+
+uint32_t LatencyTrace::percentile(const TraceHistogram &h, uint32_t permille) {
+  uint32_t rank = (h.count * permille + 999) / 1000;
+  uint32_t seen = 0;
+  for (int b = 0; b < TRACE_BUCKETS; b++) {
+    seen += h.buckets[b];
+    if (seen >= rank) return min(bucketTop(b), h.max);
+  }
+  return h.max;
+}
+
+void LatencyTrace::printHistograms() {
+  Serial.printf("Latency trace: %u sounds traced to the first output sample, %u touches without one\n",
+                total.count, abandoned);
+  if (total.count > 0) {
+    Serial.printf("  %-14s %6s %8s %8s %8s\n", "stage", "count", "p50 us", "p99 us", "max us");
+    for (int s = 1; s < TRACE_STAGES; s++) {
+      const TraceHistogram &h = stages[s];
+      if (h.count == 0) continue;
+      Serial.printf("  %-14s %6u %8u %8u %8u\n", stageNames[s], h.count,
+                    percentile(h, 500), percentile(h, 990), h.max);
+    }
+    Serial.printf("  %-14s %6u %8u %8u %8u\n", "end to end", total.count,
+                  percentile(total, 500), percentile(total, 990), total.max);
+  }
+
+  portENTER_CRITICAL(&traceLock);
+  memset(stages, 0, sizeof(stages));
+  memset(&total, 0, sizeof(total));
+  abandoned = 0;
+  portEXIT_CRITICAL(&traceLock);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// ===== TAP-TO-SOUND LATENCY TRACE =====
+// Trace points along the path from a finger landing to the first sample of
+// the sound reaching the I2S driver. A touch-down starts a trace; each
+// stage stamps the time the first time it is reached; when the first
+// output sample goes out, the gaps between consecutive stamped stages and
+// the end-to-end time are added to per-stage histograms (quarter-octave
+// buckets, so p50/p99 are within ~12%). Stages a tap skips (a cached head
+// opens its file after playing, a synth opens none) are left out of it.
+//
+// Stamps come from micros(): the stages run on both cores, and each core
+// has its own cycle counter. Only one trace is in flight; a new touch
+// replaces an unfinished one, and playSound() without a recent touch
+// (serial, bench) starts its own.
+
+#define TRACE_BUCKETS   96           // Quarter octaves up to ~16 s
+#define TRACE_STALE_MS  500          // Touch too old to be this sound's cause
+
+enum TraceStage : uint8_t {
+  TRACE_TOUCH_IRQ = 0,               // Touch interrupt edge
+  TRACE_TOUCH_READ,                  // Controller read done in the touch task
+  TRACE_HANDLE_TOUCH,                // loop() dispatches the tap
+  TRACE_PLAY_SOUND,                  // Play command posted to the audio task
+  TRACE_MIX_COMMAND,                 // Mixer task picked the command up
+  TRACE_FILE_OPEN,                   // WAV opened on the card
+  TRACE_WAV_HEADER,                  // Header parsed
+  TRACE_STREAM_BEGIN,                // Decoder set up
+  TRACE_FIRST_RENDER,                // First block with the voice in the ring
+  TRACE_FIRST_OUTPUT,                // That block's first sample taken by I2S
+  TRACE_STAGES,
+};
+
+struct TraceHistogram {
+  uint16_t buckets[TRACE_BUCKETS];
+  uint32_t count;
+  uint32_t max;
+};
+
+class LatencyTrace {
+  public:
+    LatencyTrace();
+
+    // Start a new trace with `stage` stamped at `micros`
+    void begin(TraceStage stage, uint32_t micros);
+    // Start one at `stage` unless a recent trace is in flight
+    void beginIfIdle(TraceStage stage);
+
+    void mark(TraceStage stage) { markAt(stage, micros()); }
+    void markAt(TraceStage stage, uint32_t micros);
+
+    // Mixer task: a new voice may belong to the trace (the first one
+    // started after the play command does)
+    bool claimVoice();
+    // Mixer task: the traced voice's first sample is output sample `index`
+    void firstRender(uint32_t index);
+    // Output task: `total` samples have been handed to the output so far
+    void outputProgress(uint32_t total) {
+      if (waitingOutput.load(std::memory_order_acquire) && (int32_t)(total - outputTarget) > 0) {
+        finish();
+      }
+    }
+
+    // Per-stage p50/p99/max, then start a new measurement window
+    void printHistograms();
+
+  private:
+    void finish();
+    static int bucketOf(uint32_t us);
+    static uint32_t bucketTop(int b);
+    static void add(TraceHistogram &h, uint32_t us);
+    static uint32_t percentile(const TraceHistogram &h, uint32_t permille);
+
+    uint32_t stamps[TRACE_STAGES];
+    uint16_t stamped;                // Bit per stage
+    bool active;
+    bool voiceClaimed;
+    std::atomic<bool> waitingOutput;
+    volatile uint32_t outputTarget;
+
+    TraceHistogram stages[TRACE_STAGES];   // Gap from the previous stamped stage
+    TraceHistogram total;                  // Touch (or play) to first output
+    volatile uint32_t abandoned;           // Replaced before reaching the output
+};
+
+extern LatencyTrace latencyTrace;
@@ -0,0 +1,218 @@
+#include "PcmCache.h"
+
+PcmCache::PcmCache() {
+  memset(entries, 0, sizeof(entries));
+  arena = nullptr;
+  clock = 0;
+  fillSrc = nullptr;
+  filling = nullptr;
+  queueHead = queueLen = 0;
+  hits = misses = evictions = fills = 0;
+  ttfsHitTotal = ttfsHitMax = ttfsHitCount = 0;
+  ttfsMissTotal = ttfsMissMax = ttfsMissCount = 0;
+}
+
+bool PcmCache::begin(AudioFileSource *fillSource) {
+  fillSrc = fillSource;
+  arena = (uint8_t *)malloc(PCM_CACHE_SLOTS * PCM_CACHE_SLOT_BYTES);
+  if (arena == nullptr) {
+    Serial.println("ERROR: PCM cache allocation failed");
+    return false;
+  }
+  for (int i = 0; i < PCM_CACHE_SLOTS; i++) {
+    entries[i].tag = -1;
+    entries[i].adpcm = arena + i * PCM_CACHE_SLOT_BYTES;
+  }
+  Serial.printf("PCM cache: %d slots x %u ms (%u bytes as ADPCM, %u as 16-bit)\n",
+                PCM_CACHE_SLOTS, PCM_CACHE_HEAD_MS, PCM_CACHE_SLOTS * PCM_CACHE_SLOT_BYTES,
+                PCM_CACHE_SLOTS * PCM_CACHE_HEAD_SAMPLES * 2);
+  return true;
+}
+
+PcmCacheEntry *PcmCache::findEntry(int tag) {
+  for (int i = 0; i < PCM_CACHE_SLOTS; i++) {
+    if (entries[i].state != CACHE_EMPTY && entries[i].tag == tag) return &entries[i];
+  }
+  return nullptr;
+}
+
+PcmCacheEntry *PcmCache::acquire(int tag) {
+  if (arena == nullptr) return nullptr;
+  PcmCacheEntry *e = findEntry(tag);
+  if (e == nullptr || e->state != CACHE_READY) {
+    misses++;
+    return nullptr;
+  }
+  hits++;
+  e->users++;
+  e->lastUsed = ++clock;
+  return e;
+}
+
+void PcmCache::release(PcmCacheEntry *entry) {
+  if (entry != nullptr && entry->users > 0) entry->users--;
+}
+
+// Pick a slot for a new head: an empty one, else the least recently used
+// entry that no voice is playing from
+PcmCacheEntry *PcmCache::evictLRU() {
+  PcmCacheEntry *victim = nullptr;
+  for (int i = 0; i < PCM_CACHE_SLOTS; i++) {
+    PcmCacheEntry &e = entries[i];
+    if (e.state == CACHE_EMPTY) return &e;
+    if (e.state != CACHE_READY || e.users > 0) continue;
+    if (victim == nullptr || (int32_t)(e.lastUsed - victim->lastUsed) < 0) victim = &e;
+  }
+  if (victim != nullptr) {
+    evictions++;
+    victim->state = CACHE_EMPTY;
+  }
+  return victim;
+}
+
+// ===== BACKGROUND FILL =====
+void PcmCache::request(int tag, const char *path, const WavTrim *trim) {
+  if (arena == nullptr || findEntry(tag) != nullptr) {
+    return;
+  }
+  for (int i = 0; i < queueLen; i++) {
+    if (queue[(queueHead + i) % PCM_CACHE_QUEUE].tag == tag) return;
+  }
+  if (queueLen == PCM_CACHE_QUEUE) {
+    // Drop the oldest request; newer ones reflect what is on screen now
+    queueHead = (queueHead + 1) % PCM_CACHE_QUEUE;
+    queueLen--;
+  }
+  int slot = (queueHead + queueLen) % PCM_CACHE_QUEUE;
+  queue[slot].tag = tag;
+  strncpy(queue[slot].path, path, PCM_CACHE_PATH_LEN - 1);
+  queue[slot].path[PCM_CACHE_PATH_LEN - 1] = '\0';
+  queue[slot].trim.startFrame = trim ? trim->startFrame : 0;
+  queue[slot].trim.endFrame = trim ? trim->endFrame : 0;
+  queueLen++;
+}
+
+void PcmCache::invalidate(int tag) {
+  PcmCacheEntry *e = findEntry(tag);
+  if (e == nullptr || e->users > 0) return;
+  if (e == filling) {
+    fillSrc->close();
+    filling = nullptr;
+  }
+  e->state = CACHE_EMPTY;
+}
+
+bool PcmCache::startFill() {
+  while (queueLen > 0) {
+    int tag = queue[queueHead].tag;
+    const char *path = queue[queueHead].path;
+    const WavTrim *trim = &queue[queueHead].trim;
+    queueHead = (queueHead + 1) % PCM_CACHE_QUEUE;
+    queueLen--;
+
+    if (findEntry(tag) != nullptr) continue;
+    PcmCacheEntry *e = evictLRU();
+    if (e == nullptr) return false;  // Every slot is in use right now
+
+    if (!fillSrc->open(path)) continue;
+    if (!parseWavHeader(fillSrc, e->info) ||
+        !fillStream.begin(fillSrc, e->info, AUDIO_SAMPLE_RATE, trim)) {
+      fillSrc->close();
+      continue;
+    }
+
+    e->tag = tag;
+    e->state = CACHE_FILLING;
+    e->users = 0;
+    e->samples = 0;
+    e->complete = false;
+    memset(&fillEncoder, 0, sizeof(fillEncoder));
+    filling = e;
+    return true;
+  }
+  return false;
+}
+
+// Compress the samples gathered for the current block. Blocks are filled in
+// order, so a partial one is always the last.
+void PcmCache::encodeBlock() {
+  PcmCacheEntry *e = filling;
+  uint32_t block = (e->samples - 1) / PCM_CACHE_BLOCK_SAMPLES;
+  int n = e->samples - block * PCM_CACHE_BLOCK_SAMPLES;
+  imaEncodeBlock(fillEncoder, fillBlock, n, 1, e->adpcm + block * PCM_CACHE_BLOCK_BYTES);
+}
+
+void PcmCache::finishFill() {
+  PcmCacheEntry *e = filling;
+  // Remember the exact point to resume: rewind past frames that were read
+  // ahead into the decode buffer but not yet turned into output samples
+  e->resumeOffset = fillSrc->getPos() - fillStream.unconsumedBytes();
+  fillStream.dropBuffered();
+  e->resume = fillStream;
+  e->resume.src = nullptr;
+  e->complete = (fillStream.bytesLeft == 0);
+  e->state = CACHE_READY;
+  e->lastUsed = ++clock;
+  fillSrc->close();
+  filling = nullptr;
+  fills++;
+}
+
+void PcmCache::service() {
+  if (filling == nullptr && !startFill()) return;
+
+  int32_t acc[128];
+  int budget = PCM_CACHE_FILL_SLICE;
+  while (budget > 0) {
+    uint32_t room = PCM_CACHE_HEAD_SAMPLES - filling->samples;
+    uint32_t pos = filling->samples % PCM_CACHE_BLOCK_SAMPLES;
+    if (PCM_CACHE_BLOCK_SAMPLES - pos < room) room = PCM_CACHE_BLOCK_SAMPLES - pos;
+    int n = room < 128 ? room : 128;
+    if (n == 0) break;
+
+    memset(acc, 0, n * sizeof(int32_t));
+    int got = fillStream.render(fillIn, acc, n, 32768);
+    int16_t *dst = fillBlock + pos;
+    for (int i = 0; i < got; i++) {
+      int32_t s = acc[i];
+      dst[i] = (int16_t)(s > 32767 ? 32767 : (s < -32768 ? -32768 : s));
+    }
+    filling->samples += got;
+    budget -= got;
+    bool ended = got < n;  // Sound shorter than the head
+    if (pos + got > 0 && (ended || pos + got == PCM_CACHE_BLOCK_SAMPLES ||
+                    filling->samples == PCM_CACHE_HEAD_SAMPLES)) {
+      encodeBlock();
+    }
+    if (ended) break;
+  }
+
+  if (budget > 0 || filling->samples >= PCM_CACHE_HEAD_SAMPLES) {
+    finishFill();
+  }
+}
+
+// ===== STATISTICS =====
+void PcmCache::recordFirstSample(bool hit, uint32_t us) {
+  if (hit) {
+    ttfsHitTotal += us;
+    ttfsHitCount++;
+    if (us > ttfsHitMax) ttfsHitMax = us;
+  } else {
+    ttfsMissTotal += us;
+    ttfsMissCount++;
+    if (us > ttfsMissMax) ttfsMissMax = us;
+  }
+}
+
+void PcmCache::printStats() {
+  int ready = 0;
+  for (int i = 0; i < PCM_CACHE_SLOTS; i++) {
+    if (entries[i].state == CACHE_READY) ready++;
+  }
+  Serial.printf("PCM cache: %d/%d ready, %u hits, %u misses, %u fills, %u evictions\n",
+                ready, PCM_CACHE_SLOTS, hits, misses, fills, evictions);
+  Serial.printf("  Time to first sample: hit avg %u us (max %u), miss avg %u us (max %u)\n",
+                ttfsHitCount ? ttfsHitTotal / ttfsHitCount : 0, ttfsHitMax,
+                ttfsMissCount ? ttfsMissTotal / ttfsMissCount : 0, ttfsMissMax);
+}
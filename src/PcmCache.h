@@ -0,0 +1,115 @@
+#pragma once
+
+#include <Arduino.h>
+#include "AudioFileSource.h"
+#include "AudioConfig.h"
+#include "ImaAdpcm.h"
+#include "PcmStream.h"
+
+// ===== DECODED PCM CACHE =====
+// Size-bounded LRU cache holding the first PCM_CACHE_HEAD_MS of a sound,
+// already converted to the mixer's output format (mono at
+// AUDIO_SAMPLE_RATE) and kept as IMA ADPCM blocks, a quarter of the size of
+// 16-bit samples and still finer than the 8-bit DAC. A cache hit starts playing from RAM immediately; the
+// entry also records where in the file the head ends so the mixer can open
+// the file and stream the rest while the head plays.
+//
+// Entries are fixed-size slots carved from one buffer allocated at boot.
+// Heads are filled in the background from a request queue, a slice at a
+// time, by service() called from the audio engine's mixer task.
+
+#ifndef PCM_CACHE_SLOTS
+#define PCM_CACHE_SLOTS 6
+#endif
+#ifndef PCM_CACHE_HEAD_MS
+#define PCM_CACHE_HEAD_MS 250
+#endif
+
+#define PCM_CACHE_HEAD_SAMPLES ((uint32_t)AUDIO_SAMPLE_RATE * PCM_CACHE_HEAD_MS / 1000)
+#define PCM_CACHE_QUEUE      8
+#define PCM_CACHE_PATH_LEN   24
+#define PCM_CACHE_FILL_SLICE 256   // Output samples decoded per service() call
+#define PCM_CACHE_BLOCK_SAMPLES 249  // Per ADPCM block (fits a voice's decode buffer)
+#define PCM_CACHE_BLOCK_BYTES   imaBlockAlign(PCM_CACHE_BLOCK_SAMPLES, 1)
+#define PCM_CACHE_HEAD_BLOCKS \
+  ((PCM_CACHE_HEAD_SAMPLES + PCM_CACHE_BLOCK_SAMPLES - 1) / PCM_CACHE_BLOCK_SAMPLES)
+#define PCM_CACHE_SLOT_BYTES (PCM_CACHE_HEAD_BLOCKS * PCM_CACHE_BLOCK_BYTES)
+
+enum PcmCacheState : uint8_t {
+  CACHE_EMPTY = 0,
+  CACHE_FILLING,
+  CACHE_READY,
+};
+
+struct PcmCacheEntry {
+  int16_t tag;
+  uint8_t state;
+  uint8_t users;           // Voices playing from this entry (not evictable)
+  uint32_t lastUsed;
+  uint32_t samples;        // Head length in output samples
+  bool complete;           // Whole sound fits in the head, nothing to stream
+
+  // Where streaming resumes once the head has played
+  WavInfo info;
+  uint32_t resumeOffset;   // File offset of the first frame after the head
+  PcmStream resume;        // Interpolation state and bytes left at that point
+
+  uint8_t *adpcm;          // PCM_CACHE_HEAD_BLOCKS blocks of PCM_CACHE_BLOCK_BYTES
+};
+
+class PcmCache {
+  public:
+    PcmCache();
+
+    // fillSource: a file source dedicated to background decoding
+    bool begin(AudioFileSource *fillSource);
+    // Swap the fill source; only before the first request() is posted
+    void setFillSource(AudioFileSource *fillSource) { fillSrc = fillSource; }
+
+    // Look up a ready entry and pin it; counts a hit or a miss
+    PcmCacheEntry *acquire(int tag);
+    void release(PcmCacheEntry *entry);
+
+    // Ask for a sound's head to be decoded in the background, starting at
+    // the trim's first audible frame when one is given
+    void request(int tag, const char *path, const WavTrim *trim = nullptr);
+    void service();
+    bool idle() const { return filling == nullptr && queueLen == 0; }
+
+    // Drop a sound's head, e.g. after its trim points changed
+    void invalidate(int tag);
+
+    // Time from play request to first rendered sample, in microseconds
+    void recordFirstSample(bool hit, uint32_t micros);
+    void printStats();
+
+  private:
+    PcmCacheEntry *findEntry(int tag);
+    PcmCacheEntry *evictLRU();
+    bool startFill();
+    void finishFill();
+    void encodeBlock();
+
+    PcmCacheEntry entries[PCM_CACHE_SLOTS];
+    uint8_t *arena;
+    uint32_t clock;
+
+    // Background fill
+    AudioFileSource *fillSrc;
+    PcmCacheEntry *filling;
+    PcmStream fillStream;
+    int16_t fillIn[PCM_STREAM_IN_FRAMES];
+    int16_t fillBlock[PCM_CACHE_BLOCK_SAMPLES];  // Samples of the block being filled
+    ImaEncoder fillEncoder;
+    struct {
+      int16_t tag;
+      char path[PCM_CACHE_PATH_LEN];
+      WavTrim trim;
+    } queue[PCM_CACHE_QUEUE];
+    uint8_t queueHead, queueLen;
+
+    // Statistics
+    uint32_t hits, misses, evictions, fills;
+    uint32_t ttfsHitTotal, ttfsHitMax, ttfsHitCount;
+    uint32_t ttfsMissTotal, ttfsMissMax, ttfsMissCount;
+};
@@ -0,0 +1,122 @@
+#include "PcmKernels.h"
+
+// ===== SAMPLE DECODE =====
+// One little-endian sample to 16 bits: 8-bit is unsigned, 24-bit keeps the
+// top 16 bits
+template <int Bytes> static inline int32_t pcmSample(const uint8_t *p);
+
+template <> inline int32_t pcmSample<1>(const uint8_t *p) {
+  return ((int32_t)p[0] - 128) << 8;
+}
+
+// 16-bit data is read from 2-byte aligned buffers, so this is one load
+template <> inline int32_t pcmSample<2>(const uint8_t *p) {
+  int16_t s;
+  memcpy(&s, __builtin_assume_aligned(p, 2), sizeof(s));
+  return s;
+}
+
+template <> inline int32_t pcmSample<3>(const uint8_t *p) {
+  return (int16_t)(p[1] | (p[2] << 8));
+}
+
+template <int Bytes, int Channels> static inline int32_t pcmFrame(const uint8_t *p) {
+  if (Channels == 1) return pcmSample<Bytes>(p);
+  return (pcmSample<Bytes>(p) + pcmSample<Bytes>(p + Bytes)) >> 1;
+}
+
+// ===== KERNELS =====
+template <int Bytes, int Channels>
+static void pcmConvert(const uint8_t *src, int16_t *dst, int frames) {
+  for (int i = 0; i < frames; i++, src += Bytes * Channels) {
+    dst[i] = (int16_t)pcmFrame<Bytes, Channels>(src);
+  }
+}
+
+template <int Bytes, int Channels>
+static void pcmMix(const uint8_t *src, int32_t *acc, int frames, int32_t gain) {
+  for (int i = 0; i < frames; i++, src += Bytes * Channels) {
+    acc[i] += (pcmFrame<Bytes, Channels>(src) * gain) >> 15;
+  }
+}
+
+#define PCM_KERNEL(bytes, channels) {pcmConvert<bytes, channels>, pcmMix<bytes, channels>}
+
+// Indexed by [bytes per sample - 1][channels - 1]
+static const PcmKernels kernelTable[3][2] = {
+  {PCM_KERNEL(1, 1), PCM_KERNEL(1, 2)},
+  {PCM_KERNEL(2, 1), PCM_KERNEL(2, 2)},
+  {PCM_KERNEL(3, 1), PCM_KERNEL(3, 2)},
+};
+
+const PcmKernels *pcmKernels(int bytesPerSample, int channels) {
+  if (bytesPerSample < 1 || bytesPerSample > 3 || channels < 1 || channels > 2) return nullptr;
+  return &kernelTable[bytesPerSample - 1][channels - 1];
+}
+
+void pcmConvertGeneric(const uint8_t *src, int16_t *dst, int frames, int bytesPerSample,
+                       int channels) {
+  const uint8_t *p = src;
+  for (int i = 0; i < frames; i++) {
+    int32_t s = 0;
+    for (int c = 0; c < channels; c++) {
+      if (bytesPerSample == 1) {
+        s += ((int32_t)p[0] - 128) << 8;
+      } else {
+        // 16-bit and 24-bit: keep the top 16 bits
+        s += (int16_t)(p[bytesPerSample - 2] | (p[bytesPerSample - 1] << 8));
+      }
+      p += bytesPerSample;
+    }
+    dst[i] = (int16_t)(s / channels);
+  }
+}
+
+// ===== BENCHMARK =====
+#define PCM_BENCH_BLOCK   128
+#define PCM_BENCH_PASSES  8
+
+static volatile int32_t pcmBenchSink;  // Keeps the benchmark's results live
+
+// The gain stage that follows a convert-only path
+static void applyGain(const int16_t *pcm, int32_t *acc, int frames, int32_t gain) {
+  for (int i = 0; i < frames; i++) {
+    acc[i] += ((int32_t)pcm[i] * gain) >> 15;
+  }
+}
+
+uint32_t pcmKernelCycles(const uint8_t *data, uint32_t len, int bytesPerSample, int channels,
+                         PcmKernelPath path) {
+  const PcmKernels *k = pcmKernels(bytesPerSample, channels);
+  if (k == nullptr) return 0;
+  const uint32_t blockBytes = PCM_BENCH_BLOCK * bytesPerSample * channels;
+  const int32_t gain = 3 * 32768 / 4;
+  int16_t pcm[PCM_BENCH_BLOCK];
+  int32_t acc[PCM_BENCH_BLOCK];
+  memset(acc, 0, sizeof(acc));
+
+  uint32_t samples = 0;
+  uint32_t t0 = ESP.getCycleCount();
+  for (int pass = 0; pass < PCM_BENCH_PASSES; pass++) {
+    for (uint32_t off = 0; off + blockBytes <= len; off += blockBytes) {
+      const uint8_t *p = data + off;
+      switch (path) {
+        case PCM_PATH_GENERIC:
+          pcmConvertGeneric(p, pcm, PCM_BENCH_BLOCK, bytesPerSample, channels);
+          applyGain(pcm, acc, PCM_BENCH_BLOCK, gain);
+          break;
+        case PCM_PATH_CONVERT:
+          k->convert(p, pcm, PCM_BENCH_BLOCK);
+          applyGain(pcm, acc, PCM_BENCH_BLOCK, gain);
+          break;
+        case PCM_PATH_MIX:
+          k->mix(p, acc, PCM_BENCH_BLOCK, gain);
+          break;
+      }
+      samples += PCM_BENCH_BLOCK;
+    }
+  }
+  uint32_t cycles = ESP.getCycleCount() - t0;
+  pcmBenchSink = acc[0] + acc[PCM_BENCH_BLOCK - 1];
+  return samples ? (uint32_t)((uint64_t)cycles * 100 / samples) : 0;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ===== PCM KERNELS =====
+// Sample conversion specialized at compile time, one kernel per (bytes per
+// sample, channels, output) combination WavParser accepts: 8/16/24-bit,
+// mono/stereo. Sample decode and downmix are inlined for the layout, so the
+// per-sample loop has no layout branches and no divide. A stream looks its
+// kernels up once in begin() and calls them per block.
+//
+// Two outputs:
+//   convert  mono 16-bit into a decode buffer (the resampler's input)
+//   mix      mono, Q15 gain applied and added to a mixer accumulator in the
+//            same pass (sources already at the output rate)
+
+typedef void (*PcmConvertFn)(const uint8_t *src, int16_t *dst, int frames);
+typedef void (*PcmMixFn)(const uint8_t *src, int32_t *acc, int frames, int32_t gain);
+
+struct PcmKernels {
+  PcmConvertFn convert;
+  PcmMixFn mix;
+};
+
+// Kernels for a layout, or nullptr if there are none
+const PcmKernels *pcmKernels(int bytesPerSample, int channels);
+
+// The layout-generic loop the kernels replace, kept as the benchmark baseline
+void pcmConvertGeneric(const uint8_t *src, int16_t *dst, int frames, int bytesPerSample,
+                       int channels);
+
+enum PcmKernelPath : uint8_t {
+  PCM_PATH_GENERIC,    // pcmConvertGeneric(), then a gain pass
+  PCM_PATH_CONVERT,    // Specialized convert, then a gain pass
+  PCM_PATH_MIX,        // Specialized convert and gain in one pass
+};
+
+// Cycles per sample x100 to take `len` bytes of `data` in a layout to gained
+// samples in an accumulator along one path
+uint32_t pcmKernelCycles(const uint8_t *data, uint32_t len, int bytesPerSample, int channels,
+                         PcmKernelPath path);
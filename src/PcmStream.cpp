@@ -0,0 +1,259 @@
+#include "PcmStream.h"
+#include "ImaAdpcm.h"
+
+// Raw bytes read per refill: PCM_STREAM_IN_FRAMES frames of up to 24-bit
+// stereo. Streams are decoded one at a time, so the scratch is shared.
+// Aligned for the 16-bit kernels' loads.
+alignas(4) static uint8_t readScratch[PCM_STREAM_IN_FRAMES * 6];
+
+// ===== ANTI-ALIAS FILTER =====
+// Polyphase windowed-sinc table, PCM_FIR_PHASES rows of PCM_FIR_TAPS Q15
+// coefficients, one per rate pair in use. Same design as the offline bank
+// compiler (tools/build_bank.py): Blackman window, cutoff at 0.45 of the
+// lower rate. Allocated and built for the common rates by
+// reserveFilters() at boot, other rates on first use, and kept; streams
+// only begin in the audio task, so no locking is needed.
+#define PCM_FIR_TABLE_BYTES (PCM_FIR_PHASES * PCM_FIR_TAPS * sizeof(int16_t))
+
+static const uint32_t commonRates[] = {44100, 48000};
+
+static struct {
+  uint32_t inRate;           // 0 = unused
+  uint32_t outRate;
+  int16_t *coefs;
+} firTables[PCM_FIR_TABLES];
+
+static const int16_t *firTable(uint32_t inRate, uint32_t outRate) {
+  int slot = 0;
+  for (int i = 0; i < PCM_FIR_TABLES; i++) {
+    if (firTables[i].inRate == inRate && firTables[i].outRate == outRate) return firTables[i].coefs;
+    if (firTables[i].inRate == 0) slot = i;
+  }
+  if (firTables[slot].coefs == nullptr) {
+    firTables[slot].coefs = (int16_t *)malloc(PCM_FIR_TABLE_BYTES);
+    if (firTables[slot].coefs == nullptr) return nullptr;
+  }
+  // With every slot taken, slot 0 is rebuilt for the new pair; streams still
+  // on it carry on with a slightly different cutoff. That needs more than
+  // PCM_FIR_TABLES source rates in one sound set.
+
+  float ratio = (float)outRate / inRate;
+  float cutoff = 0.45f * (ratio < 1.0f ? ratio : 1.0f);
+  const int half = PCM_FIR_TAPS / 2;
+  for (int p = 0; p < PCM_FIR_PHASES; p++) {
+    float taps[PCM_FIR_TAPS];
+    float sum = 0.0f;
+    for (int k = 0; k < PCM_FIR_TAPS; k++) {
+      float x = k - half + 1 - (float)p / PCM_FIR_PHASES;
+      float w = 2.0f * (float)M_PI * cutoff * x;
+      float sinc = 2.0f * cutoff * (x != 0.0f ? sinf(w) / w : 1.0f);
+      float window = 0.42f + 0.5f * cosf((float)M_PI * x / half) +
+                     0.08f * cosf(2.0f * (float)M_PI * x / half);
+      taps[k] = fabsf(x) < half ? sinc * window : 0.0f;
+      sum += taps[k];
+    }
+    // Normalize each phase to unity DC gain
+    int16_t *row = firTables[slot].coefs + p * PCM_FIR_TAPS;
+    for (int k = 0; k < PCM_FIR_TAPS; k++) {
+      int32_t c = lrintf(taps[k] / sum * 32768.0f);
+      row[k] = (int16_t)(c > 32767 ? 32767 : c);
+    }
+  }
+  firTables[slot].inRate = inRate;
+  firTables[slot].outRate = outRate;
+  return firTables[slot].coefs;
+}
+
+void PcmStream::reserveFilters(uint32_t outRate) {
+  for (int i = 0; i < PCM_FIR_TABLES; i++) {
+    if (firTables[i].coefs == nullptr) firTables[i].coefs = (int16_t *)malloc(PCM_FIR_TABLE_BYTES);
+  }
+  for (uint32_t rate : commonRates) {
+    if (rate != outRate) firTable(rate, outRate);
+  }
+}
+
+bool PcmStream::begin(AudioFileSource *source, const WavInfo &info, uint32_t outRate,
+                      const WavTrim *trim) {
+  src = source;
+  channels = info.channels;
+  bytesPerSample = info.bitsPerSample / 8;
+  kernels = nullptr;
+  blockAlign = blockRead = skip = 0;
+  framesLeft = 0;
+  if (info.formatTag == WAV_FORMAT_IMA_ADPCM) {
+    // A whole block is decoded into the buffer at once
+    if (info.samplesPerBlock > PCM_STREAM_IN_FRAMES) return false;
+    blockAlign = info.blockAlign;
+    framesLeft = info.frameCount;
+  } else {
+    kernels = pcmKernels(bytesPerSample, channels);
+    if (kernels == nullptr) return false;
+  }
+  step = (uint32_t)(((uint64_t)info.sampleRate << 16) / outRate);
+  frac = 1 << 16;  // Load the first sample on the first output tick
+  s0 = s1 = 0;
+  inPos = inLen = 0;
+  bytesLeft = info.dataSize;
+  fir = (info.sampleRate == outRate) ? nullptr : firTable(info.sampleRate, outRate);
+  histPos = 0;
+  memset(hist, 0, sizeof(hist));
+
+  if (trim != nullptr && trim->endFrame > trim->startFrame &&
+      trim->endFrame <= info.frameCount) {
+    if (blockAlign != 0) {
+      // Start at the block holding the first frame and drop what precedes it
+      uint32_t block = trim->startFrame / info.samplesPerBlock;
+      skip = trim->startFrame % info.samplesPerBlock;
+      bytesLeft = info.dataSize - block * blockAlign;
+      framesLeft = trim->endFrame - block * info.samplesPerBlock;
+      return src->seek(info.dataOffset + block * blockAlign, SEEK_SET);
+    }
+    bytesLeft = (trim->endFrame - trim->startFrame) * info.blockAlign;
+    return src->seek(info.dataOffset + trim->startFrame * info.blockAlign, SEEK_SET);
+  }
+  return true;
+}
+
+// Refill the decode buffer with mono 16-bit frames
+bool PcmStream::fill(int16_t *in) {
+  if (blockAlign != 0) return fillAdpcm(in);
+  uint32_t frameBytes = channels * bytesPerSample;
+  uint32_t frames = bytesLeft / frameBytes;
+  if (frames > PCM_STREAM_IN_FRAMES) frames = PCM_STREAM_IN_FRAMES;
+  if (frames == 0) return false;
+
+  uint32_t got = src->read(readScratch, frames * frameBytes);
+  frames = got / frameBytes;
+  if (frames == 0) return false;
+  bytesLeft -= frames * frameBytes;
+
+  kernels->convert(readScratch, in, frames);
+
+  inPos = 0;
+  inLen = frames;
+  return true;
+}
+
+// Decode the next ADPCM block, dropping its first `skip` frames
+bool PcmStream::fillAdpcm(int16_t *in) {
+  do {
+    uint32_t bytes = bytesLeft < blockAlign ? bytesLeft : blockAlign;
+    if (bytes == 0 || framesLeft == 0) return false;
+    uint32_t got = src->read(readScratch, bytes);
+    bytesLeft -= got;
+    uint32_t frames = imaDecodeBlock(readScratch, got, channels, in);
+    if (frames == 0) return false;
+    if (frames > framesLeft) frames = framesLeft;  // Padding of the last block
+    framesLeft -= frames;
+    blockRead = got;
+    inLen = frames;
+    inPos = skip < frames ? skip : frames;
+    skip = 0;
+  } while (inPos >= inLen);
+  return true;
+}
+
+int PcmStream::render(int16_t *in, int32_t *acc, int samples, int32_t gain) {
+  if (fir != nullptr) return renderFir(in, acc, samples, gain);
+  if (step == (1 << 16)) return renderDirect(in, acc, samples, gain);
+  return renderLinear(in, acc, samples, gain);
+}
+
+// Passthrough at equal rates. PCM: read just the frames this block needs
+// and mix them straight from the read buffer, so nothing is left buffered
+// in between. ADPCM: mix from the decoded block.
+int PcmStream::renderDirect(int16_t *in, int32_t *acc, int samples, int32_t gain) {
+  if (blockAlign != 0) {
+    int done = 0;
+    while (done < samples) {
+      if (inPos >= inLen && !fill(in)) break;
+      int n = inLen - inPos;
+      if (n > samples - done) n = samples - done;
+      const int16_t *p = in + inPos;
+      for (int i = 0; i < n; i++) {
+        acc[done + i] += ((int32_t)p[i] * gain) >> 15;
+      }
+      inPos += n;
+      done += n;
+    }
+    return done;
+  }
+
+  uint32_t frameBytes = channels * bytesPerSample;
+  int done = 0;
+  while (done < samples) {
+    uint32_t frames = bytesLeft / frameBytes;
+    if (frames > (uint32_t)(samples - done)) frames = samples - done;
+    if (frames == 0) break;
+
+    uint32_t got = src->read(readScratch, frames * frameBytes);
+    frames = got / frameBytes;
+    if (frames == 0) break;
+    bytesLeft -= frames * frameBytes;
+    kernels->mix(readScratch, acc + done, frames, gain);
+    done += frames;
+  }
+  return done;
+}
+
+// Rate conversion by linear interpolation: the fallback when no filter
+// table could be allocated
+int PcmStream::renderLinear(int16_t *in, int32_t *acc, int samples, int32_t gain) {
+  for (int i = 0; i < samples; i++) {
+    while (frac >= (1 << 16)) {
+      if (inPos >= inLen && !fill(in)) return i;
+      s0 = s1;
+      s1 = in[inPos++];
+      frac -= 1 << 16;
+    }
+    int32_t s = s0 + ((((int32_t)s1 - s0) * (int32_t)frac) >> 16);
+    acc[i] += (s * gain) >> 15;
+    frac += step;
+  }
+  return samples;
+}
+
+int PcmStream::renderFir(int16_t *in, int32_t *acc, int samples, int32_t gain) {
+  for (int i = 0; i < samples; i++) {
+    while (frac >= (1 << 16)) {
+      if (inPos >= inLen && !fill(in)) return i;
+      int16_t x = in[inPos++];
+      hist[histPos] = x;
+      hist[histPos + PCM_FIR_TAPS] = x;
+      histPos = (histPos + 1) & (PCM_FIR_TAPS - 1);
+      frac -= 1 << 16;
+    }
+    const int16_t *h = fir + (frac >> (16 - PCM_FIR_PHASE_BITS)) * PCM_FIR_TAPS;
+    const int16_t *x = hist + histPos;  // Oldest to newest
+    int32_t s = 0;
+    for (int k = 0; k < PCM_FIR_TAPS; k++) {
+      s += (int32_t)x[k] * h[k];
+    }
+    s >>= 15;
+    acc[i] += (s * gain) >> 15;
+    frac += step;
+  }
+  return samples;
+}
+
+uint32_t PcmStream::unconsumedBytes() const {
+  if (blockAlign != 0) return inPos < inLen ? blockRead : 0;
+  return (uint32_t)(inLen - inPos) * channels * bytesPerSample;
+}
+
+void PcmStream::dropBuffered() {
+  bytesLeft += unconsumedBytes();
+  if (blockAlign != 0 && inPos < inLen) {
+    framesLeft += inLen;
+    skip = inPos;
+  }
+  inPos = inLen = 0;
+}
+
+uint32_t PcmStream::samplesLeft() const {
+  uint32_t frames = inLen - inPos;
+  if (blockAlign != 0) frames += framesLeft > skip ? framesLeft - skip : 0;
+  else frames += bytesLeft / (channels * bytesPerSample);
+  return step ? (uint32_t)(((uint64_t)frames << 16) / step) : 0;
+}
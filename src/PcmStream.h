@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Arduino.h>
+#include "AudioFileSource.h"
+#include "PcmKernels.h"
+#include "WavParser.h"
+
+// ===== PCM STREAM =====
+// Streaming decoder for PCM and IMA ADPCM WAV data: reads frames from a
+// source (ADPCM a block at a time), downmixes
+// to mono 16-bit and converts to the fixed output rate. Rate conversion is a
+// Q15 polyphase FIR (windowed sinc, cut off below the lower Nyquist), so
+// decimating 44.1/48 kHz assets to the device rate does not alias into the
+// audible band. Sources already at the output rate pass straight through:
+// PCM bytes are converted and gained into the mix in one kernel pass.
+// The conversion kernels are picked for the source layout in begin().
+// The caller provides the decode buffer, so a stream can live in a voice
+// array, the PCM cache filler, or on the stack.
+
+#define PCM_STREAM_IN_FRAMES 256   // Decoded source frames buffered per stream
+
+#ifndef PCM_FIR_TAPS
+#define PCM_FIR_TAPS        32     // Taps per phase (power of two)
+#endif
+#define PCM_FIR_PHASE_BITS  5
+#define PCM_FIR_PHASES      (1 << PCM_FIR_PHASE_BITS)
+#define PCM_FIR_TABLES      4      // Distinct source rates kept at once
+
+struct PcmStream {
+  uint8_t channels;
+  uint8_t bytesPerSample;
+  uint16_t inPos, inLen;   // Read position in the decode buffer
+  uint32_t step;           // Source frames per output sample, Q16
+  uint32_t frac;           // Position between s0 and s1, Q16
+  int16_t s0, s1;          // Interpolation pair (linear path)
+  uint32_t bytesLeft;      // Sample data bytes still to read
+  AudioFileSource *src;
+  const PcmKernels *kernels;  // For the source layout (PCM)
+
+  // IMA ADPCM (blockAlign 0 for PCM). Frames are counted from the start of
+  // the next block to read.
+  uint16_t blockAlign;
+  uint16_t blockRead;      // Bytes of the block in the decode buffer
+  uint16_t skip;           // Leading frames of the next block to drop
+  uint32_t framesLeft;
+
+  // FIR path: phase table for this rate pair (nullptr = linear/passthrough)
+  // and the last PCM_FIR_TAPS inputs, stored twice so the window is contiguous
+  const int16_t *fir;
+  uint8_t histPos;
+  int16_t hist[2 * PCM_FIR_TAPS];
+
+  // Allocate every filter table and build those for 44.1 and 48 kHz
+  // sources, so that begin() neither allocates nor spends the build time.
+  // Call at boot, before the audio task starts.
+  static void reserveFilters(uint32_t outRate);
+
+  // Set up for a source positioned at info.dataOffset. With a trim, the
+  // source is moved to the first audible frame and the stream ends after
+  // the last one.
+  bool begin(AudioFileSource *source, const WavInfo &info, uint32_t outRate,
+             const WavTrim *trim = nullptr);
+
+  // Mix up to `samples` output samples into acc with a Q15 gain.
+  // Returns the number produced; fewer than requested means end of data.
+  int render(int16_t *in, int32_t *acc, int samples, int32_t gain);
+
+  // Source bytes already read into the decode buffer but not yet played.
+  // dropBuffered() discards them and adds them back to bytesLeft, so the
+  // stream can be resumed later from (source position - unconsumedBytes()).
+  // For ADPCM that is the whole block in the buffer; the frames of it
+  // already played are skipped when it is decoded again.
+  uint32_t unconsumedBytes() const;
+  void dropBuffered();
+
+  // Output samples still to come (approximate by the resampler's delay)
+  uint32_t samplesLeft() const;
+
+  private:
+    bool fill(int16_t *in);
+    bool fillAdpcm(int16_t *in);
+    int renderDirect(int16_t *in, int32_t *acc, int samples, int32_t gain);
+    int renderLinear(int16_t *in, int32_t *acc, int samples, int32_t gain);
+    int renderFir(int16_t *in, int32_t *acc, int samples, int32_t gain);
+};
@@ -0,0 +1,175 @@
+#include "PowerGovernor.h"
+
+PowerGovernor powerGovernor;
+
+static const char *const stateNames[POWER_STATES] = {"active", "dimmed", "dark", "sleep"};
+
+// Clock and backlight of each state
+static const uint32_t stateMhz[POWER_STATES] = {
+  POWER_FULL_MHZ, POWER_IDLE_MHZ, POWER_IDLE_MHZ, POWER_IDLE_MHZ,
+};
+static const uint8_t stateBacklight[POWER_STATES] = {
+  POWER_BACKLIGHT_FULL, POWER_BACKLIGHT_DIM, 0, 0,
+};
+static const uint32_t stateAfterMs[POWER_STATES] = {
+  0, POWER_DIM_MS, POWER_DARK_MS, POWER_SLEEP_MS,
+};
+
+PowerGovernor::PowerGovernor() {
+  hooks = {nullptr, nullptr, nullptr, nullptr};
+  current = POWER_ACTIVE;
+  mhz = 0;
+  backlight = 0;
+  lastActive = stateSince = 0;
+  soundPending = false;
+  soundFrom = POWER_ACTIVE;
+  soundWake = 0;
+  resetStats();
+}
+
+void PowerGovernor::begin(const PowerHooks &h) {
+  hooks = h;
+  uint32_t now = hooks.clock();
+  lastActive = stateSince = now;
+  current = POWER_ACTIVE;
+  mhz = 0;
+  apply(POWER_FULL_MHZ, POWER_BACKLIGHT_FULL);
+  resetStats();
+  Serial.printf("Power governor: %s, dim %u s, dark %u s, light sleep %u s\n",
+                POWER_GOVERNOR ? "on" : "off", POWER_DIM_MS / 1000, POWER_DARK_MS / 1000,
+                POWER_SLEEP_MS / 1000);
+}
+
+// ===== TRANSITIONS =====
+void PowerGovernor::activity() {
+  uint32_t now = hooks.clock();
+  lastActive = now;
+  if (!soundPending) {
+    soundPending = true;
+    soundFrom = current;
+    soundWake = now;
+  }
+  if (current != POWER_ACTIVE) enter(POWER_ACTIVE, now);
+}
+
+void PowerGovernor::service(bool busy, bool maySleep) {
+  uint32_t now = hooks.clock();
+  account(now);  // Often enough that micros() wrapping loses nothing
+  if (soundPending && now - soundWake > POWER_SOUND_WINDOW_MS * 1000u) soundPending = false;
+
+  if (busy) {
+    lastActive = now;
+    if (current != POWER_ACTIVE) enter(POWER_ACTIVE, now);
+    return;
+  }
+
+  // Step down (never up) to the deepest state the idle time has reached
+  uint32_t idleMs = (now - lastActive) / 1000;
+  if (idleMs > POWER_SLEEP_MS) {
+    // Hold the idle time there, or micros() wrapping (~71 min) would undo it
+    lastActive = now - POWER_SLEEP_MS * 1000u;
+    idleMs = POWER_SLEEP_MS;
+  }
+  int target = POWER_ACTIVE;
+  if (POWER_GOVERNOR) {
+    for (int s = POWER_SLEEP; s > POWER_ACTIVE; s--) {
+      if (idleMs >= stateAfterMs[s]) {
+        target = s;
+        break;
+      }
+    }
+  }
+  if (target == POWER_SLEEP && !maySleep) target = POWER_DARK;
+  if (target > current || (current == POWER_SLEEP && !maySleep)) {
+    enter((PowerState)target, now);
+  }
+  if (current != POWER_SLEEP || hooks.lightSleep == nullptr) return;
+
+  uint8_t cause = hooks.lightSleep(POWER_SLEEP_SLICE_MS);
+  now = hooks.clock();
+  sleepCount++;
+  if (cause >= POWER_WAKE_CAUSES) cause = POWER_WAKE_OTHER;
+  wakeCount[cause]++;
+  if (cause == POWER_WAKE_TOUCH) {
+    // Ramp now; the touch task reads the controller meanwhile
+    lastActive = now;
+    soundPending = true;
+    soundFrom = POWER_SLEEP;
+    soundWake = now;
+    enter(POWER_ACTIVE, now);
+  }
+}
+
+void PowerGovernor::soundStarted() {
+  if (!soundPending) return;
+  soundPending = false;
+  uint32_t us = hooks.clock() - soundWake;
+  soundN[soundFrom]++;
+  soundSum[soundFrom] += us;
+  if (us > soundMax[soundFrom]) soundMax[soundFrom] = us;
+}
+
+void PowerGovernor::account(uint32_t now) {
+  timeIn[current] += now - stateSince;
+  stateSince = now;
+}
+
+void PowerGovernor::enter(PowerState s, uint32_t now) {
+  account(now);
+  current = s;
+  transitions[s]++;
+  apply(stateMhz[s], stateBacklight[s]);
+}
+
+// Only settings that change reach the hooks; raising the clock is timed
+void PowerGovernor::apply(uint32_t cpu, uint8_t light) {
+  if (cpu != mhz && hooks.setCpuMhz != nullptr) {
+    bool ramp = cpu > mhz && mhz != 0;
+    uint32_t t0 = ramp ? hooks.clock() : 0;
+    hooks.setCpuMhz(cpu);
+    if (ramp) {
+      uint32_t us = hooks.clock() - t0;
+      rampCount++;
+      if (us > rampMax) rampMax = us;
+    }
+  }
+  mhz = cpu;
+  if (light != backlight && hooks.setBacklight != nullptr) hooks.setBacklight(light);
+  backlight = light;
+}
+
+// ===== STATISTICS =====
+void PowerGovernor::resetStats() {
+  for (int s = 0; s < POWER_STATES; s++) {
+    timeIn[s] = 0;
+    transitions[s] = 0;
+    soundN[s] = soundMax[s] = 0;
+    soundSum[s] = 0;
+  }
+  for (int c = 0; c < POWER_WAKE_CAUSES; c++) wakeCount[c] = 0;
+  sleepCount = rampCount = rampMax = 0;
+}
+
+void PowerGovernor::printStats() {
+  account(hooks.clock());
+  uint64_t total = 0;
+  for (int s = 0; s < POWER_STATES; s++) total += timeIn[s];
+  if (total == 0) total = 1;
+
+  Serial.printf("Power: %s now at %u MHz\n", stateNames[current], mhz);
+  for (int s = 0; s < POWER_STATES; s++) {
+    Serial.printf("  %-6s %8u s (%3u%%), entered %u times\n", stateNames[s],
+                  (uint32_t)(timeIn[s] / 1000000), (uint32_t)(timeIn[s] * 100 / total),
+                  transitions[s]);
+  }
+  Serial.printf("  Light sleeps: %u (touch wakes %u, timer %u, other %u); "
+                "%u ramps to full clock, longest %u us\n",
+                sleepCount, wakeCount[POWER_WAKE_TOUCH], wakeCount[POWER_WAKE_TIMER],
+                wakeCount[POWER_WAKE_OTHER], rampCount, rampMax);
+  for (int s = 0; s < POWER_STATES; s++) {
+    if (soundN[s] == 0) continue;
+    Serial.printf("  Wake to sound from %-6s avg %u us, max %u us over %u sounds\n",
+                  stateNames[s], soundAvgMicros((PowerState)s), soundMax[s], soundN[s]);
+  }
+  resetStats();
+}
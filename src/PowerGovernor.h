@@ -0,0 +1,142 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ===== IDLE POWER GOVERNOR =====
+// Steps the board down while nobody uses it, and back up the moment
+// someone does:
+//
+//   ACTIVE   full clock, backlight full     touch, serial byte or work under way
+//   DIMMED   POWER_IDLE_MHZ, backlight dim  after POWER_DIM_MS idle
+//   DARK     POWER_IDLE_MHZ, backlight off  after POWER_DARK_MS idle
+//   SLEEP    light sleep between passes     after POWER_SLEEP_MS idle
+//
+// In SLEEP each loop() pass sleeps until the touch interrupt line or a
+// POWER_SLEEP_SLICE_MS timer wakes it, so the millis() housekeeping still
+// runs about once a slice. A touch or serial byte calls activity(), which
+// ramps to full clock before returning: loop() calls it before the tap or
+// command posts anything, so a sound is always decoded at full clock and
+// the first one after a wake starts as fast as any other. Taps act in
+// every state; the one that wakes the board also plays.
+//
+// The governor owns no hardware. The clock, CPU, backlight and sleep are
+// hooks, so the host benchmark drives it against a simulated clock; the
+// board passes micros(), setCpuFrequencyMhz(), the backlight PWM and
+// esp_light_sleep_start(). It reports the time spent in each state, wakes
+// by cause, the longest clock ramp, and how long after the first activity
+// out of each state the next voice started (wake-to-sound).
+
+#ifndef POWER_GOVERNOR
+#define POWER_GOVERNOR 1             // 0: always ACTIVE (stats still kept)
+#endif
+#ifndef POWER_DIM_MS
+#define POWER_DIM_MS          30000
+#endif
+#ifndef POWER_DARK_MS
+#define POWER_DARK_MS         120000
+#endif
+#ifndef POWER_SLEEP_MS
+#define POWER_SLEEP_MS        150000
+#endif
+#define POWER_SLEEP_SLICE_MS  1000   // Longest light sleep in one loop() pass
+#define POWER_FULL_MHZ        240
+#define POWER_IDLE_MHZ        80     // Lowest clock that keeps APB (UART, SPI) at 80 MHz
+#define POWER_BACKLIGHT_FULL  255
+#ifndef POWER_BACKLIGHT_DIM
+#define POWER_BACKLIGHT_DIM   24     // Of 255
+#endif
+#define POWER_SOUND_WINDOW_MS 2000   // A voice later than this after the wake was not its doing
+
+enum PowerState : uint8_t {
+  POWER_ACTIVE = 0,
+  POWER_DIMMED,
+  POWER_DARK,
+  POWER_SLEEP,
+  POWER_STATES,
+};
+
+enum PowerWake : uint8_t {
+  POWER_WAKE_TIMER = 0,              // Slice ran out
+  POWER_WAKE_TOUCH,                  // Touch interrupt line
+  POWER_WAKE_OTHER,
+  POWER_WAKE_CAUSES,
+};
+
+struct PowerHooks {
+  uint32_t (*clock)();               // Microseconds, wrapping
+  void (*setCpuMhz)(uint32_t mhz);
+  void (*setBacklight)(uint8_t duty);  // 0 (off) .. 255
+  uint8_t (*lightSleep)(uint32_t maxMs);  // Returns a PowerWake
+};
+
+class PowerGovernor {
+  public:
+    PowerGovernor();
+
+    // Start ACTIVE: full clock, backlight on
+    void begin(const PowerHooks &hooks);
+
+    // A touch or serial byte: back to ACTIVE at full clock before this
+    // returns. The first one out of a lower state starts a wake-to-sound
+    // measurement.
+    void activity();
+
+    // loop(), once per pass. busy: work under way that holds ACTIVE
+    // (playback, a redraw, a scroll, delayed remote commands); maySleep:
+    // false keeps the board out of SLEEP (a remote link, whose bytes a
+    // light sleep would lose). Steps down after the idle timeouts, and in
+    // SLEEP sleeps for up to a slice.
+    void service(bool busy, bool maySleep);
+
+    // loop(): a voice started
+    void soundStarted();
+
+    PowerState state() const { return current; }
+    uint32_t cpuMhz() const { return mhz; }
+
+    // Time in each state, wakes, ramps and wake-to-sound since the last call
+    void printStats();
+
+    // For the host benchmark: totals since the last printStats()
+    uint64_t stateMicros(PowerState s) {
+      account(hooks.clock());
+      return timeIn[s];
+    }
+    uint32_t wakes(PowerWake cause) const { return wakeCount[cause]; }
+    uint32_t sleeps() const { return sleepCount; }
+    uint32_t soundCount(PowerState from) const { return soundN[from]; }
+    uint32_t soundAvgMicros(PowerState from) const {
+      return soundN[from] ? (uint32_t)(soundSum[from] / soundN[from]) : 0;
+    }
+    uint32_t soundMaxMicros(PowerState from) const { return soundMax[from]; }
+    uint32_t rampMaxMicros() const { return rampMax; }
+
+  private:
+    void account(uint32_t now);
+    void enter(PowerState s, uint32_t now);
+    void apply(uint32_t cpu, uint8_t backlight);
+    void resetStats();
+
+    PowerHooks hooks;
+    PowerState current;
+    uint32_t mhz;
+    uint8_t backlight;
+    uint32_t lastActive;               // Last activity or busy pass
+    uint32_t stateSince;               // Time already accounted up to
+    bool soundPending;                 // Woken, no voice started yet
+    PowerState soundFrom;              // State the wake came out of
+    uint32_t soundWake;
+
+    // Statistics
+    uint64_t timeIn[POWER_STATES];
+    uint32_t transitions[POWER_STATES];  // Entries into each state
+    uint32_t wakeCount[POWER_WAKE_CAUSES];
+    uint32_t sleepCount;
+    uint32_t soundN[POWER_STATES];     // Wake-to-sound by the state woken from
+    uint64_t soundSum[POWER_STATES];
+    uint32_t soundMax[POWER_STATES];
+    uint32_t rampCount;
+    uint32_t rampMax;                  // Longest setCpuMhz() call raising the clock
+};
+
+extern PowerGovernor powerGovernor;
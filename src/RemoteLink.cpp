@@ -0,0 +1,242 @@
+#include "RemoteLink.h"
+
+RemoteLink remoteLink;
+
+// ===== FRAMING =====
+uint16_t remoteCrc16(const uint8_t *data, int len) {
+  uint16_t crc = 0xFFFF;
+  for (int i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int b = 0; b < 8; b++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+int remoteEncode(uint8_t seq, const uint8_t *payload, int len, uint8_t *out) {
+  out[0] = REMOTE_SYNC;
+  out[1] = len;
+  out[2] = seq;
+  memcpy(out + 3, payload, len);
+  uint16_t crc = remoteCrc16(out + 1, len + 2);
+  out[3 + len] = crc & 0xFF;
+  out[4 + len] = crc >> 8;
+  return len + REMOTE_FRAME_OVERHEAD;
+}
+
+uint8_t RemoteParser::feed(uint8_t c) {
+  if (state != 0 && millis() - startMillis > REMOTE_FRAME_TIMEOUT_MS) state = 0;
+
+  if (state == 0) {
+    if (c != REMOTE_SYNC) return REMOTE_PARSE_IGNORED;
+    buf[0] = c;
+    got = 1;
+    state = 1;
+    startMillis = millis();
+    return REMOTE_PARSE_MORE;
+  }
+
+  // A length no frame can have: the sync byte was not one, and this byte
+  // may be a console command
+  if (got == 1 && c > REMOTE_MAX_PAYLOAD) {
+    state = 0;
+    return REMOTE_PARSE_IGNORED;
+  }
+
+  buf[got++] = c;
+  if (got < buf[1] + REMOTE_FRAME_OVERHEAD) return REMOTE_PARSE_MORE;
+  state = 0;
+  int end = 3 + buf[1];
+  uint16_t crc = buf[end] | (buf[end + 1] << 8);
+  return crc == remoteCrc16(buf + 1, end - 1) ? REMOTE_PARSE_FRAME : REMOTE_PARSE_BAD_CRC;
+}
+
+// ===== LINK =====
+RemoteLink::RemoteLink() {
+  playFn = nullptr;
+  stopFn = nullptr;
+  volumeFn = nullptr;
+  statusFn = nullptr;
+  queueFn = nullptr;
+  active = false;
+  pendingCount = 0;
+  frames = rejected = commands = delayed = dropped = 0;
+  frameMicrosMax = 0;
+}
+
+void RemoteLink::begin(PlayFn play, StopFn stop, VolumeFn volume, StatusFn status,
+                       QueueFn queue) {
+  playFn = play;
+  stopFn = stop;
+  volumeFn = volume;
+  statusFn = status;
+  queueFn = queue;
+}
+
+bool RemoteLink::feed(uint8_t c) {
+  uint8_t result = parser.feed(c);
+  if (result == REMOTE_PARSE_IGNORED) return false;
+  if (result == REMOTE_PARSE_FRAME) runFrame();
+
+  // A corrupted length byte can make a bad frame swallow the start of the
+  // next one, so the search resumes at the byte after the bad sync byte:
+  // what the parser took since then goes through it again, ahead of any
+  // bytes an earlier retry has not reached yet
+  uint8_t rest[sizeof(parser.buf)];
+  int n = 0, i = 0;
+  while (result == REMOTE_PARSE_BAD_CRC) {
+    rejected++;
+    uint8_t ack[2] = {REMOTE_ACK, REMOTE_BAD_CRC};
+    send(parser.seq(), ack, sizeof(ack));
+    int taken = parser.got - 1;
+    memmove(rest + taken, rest + i, n - i);
+    memcpy(rest, parser.buf + 1, taken);
+    n = taken + n - i;
+    i = 0;
+    while (i < n) {
+      result = parser.feed(rest[i++]);
+      if (result == REMOTE_PARSE_FRAME) runFrame();
+      if (result == REMOTE_PARSE_BAD_CRC) break;
+    }
+  }
+  return true;
+}
+
+static int commandBytes(uint8_t op) {
+  switch (op) {
+    case REMOTE_PLAY:
+    case REMOTE_STOP:
+    case REMOTE_QUEUE:
+      return 5;
+    case REMOTE_VOLUME:
+      return 2;
+    case REMOTE_STATUS:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+void RemoteLink::runFrame() {
+  uint32_t t0 = micros();
+  const uint8_t *p = parser.payload();
+  int len = parser.length();
+  uint8_t ack[2] = {REMOTE_ACK, REMOTE_OK};
+
+  // The whole batch must parse before any of it runs
+  for (int i = 0; i < len;) {
+    int n = commandBytes(p[i]);
+    if (n == 0 || i + n > len) {
+      rejected++;
+      ack[1] = REMOTE_BAD_COMMAND;
+      send(parser.seq(), ack, sizeof(ack));
+      return;
+    }
+    i += n;
+  }
+
+  active = true;
+  frames++;
+  uint32_t now = millis();
+  bool status = false;
+  for (int i = 0; i < len; i += commandBytes(p[i])) {
+    uint8_t result = REMOTE_OK;
+    switch (p[i]) {
+      case REMOTE_PLAY:
+      case REMOTE_STOP:
+        result = run(p[i], p[i + 1] | (p[i + 2] << 8), p[i + 3] | (p[i + 4] << 8), now);
+        break;
+      case REMOTE_VOLUME:
+        if (volumeFn != nullptr) volumeFn(p[i + 1]);
+        commands++;
+        break;
+      case REMOTE_STATUS:
+        status = true;
+        break;
+      case REMOTE_QUEUE:
+        commands++;
+        if (queueFn == nullptr || !queueFn(p[i + 1] | (p[i + 2] << 8), p[i + 3] | (p[i + 4] << 8))) {
+          result = REMOTE_BAD_INDEX;
+        }
+        break;
+    }
+    if (ack[1] == REMOTE_OK) ack[1] = result;
+  }
+
+  if (status && statusFn != nullptr) {
+    RemoteStatus s;
+    statusFn(s);
+    uint8_t reply[15] = {REMOTE_STATUS_REPLY, s.volume, s.voices,
+                         (uint8_t)(s.sounds & 0xFF), (uint8_t)(s.sounds >> 8),
+                         (uint8_t)(pendingCount & 0xFF), (uint8_t)(pendingCount >> 8)};
+    memcpy(reply + 7, &frames, 4);       // Little endian, as the ESP32
+    memcpy(reply + 11, &rejected, 4);
+    send(parser.seq(), reply, sizeof(reply));
+  }
+  send(parser.seq(), ack, sizeof(ack));
+
+  uint32_t dt = micros() - t0;
+  if (dt > frameMicrosMax) frameMicrosMax = dt;
+}
+
+uint8_t RemoteLink::run(uint8_t op, uint16_t index, uint32_t delayMs, uint32_t now) {
+  if (delayMs > 0) {
+    if (pendingCount == REMOTE_PENDING) {
+      dropped++;
+      return REMOTE_QUEUE_FULL;
+    }
+    pending[pendingCount++] = {now + delayMs, op, index};
+    delayed++;
+    return REMOTE_OK;
+  }
+
+  commands++;
+  if (op == REMOTE_PLAY) {
+    return (playFn != nullptr && playFn(index)) ? REMOTE_OK : REMOTE_BAD_INDEX;
+  }
+  if (stopFn != nullptr) stopFn(index);
+  return REMOTE_OK;
+}
+
+void RemoteLink::service() {
+  if (parser.busy() && millis() - parser.startMillis > REMOTE_FRAME_TIMEOUT_MS) {
+    parser.reset();
+    rejected++;
+  }
+  if (pendingCount == 0) return;
+
+  // Due commands run in the order they arrived; the rest keep it
+  uint32_t now = millis();
+  int kept = 0;
+  for (int i = 0; i < pendingCount; i++) {
+    if ((int32_t)(now - pending[i].due) >= 0) {
+      run(pending[i].op, pending[i].index, 0, now);
+    } else {
+      pending[kept++] = pending[i];
+    }
+  }
+  pendingCount = kept;
+}
+
+void RemoteLink::voiceStarted(int index) {
+  if (!active) return;
+  uint8_t started[3] = {REMOTE_STARTED, (uint8_t)(index & 0xFF), (uint8_t)(index >> 8)};
+  send(0, started, sizeof(started));
+}
+
+// One write per frame, so log text from other tasks cannot split it
+void RemoteLink::send(uint8_t seq, const uint8_t *payload, int len) {
+  uint8_t frame[REMOTE_MAX_PAYLOAD + REMOTE_FRAME_OVERHEAD];
+  Serial.write(frame, remoteEncode(seq, payload, len, frame));
+}
+
+// ===== STATISTICS =====
+void RemoteLink::printStats() {
+  Serial.printf("Remote: %u frames, %u rejected, %u commands run (%u were delayed), "
+                "%u dropped with the delay table full\n",
+                frames, rejected, commands, delayed, dropped);
+  Serial.printf("  Longest frame in loop(): %u us, delayed commands waiting: %d of %d\n",
+                frameMicrosMax, pendingCount, REMOTE_PENDING);
+  frameMicrosMax = 0;
+}
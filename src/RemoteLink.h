@@ -0,0 +1,166 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ===== SERIAL REMOTE CONTROL =====
+// Binary commands from a show-control PC over the USB serial port, next to
+// the single-character console commands (tools/sound_remote.py is the
+// client). Both directions use one frame format:
+//
+//   0xA5 | length | seq | payload (length bytes) | CRC-16 (little endian)
+//
+// The CRC is CRC-16/CCITT-FALSE over length, seq and payload. The sync
+// byte is not a console command, so a frame starts wherever the console
+// reads one, and the link consumes bytes until the frame is complete or
+// stalls for REMOTE_FRAME_TIMEOUT_MS. Log text the board prints is skipped
+// by the client the same way. A frame that fails its CRC is answered with
+// BAD_CRC and the search for a sync byte resumes right after its own, so a
+// corrupted length cannot swallow the frame behind it. A command payload
+// is a batch of:
+//
+//   PLAY    0x01  u16 sound index, u16 delay ms
+//   STOP    0x02  u16 sound index (0xFFFF: all), u16 delay ms
+//   VOLUME  0x03  u8 level (0..10)
+//   STATUS  0x04
+//   QUEUE   0x05  u16 sound index, u16 gap in output samples
+//
+// Delays count from the frame's arrival, so one frame can lay out a cue
+// sequence; commands without a delay run as the frame is parsed, delayed
+// ones from a fixed table checked every loop(). QUEUE appends to the
+// mixer's gapless sequence instead: the sound starts on the sample after
+// the previous queued one ends, plus the gap. The board answers every
+// frame with ACK (seq echoed, result) or, for a frame with STATUS, STATUS
+// and then ACK. Once a remote has sent a valid frame, each voice start is
+// reported with STARTED, which is what the client times playback by.
+//
+//   ACK      0x81  u8 result
+//   STATUS   0x84  u8 volume, u8 voices playing, u16 sounds, u16 pending,
+//                  u32 frames received, u32 frames rejected
+//   STARTED  0x85  u16 sound index
+//
+// Everything runs in loop(): bytes are fed one at a time as they arrive,
+// nothing waits for the rest of a frame, and commands only post to the
+// audio task.
+
+#define REMOTE_SYNC             0xA5
+#define REMOTE_MAX_PAYLOAD      64      // Up to 12 PLAY commands per frame
+#define REMOTE_FRAME_OVERHEAD   5       // Sync, length, seq, CRC
+#define REMOTE_PENDING          32      // Delayed commands waiting at once
+#define REMOTE_FRAME_TIMEOUT_MS 50      // A frame stalled this long is dropped
+#define REMOTE_ALL_SOUNDS       0xFFFF
+
+enum RemoteOpcode : uint8_t {
+  REMOTE_PLAY = 0x01,
+  REMOTE_STOP = 0x02,
+  REMOTE_VOLUME = 0x03,
+  REMOTE_STATUS = 0x04,
+  REMOTE_QUEUE = 0x05,
+  REMOTE_ACK = 0x81,                    // Board to PC
+  REMOTE_STATUS_REPLY = 0x84,
+  REMOTE_STARTED = 0x85,
+};
+
+enum RemoteResult : uint8_t {
+  REMOTE_OK = 0,
+  REMOTE_BAD_CRC,                       // Nothing in the frame was run
+  REMOTE_BAD_COMMAND,                   // Unknown opcode or cut-off arguments; nothing run
+  REMOTE_BAD_INDEX,                     // A sound that does not exist (others ran)
+  REMOTE_QUEUE_FULL,                    // Delayed commands dropped (others ran)
+};
+
+enum RemoteParse : uint8_t {
+  REMOTE_PARSE_IGNORED = 0,             // Not part of a frame
+  REMOTE_PARSE_MORE,                    // Taken; frame not complete yet
+  REMOTE_PARSE_FRAME,                   // Taken; a valid frame is ready
+  REMOTE_PARSE_BAD_CRC,                 // Taken; the frame failed its CRC
+};
+
+struct RemoteStatus {
+  uint8_t volume;
+  uint8_t voices;
+  uint16_t sounds;
+};
+
+// Incremental frame decoder, used by the board and by the host benchmark
+struct RemoteParser {
+  uint8_t state;
+  uint8_t got;
+  uint32_t startMillis;
+  uint8_t buf[REMOTE_MAX_PAYLOAD + REMOTE_FRAME_OVERHEAD];
+
+  RemoteParser() : state(0), got(0), startMillis(0) {}
+  uint8_t feed(uint8_t c);
+  bool busy() const { return state != 0; }
+  void reset() { state = 0; }
+  uint8_t seq() const { return buf[2]; }
+  uint8_t length() const { return buf[1]; }
+  const uint8_t *payload() const { return buf + 3; }
+};
+
+uint16_t remoteCrc16(const uint8_t *data, int len);
+
+// Frame `len` payload bytes into out (REMOTE_FRAME_OVERHEAD more bytes);
+// returns the frame length
+int remoteEncode(uint8_t seq, const uint8_t *payload, int len, uint8_t *out);
+
+class RemoteLink {
+  public:
+    typedef bool (*PlayFn)(int index);      // false: no such sound
+    typedef void (*StopFn)(int index);      // REMOTE_ALL_SOUNDS: everything
+    typedef void (*VolumeFn)(int level);
+    typedef void (*StatusFn)(RemoteStatus &status);
+    typedef bool (*QueueFn)(int index, uint32_t gap);  // false: no such sound
+
+    RemoteLink();
+    void begin(PlayFn play, StopFn stop, VolumeFn volume, StatusFn status, QueueFn queue);
+
+    // Console: offer a received byte. Returns false if it is not part of a
+    // frame, i.e. a console command.
+    bool feed(uint8_t c);
+
+    // loop(): run delayed commands that are due, drop a stalled frame
+    void service();
+
+    // loop(): a voice started playing `index`
+    void voiceStarted(int index);
+
+    // A remote has sent a valid frame (it then expects the board to listen)
+    bool connected() const { return active; }
+    // A frame is half in or delayed commands are waiting
+    bool waiting() const { return pendingCount > 0 || parser.busy(); }
+
+    // Frames, rejects and commands since boot, and the longest frame
+    // handling since the last call
+    void printStats();
+
+  private:
+    struct Pending {
+      uint32_t due;                       // millis()
+      uint8_t op;
+      uint16_t index;
+    };
+
+    void runFrame();
+    uint8_t run(uint8_t op, uint16_t index, uint32_t delayMs, uint32_t now);
+    void send(uint8_t seq, const uint8_t *payload, int len);
+
+    PlayFn playFn;
+    StopFn stopFn;
+    VolumeFn volumeFn;
+    StatusFn statusFn;
+    QueueFn queueFn;
+    RemoteParser parser;
+    bool active;                          // A valid frame has been received
+    Pending pending[REMOTE_PENDING];
+    int pendingCount;
+
+    // Statistics
+    uint32_t frames;
+    uint32_t rejected;
+    uint32_t commands;
+    uint32_t delayed;
+    uint32_t dropped;
+    uint32_t frameMicrosMax;              // Longest frame handling in loop()
+};
+
+extern RemoteLink remoteLink;
@@ -0,0 +1,662 @@
+#include "SoundCatalog.h"
+#include "AudioFileSourceBank.h"
+#include "EventLog.h"
+#include <strings.h>
+
+// ===== CSV SOURCE =====
+CatalogCsvSource::CatalogCsvSource(fs::FS &f, const char *p) : fs(f), path(p) {
+  bufLen = bufPos = 0;
+  headerSkipped = false;
+  invalidRows = 0;
+}
+
+bool CatalogCsvSource::stat(uint32_t &size, uint32_t &time) {
+  fs::File f = fs.open(path, FILE_READ);
+  if (!f) return false;
+  size = f.size();
+  time = (uint32_t)f.getLastWrite();
+  f.close();
+  return true;
+}
+
+bool CatalogCsvSource::rewind() {
+  if (!file) file = fs.open(path, FILE_READ);
+  if (!file || !file.seek(0)) return false;
+  bufLen = bufPos = 0;
+  headerSkipped = false;
+  invalidRows = 0;
+  return true;
+}
+
+// One line without its terminator, cut to len - 1 bytes. Reads the card in
+// buf-sized chunks: a byte at a time goes through the whole VFS stack.
+bool CatalogCsvSource::readLine(char *line, size_t len) {
+  size_t n = 0;
+  bool any = false;
+  for (;;) {
+    if (bufPos == bufLen) {
+      bufLen = file.read(buf, sizeof(buf));
+      bufPos = 0;
+      if (bufLen == 0) break;
+    }
+    char c = buf[bufPos++];
+    any = true;
+    if (c == '\n') break;
+    if (n < len - 1) line[n++] = c;
+  }
+  line[n] = '\0';
+  return any;
+}
+
+static char *trimSpace(char *s) {
+  while (*s == ' ' || *s == '\t') s++;
+  char *end = s + strlen(s);
+  while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+  *end = '\0';
+  return s;
+}
+
+static void copyField(char *dst, const char *src, size_t len) {
+  strncpy(dst, src, len - 1);
+  dst[len - 1] = '\0';
+}
+
+bool CatalogCsvSource::next(char *name, char *title) {
+  char raw[128];
+  while (readLine(raw, sizeof(raw))) {
+    char *line = trimSpace(raw);
+    if (*line == '\0') continue;
+
+    // Skip header row
+    if (!headerSkipped) {
+      headerSkipped = true;
+      continue;
+    }
+
+    // Parse CSV line: filename,title
+    char *comma = strchr(line, ',');
+    if (comma == nullptr || comma == line) {
+      invalidRows++;
+      continue;
+    }
+    *comma = '\0';
+    copyField(name, trimSpace(line), CATALOG_NAME_LEN);
+    copyField(title, trimSpace(comma + 1), CATALOG_TITLE_LEN);
+    return true;
+  }
+  return false;
+}
+
+// ===== BANK SOURCE =====
+CatalogBankSource::CatalogBankSource(SoundBank &b, fs::FS &f, const char *p)
+    : bank(b), fs(f), path(p) {
+  row = 0;
+}
+
+bool CatalogBankSource::stat(uint32_t &size, uint32_t &time) {
+  fs::File f = fs.open(path, FILE_READ);
+  if (!f) return false;
+  size = f.size();
+  time = (uint32_t)f.getLastWrite();
+  f.close();
+  return true;
+}
+
+bool CatalogBankSource::next(char *name, char *title) {
+  SoundBankEntry e;
+  if (row >= bank.count() || !bank.entry(row, e)) return false;
+  copyField(name, e.filename, CATALOG_NAME_LEN);
+  bank.readTitle(e, title, CATALOG_TITLE_LEN);
+  row++;
+  return true;
+}
+
+bool CatalogBankSource::thumb(WavThumb &t) {
+  return row > 0 && bank.thumb(row - 1, t);
+}
+
+// ===== SOUND CATALOG =====
+SoundCatalog::SoundCatalog() {
+  builtinCount = 0;
+  memset(&header, 0, sizeof(header));
+  cardCount = 0;
+  windowFirst = windowCount = 0;
+  statGets = statLoads = 0;
+  statLoadMicrosMax = statLoadMicrosTotal = 0;
+  statSearches = statProbes = statSearchMicrosMax = 0;
+  buildMillis = 0;
+}
+
+bool SoundCatalog::addBuiltin(const char *filename, const char *title) {
+  if (builtinCount >= CATALOG_MAX_BUILTINS) return false;
+  SoundEntry &e = builtin[builtinCount++];
+  memset(&e, 0, sizeof(e));
+  copyField(e.filename, filename, sizeof(e.filename));
+  copyField(e.title, title, sizeof(e.title));
+  return true;
+}
+
+bool SoundCatalog::open(fs::FS &fs, const char *indexPath, CatalogSource &source) {
+  file.close();
+  cardCount = windowCount = 0;
+  buildMillis = 0;
+
+  file = fs.open(indexPath, "r+");
+  if (!file || !readHeader(file, header) || !isCurrent(source, header)) {
+    uint32_t t0 = millis();
+    if (!build(fs, indexPath, source)) {
+      Serial.printf("ERROR: Could not build %s\n", indexPath);
+      file.close();
+      memset(&header, 0, sizeof(header));
+      return false;
+    }
+    buildMillis = max<uint32_t>(millis() - t0, 1);
+    file = fs.open(indexPath, "r+");
+    if (!file || !readHeader(file, header)) return false;
+    Serial.printf("Built %s: %u sounds in %u ms", indexPath, header.count, buildMillis);
+    if (source.skipped() > 0) Serial.printf(", %d invalid rows skipped", source.skipped());
+    Serial.println();
+  }
+
+  cardCount = header.count;
+  Serial.printf("Catalog: %d sounds (%d built-in), %d in RAM\n", count(), builtinCount,
+                min(cardCount, CATALOG_WINDOW));
+  return cardCount > 0;
+}
+
+bool SoundCatalog::readHeader(fs::File &f, CatalogHeader &h) {
+  if (!f.seek(0) || f.read((uint8_t *)&h, sizeof(h)) != sizeof(h)) return false;
+  return memcmp(h.magic, CATALOG_MAGIC, 4) == 0 && h.version == CATALOG_VERSION &&
+         h.recordsOffset == sizeof(h) &&
+         h.titlesOffset == h.recordsOffset + h.count * sizeof(CatalogRecord) &&
+         h.stringsOffset == h.titlesOffset + h.count * sizeof(CatalogTitle) &&
+         f.size() == h.stringsOffset + h.stringsSize;
+}
+
+bool SoundCatalog::isCurrent(CatalogSource &source, const CatalogHeader &h) {
+  uint32_t size, time;
+  return source.stat(size, time) && h.sourceKind == source.kind() &&
+         h.sourceSize == size && h.sourceTime == time;
+}
+
+// ===== TITLE SORT =====
+static int compareTitles(const CatalogTitle &a, const CatalogTitle &b) {
+  int c = strcasecmp(a.title, b.title);
+  if (c != 0) return c;
+  return a.card < b.card ? -1 : a.card > b.card ? 1 : 0;
+}
+
+static int compareTitlesQsort(const void *a, const void *b) {
+  return compareTitles(*(const CatalogTitle *)a, *(const CatalogTitle *)b);
+}
+
+// Titles [pos, end) of a sorted run in a scratch file, read a block at a time
+struct TitleRun {
+  fs::File &file;
+  uint32_t pos, end;
+  CatalogTitle *block;
+  int cap, len, at;
+  bool ok;
+
+  TitleRun(fs::File &f, uint32_t from, uint32_t to, CatalogTitle *buf, int n)
+      : file(f), pos(from), end(to), block(buf), cap(n), len(0), at(0), ok(true) {}
+
+  const CatalogTitle *peek() {
+    if (at == len) {
+      if (pos >= end) return nullptr;
+      len = min<uint32_t>(cap, end - pos);
+      size_t bytes = len * sizeof(CatalogTitle);
+      if (!file.seek(pos * sizeof(CatalogTitle)) || file.read((uint8_t *)block, bytes) != bytes) {
+        ok = false;
+        pos = end;
+        return nullptr;
+      }
+      pos += len;
+      at = 0;
+    }
+    return &block[at];
+  }
+  void pop() { at++; }
+};
+
+// Merge neighbouring runs of `width` titles from in into runs of twice that
+static bool mergePass(fs::File &in, fs::File &out, uint32_t count, uint32_t width,
+                      CatalogTitle *buf) {
+  const int block = CATALOG_SORT_RUN / 3;
+  CatalogTitle *staged = buf + 2 * block;
+  int n = 0;
+  bool ok = true;
+  for (uint32_t start = 0; start < count; start += 2 * width) {
+    uint32_t mid = min(start + width, count);
+    uint32_t end = min(start + 2 * width, count);
+    TitleRun a(in, start, mid, buf, block);
+    TitleRun b(in, mid, end, buf + block, block);
+    for (;;) {
+      const CatalogTitle *x = a.peek();
+      const CatalogTitle *y = b.peek();
+      if (x == nullptr && y == nullptr) break;
+      bool fromA = x != nullptr && (y == nullptr || compareTitles(*x, *y) <= 0);
+      staged[n++] = fromA ? *x : *y;
+      if (fromA) a.pop();
+      else b.pop();
+      if (n == block) {
+        ok &= out.write((const uint8_t *)staged, n * sizeof(CatalogTitle)) == n * sizeof(CatalogTitle);
+        n = 0;
+      }
+    }
+    ok &= a.ok && b.ok;
+  }
+  ok &= out.write((const uint8_t *)staged, n * sizeof(CatalogTitle)) == n * sizeof(CatalogTitle);
+  return ok;
+}
+
+// External merge sort of the source's titles: runs of CATALOG_SORT_RUN
+// sorted in buf, then merge passes back and forth between two scratch
+// files, each run and the output buffered a block at a time. RAM use is
+// buf alone, whatever the list length. On success scratch[sorted] holds
+// the title table and the other scratch file is gone.
+bool SoundCatalog::sortTitles(fs::FS &fs, CatalogSource &source, uint32_t count,
+                              CatalogTitle *buf, char (*scratch)[48], int &sorted) {
+  char name[CATALOG_NAME_LEN];
+  char title[CATALOG_TITLE_LEN];
+  fs::File out = fs.open(scratch[0], FILE_WRITE);
+  if (!out || !source.rewind()) return false;
+
+  uint32_t rows = 0;
+  int n = 0;
+  bool ok = true;
+  while (rows < count && source.next(name, title)) {
+    CatalogTitle &t = buf[n++];
+    memset(&t, 0, sizeof(t));
+    memcpy(t.title, title, strnlen(title, sizeof(t.title) - 1));  // NUL-padded by the memset
+    t.card = rows++;
+    if (n == CATALOG_SORT_RUN || rows == count) {
+      qsort(buf, n, sizeof(CatalogTitle), compareTitlesQsort);
+      ok &= out.write((const uint8_t *)buf, n * sizeof(CatalogTitle)) == n * sizeof(CatalogTitle);
+      n = 0;
+    }
+  }
+  out.close();
+  ok &= rows == count;
+
+  sorted = 0;
+  for (uint32_t width = CATALOG_SORT_RUN; ok && width < count; width *= 2) {
+    fs::File in = fs.open(scratch[sorted], FILE_READ);
+    out = fs.open(scratch[sorted ^ 1], FILE_WRITE);
+    ok = in && out && mergePass(in, out, count, width, buf);
+    in.close();
+    out.close();
+    sorted ^= 1;
+  }
+  fs.remove(scratch[sorted ^ 1]);
+  if (!ok) fs.remove(scratch[sorted]);
+  return ok;
+}
+
+// ===== INDEX BUILD =====
+// Sequential passes over the source (count, title sort, records, strings),
+// so neither the index nor the source is ever held in RAM. The header's
+// magic is written last: an interrupted build leaves an index that fails
+// readHeader() and is rebuilt on the next boot. Trim points and thumbnails
+// of a stale index carry over to rows that kept their position and
+// filename (rows appended to index.csv); the file-size check re-analyzes
+// replaced WAVs. A bank's thumbnails are taken from the bank.
+bool SoundCatalog::build(fs::FS &fs, const char *indexPath, CatalogSource &source) {
+  CatalogHeader old;
+  bool carry = file && readHeader(file, old) && old.sourceKind == source.kind();
+
+  CatalogHeader h;
+  memset(&h, 0, sizeof(h));
+  h.version = CATALOG_VERSION;
+  h.sourceKind = source.kind();
+  if (!source.stat(h.sourceSize, h.sourceTime) || !source.rewind()) return false;
+
+  char name[CATALOG_NAME_LEN];
+  char title[CATALOG_TITLE_LEN];
+  while (source.next(name, title)) {
+    h.count++;
+    h.stringsSize += strlen(name) + strlen(title);
+  }
+  h.recordsOffset = sizeof(h);
+  h.titlesOffset = h.recordsOffset + h.count * sizeof(CatalogRecord);
+  h.stringsOffset = h.titlesOffset + h.count * sizeof(CatalogTitle);
+
+  CatalogTitle *sortBuf = (CatalogTitle *)malloc(CATALOG_SORT_RUN * sizeof(CatalogTitle));
+  if (sortBuf == nullptr) return false;
+  char scratch[2][48];
+  snprintf(scratch[0], sizeof(scratch[0]), "%s.s0", indexPath);
+  snprintf(scratch[1], sizeof(scratch[1]), "%s.s1", indexPath);
+  int sorted = 0;
+  if (h.count > 0 && !sortTitles(fs, source, h.count, sortBuf, scratch, sorted)) {
+    free(sortBuf);
+    return false;
+  }
+
+  char tmpPath[48];
+  snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", indexPath);
+  fs::File out = fs.open(tmpPath, FILE_WRITE);
+  if (!out) {
+    free(sortBuf);
+    fs.remove(scratch[sorted]);
+    return false;
+  }
+
+  // Writes are staged through the window's string buffer (unused here)
+  size_t staged = 0;
+  bool ok = true;
+  auto put = [&](const void *src, size_t len) {
+    if (staged + len > sizeof(strings)) {
+      ok &= out.write((const uint8_t *)strings, staged) == staged;
+      staged = 0;
+    }
+    memcpy(strings + staged, src, len);
+    staged += len;
+  };
+  CatalogHeader blank;
+  memset(&blank, 0, sizeof(blank));
+  put(&blank, sizeof(blank));
+
+  uint32_t rows = 0, offset = 0;
+  source.rewind();
+  while (source.next(name, title) && rows < h.count) {
+    CatalogRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.nameLen = strlen(name);
+    rec.titleLen = strlen(title);
+    rec.nameOffset = offset;
+    rec.titleOffset = offset + rec.nameLen;
+    offset += rec.nameLen + rec.titleLen;
+
+    CatalogRecord prev;
+    char prevName[CATALOG_NAME_LEN];
+    if (carry && rows < old.count &&
+        file.seek(old.recordsOffset + rows * sizeof(prev)) &&
+        file.read((uint8_t *)&prev, sizeof(prev)) == sizeof(prev) &&
+        prev.nameLen == rec.nameLen && prev.nameLen < sizeof(prevName) &&
+        file.seek(old.stringsOffset + prev.nameOffset) &&
+        file.read((uint8_t *)prevName, prev.nameLen) == prev.nameLen &&
+        memcmp(prevName, name, rec.nameLen) == 0) {
+      rec.trimStart = prev.trimStart;
+      rec.trimEnd = prev.trimEnd;
+      rec.trimFileSize = prev.trimFileSize;
+      rec.durationMs = prev.durationMs;
+      memcpy(rec.wave, prev.wave, sizeof(rec.wave));
+    }
+    WavThumb t;
+    if (source.thumb(t)) {
+      rec.durationMs = t.durationMs;
+      memcpy(rec.wave, t.wave, sizeof(rec.wave));
+    }
+    put(&rec, sizeof(rec));
+    rows++;
+  }
+
+  uint32_t titles = 0;
+  if (h.count > 0) {
+    fs::File in = fs.open(scratch[sorted], FILE_READ);
+    size_t got;
+    while (in && (got = in.read((uint8_t *)sortBuf, CATALOG_SORT_RUN * sizeof(CatalogTitle))) > 0) {
+      for (size_t i = 0; i < got / sizeof(CatalogTitle); i++) put(&sortBuf[i], sizeof(CatalogTitle));
+      titles += got / sizeof(CatalogTitle);
+    }
+    in.close();
+    fs.remove(scratch[sorted]);
+  }
+  free(sortBuf);
+
+  uint32_t strRows = 0;
+  source.rewind();
+  while (source.next(name, title) && strRows < rows) {
+    put(name, strlen(name));
+    put(title, strlen(title));
+    strRows++;
+  }
+  ok &= out.write((const uint8_t *)strings, staged) == staged;
+
+  // The source changed between passes: keep the old index, try next boot
+  ok &= rows == h.count && titles == h.count && strRows == h.count && offset == h.stringsSize;
+  memcpy(h.magic, CATALOG_MAGIC, 4);
+  ok = ok && out.seek(0) && out.write((const uint8_t *)&h, sizeof(h)) == sizeof(h);
+  out.close();
+  file.close();
+  if (!ok) {
+    fs.remove(tmpPath);
+    return false;
+  }
+  fs.remove(indexPath);
+  return fs.rename(tmpPath, indexPath);
+}
+
+// ===== RANDOM ACCESS =====
+void SoundCatalog::fill(const CatalogRecord &rec, const char *name, const char *title,
+                        SoundEntry &e) {
+  size_t n = min<size_t>(rec.nameLen, sizeof(e.filename) - 1);
+  memcpy(e.filename, name, n);
+  e.filename[n] = '\0';
+  n = min<size_t>(rec.titleLen, sizeof(e.title) - 1);
+  memcpy(e.title, title, n);
+  e.title[n] = '\0';
+  e.trim.startFrame = rec.trimStart;
+  e.trim.endFrame = rec.trimEnd;
+  e.trimFileSize = rec.trimFileSize;
+  e.thumb.durationMs = rec.durationMs;
+  memcpy(e.thumb.wave, rec.wave, sizeof(e.thumb.wave));
+}
+
+bool SoundCatalog::readRecord(int card, CatalogRecord &rec) {
+  return file.seek(header.recordsOffset + card * sizeof(rec)) &&
+         file.read((uint8_t *)&rec, sizeof(rec)) == sizeof(rec);
+}
+
+// One sound's strings, read on their own
+bool SoundCatalog::readEntry(const CatalogRecord &rec, SoundEntry &e) {
+  char name[CATALOG_NAME_LEN];
+  char title[CATALOG_TITLE_LEN];
+  size_t nameLen = min<size_t>(rec.nameLen, sizeof(name));
+  size_t titleLen = min<size_t>(rec.titleLen, sizeof(title));
+  if (!file.seek(header.stringsOffset + rec.nameOffset) ||
+      file.read((uint8_t *)name, nameLen) != nameLen ||
+      !file.seek(header.stringsOffset + rec.titleOffset) ||
+      file.read((uint8_t *)title, titleLen) != titleLen) {
+    return false;
+  }
+  fill(rec, name, title, e);
+  return true;
+}
+
+// Records [first, first + CATALOG_WINDOW) in one read, then the span of the
+// string table they point into in another (the builder lays a window's
+// strings out contiguously)
+bool SoundCatalog::loadWindow(int first) {
+  uint32_t t0 = micros();
+  int n = min(CATALOG_WINDOW, cardCount - first);
+  windowCount = 0;
+  if (n <= 0 || !file.seek(header.recordsOffset + first * sizeof(CatalogRecord)) ||
+      file.read((uint8_t *)records, n * sizeof(CatalogRecord)) != n * sizeof(CatalogRecord)) {
+    return false;
+  }
+
+  uint32_t lo = UINT32_MAX, hi = 0;
+  for (int i = 0; i < n; i++) {
+    lo = min(lo, min(records[i].nameOffset, records[i].titleOffset));
+    hi = max(hi, max(records[i].nameOffset + records[i].nameLen,
+                     records[i].titleOffset + records[i].titleLen));
+  }
+  if (hi - lo <= sizeof(strings) && file.seek(header.stringsOffset + lo) &&
+      file.read((uint8_t *)strings, hi - lo) == hi - lo) {
+    for (int i = 0; i < n; i++) {
+      fill(records[i], strings + records[i].nameOffset - lo,
+           strings + records[i].titleOffset - lo, window[i]);
+    }
+  } else {
+    for (int i = 0; i < n; i++) {
+      if (!readEntry(records[i], window[i])) return false;
+    }
+  }
+  windowFirst = first;
+  windowCount = n;
+
+  uint32_t us = micros() - t0;
+  statLoads++;
+  statLoadMicrosTotal += us;
+  if (us > statLoadMicrosMax) statLoadMicrosMax = us;
+  return true;
+}
+
+const SoundEntry *SoundCatalog::get(int index) {
+  if (index < 0 || index >= count()) return nullptr;
+  if (index < builtinCount) return &builtin[index];
+  statGets++;
+  int card = index - builtinCount;
+  if (card < windowFirst || card >= windowFirst + windowCount) {
+    prefetch(index, 1);
+    if (card < windowFirst || card >= windowFirst + windowCount) return nullptr;
+  }
+  return &window[card - windowFirst];
+}
+
+void SoundCatalog::prefetch(int first, int visible) {
+  int from = max(first - builtinCount, 0);
+  int to = min(first + visible - builtinCount, cardCount);
+  if (from >= to) return;
+  if (from >= windowFirst && to <= windowFirst + windowCount) return;
+
+  int start = from - (CATALOG_WINDOW - (to - from)) / 2;
+  start = constrain(start, 0, max(cardCount - CATALOG_WINDOW, 0));
+  if (!loadWindow(start)) LOG_WARN("Catalog: could not load sounds from %d", start + builtinCount);
+}
+
+bool SoundCatalog::read(int index, SoundEntry &out) {
+  if (index < 0 || index >= count()) return false;
+  if (index < builtinCount) {
+    out = builtin[index];
+    return true;
+  }
+  int card = index - builtinCount;
+  if (card >= windowFirst && card < windowFirst + windowCount) {
+    out = window[card - windowFirst];
+    return true;
+  }
+  CatalogRecord rec;
+  return readRecord(card, rec) && readEntry(rec, out);
+}
+
+bool SoundCatalog::path(int index, char *dst, size_t len) {
+  if (index < 0 || index >= count()) return false;
+  if (index >= builtinCount && fromBank()) {
+    snprintf(dst, len, "#%d", index - builtinCount);
+    return true;
+  }
+  SoundEntry e;
+  if (!read(index, e)) return false;
+  snprintf(dst, len, index < builtinCount ? "%s" : "/%s", e.filename);
+  return true;
+}
+
+bool SoundCatalog::readThumb(int index, WavThumb &out) {
+  if (index < 0 || index >= count()) return false;
+  if (index < builtinCount) {
+    out = builtin[index].thumb;
+    return true;
+  }
+  int card = index - builtinCount;
+  if (card >= windowFirst && card < windowFirst + windowCount) {
+    out = window[card - windowFirst].thumb;
+    return true;
+  }
+  CatalogRecord rec;
+  if (!readRecord(card, rec)) return false;
+  out.durationMs = rec.durationMs;
+  memcpy(out.wave, rec.wave, sizeof(out.wave));
+  return true;
+}
+
+bool SoundCatalog::setAnalysis(int index, const WavTrim &trim, const WavThumb &thumb,
+                               uint32_t fileSize) {
+  int card = index - builtinCount;
+  if (card < 0 || card >= cardCount) return false;
+
+  // The record's tail, trimStart through wave, in one write
+  CatalogRecord rec;
+  rec.trimStart = trim.startFrame;
+  rec.trimEnd = trim.endFrame;
+  rec.trimFileSize = fileSize;
+  rec.durationMs = thumb.durationMs;
+  memcpy(rec.wave, thumb.wave, sizeof(rec.wave));
+  const size_t from = offsetof(CatalogRecord, trimStart);
+  const size_t len = sizeof(rec) - from;
+  if (!file.seek(header.recordsOffset + card * sizeof(CatalogRecord) + from) ||
+      file.write((const uint8_t *)&rec + from, len) != len) {
+    return false;
+  }
+  file.flush();
+
+  if (card >= windowFirst && card < windowFirst + windowCount) {
+    window[card - windowFirst].trim = trim;
+    window[card - windowFirst].trimFileSize = fileSize;
+    window[card - windowFirst].thumb = thumb;
+  }
+  return true;
+}
+
+// ===== TITLE SEARCH =====
+int SoundCatalog::readTitles(int rank, int n, CatalogTitle *out) {
+  n = min(n, cardCount - rank);
+  if (rank < 0 || n <= 0) return 0;
+  size_t bytes = n * sizeof(CatalogTitle);
+  if (!file.seek(header.titlesOffset + rank * sizeof(CatalogTitle)) ||
+      file.read((uint8_t *)out, bytes) != bytes) {
+    return 0;
+  }
+  return n;
+}
+
+void SoundCatalog::findPrefix(const char *prefix, int lo, int hi, int &first, int &end) {
+  uint32_t t0 = micros();
+  size_t len = strlen(prefix);
+  lo = max(lo, 0);
+  hi = min(hi, cardCount);
+  bool ok = true;
+
+  // First rank in [a, b) whose title sorts after the prefix, or at or after
+  // it when !past (a title that starts with the prefix compares equal)
+  auto bound = [&](int a, int b, bool past) {
+    while (ok && a < b) {
+      int mid = a + (b - a) / 2;
+      CatalogTitle t;
+      statProbes++;
+      if (readTitles(mid, 1, &t) != 1) {
+        ok = false;
+        break;
+      }
+      int c = strncasecmp(t.title, prefix, len);
+      if (c < 0 || (past && c == 0)) a = mid + 1;
+      else b = mid;
+    }
+    return a;
+  };
+  first = bound(lo, hi, false);
+  end = bound(first, hi, true);
+  if (!ok) {
+    LOG_WARN("Catalog: title search failed");
+    first = end = lo;
+  }
+
+  uint32_t us = micros() - t0;
+  statSearches++;
+  if (us > statSearchMicrosMax) statSearchMicrosMax = us;
+}
+
+// ===== STATISTICS =====
+void SoundCatalog::printStats() {
+  Serial.printf("Catalog: %d sounds, window %d at %d, %u RAM bytes\n", count(), windowCount,
+                windowFirst + builtinCount, (unsigned)sizeof(*this));
+  if (buildMillis > 0) Serial.printf("  Index built this boot in %u ms\n", buildMillis);
+  Serial.printf("  %u lookups, %u window loads, load avg %u us, max %u us\n", statGets, statLoads,
+                statLoads ? statLoadMicrosTotal / statLoads : 0, statLoadMicrosMax);
+  Serial.printf("  %u title searches, %u title reads, max %u us\n", statSearches, statProbes,
+                statSearchMicrosMax);
+  statGets = statLoads = 0;
+  statLoadMicrosMax = statLoadMicrosTotal = 0;
+  statSearches = statProbes = statSearchMicrosMax = 0;
+}
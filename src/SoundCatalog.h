@@ -0,0 +1,226 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include "WavParser.h"
+
+class SoundBank;
+
+// ===== SOUND CATALOG =====
+// The sound list, kept on the card as a binary index (/catalog.idx):
+//
+//   header   36 bytes, see CatalogHeader
+//   records  one 60-byte CatalogRecord per sound, in list order
+//   titles   one 36-byte CatalogTitle per sound, in A-Z title order
+//   strings  each sound's filename then its title, in list order
+//
+// Records are fixed-size, so sound n is one seek away. The title table is
+// sorted case-insensitively when the index is built, so a prefix search
+// is a binary search of O(log n) 36-byte reads, and a page of the A-Z list
+// is one read. Only a window of
+// CATALOG_WINDOW sounds around the current page is held in RAM (a window
+// load is one read for its records and one for their strings), so memory
+// use is the same for 20 sounds or 20,000.
+//
+// The index is built from index.csv or from the sound bank's table, and
+// rebuilt when that source's size or modification time changes. Silence-
+// trim points and button thumbnails (WavThumb) of loose WAVs live in the
+// records and are updated in place by the idle analysis pass; a bank's
+// thumbnails come from its table. Built-in sounds come first and stay in
+// RAM.
+//
+// Used from loop() only.
+
+#define CATALOG_MAGIC        "SCAT"
+#define CATALOG_VERSION      3
+#define CATALOG_NAME_LEN     16     // Filename bytes in RAM, NUL included
+#define CATALOG_TITLE_LEN    32     // Title bytes in RAM, NUL included
+#define CATALOG_MAX_BUILTINS 8
+#ifndef CATALOG_WINDOW
+#define CATALOG_WINDOW       16     // Sounds held in RAM (visible page + prefetch)
+#endif
+#ifndef CATALOG_SORT_RUN
+#define CATALOG_SORT_RUN     96     // Titles sorted in RAM per run while building
+#endif
+
+enum CatalogSourceKind : uint8_t {
+  CATALOG_SOURCE_CSV = 1,
+  CATALOG_SOURCE_BANK = 2,
+};
+
+struct CatalogHeader {
+  char magic[4];
+  uint16_t version;
+  uint8_t sourceKind;
+  uint8_t reserved;
+  uint32_t count;
+  uint32_t recordsOffset;
+  uint32_t titlesOffset;
+  uint32_t stringsOffset;
+  uint32_t stringsSize;
+  uint32_t sourceSize;              // Source the index was built from
+  uint32_t sourceTime;
+};
+
+struct CatalogRecord {
+  uint32_t nameOffset;              // Into the string table
+  uint32_t titleOffset;
+  uint8_t nameLen;
+  uint8_t titleLen;
+  uint16_t flags;
+  uint32_t trimStart;               // WavTrim; trimEnd 0 until analyzed
+  uint32_t trimEnd;
+  uint32_t trimFileSize;            // File size the trim was found for
+  uint32_t durationMs;              // WavThumb; 0 until analyzed
+  uint8_t wave[WAV_THUMB_COLUMNS];
+};
+
+// Title table entry; the title is NUL-padded so entries compare directly
+struct CatalogTitle {
+  char title[CATALOG_TITLE_LEN];
+  uint32_t card;                    // Record index (sound index - builtins)
+};
+
+static_assert(sizeof(CatalogHeader) == 36, "Catalog header layout");
+static_assert(sizeof(CatalogRecord) == 60, "Catalog record layout");
+static_assert(sizeof(CatalogTitle) == 36, "Catalog title layout");
+
+struct SoundEntry {
+  char filename[CATALOG_NAME_LEN];  // e.g., "0001.wav"
+  char title[CATALOG_TITLE_LEN];    // e.g., "Achievement Bell"
+  WavTrim trim;                     // Audible span (loose WAVs; endFrame 0 until analyzed)
+  uint32_t trimFileSize;            // Size the trim points were found for
+  WavThumb thumb;                   // Button thumbnail (durationMs 0 until analyzed)
+};
+
+// ===== CATALOG SOURCES =====
+// Rows an index is built from: rewind(), then next() until it returns
+// false. name and title are CATALOG_NAME_LEN / CATALOG_TITLE_LEN buffers.
+class CatalogSource {
+  public:
+    virtual ~CatalogSource() {}
+    virtual uint8_t kind() const = 0;
+    virtual bool stat(uint32_t &size, uint32_t &time) = 0;
+    virtual bool rewind() = 0;
+    virtual bool next(char *name, char *title) = 0;
+    virtual int skipped() const { return 0; }
+    // Thumbnail of the row next() last returned, if the source has them
+    virtual bool thumb(WavThumb &) { return false; }
+};
+
+// index.csv: a header row, then "filename,title" rows
+class CatalogCsvSource : public CatalogSource {
+  public:
+    CatalogCsvSource(fs::FS &fs, const char *path);
+    virtual uint8_t kind() const override { return CATALOG_SOURCE_CSV; }
+    virtual bool stat(uint32_t &size, uint32_t &time) override;
+    virtual bool rewind() override;
+    virtual bool next(char *name, char *title) override;
+    virtual int skipped() const override { return invalidRows; }
+
+  private:
+    bool readLine(char *line, size_t len);
+
+    fs::FS &fs;
+    const char *path;
+    fs::File file;
+    uint8_t buf[256];
+    size_t bufLen;
+    size_t bufPos;
+    bool headerSkipped;
+    int invalidRows;
+};
+
+// The table of an open sound bank
+class CatalogBankSource : public CatalogSource {
+  public:
+    CatalogBankSource(SoundBank &bank, fs::FS &fs, const char *path);
+    virtual uint8_t kind() const override { return CATALOG_SOURCE_BANK; }
+    virtual bool stat(uint32_t &size, uint32_t &time) override;
+    virtual bool rewind() override { row = 0; return true; }
+    virtual bool next(char *name, char *title) override;
+    virtual bool thumb(WavThumb &t) override;
+
+  private:
+    SoundBank &bank;
+    fs::FS &fs;
+    const char *path;
+    int row;
+};
+
+// ===== SOUND CATALOG =====
+class SoundCatalog {
+  public:
+    SoundCatalog();
+
+    // Built-ins must be added before open()
+    bool addBuiltin(const char *filename, const char *title);
+    // Open the index at indexPath, (re)building it from source if stale
+    bool open(fs::FS &fs, const char *indexPath, CatalogSource &source);
+
+    int count() const { return builtinCount + cardCount; }
+    int builtins() const { return builtinCount; }
+    bool fromBank() const { return header.sourceKind == CATALOG_SOURCE_BANK; }
+
+    // Sound `index`, loading the window around it on a miss. The pointer
+    // is valid until the next get(), prefetch() or open().
+    const SoundEntry *get(int index);
+    // Make sure sounds [first, first + visible) are in the window, with
+    // the rest of the window split around them
+    void prefetch(int first, int visible);
+    // Copy one sound without moving the window
+    bool read(int index, SoundEntry &out);
+    // Path the mixer opens: "/<filename>", or "#<n>" for bank entry n (as
+    // read(), does not move the window)
+    bool path(int index, char *dst, size_t len);
+    // Thumbnail of one sound: one record read unless it is in the window
+    // (as read(), does not move the window)
+    bool readThumb(int index, WavThumb &out);
+    // Store new trim points and thumbnail in the sound's record
+    bool setAnalysis(int index, const WavTrim &trim, const WavThumb &thumb, uint32_t fileSize);
+
+    // Card sounds in A-Z title order, by rank 0 .. count() - builtins() - 1.
+    // Reads up to n titles from rank in one read; returns how many.
+    int readTitles(int rank, int n, CatalogTitle *out);
+    // Ranks [first, end) of the titles starting with prefix (any case),
+    // searched within ranks [lo, hi): typing one more letter only needs
+    // the previous range. Two binary searches over the title table.
+    void findPrefix(const char *prefix, int lo, int hi, int &first, int &end);
+
+    // Window hits/loads, searches and build time, then start a new
+    // measurement window
+    void printStats();
+
+  private:
+    bool isCurrent(CatalogSource &source, const CatalogHeader &h);
+    bool build(fs::FS &fs, const char *indexPath, CatalogSource &source);
+    bool sortTitles(fs::FS &fs, CatalogSource &source, uint32_t count, CatalogTitle *buf,
+                    char (*scratch)[48], int &sorted);
+    bool readHeader(fs::File &f, CatalogHeader &h);
+    bool readRecord(int card, CatalogRecord &rec);
+    bool readEntry(const CatalogRecord &rec, SoundEntry &e);
+    bool loadWindow(int first);
+    static void fill(const CatalogRecord &rec, const char *name, const char *title, SoundEntry &e);
+
+    SoundEntry builtin[CATALOG_MAX_BUILTINS];
+    int builtinCount;
+
+    fs::File file;
+    CatalogHeader header;
+    int cardCount;
+
+    SoundEntry window[CATALOG_WINDOW];
+    CatalogRecord records[CATALOG_WINDOW];
+    char strings[CATALOG_WINDOW * (CATALOG_NAME_LEN + CATALOG_TITLE_LEN)];
+    int windowFirst;                // Card index of window[0]
+    int windowCount;
+
+    uint32_t statGets;
+    uint32_t statLoads;
+    uint32_t statLoadMicrosMax;
+    uint32_t statLoadMicrosTotal;
+    uint32_t statSearches;
+    uint32_t statProbes;
+    uint32_t statSearchMicrosMax;
+    uint32_t buildMillis;           // 0 if the index on the card was current
+};
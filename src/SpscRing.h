@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// ===== SINGLE-PRODUCER / SINGLE-CONSUMER RING =====
+// Lock-free FIFO between exactly one writer and one reader, which may run on
+// different cores. The writer only stores `head` and the reader only stores
+// `tail`; acquire/release ordering makes the slot contents visible before
+// the index that publishes them. N must be a power of two; indices run
+// freely and wrap, so all N slots are usable.
+
+template <typename T, size_t N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+  public:
+    SpscRing() : head(0), tail(0) {}
+
+    // Either side
+    size_t available() const {
+      return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    size_t space() const { return N - available(); }
+    static constexpr size_t capacity() { return N; }
+
+    // Producer side
+    bool push(const T &item) {
+      uint32_t h = head.load(std::memory_order_relaxed);
+      if (h - tail.load(std::memory_order_acquire) == N) return false;
+      slots[h & (N - 1)] = item;
+      head.store(h + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Consumer side
+    bool pop(T &item) {
+      uint32_t t = tail.load(std::memory_order_relaxed);
+      if (head.load(std::memory_order_acquire) == t) return false;
+      item = slots[t & (N - 1)];
+      tail.store(t + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Look at the oldest item without removing it
+    const T *peek() const {
+      uint32_t t = tail.load(std::memory_order_relaxed);
+      if (head.load(std::memory_order_acquire) == t) return nullptr;
+      return &slots[t & (N - 1)];
+    }
+
+    void drop() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // Consumer side; only valid while the producer is quiescent
+    void clear() { tail.store(head.load(std::memory_order_acquire), std::memory_order_release); }
+
+  private:
+    T slots[N];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+};
@@ -0,0 +1,158 @@
+#include "TouchInput.h"
+#include "LatencyTrace.h"
+
+TouchInput *TouchInput::instance = nullptr;
+
+TouchInput::TouchInput() {
+  readFn = nullptr;
+  reinitFn = nullptr;
+  irqPin = -1;
+  irqHeld = false;
+  task = nullptr;
+  reinitRequested = false;
+  irqMicros = 0;
+  irqSeen = false;
+  down = lineHeld = false;
+  lastX = lastY = 0;
+  statReads = statWakes = statDrops = 0;
+  statEvents[0] = statEvents[1] = statEvents[2] = 0;
+  statLatencyCount = statLatencySum = statLatencyMax = 0;
+  statWindowStart = 0;
+}
+
+bool TouchInput::begin(ReadFn read, ReinitFn reinit, int pin, bool held) {
+  readFn = read;
+  reinitFn = reinit;
+  irqPin = pin;
+  irqHeld = held;
+  instance = this;
+  statWindowStart = millis();
+
+  if (xTaskCreatePinnedToCore(touchTask, "touch", TOUCH_TASK_STACK, this,
+                              TOUCH_TASK_PRIORITY, &task, TOUCH_TASK_CORE) != pdPASS) {
+    task = nullptr;
+    Serial.println("ERROR: Could not start touch task");
+    return false;
+  }
+  pinMode(irqPin, INPUT);
+  attachInterrupt(digitalPinToInterrupt(irqPin), onIrq, FALLING);
+  Serial.printf("Touch task: %s on GPIO %d, %d ms sampling while touched\n",
+                TOUCH_USE_IRQ ? "interrupt" : "polling", irqPin, TOUCH_ACTIVE_MS);
+  return true;
+}
+
+void TouchInput::requestReinit() {
+  reinitRequested.store(true);
+  if (task != nullptr) xTaskNotifyGive(task);
+}
+
+void TouchInput::wake(uint32_t edgeMicros) {
+  irqMicros = edgeMicros;
+  irqSeen = true;
+  if (task != nullptr) xTaskNotifyGive(task);
+}
+
+// ===== INTERRUPT =====
+void IRAM_ATTR TouchInput::onIrq() {
+  TouchInput *t = instance;
+  t->irqMicros = micros();
+  t->irqSeen = true;
+#if TOUCH_USE_IRQ
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(t->task, &woken);
+  portYIELD_FROM_ISR(woken);
+#endif
+}
+
+// ===== TOUCH TASK =====
+void TouchInput::touchTask(void *arg) {
+  ((TouchInput *)arg)->taskLoop();
+}
+
+void TouchInput::taskLoop() {
+  for (;;) {
+    TickType_t wait = down || lineHeld ? pdMS_TO_TICKS(TOUCH_ACTIVE_MS)
+                           : TOUCH_USE_IRQ ? portMAX_DELAY : pdMS_TO_TICKS(TOUCH_IDLE_POLL_MS);
+    if (ulTaskNotifyTake(pdTRUE, wait) > 0) statWakes++;
+
+    if (reinitRequested.exchange(false) && reinitFn != nullptr) reinitFn();
+    sample();
+
+#if TOUCH_USE_IRQ
+    // Our own bus traffic can toggle a held line; drop those edges. A line
+    // still low without a touch is checked again after TOUCH_ACTIVE_MS:
+    // notifying ourselves would spin this task above loop() for as long as
+    // the light contact lasts
+    lineHeld = false;
+    if (!down && irqHeld) {
+      ulTaskNotifyTake(pdTRUE, 0);
+      lineHeld = digitalRead(irqPin) == LOW;
+    }
+#endif
+  }
+}
+
+void TouchInput::sample() {
+  int x, y;
+  statReads++;
+  bool touched = readFn(x, y);
+  uint32_t now = micros();
+
+  if (touched) {
+    if (!down) {
+      down = true;
+      // Date the tap from the interrupt edge when there was one
+      uint32_t edge = irqSeen ? irqMicros : now;
+      latencyTrace.begin(TRACE_TOUCH_IRQ, edge);
+      latencyTrace.markAt(TRACE_TOUCH_READ, now);
+      push(TOUCH_DOWN, x, y, edge);
+      irqSeen = false;
+    } else if (x != lastX || y != lastY) {
+      push(TOUCH_MOVE, x, y, now);
+    }
+    lastX = x;
+    lastY = y;
+  } else if (down) {
+    down = false;
+    push(TOUCH_UP, lastX, lastY, now);
+  } else if (irqHeld) {
+    irqSeen = false;  // Edge from our own read, not a finger
+  }
+}
+
+void TouchInput::push(uint8_t type, int x, int y, uint32_t t) {
+  TouchEvent ev = {type, (int16_t)x, (int16_t)y, t};
+  if (!events.push(ev)) {
+    statDrops++;
+    return;
+  }
+  statEvents[type]++;
+}
+
+// ===== STATISTICS =====
+void TouchInput::recordLatency(uint32_t us) {
+  statLatencyCount++;
+  statLatencySum += us;
+  if (us > statLatencyMax) statLatencyMax = us;
+}
+
+void TouchInput::printStats() {
+  uint32_t ms = millis() - statWindowStart;
+  if (ms == 0) ms = 1;
+  Serial.printf("Touch (%s): %u reads in %u ms (%u.%u/s), %u wakes\n",
+                TOUCH_USE_IRQ ? "interrupt" : "polling", statReads, ms,
+                statReads * 1000 / ms, statReads * 10000 / ms % 10, statWakes);
+  Serial.printf("  Events: %u down, %u move, %u up, %u dropped\n",
+                statEvents[TOUCH_DOWN], statEvents[TOUCH_MOVE], statEvents[TOUCH_UP], statDrops);
+  if (statLatencyCount > 0) {
+    Serial.printf("  Tap to playSound(): avg %u us, max %u us over %u taps\n",
+                  statLatencySum / statLatencyCount, statLatencyMax, statLatencyCount);
+  } else {
+    Serial.println("  Tap to playSound(): no taps yet");
+  }
+
+  statReads = statWakes = statDrops = 0;
+  statEvents[0] = statEvents[1] = statEvents[2] = 0;
+  statLatencyCount = statLatencySum = statLatencyMax = 0;
+  statWindowStart = millis();
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "SpscRing.h"
+
+// ===== INTERRUPT-DRIVEN TOUCH INPUT =====
+// A touch task sleeps until the controller's interrupt line fires, reads the
+// controller, and queues timestamped down/move/up events for loop(). While
+// a finger is down it samples every TOUCH_ACTIVE_MS to report moves and the
+// lift; with no finger there is no bus traffic at all. A held line with no
+// touch reported (a press too light for the controller's pressure
+// threshold) is also sampled every TOUCH_ACTIVE_MS until it rises or turns
+// into a touch.
+//
+// The board-specific read and re-init functions are passed in and only ever
+// run in the touch task, so nothing else may use the touch bus afterwards.
+// With TOUCH_USE_IRQ 0 the task instead polls every TOUCH_IDLE_POLL_MS, as
+// the firmware used to; the interrupt still timestamps touches, so tap
+// latency can be compared between the two modes.
+
+#ifndef TOUCH_USE_IRQ
+#define TOUCH_USE_IRQ 1
+#endif
+#ifndef TOUCH_ACTIVE_MS
+#define TOUCH_ACTIVE_MS 10          // Sampling interval while a finger is down
+#endif
+#define TOUCH_IDLE_POLL_MS  50      // Polling interval without the interrupt
+#define TOUCH_QUEUE         16
+#define TOUCH_TASK_CORE     1       // With loop(), away from the audio tasks
+#define TOUCH_TASK_PRIORITY 2       // Above loop() (1)
+#define TOUCH_TASK_STACK    3072
+
+enum TouchEventType : uint8_t {
+  TOUCH_DOWN = 0,
+  TOUCH_MOVE,
+  TOUCH_UP,
+};
+
+struct TouchEvent {
+  uint8_t type;
+  int16_t x, y;
+  uint32_t micros;                  // Interrupt edge for TOUCH_DOWN, else read time
+};
+
+class TouchInput {
+  public:
+    typedef bool (*ReadFn)(int &x, int &y);
+    typedef void (*ReinitFn)();
+
+    TouchInput();
+
+    // irqHeld: the line stays low while touched (XPT2046 PENIRQ) rather
+    // than pulsing (CST816S INT)
+    bool begin(ReadFn read, ReinitFn reinit, int irqPin, bool irqHeld);
+
+    // Consumer side (loop())
+    bool poll(TouchEvent &ev) { return events.pop(ev); }
+
+    // Run the re-init function in the touch task before the next read
+    void requestReinit();
+
+    // The touch line woke the board from light sleep at `edgeMicros`; the
+    // edge fell while the interrupt was off, so date the touch from it and
+    // read the controller now
+    void wake(uint32_t edgeMicros);
+
+    // Tap (touch-down edge) to playSound() latency, recorded by the caller
+    void recordLatency(uint32_t us);
+
+    // Reads, wakes, events and tap latency since the last call
+    void printStats();
+
+  private:
+    static void IRAM_ATTR onIrq();
+    static void touchTask(void *arg);
+    void taskLoop();
+    void sample();
+    void push(uint8_t type, int x, int y, uint32_t t);
+
+    static TouchInput *instance;
+
+    ReadFn readFn;
+    ReinitFn reinitFn;
+    int irqPin;
+    bool irqHeld;
+    TaskHandle_t task;
+    SpscRing<TouchEvent, TOUCH_QUEUE> events;
+    std::atomic<bool> reinitRequested;
+
+    volatile uint32_t irqMicros;    // Time of the last falling edge
+    volatile bool irqSeen;          // Edge since the last touch-down
+    bool down;
+    bool lineHeld;                  // Held line low, but no touch read yet
+    int16_t lastX, lastY;
+
+    // Statistics
+    volatile uint32_t statReads;
+    volatile uint32_t statWakes;
+    volatile uint32_t statEvents[3];
+    volatile uint32_t statDrops;
+    uint32_t statLatencyCount;
+    uint32_t statLatencySum;
+    uint32_t statLatencyMax;
+    uint32_t statWindowStart;
+};
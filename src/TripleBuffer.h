@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// ===== TRIPLE BUFFER =====
+// Latest-value snapshot between exactly one writer and one reader, which
+// may run on different cores. Of three slots the writer owns one (back),
+// the reader owns one (front) and the third is the hand-over slot; each
+// side swaps its slot with the hand-over slot in a single atomic exchange,
+// so neither ever waits for or retries against the other (wait-free), and
+// a reader never sees a slot the writer is filling. Snapshots the reader
+// does not pick up in time are overwritten: only the newest one counts.
+
+template <typename T>
+class TripleBuffer {
+  public:
+    TripleBuffer() : backIndex(0), middle(1), frontIndex(2) {
+      slots[0] = slots[1] = slots[2] = T();
+    }
+
+    // Writer side: fill back(), then publish() it
+    T &back() { return slots[backIndex]; }
+    void publish() {
+      backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Reader side: take the newest published snapshot into front(), if
+    // there is one; false if front() is still the newest
+    bool update() {
+      if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) return false;
+      frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+      return true;
+    }
+    const T &front() const { return slots[frontIndex]; }
+
+  private:
+    static const uint32_t INDEX = 3;
+    static const uint32_t FRESH = 4;  // Hand-over slot holds an unread snapshot
+
+    T slots[3];
+    uint32_t backIndex;               // Writer's only
+    std::atomic<uint32_t> middle;     // Hand-over slot index | FRESH
+    uint32_t frontIndex;              // Reader's only
+};
@@ -0,0 +1,730 @@
+#include "UiRenderer.h"
+#include "EventLog.h"
+
+UiRenderer::UiRenderer() {
+  tft = nullptr;
+  sprite = nullptr;
+  dmaBuf[0] = dmaBuf[1] = nullptr;
+  dma = false;
+  screenW = screenH = 0;
+  background = 0;
+  memset(widgets, 0, sizeof(widgets));
+  dirtyCount = 0;
+  active = {0, 0, 0, 0};
+  activeY = 0;
+  pending = inFlight = false;
+  nextBuf = 0;
+  inFrame = false;
+  frameStart = 0;
+  memset(&frame, 0, sizeof(frame));
+  memset(&last, 0, sizeof(last));
+  frameLog = false;
+  statFrames = statBytes = statCpu = statCpuMax = 0;
+  scrollView = false;
+  view = {0, 0, 0, 0};
+  rowH = rowPitch = rowBytes = 0;
+  rowSource = nullptr;
+  scrollY = shownScrollY = 0;
+  scrollMoved = 0;
+  memset(rows, 0, sizeof(rows));
+  rowBits = nullptr;
+  rowBitsSize = 0;
+  rowStamp = 0;
+  shown = nullptr;
+  shownSize = 0;
+  statScrollFrames = statScrollPixels = statScrollBytes = 0;
+  statScrollIntervals = statScrollMicros = 0;
+  statRowRenders = statRowHits = 0;
+  lastScrollFrame = 0;
+}
+
+bool UiRenderer::begin(TFT_eSPI *display, uint16_t bg) {
+  tft = display;
+  background = bg;
+  screenW = tft->width();
+  screenH = tft->height();
+
+  size_t bytes = (size_t)screenW * UI_STRIP_LINES * sizeof(uint16_t);
+  sprite = new TFT_eSprite(tft);
+  sprite->setColorDepth(16);
+  dmaBuf[0] = (uint16_t *)heap_caps_malloc(bytes, MALLOC_CAP_DMA);
+  dmaBuf[1] = (uint16_t *)heap_caps_malloc(bytes, MALLOC_CAP_DMA);
+  if (sprite->createSprite(screenW, UI_STRIP_LINES) == nullptr ||
+      dmaBuf[0] == nullptr || dmaBuf[1] == nullptr) {
+    Serial.println("ERROR: UI strip buffer allocation failed, drawing directly");
+    sprite->deleteSprite();
+    delete sprite;
+    sprite = nullptr;
+    heap_caps_free(dmaBuf[0]);
+    heap_caps_free(dmaBuf[1]);
+    dmaBuf[0] = dmaBuf[1] = nullptr;
+  } else {
+    dma = tft->initDMA();
+  }
+
+  Serial.printf("UI renderer: %dx%d strips, %s\n", screenW, UI_STRIP_LINES,
+                sprite == nullptr ? "direct drawing" : dma ? "DMA" : "blocking pushes");
+  invalidateAll();
+  return sprite != nullptr;
+}
+
+// ===== WIDGET STATE =====
+void UiRenderer::update(int id, const UiWidget &next) {
+  if (id < 0 || id >= UI_MAX_WIDGETS) return;
+  UiWidget &cur = widgets[id];
+  if (memcmp(&cur, &next, sizeof(UiWidget)) == 0) return;  // No visible change
+
+  // A bar that only moved: the span between the old and new fill ends, and
+  // the old and new marker columns
+  if (cur.kind == UI_BAR && next.kind == UI_BAR && cur.x == next.x && cur.y == next.y &&
+      cur.w == next.w && cur.h == next.h && cur.bg == next.bg && cur.fg == next.fg) {
+    if (cur.fill != next.fill) {
+      int16_t x0 = min(cur.fill, next.fill);
+      addDirty({(int16_t)(cur.x + x0), cur.y, (int16_t)(abs(cur.fill - next.fill)), cur.h});
+    }
+    if (cur.mark != next.mark) {
+      if (cur.mark >= 0) addDirty({(int16_t)(cur.x + cur.mark), cur.y, 1, cur.h});
+      if (next.mark >= 0) addDirty({(int16_t)(next.x + next.mark), next.y, 1, next.h});
+    }
+    cur = next;
+    return;
+  }
+
+  if (cur.kind != UI_HIDDEN) addDirty({cur.x, cur.y, cur.w, cur.h});
+  if (next.kind != UI_HIDDEN) addDirty({next.x, next.y, next.w, next.h});
+  cur = next;
+}
+
+void UiRenderer::setButton(int id, int x, int y, int w, int h, const char *label,
+                           uint16_t bg, uint16_t fg) {
+  UiWidget next;
+  memset(&next, 0, sizeof(next));  // Padding too, so memcmp sees only real changes
+  next.kind = UI_BUTTON;
+  next.datum = MC_DATUM;
+  next.textSize = 2;
+  next.x = x;
+  next.y = y;
+  next.w = w;
+  next.h = h;
+  next.bg = bg;
+  next.fg = fg;
+  strncpy(next.label, label, UI_LABEL_LEN - 1);
+  update(id, next);
+}
+
+void UiRenderer::setText(int id, int x, int y, int w, int h, const char *text,
+                         uint16_t fg, uint8_t datum, uint8_t textSize) {
+  UiWidget next;
+  memset(&next, 0, sizeof(next));
+  next.kind = UI_TEXT;
+  next.datum = datum;
+  next.textSize = textSize;
+  next.x = x;
+  next.y = y;
+  next.w = w;
+  next.h = h;
+  next.fg = fg;
+  strncpy(next.label, text, UI_LABEL_LEN - 1);
+  update(id, next);
+}
+
+void UiRenderer::setKeys(int id, int x, int y, int w, int h, const char *keys,
+                         uint16_t bg, uint16_t fg, uint8_t textSize) {
+  UiWidget next;
+  memset(&next, 0, sizeof(next));
+  next.kind = UI_KEYS;
+  next.datum = MC_DATUM;
+  next.textSize = textSize;
+  next.x = x;
+  next.y = y;
+  next.w = w;
+  next.h = h;
+  next.bg = bg;
+  next.fg = fg;
+  strncpy(next.label, keys, UI_LABEL_LEN - 1);
+  update(id, next);
+}
+
+void UiRenderer::setWaveButton(int id, int x, int y, int w, int h, const char *label,
+                               const uint8_t *wave, const char *detail, uint16_t bg,
+                               uint16_t fg) {
+  UiWidget next;
+  memset(&next, 0, sizeof(next));
+  next.kind = UI_WAVE_BUTTON;
+  next.datum = ML_DATUM;
+  next.textSize = 2;
+  next.x = x;
+  next.y = y;
+  next.w = w;
+  next.h = h;
+  next.bg = bg;
+  next.fg = fg;
+  strncpy(next.label, label, UI_LABEL_LEN - 1);
+  strncpy(next.detail, detail, UI_DETAIL_LEN - 1);
+  memcpy(next.wave, wave, UI_WAVE_COLUMNS);
+  update(id, next);
+}
+
+void UiRenderer::setBar(int id, int x, int y, int w, int h, int fill, int mark, uint16_t bg,
+                        uint16_t fg) {
+  UiWidget next;
+  memset(&next, 0, sizeof(next));
+  next.kind = UI_BAR;
+  next.x = x;
+  next.y = y;
+  next.w = w;
+  next.h = h;
+  next.bg = bg;
+  next.fg = fg;
+  next.fill = constrain(fill, 0, w);
+  next.mark = mark < w ? mark : w - 1;
+  update(id, next);
+}
+
+void UiRenderer::hide(int id) {
+  UiWidget next;
+  memset(&next, 0, sizeof(next));
+  update(id, next);
+}
+
+char UiRenderer::keyAt(int id, int x, int y) const {
+  if (id < 0 || id >= UI_MAX_WIDGETS) return '\0';
+  const UiWidget &wd = widgets[id];
+  int n = strlen(wd.label);
+  if (wd.kind != UI_KEYS || n == 0 || x < wd.x || x >= wd.x + wd.w ||
+      y < wd.y || y >= wd.y + wd.h) {
+    return '\0';
+  }
+  return wd.label[(x - wd.x) * n / wd.w];
+}
+
+int UiRenderer::widgetAt(int x, int y) const {
+  for (int i = UI_MAX_WIDGETS - 1; i >= 0; i--) {
+    const UiWidget &wd = widgets[i];
+    if (wd.kind != UI_HIDDEN && x >= wd.x && x < wd.x + wd.w && y >= wd.y && y < wd.y + wd.h) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Something may have drawn on the panel: the view's lines go out in full
+void UiRenderer::invalidate(int x, int y, int w, int h) {
+  forgetShown();
+  addDirty({(int16_t)x, (int16_t)y, (int16_t)w, (int16_t)h});
+}
+
+void UiRenderer::invalidateAll() {
+  dirtyCount = 0;
+  forgetShown();
+  addDirty({0, 0, screenW, screenH});
+}
+
+// ===== SCROLL VIEW =====
+static inline uint16_t panelOrder(uint16_t c) { return (uint16_t)((c >> 8) | (c << 8)); }
+
+bool UiRenderer::beginScrollView(int x, int y, int w, int h, int rh, int pitch, int pos,
+                                 UiRowSource source) {
+  if (sprite == nullptr || w > screenW || rh <= 0 || pitch < rh) return false;
+  int bytes = (w + 3) / 4;
+  size_t need = (size_t)UI_ROW_CACHE * bytes * rh;
+  if (need > rowBitsSize) {
+    free(rowBits);
+    rowBits = (uint8_t *)malloc(need);
+    rowBitsSize = rowBits != nullptr ? need : 0;
+    if (rowBits == nullptr) {
+      LOG_WARN("UI: no RAM for the row cache");
+      return false;
+    }
+  }
+  if (h > shownSize) {
+    free(shown);
+    shown = (UiShownLine *)malloc(h * sizeof(UiShownLine));
+    shownSize = shown != nullptr ? h : 0;
+    if (shown == nullptr) {
+      LOG_WARN("UI: no RAM for the row cache");
+      return false;
+    }
+  }
+  view = {(int16_t)x, (int16_t)y, (int16_t)w, (int16_t)h};
+  rowH = rh;
+  rowPitch = pitch;
+  rowBytes = bytes;
+  rowSource = source;
+  scrollY = shownScrollY = pos;
+  scrollView = true;
+  invalidateRows();
+  return true;
+}
+
+void UiRenderer::endScrollView() {
+  if (!scrollView) return;
+  scrollView = false;
+  addDirty(view);
+}
+
+void UiRenderer::setScrollPos(int pos) {
+  if (pos == scrollY) return;
+  scrollY = pos;
+  scrollMoved = micros();
+  if (scrollView) addDirty(view);
+}
+
+void UiRenderer::invalidateRows() {
+  for (int i = 0; i < UI_ROW_CACHE; i++) rows[i].row = -1;
+  forgetShown();
+  if (scrollView) addDirty(view);
+}
+
+void UiRenderer::forgetShown() {
+  for (int i = 0; i < shownSize; i++) shown[i].row = UI_SHOWN_UNKNOWN;
+}
+
+// Cached bitmap of a row without drawing it, or nullptr
+UiRowBitmap *UiRenderer::cachedRow(int row) {
+  for (int i = 0; i < UI_ROW_CACHE; i++) {
+    if (rows[i].row == row) return &rows[i];
+  }
+  return nullptr;
+}
+
+// Cached bitmap of a row, drawing it on a miss over the least recently
+// used one
+UiRowBitmap *UiRenderer::rowBitmap(int row) {
+  UiRowBitmap *victim = &rows[0];
+  for (int i = 0; i < UI_ROW_CACHE; i++) {
+    if (rows[i].row == row) {
+      rows[i].used = ++rowStamp;
+      statRowHits++;
+      return &rows[i];
+    }
+    if (rows[i].row < 0 || (victim->row >= 0 && rows[i].used < victim->used)) victim = &rows[i];
+  }
+  renderRow(*victim, row);
+  victim->used = ++rowStamp;
+  return victim;
+}
+
+// Draw the row's button into the strip sprite a band at a time and keep
+// it as 2-bit palette indices. Called before a strip is composed, while
+// the sprite is free.
+void UiRenderer::renderRow(UiRowBitmap &rb, int row) {
+  statRowRenders++;
+  rb.row = row;
+  // Lines showing an earlier drawing of it are compared against nothing
+  for (int i = 0; i < shownSize; i++) {
+    if (shown[i].row == row) shown[i].row = UI_SHOWN_UNKNOWN;
+  }
+  UiWidget wd;
+  memset(&wd, 0, sizeof(wd));
+  rb.blank = row < 0 || !rowSource(row, wd);
+  if (rb.blank) return;
+
+  if (wd.kind != UI_WAVE_BUTTON) wd.kind = UI_BUTTON;
+  wd.datum = wd.kind == UI_WAVE_BUTTON ? ML_DATUM : MC_DATUM;
+  wd.textSize = 2;
+  wd.x = wd.y = 0;
+  wd.w = view.w;
+  wd.h = rowH;
+  rb.palette[0] = panelOrder(background);
+  rb.palette[1] = panelOrder(wd.bg);
+  rb.palette[2] = panelOrder(wd.fg);
+  rb.palette[3] = panelOrder(TFT_WHITE);
+
+  uint8_t *bits = rowBits + (size_t)(&rb - rows) * rowBytes * rowH;
+  memset(bits, 0, (size_t)rowBytes * rowH);
+  const uint16_t *px = (const uint16_t *)sprite->getPointer();
+  for (int band = 0; band < rowH; band += UI_STRIP_LINES) {
+    int lines = min(UI_STRIP_LINES, rowH - band);
+    sprite->setViewport(0, 0, view.w, lines, false);
+    sprite->fillRect(0, 0, view.w, lines, background);
+    drawWidget(*sprite, wd, 0, band);
+    sprite->resetViewport();
+    for (int ly = 0; ly < lines; ly++) {
+      const uint16_t *src = px + ly * screenW;
+      uint8_t *dst = bits + (band + ly) * rowBytes;
+      for (int x = 0; x < view.w; x++) {
+        uint8_t k = 3;
+        while (k > 0 && src[x] != rb.palette[k]) k--;
+        dst[x >> 2] |= k << ((x & 3) * 2);
+      }
+    }
+  }
+}
+
+// Unpack the rows under the strip into the composed sprite lines. Returns
+// the part of the strip the panel does not already show: a view line that
+// showed another line of a still cached row counts only from its first to
+// its last differing column, one that showed the same line not at all.
+// Lines outside the view, or a strip reaching past its sides, count whole.
+UiRect UiRenderer::composeScrollView(const UiRect &strip) {
+  int x0 = max<int>(strip.x, view.x), x1 = min<int>(strip.x + strip.w, view.x + view.w);
+  int y0 = max<int>(strip.y, view.y), y1 = min<int>(strip.y + strip.h, view.y + view.h);
+  if (x0 >= x1 || y0 >= y1) return strip;
+  bool whole = x0 != strip.x || x1 != strip.x + strip.w;
+
+  // Changed span, starting with the strip lines outside the view
+  int cx0 = x1, cx1 = x0, cy0 = y1, cy1 = y0;
+  if (strip.y < y0 || strip.y + strip.h > y1) {
+    cx0 = x0;
+    cx1 = x1;
+    cy0 = strip.y < y0 ? strip.y : y1;
+    cy1 = strip.y + strip.h > y1 ? strip.y + strip.h : y0;
+  }
+
+  uint16_t *px = (uint16_t *)sprite->getPointer();
+  uint16_t bg = panelOrder(background);
+  UiRowBitmap *rb = nullptr;
+  int b0 = (x0 - view.x) >> 2, b1 = (x1 - 1 - view.x) >> 2;
+  for (int y = y0; y < y1; y++) {
+    uint16_t *dst = px + (y - strip.y) * screenW;
+    int listY = scrollY + (y - view.y);
+    int row = listY >= 0 ? listY / rowPitch : -1;
+    int ly = listY - row * rowPitch;
+    if (row >= 0 && (rb == nullptr || rb->row != row)) rb = rowBitmap(row);
+    bool blank = row < 0 || ly >= rowH || rb->blank;
+    UiShownLine now = {(int16_t)(blank ? UI_SHOWN_BLANK : row), (int16_t)(blank ? 0 : ly)};
+    UiShownLine was = shown[y - view.y];
+    shown[y - view.y] = now;
+
+    const uint8_t *src = nullptr;
+    if (blank) {
+      for (int x = x0; x < x1; x++) dst[x] = bg;
+    } else {
+      src = rowBits + (size_t)(rb - rows) * rowBytes * rowH + ly * rowBytes;
+      for (int x = x0; x < x1; x++) {
+        int c = x - view.x;
+        dst[x] = rb->palette[(src[c >> 2] >> ((c & 3) * 2)) & 3];
+      }
+    }
+
+    // Columns that differ from what the panel shows on this line
+    int d0 = x0, d1 = x1;
+    if (!whole && was.row == now.row && was.line == now.line) {
+      d0 = d1;
+    } else if (!whole && src != nullptr && was.row >= 0) {
+      const UiRowBitmap *old = cachedRow(was.row);
+      if (old != nullptr && memcmp(old->palette, rb->palette, sizeof(rb->palette)) == 0) {
+        const uint8_t *prev = rowBits + (size_t)(old - rows) * rowBytes * rowH + was.line * rowBytes;
+        int f = b0, l = b1;
+        while (f <= b1 && src[f] == prev[f]) f++;
+        while (l >= f && src[l] == prev[l]) l--;
+        d0 = max(x0, view.x + f * 4);
+        d1 = f > l ? d0 : min(x1, view.x + l * 4 + 4);
+      }
+    }
+    if (d0 < d1) {
+      cx0 = min(cx0, d0);
+      cx1 = max(cx1, d1);
+      cy0 = min(cy0, y);
+      cy1 = max(cy1, y + 1);
+    }
+  }
+  if (cx0 >= cx1 || cy0 >= cy1) return {strip.x, strip.y, 0, 0};
+  return {(int16_t)cx0, (int16_t)cy0, (int16_t)(cx1 - cx0), (int16_t)(cy1 - cy0)};
+}
+
+// ===== DIRTY RECTANGLES =====
+static bool touches(const UiRect &a, const UiRect &b) {
+  return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+static UiRect unite(const UiRect &a, const UiRect &b) {
+  int16_t x0 = min(a.x, b.x), y0 = min(a.y, b.y);
+  int16_t x1 = max(a.x + a.w, b.x + b.w), y1 = max(a.y + a.h, b.y + b.h);
+  return {x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+}
+
+void UiRenderer::addDirty(UiRect r) {
+  // Clip to the screen
+  if (r.x < 0) { r.w += r.x; r.x = 0; }
+  if (r.y < 0) { r.h += r.y; r.y = 0; }
+  if (r.x + r.w > screenW) r.w = screenW - r.x;
+  if (r.y + r.h > screenH) r.h = screenH - r.y;
+  if (r.w <= 0 || r.h <= 0) return;
+
+  if (!inFrame) {
+    inFrame = true;
+    frameStart = micros();
+    memset(&frame, 0, sizeof(frame));
+  }
+
+  // Absorb every waiting rectangle this one overlaps or borders, so
+  // neighbouring changes go out as one strip run
+  for (int i = 0; i < dirtyCount; ) {
+    if (touches(r, dirty[i])) {
+      r = unite(r, dirty[i]);
+      dirty[i] = dirty[--dirtyCount];
+      i = 0;
+    } else {
+      i++;
+    }
+  }
+  if (dirtyCount == UI_MAX_DIRTY) {
+    dirty[dirtyCount - 1] = unite(dirty[dirtyCount - 1], r);
+    return;
+  }
+  dirty[dirtyCount++] = r;
+}
+
+// Next strip of the rectangle being painted, starting the next waiting
+// rectangle when it is done
+bool UiRenderer::nextStrip(UiRect &strip) {
+  if (active.h == 0) {
+    if (dirtyCount == 0) return false;
+    active = dirty[0];
+    dirty[0] = dirty[--dirtyCount];
+    activeY = active.y;
+    frame.rects++;
+  }
+
+  int16_t bottom = active.y + active.h;
+  strip = {active.x, activeY, active.w, (int16_t)min(UI_STRIP_LINES, bottom - activeY)};
+  activeY += strip.h;
+  if (activeY >= bottom) active.h = 0;
+  return true;
+}
+
+// ===== COMPOSITION =====
+void UiRenderer::drawWidget(TFT_eSPI &g, const UiWidget &wd, int ox, int oy) {
+  int x = wd.x - ox;
+  int y = wd.y - oy;
+  if (wd.kind == UI_KEYS) {
+    // Key i spans [i * w / n, (i + 1) * w / n), as keyAt() hit-tests it
+    int n = strlen(wd.label);
+    char key[2] = {0, 0};
+    g.setTextColor(wd.fg);
+    g.setTextDatum(MC_DATUM);
+    g.setTextSize(wd.textSize);
+    for (int i = 0; i < n; i++) {
+      int kx = x + i * wd.w / n;
+      int kw = x + (i + 1) * wd.w / n - kx;
+      g.fillRoundRect(kx + 1, y, kw - 2, wd.h, 3, wd.bg);
+      key[0] = wd.label[i];
+      g.drawString(key, kx + kw / 2, y + wd.h / 2);
+    }
+    return;
+  }
+  if (wd.kind == UI_BAR) {
+    if (wd.fill > 0) g.fillRect(x, y, wd.fill, wd.h, wd.fg);
+    if (wd.fill < wd.w) g.fillRect(x + wd.fill, y, wd.w - wd.fill, wd.h, wd.bg);
+    if (wd.mark >= 0) g.drawFastVLine(x + wd.mark, y, wd.h, TFT_WHITE);
+    return;
+  }
+  if (wd.kind == UI_BUTTON || wd.kind == UI_WAVE_BUTTON) {
+    g.fillRoundRect(x, y, wd.w, wd.h, 6, wd.bg);
+    g.drawRoundRect(x, y, wd.w, wd.h, 6, TFT_WHITE);
+  }
+  g.setTextColor(wd.fg);
+  g.setTextDatum(wd.datum);
+  g.setTextSize(wd.textSize);
+  if (wd.datum == MC_DATUM) {
+    g.drawString(wd.label, x + wd.w / 2, y + wd.h / 2);
+  } else if (wd.datum == ML_DATUM) {
+    g.drawString(wd.label, x + UI_WAVE_PAD, y + wd.h / 2);
+  } else {
+    g.drawString(wd.label, x, y);
+  }
+  if (wd.kind == UI_WAVE_BUTTON) drawWave(g, wd, x, y);
+}
+
+// Thumbnail at the right end of a UI_WAVE_BUTTON, drawn from its level
+// table only: per column a line for the peak and one beside it for the
+// RMS, mirrored about the centre line, then the detail text. Its box is
+// cleared first, so a long label is cut off rather than drawn through.
+// 2 lines per column and one short string, whatever the sound's length.
+void UiRenderer::drawWave(TFT_eSPI &g, const UiWidget &wd, int x, int y) {
+  int waveW = UI_WAVE_COLUMNS * 2;
+  int bx = x + wd.w - UI_WAVE_PAD - waveW;
+  int waveH = wd.h - 2 * UI_WAVE_PAD - 10;      // Detail line and a gap below
+  int half = (waveH - 1) / 2;
+  int cy = y + UI_WAVE_PAD + half;
+  g.fillRect(bx - UI_WAVE_PAD, y + 2, waveW + UI_WAVE_PAD, wd.h - 4, wd.bg);
+  for (int c = 0; c < UI_WAVE_COLUMNS; c++) {
+    int peak = (wd.wave[c] >> 4) * half / 15;
+    int rms = (wd.wave[c] & 15) * half / 15;
+    int cx = bx + c * 2;
+    if (wd.wave[c] >> 4) g.drawFastVLine(cx, cy - peak, 2 * peak + 1, wd.fg);
+    if (wd.wave[c] & 15) g.drawFastVLine(cx + 1, cy - rms, 2 * rms + 1, wd.fg);
+  }
+  g.setTextDatum(BR_DATUM);
+  g.setTextSize(1);
+  g.drawString(wd.detail, bx + waveW, y + wd.h - UI_WAVE_PAD);
+}
+
+// Paint one strip (screen coordinates) into g, whose line 0 is screen line oy
+void UiRenderer::paint(TFT_eSPI &g, const UiRect &strip, int oy) {
+  g.setViewport(strip.x, strip.y - oy, strip.w, strip.h, false);
+  g.fillRect(strip.x, strip.y - oy, strip.w, strip.h, background);
+  for (int i = 0; i < UI_MAX_WIDGETS; i++) {
+    const UiWidget &wd = widgets[i];
+    if (wd.kind == UI_HIDDEN) continue;
+    if (wd.x >= strip.x + strip.w || wd.x + wd.w <= strip.x ||
+        wd.y >= strip.y + strip.h || wd.y + wd.h <= strip.y) continue;
+    drawWidget(g, wd, 0, oy);
+  }
+  g.resetViewport();
+}
+
+// Compose the strip and pack the part the panel does not already show,
+// trimming strip to it; false if there is none
+bool UiRenderer::composeStrip(UiRect &strip, uint16_t *dst) {
+  if (scrollView) {
+    // Rows first exposed in this strip are drawn before the sprite is used
+    int y0 = max<int>(strip.y, view.y), y1 = min(strip.y + strip.h, view.y + view.h);
+    if (y0 < y1) {
+      int first = max(scrollY + (y0 - view.y), 0) / rowPitch;
+      int last = max(scrollY + (y1 - 1 - view.y), 0) / rowPitch;
+      for (int row = first; row <= last; row++) rowBitmap(row);
+    }
+  }
+  paint(*sprite, strip, strip.y);
+  UiRect push = scrollView ? composeScrollView(strip) : strip;
+  if (push.h == 0) return false;
+
+  // Pack those columns into one contiguous image for the DMA. The sprite
+  // already holds pixels in panel byte order.
+  const uint16_t *src = (const uint16_t *)sprite->getPointer() +
+                        (push.y - strip.y) * screenW + push.x;
+  for (int row = 0; row < push.h; row++) {
+    memcpy(dst + row * push.w, src + row * screenW, push.w * sizeof(uint16_t));
+  }
+  strip = push;
+  return true;
+}
+
+void UiRenderer::pushStrip() {
+  const UiRect &s = pendingStrip;
+  if (dma) {
+    tft->startWrite();  // Held until the transfer completes
+    tft->pushImageDMA(s.x, s.y, s.w, s.h, dmaBuf[nextBuf]);
+    inFlight = true;
+  } else {
+    tft->pushImage(s.x, s.y, s.w, s.h, dmaBuf[nextBuf]);
+  }
+  nextBuf ^= 1;
+  pending = false;
+  frame.bytes += (uint32_t)s.w * s.h * sizeof(uint16_t);
+  frame.strips++;
+}
+
+// ===== FRAME LOOP =====
+void UiRenderer::render() {
+  if (tft == nullptr) return;
+  uint32_t t0 = micros();
+  bool worked = false;
+
+  // Previous strip is out: release the bus for the SD card
+  if (inFlight && !tft->dmaBusy()) {
+    tft->endWrite();
+    inFlight = false;
+  }
+
+  // Compose the next strip into the buffer that is not on the wire
+  if (!pending) {
+    UiRect strip;
+    if (nextStrip(strip)) {
+      if (sprite == nullptr) {
+        paint(*tft, strip, 0);
+        frame.bytes += (uint32_t)strip.w * strip.h * sizeof(uint16_t);
+        frame.strips++;
+      } else if (composeStrip(strip, dmaBuf[nextBuf])) {
+        pendingStrip = strip;
+        pending = true;
+      }
+      worked = true;
+    }
+  }
+  if (pending && !inFlight) {
+    pushStrip();
+    worked = true;
+  }
+
+  if (inFrame) {
+    if (worked) frame.renderMicros += micros() - t0;
+    if (idle()) endFrame();
+  }
+}
+
+void UiRenderer::flush() {
+  while (!idle()) render();
+}
+
+void UiRenderer::endFrame() {
+  inFrame = false;
+  frame.screenMicros = micros() - frameStart;
+  last = frame;
+
+  // A frame that moved the scroll view: its rate and bus cost per pixel
+  if (scrollY != shownScrollY) {
+    uint32_t now = micros();
+    if (statScrollFrames > 0 && now - lastScrollFrame < 100000) {
+      statScrollIntervals++;
+      statScrollMicros += now - lastScrollFrame;
+    }
+    lastScrollFrame = now;
+    statScrollFrames++;
+    statScrollPixels += abs(scrollY - shownScrollY);
+    statScrollBytes += frame.bytes;
+    shownScrollY = scrollY;
+  }
+
+  statFrames++;
+  statBytes += frame.bytes;
+  statCpu += frame.renderMicros;
+  if (frame.renderMicros > statCpuMax) statCpuMax = frame.renderMicros;
+
+  if (frameLog) {
+    LOG_INFO("UI frame: %u rects, %u strips, %u bytes, render %u us, on screen in %u us",
+             frame.rects, frame.strips, frame.bytes, frame.renderMicros, frame.screenMicros);
+  }
+}
+
+// ===== STATISTICS =====
+void UiRenderer::printStats() {
+  Serial.printf("UI: %u frames, %u KB pushed (%s, %dx%d strips)\n",
+                statFrames, statBytes / 1024,
+                sprite == nullptr ? "direct drawing" : dma ? "DMA" : "blocking pushes",
+                screenW, UI_STRIP_LINES);
+  Serial.printf("  Render time per frame avg %u us (max %u), avg %u bytes\n",
+                statFrames ? statCpu / statFrames : 0, statCpuMax,
+                statFrames ? statBytes / statFrames : 0);
+  if (statScrollFrames > 0) {
+    Serial.printf("  Scrolling: %u frames, %.1f fps, %u pixels, %u bytes per scrolled pixel\n",
+                  statScrollFrames,
+                  statScrollMicros ? statScrollIntervals * 1e6f / statScrollMicros : 0.0f,
+                  statScrollPixels, statScrollPixels ? statScrollBytes / statScrollPixels : 0);
+    Serial.printf("  Row cache: %u rows drawn, %u hits (%u bytes)\n", statRowRenders,
+                  statRowHits, (unsigned)rowBitsSize);
+  }
+  statFrames = statBytes = statCpu = statCpuMax = 0;
+  statScrollFrames = statScrollPixels = statScrollBytes = 0;
+  statScrollIntervals = statScrollMicros = 0;
+  statRowRenders = statRowHits = 0;
+}
+
+// Redraw one widget straight to the panel, the way the UI used to, then the
+// same change through the renderer, and compare what the UI loop paid
+void UiRenderer::benchmark(int id) {
+  if (tft == nullptr || id < 0 || id >= UI_MAX_WIDGETS || widgets[id].kind == UI_HIDDEN) {
+    Serial.println("UI benchmark: widget not shown");
+    return;
+  }
+  flush();
+  const UiWidget &wd = widgets[id];
+
+  uint32_t t0 = micros();
+  drawWidget(*tft, wd, 0, 0);
+  uint32_t direct = micros() - t0;
+
+  bool log = frameLog;
+  frameLog = false;
+  invalidate(wd.x, wd.y, wd.w, wd.h);
+  flush();
+  frameLog = log;
+
+  Serial.printf("UI redraw of a %dx%d widget:\n", wd.w, wd.h);
+  Serial.printf("  Direct to the panel: %u us in the UI loop\n", direct);
+  Serial.printf("  Renderer: %u us in the UI loop, %u strips, %u bytes, on screen in %u us\n",
+                last.renderMicros, last.strips, last.bytes, last.screenMicros);
+}
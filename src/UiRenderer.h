@@ -0,0 +1,247 @@
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+// ===== RETAINED-MODE UI RENDERER =====
+// The UI is a small set of widgets (buttons, text boxes, key rows,
+// buttons with a waveform thumbnail and meter bars) whose state is kept here. Setting a widget only records the new state and, if anything
+// changed, marks its rectangle dirty; nothing touches the display. A bar
+// whose fill or marker moved marks only the pixels between the old and
+// new positions.
+//
+// render(), called every pass of loop(), repaints dirty rectangles one
+// UI_STRIP_LINES-high strip at a time: the strip is composed off-screen in
+// a TFT_eSprite (background, then every widget that overlaps it, back to
+// front), packed into a DMA buffer and pushed to the panel in the
+// background. Two DMA buffers let the next strip be composed while the
+// previous one is still on the wire, and a call never waits for the DMA, so
+// a repaint costs the UI loop only the compose time.
+//
+// The display shares its SPI peripheral with the SD card, which the audio
+// tasks read from the other core. The bus is held only while one strip is
+// being transferred, so card reads wait at most one strip.
+//
+// A scroll view shows a list of equal rows (buttons) at any pixel offset,
+// for drag and fling scrolling. Rows come from a callback the first time
+// they are exposed and are kept as 2-bit bitmaps (screen background, row
+// background, label, outline) in a small cache, so a scrolled frame only
+// unpacks cached rows into the strips; only newly exposed rows are drawn.
+// The panel's own vertical scrolling (ILI9341/ST7789 VSCRDEF/VSCRSADD)
+// is no help here: it shifts along the panel's long side, which is the
+// horizontal axis in this landscape UI. Instead each line of the view
+// remembers which line of which cached row the panel shows; a scrolled
+// strip is compared bitmap to bitmap against that and only its changed
+// lines and columns are pushed (none when the strip is unchanged). Lines
+// not known to be on the panel (after invalidate() or invalidateRows())
+// go out whole. A scrolled frame still changes most of the view, so the
+// caller also starts one at most every UI_SCROLL_FRAME_MS (scrollFrameDue()),
+// folding the moves in between into it: a drag or fling then holds the bus
+// for about half of each period and the SD card gets the rest. The scroll
+// statistics report the cost per scrolled pixel.
+
+#ifndef UI_MAX_WIDGETS
+#define UI_MAX_WIDGETS 20
+#endif
+#ifndef UI_STRIP_LINES
+#define UI_STRIP_LINES 16           // 10 KB per buffer at 320 pixels wide
+#endif
+#define UI_MAX_DIRTY   8
+#define UI_LABEL_LEN   32
+#define UI_DETAIL_LEN  8
+#define UI_WAVE_COLUMNS 32          // Thumbnail columns, 2 pixels wide each
+#define UI_WAVE_PAD    6            // Inset of the label and thumbnail in their button
+#ifndef UI_SCROLL_FRAME_MS
+#define UI_SCROLL_FRAME_MS 33       // Scroll frame period: ~30 fps
+#endif
+#ifndef UI_ROW_CACHE
+#define UI_ROW_CACHE   5            // Row bitmaps: a view's visible rows plus one
+#endif
+
+enum UiWidgetKind : uint8_t {
+  UI_HIDDEN = 0,
+  UI_BUTTON,                         // Rounded, outlined, centred size-2 label
+  UI_TEXT,                           // Transparent text anchored in its box
+  UI_KEYS,                           // Row of equal keys, one per label character
+  UI_WAVE_BUTTON,                    // Button, label on the left, thumbnail and detail on the right
+  UI_BAR,                            // Meter bar filled from the left, with an optional marker
+};
+
+struct UiWidget {
+  uint8_t kind;
+  uint8_t datum;                     // UI_TEXT: TL_DATUM or MC_DATUM
+  uint8_t textSize;
+  int16_t x, y, w, h;
+  uint16_t bg, fg;
+  char label[UI_LABEL_LEN];
+  char detail[UI_DETAIL_LEN];        // UI_WAVE_BUTTON: size-1 text under the thumbnail
+  uint8_t wave[UI_WAVE_COLUMNS];     // UI_WAVE_BUTTON: peak << 4 | RMS per column, 0..15
+  int16_t fill;                      // UI_BAR: filled pixels from the left
+  int16_t mark;                      // UI_BAR: marker column, -1 for none
+};
+
+struct UiRect {
+  int16_t x, y, w, h;
+};
+
+// Fills in label, bg and fg of list row `row` (and for a thumbnail, kind
+// UI_WAVE_BUTTON, wave and detail); false past the end
+typedef bool (*UiRowSource)(int row, UiWidget &button);
+
+struct UiRowBitmap {
+  int32_t row;                       // List row, -1 if free
+  uint32_t used;                     // LRU stamp
+  uint16_t palette[4];               // Panel byte order
+  bool blank;                        // Past the end of the list
+};
+
+// What one line of the scroll view shows on the panel
+struct UiShownLine {
+  int16_t row;                       // List row, UI_SHOWN_BLANK or UI_SHOWN_UNKNOWN
+  int16_t line;                      // Line within the row
+};
+#define UI_SHOWN_BLANK   -1          // Screen background
+#define UI_SHOWN_UNKNOWN -2          // Not known: push in full
+
+struct UiFrameStats {
+  uint32_t renderMicros;             // Spent in render(): what the UI loop paid
+  uint32_t screenMicros;             // First dirty mark to last strip on screen
+  uint32_t bytes;                    // Pixel data pushed to the panel
+  uint16_t strips;
+  uint16_t rects;
+};
+
+class UiRenderer {
+  public:
+    UiRenderer();
+
+    // Allocates the strip sprite and DMA buffers; without them every strip
+    // is pushed synchronously
+    bool begin(TFT_eSPI *display, uint16_t background);
+
+    // State updates: cheap, only mark dirty rectangles on change
+    void setButton(int id, int x, int y, int w, int h, const char *label,
+                   uint16_t bg, uint16_t fg);
+    void setText(int id, int x, int y, int w, int h, const char *text,
+                 uint16_t fg, uint8_t datum, uint8_t textSize);
+    // One widget for a whole keyboard row: a key per character of keys
+    void setKeys(int id, int x, int y, int w, int h, const char *keys,
+                 uint16_t bg, uint16_t fg, uint8_t textSize);
+    // A button with an amplitude thumbnail (UI_WAVE_COLUMNS levels) and a
+    // short detail line at its right end
+    void setWaveButton(int id, int x, int y, int w, int h, const char *label,
+                       const uint8_t *wave, const char *detail, uint16_t bg, uint16_t fg);
+    // A bar `fill` pixels full, in fg over bg, with a white marker at
+    // column mark (-1: none)
+    void setBar(int id, int x, int y, int w, int h, int fill, int mark, uint16_t bg,
+                uint16_t fg);
+    void hide(int id);
+    void invalidate(int x, int y, int w, int h);
+    void invalidateAll();
+
+    // Topmost visible widget at a screen point, or -1
+    int widgetAt(int x, int y) const;
+    // Character of the UI_KEYS key under a screen point, or '\0'
+    char keyAt(int id, int x, int y) const;
+
+    // Scroll view over the rectangle, rows rowH high every pitch pixels,
+    // starting pos list pixels down. Needs the strip sprite; the row cache
+    // is allocated on first use and kept. Widgets under the view are
+    // painted over while it is up.
+    bool beginScrollView(int x, int y, int w, int h, int rowH, int pitch, int pos,
+                         UiRowSource source);
+    void endScrollView();
+    bool scrollViewActive() const { return scrollView; }
+    // List pixels above the top of the view; repaints the view on change
+    void setScrollPos(int pos);
+    int scrollPos() const { return scrollY; }
+    // UI_SCROLL_FRAME_MS since the last position change
+    bool scrollFrameDue() const { return micros() - scrollMoved >= UI_SCROLL_FRAME_MS * 1000UL; }
+    // Row contents changed (e.g. a highlight): drop the cached bitmaps
+    void invalidateRows();
+
+    // Compose and/or push at most one strip; returns immediately if the DMA
+    // is still busy with the previous one
+    void render();
+    bool idle() const { return !pending && !inFlight && active.h == 0 && dirtyCount == 0; }
+    void flush();                    // Render until everything is on screen
+
+    // Per-frame log line (render time, bytes pushed), off by default
+    void setFrameLog(bool on) { frameLog = on; }
+    bool frameLogEnabled() const { return frameLog; }
+
+    // Frame and scroll statistics since the last call, then a direct-
+    // versus-renderer redraw of one widget
+    const UiFrameStats &lastFrame() const { return last; }
+    void printStats();
+    void benchmark(int id);
+
+  private:
+    static void drawWidget(TFT_eSPI &g, const UiWidget &wd, int ox, int oy);
+    static void drawWave(TFT_eSPI &g, const UiWidget &wd, int x, int y);
+    void paint(TFT_eSPI &g, const UiRect &strip, int oy);
+    void update(int id, const UiWidget &next);
+    void addDirty(UiRect r);
+    bool nextStrip(UiRect &strip);
+    bool composeStrip(UiRect &strip, uint16_t *dst);
+    void pushStrip();
+    void endFrame();
+    UiRowBitmap *rowBitmap(int row);
+    UiRowBitmap *cachedRow(int row);
+    void renderRow(UiRowBitmap &rb, int row);
+    UiRect composeScrollView(const UiRect &strip);
+    void forgetShown();
+
+    TFT_eSPI *tft;
+    TFT_eSprite *sprite;             // Full-width strip, composed off-screen
+    uint16_t *dmaBuf[2];             // Packed strips; one may be on the wire
+    bool dma;
+    int16_t screenW, screenH;
+    uint16_t background;
+
+    UiWidget widgets[UI_MAX_WIDGETS];
+    UiRect dirty[UI_MAX_DIRTY];      // Waiting, merged where they overlap
+    uint8_t dirtyCount;
+    UiRect active;                   // Rectangle being painted (h 0 if none)
+    int16_t activeY;                 // Next strip's top line in it
+
+    UiRect pendingStrip;             // Composed, waiting for the DMA
+    bool pending;
+    bool inFlight;
+    uint8_t nextBuf;
+
+    // Current frame: from the first dirty mark until it is all on screen
+    bool inFrame;
+    uint32_t frameStart;
+    UiFrameStats frame;
+    UiFrameStats last;
+    bool frameLog;
+
+    // Scroll view
+    bool scrollView;
+    UiRect view;
+    int16_t rowH, rowPitch, rowBytes;
+    UiRowSource rowSource;
+    int scrollY;
+    int shownScrollY;                // Position of the last finished frame
+    uint32_t scrollMoved;            // micros() of the last setScrollPos() change
+    UiRowBitmap rows[UI_ROW_CACHE];
+    uint8_t *rowBits;                // UI_ROW_CACHE bitmaps, rowBytes * rowH each
+    size_t rowBitsSize;
+    uint32_t rowStamp;
+    UiShownLine *shown;              // Per view line, what the panel shows
+    int16_t shownSize;
+
+    uint32_t statFrames;
+    uint32_t statBytes;
+    uint32_t statCpu;
+    uint32_t statCpuMax;
+    uint32_t statScrollFrames;
+    uint32_t statScrollPixels;
+    uint32_t statScrollBytes;
+    uint32_t statScrollIntervals;    // Back-to-back scroll frames, for the rate
+    uint32_t statScrollMicros;
+    uint32_t statRowRenders;
+    uint32_t statRowHits;
+    uint32_t lastScrollFrame;
+};
@@ -0,0 +1,286 @@
+#include "WavParser.h"
+#include "ImaAdpcm.h"
+
+// Tail of KSDATAFORMAT_SUBTYPE_* GUIDs; the first two bytes hold the format tag
+static const uint8_t SUBTYPE_GUID_TAIL[14] = {
+  0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+};
+
+static uint16_t readLE16(const uint8_t *p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t readLE32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Block layout and length of an IMA ADPCM file. The last block may be
+// short; the fact chunk, when present, gives the exact frame count.
+static bool checkAdpcm(AudioFileSource *src, WavInfo &info, uint32_t factFrames) {
+  uint32_t channelBytes = IMA_HEADER_BYTES * info.channels;
+  if (info.bitsPerSample != 4 || info.sampleRate == 0) return false;
+  if (info.blockAlign <= channelBytes || info.blockAlign % channelBytes != 0) return false;
+  uint16_t perBlock = imaBlockSamples(info.blockAlign, info.channels);
+  if (info.samplesPerBlock != 0 && info.samplesPerBlock != perBlock) return false;
+  info.samplesPerBlock = perBlock;
+
+  uint32_t rest = info.dataSize % info.blockAlign;
+  rest -= rest % channelBytes;
+  info.frameCount = info.dataSize / info.blockAlign * perBlock;
+  if (rest > channelBytes) info.frameCount += imaBlockSamples(rest, info.channels);
+  if (factFrames > 0 && factFrames < info.frameCount) info.frameCount = factFrames;
+
+  return src->seek(info.dataOffset, SEEK_SET);
+}
+
+bool parseWavHeader(AudioFileSource *src, WavInfo &info) {
+  uint8_t buf[40];
+  memset(&info, 0, sizeof(info));
+
+  if (!src->seek(0, SEEK_SET)) return false;
+  if (src->read(buf, 12) != 12) return false;
+  if (memcmp(buf, "RIFF", 4) != 0 || memcmp(buf + 8, "WAVE", 4) != 0) return false;
+
+  uint32_t pos = 12;
+  bool haveFmt = false;
+  uint32_t factFrames = 0;
+  uint32_t fileSize = src->getSize();
+
+  while (pos + 8 <= fileSize) {
+    if (src->read(buf, 8) != 8) return false;
+    uint32_t chunkSize = readLE32(buf + 4);
+    pos += 8;
+
+    if (memcmp(buf, "fmt ", 4) == 0) {
+      uint32_t len = chunkSize < sizeof(buf) ? chunkSize : sizeof(buf);
+      if (len < 16 || src->read(buf, len) != len) return false;
+      info.formatTag = readLE16(buf);
+      info.channels = readLE16(buf + 2);
+      info.sampleRate = readLE32(buf + 4);
+      info.blockAlign = readLE16(buf + 12);
+      info.bitsPerSample = readLE16(buf + 14);
+      if (info.formatTag == WAV_FORMAT_EXTENSIBLE) {
+        // cbSize(2) validBits(2) channelMask(4) subFormat GUID(16)
+        if (len < 40 || memcmp(buf + 26, SUBTYPE_GUID_TAIL, sizeof(SUBTYPE_GUID_TAIL)) != 0) {
+          return false;
+        }
+        info.formatTag = readLE16(buf + 24);
+      } else if (info.formatTag == WAV_FORMAT_IMA_ADPCM && len >= 20) {
+        info.samplesPerBlock = readLE16(buf + 18);  // After cbSize
+      }
+      haveFmt = true;
+    } else if (memcmp(buf, "fact", 4) == 0 && chunkSize >= 4) {
+      if (src->read(buf, 4) != 4) return false;
+      factFrames = readLE32(buf);
+    } else if (memcmp(buf, "data", 4) == 0) {
+      if (!haveFmt) return false;
+      info.dataOffset = pos;
+      info.dataSize = chunkSize;
+      if (info.dataSize > fileSize - info.dataOffset || chunkSize == 0xFFFFFFFF) {
+        info.dataSize = fileSize - info.dataOffset;  // Truncated or streamed file
+      }
+      break;
+    }
+    // LIST, bext, cue, PAD, ... carry nothing needed for playback
+
+    // Chunks are word-aligned; skip to the next one. A size past the end of
+    // the file ends the walk: a corrupt one could wrap pos back to this
+    // chunk and loop forever.
+    if (chunkSize > fileSize - pos) break;
+    pos += chunkSize + (chunkSize & 1);
+    if (!src->seek(pos, SEEK_SET)) return false;
+  }
+
+  if (info.dataOffset == 0) return false;
+  if (info.channels < 1 || info.channels > 2) return false;
+  if (info.formatTag == WAV_FORMAT_IMA_ADPCM) return checkAdpcm(src, info, factFrames);
+  if (info.formatTag != WAV_FORMAT_PCM) return false;
+  if (info.bitsPerSample != 8 && info.bitsPerSample != 16 && info.bitsPerSample != 24) return false;
+  if (info.blockAlign != info.channels * (info.bitsPerSample / 8)) return false;
+  if (info.sampleRate == 0) return false;
+
+  info.dataSize -= info.dataSize % info.blockAlign;
+  info.frameCount = info.dataSize / info.blockAlign;
+  if (factFrames > 0 && factFrames < info.frameCount) {
+    info.frameCount = factFrames;
+    info.dataSize = factFrames * info.blockAlign;
+  }
+
+  return src->seek(info.dataOffset, SEEK_SET);
+}
+
+// ===== SILENCE ANALYSIS =====
+#define ANALYZE_FRAMES 128
+
+// Index of the first (or last) audible frame in buf, or -1
+static int findAudible(const uint8_t *buf, int frames, const WavInfo &info, bool fromEnd) {
+  int bytesPerSample = info.bitsPerSample / 8;
+  for (int n = 0; n < frames; n++) {
+    int f = fromEnd ? frames - 1 - n : n;
+    const uint8_t *p = buf + f * info.blockAlign;
+    for (int c = 0; c < info.channels; c++, p += bytesPerSample) {
+      int32_t s;
+      if (bytesPerSample == 1) {
+        s = ((int32_t)p[0] - 128) << 8;
+      } else {
+        s = (int16_t)(p[bytesPerSample - 2] | (p[bytesPerSample - 1] << 8));
+      }
+      if (s >= WAV_SILENCE_THRESHOLD || s <= -WAV_SILENCE_THRESHOLD) return f;
+    }
+  }
+  return -1;
+}
+
+bool analyzeWavSilence(AudioFileSource *src, const WavInfo &info, WavTrim &trim) {
+  uint8_t buf[ANALYZE_FRAMES * 6];
+  uint32_t total = info.frameCount;
+  trim.startFrame = 0;
+  trim.endFrame = total;
+  if (total == 0) return false;
+  if (info.formatTag == WAV_FORMAT_IMA_ADPCM) return true;
+
+  // Leading silence
+  uint32_t first = total;
+  for (uint32_t frame = 0; frame < total; frame += ANALYZE_FRAMES) {
+    uint32_t n = total - frame < ANALYZE_FRAMES ? total - frame : ANALYZE_FRAMES;
+    if (!src->seek(info.dataOffset + frame * info.blockAlign, SEEK_SET)) return false;
+    if (src->read(buf, n * info.blockAlign) != n * info.blockAlign) return false;
+    int hit = findAudible(buf, n, info, false);
+    if (hit >= 0) {
+      first = frame + hit;
+      break;
+    }
+  }
+  if (first == total) {
+    trim.endFrame = 1;  // Entirely silent: a single frame, effectively nothing
+    return true;
+  }
+
+  // Trailing silence, scanning backward block by block
+  uint32_t last = first;
+  uint32_t end = total;
+  while (end > first) {
+    uint32_t n = end - first < ANALYZE_FRAMES ? end - first : ANALYZE_FRAMES;
+    uint32_t frame = end - n;
+    if (!src->seek(info.dataOffset + frame * info.blockAlign, SEEK_SET)) return false;
+    if (src->read(buf, n * info.blockAlign) != n * info.blockAlign) return false;
+    int hit = findAudible(buf, n, info, true);
+    if (hit >= 0) {
+      last = frame + hit;
+      break;
+    }
+    end = frame;
+  }
+
+  uint32_t preroll = info.sampleRate * WAV_TRIM_PREROLL_MS / 1000;
+  uint32_t tail = info.sampleRate * WAV_TRIM_TAIL_MS / 1000;
+  trim.startFrame = first > preroll ? first - preroll : 0;
+  trim.endFrame = last + 1 + tail < total ? last + 1 + tail : total;
+  return true;
+}
+
+// ===== THUMBNAIL =====
+uint8_t wavThumbLevel(uint32_t magnitude) {
+  if (magnitude == 0) return 0;
+  float db = 20.0f * log10f(magnitude / 32768.0f);
+  int level = 15 + (int)floorf(db / WAV_THUMB_DB_STEP + 0.5f);
+  return constrain(level, 0, 15);
+}
+
+WavEnvelope::WavEnvelope() {
+  src = nullptr;
+  memset(&info, 0, sizeof(info));
+  startFrame = endFrame = frame = blockFrame = 0;
+  column = 0;
+  columnEnd = 0;
+  peak = 0;
+  sumSquares = 0;
+  samples = 0;
+  memset(&thumb, 0, sizeof(thumb));
+}
+
+bool WavEnvelope::begin(AudioFileSource *source, const WavInfo &wav, const WavTrim &trim) {
+  src = source;
+  info = wav;
+  startFrame = trim.startFrame;
+  endFrame = trim.endFrame != 0 ? trim.endFrame : info.frameCount;
+  if (endFrame > info.frameCount) endFrame = info.frameCount;
+  if (startFrame > endFrame) startFrame = endFrame;
+  frame = startFrame;
+  memset(&thumb, 0, sizeof(thumb));
+  thumb.durationMs = (uint64_t)(endFrame - startFrame) * 1000 / info.sampleRate;
+  column = 0;
+  columnEnd = startFrame + (endFrame - startFrame) / WAV_THUMB_COLUMNS;
+  peak = 0;
+  sumSquares = 0;
+  samples = 0;
+
+  if (info.formatTag == WAV_FORMAT_IMA_ADPCM) {
+    if (info.samplesPerBlock > WAV_ENVELOPE_BLOCK || info.blockAlign > sizeof(buf)) return false;
+    uint32_t block = startFrame / info.samplesPerBlock;
+    blockFrame = block * info.samplesPerBlock;
+    return src->seek(info.dataOffset + block * info.blockAlign, SEEK_SET);
+  }
+  return src->seek(info.dataOffset + startFrame * info.blockAlign, SEEK_SET);
+}
+
+// Finish every column that ends at or before frame upTo
+void WavEnvelope::closeColumns(uint32_t upTo) {
+  uint32_t span = endFrame - startFrame;
+  while (column < WAV_THUMB_COLUMNS && columnEnd <= upTo) {
+    if (samples > 0) {
+      uint8_t rms = wavThumbLevel((uint32_t)sqrtf((float)(sumSquares / samples)));
+      thumb.wave[column] = (wavThumbLevel(peak) << 4) | rms;
+    }
+    peak = 0;
+    sumSquares = 0;
+    samples = 0;
+    column++;
+    columnEnd = startFrame + (uint64_t)span * (column + 1) / WAV_THUMB_COLUMNS;
+  }
+}
+
+void WavEnvelope::add(int32_t s) {
+  if (frame >= columnEnd) closeColumns(frame);
+  uint32_t m = s < 0 ? -s : s;
+  if (m > peak) peak = m;
+  sumSquares += (uint64_t)m * m;
+  samples++;
+  frame++;
+}
+
+bool WavEnvelope::step() {
+  uint32_t stop = endFrame - frame < WAV_ENVELOPE_STEP_FRAMES ? endFrame
+                                                              : frame + WAV_ENVELOPE_STEP_FRAMES;
+  while (frame < stop) {
+    if (info.formatTag == WAV_FORMAT_IMA_ADPCM) {
+      // One block; frames before the span (first block) are decoded and dropped
+      uint32_t at = blockFrame / info.samplesPerBlock * info.blockAlign;
+      uint32_t bytes = info.dataSize - at < info.blockAlign ? info.dataSize - at : info.blockAlign;
+      if (src->read(buf, bytes) != bytes) return false;
+      int n = imaDecodeBlock(buf, bytes, info.channels, decoded);
+      if (n <= 0) return false;
+      for (int i = frame - blockFrame; i < n && frame < endFrame; i++) add(decoded[i]);
+      blockFrame += info.samplesPerBlock;
+      continue;
+    }
+
+    uint32_t n = stop - frame < ANALYZE_FRAMES ? stop - frame : ANALYZE_FRAMES;
+    if (src->read(buf, n * info.blockAlign) != n * info.blockAlign) return false;
+    int bytesPerSample = info.bitsPerSample / 8;
+    const uint8_t *p = buf;
+    for (uint32_t f = 0; f < n; f++) {
+      int32_t sum = 0;
+      for (int c = 0; c < info.channels; c++, p += bytesPerSample) {
+        if (bytesPerSample == 1) {
+          sum += ((int32_t)p[0] - 128) << 8;
+        } else {
+          sum += (int16_t)(p[bytesPerSample - 2] | (p[bytesPerSample - 1] << 8));
+        }
+      }
+      add(sum / info.channels);
+    }
+  }
+  if (done()) closeColumns(endFrame);
+  return true;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <Arduino.h>
+#include "AudioFileSource.h"
+
+// ===== WAV HEADER PARSER =====
+// Walks the RIFF chunk list instead of assuming a 44-byte header, so files
+// with larger fmt chunks, WAVE_FORMAT_EXTENSIBLE, or extra chunks (LIST,
+// fact, bext, ...) before the sample data are handled.
+
+#define WAV_FORMAT_PCM        0x0001
+#define WAV_FORMAT_IMA_ADPCM  0x0011
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+// Samples below this magnitude (16-bit scale) count as silence. 256 is one
+// step of the 8-bit internal DAC, so anything quieter is inaudible anyway.
+#ifndef WAV_SILENCE_THRESHOLD
+#define WAV_SILENCE_THRESHOLD 256
+#endif
+#define WAV_TRIM_PREROLL_MS   5     // Kept before the first audible sample
+#define WAV_TRIM_TAIL_MS      30    // Kept after the last audible sample
+
+struct WavInfo {
+  uint16_t formatTag;      // Effective format (sub-format for EXTENSIBLE)
+  uint16_t channels;
+  uint32_t sampleRate;
+  uint16_t bitsPerSample;
+  uint16_t blockAlign;     // Bytes per frame (all channels); per block for ADPCM
+  uint16_t samplesPerBlock;  // IMA ADPCM frames per block (0 for PCM)
+  uint32_t dataOffset;     // File offset of the first sample byte
+  uint32_t dataSize;       // Sample data length in bytes
+  uint32_t frameCount;     // From the fact chunk if present, else dataSize / blockAlign
+};
+
+// Audible span of a sound in frames, [startFrame, endFrame). A zero
+// endFrame means "not analyzed": play the whole data chunk.
+struct WavTrim {
+  uint32_t startFrame;
+  uint32_t endFrame;
+};
+
+// Parse the header of an open source. On success the source is positioned
+// at dataOffset. Only PCM (8/16/24-bit) and 4-bit IMA ADPCM, mono or
+// stereo, are accepted.
+bool parseWavHeader(AudioFileSource *src, WavInfo &info);
+
+// One-time analysis pass: find the leading and trailing silence boundaries.
+// Scans forward from the start and backward from the end, so only the
+// silent regions plus one block at each end are read. ADPCM files are not
+// scanned: the whole file counts as audible.
+bool analyzeWavSilence(AudioFileSource *src, const WavInfo &info, WavTrim &trim);
+
+// ===== THUMBNAIL =====
+// What a sound button shows of a sound without reading its data: the
+// length of the audible span and a coarse amplitude envelope over it,
+// WAV_THUMB_COLUMNS columns of peak (high nibble) and RMS (low nibble)
+// level on a WAV_THUMB_DB_STEP scale, 15 at full scale and 0 below -45 dB.
+// tools/build_bank.py computes the same table for bank sounds.
+#define WAV_THUMB_COLUMNS   32
+#define WAV_THUMB_DB_STEP   3
+#ifndef WAV_ENVELOPE_STEP_FRAMES
+#define WAV_ENVELOPE_STEP_FRAMES 1024  // Source frames read per step()
+#endif
+#define WAV_ENVELOPE_BLOCK  256   // Largest IMA ADPCM block scanned, in frames
+
+struct WavThumb {
+  uint32_t durationMs;     // Audible span; 0 until analyzed
+  uint8_t wave[WAV_THUMB_COLUMNS];
+};
+
+// Thumbnail level (0..15) of a magnitude on the 16-bit scale
+uint8_t wavThumbLevel(uint32_t magnitude);
+
+// Envelope pass over the audible span of an open source, a bounded number
+// of frames per step() so it can share loop() with the UI. Reads through
+// its own buffers; the source is left wherever the last step stopped.
+class WavEnvelope {
+  public:
+    WavEnvelope();
+    bool begin(AudioFileSource *src, const WavInfo &info, const WavTrim &trim);
+    // Scan the next WAV_ENVELOPE_STEP_FRAMES frames; false on a read error
+    bool step();
+    bool done() const { return frame >= endFrame; }
+
+    WavThumb thumb;          // Complete once done()
+
+  private:
+    void add(int32_t s);
+    void closeColumns(uint32_t upTo);
+
+    AudioFileSource *src;
+    WavInfo info;
+    uint32_t startFrame;
+    uint32_t endFrame;
+    uint32_t frame;          // Next frame to fold in
+    uint32_t blockFrame;     // ADPCM: first frame of the next block to read
+    int column;
+    uint32_t columnEnd;      // First frame of the next column
+    uint32_t peak;
+    uint64_t sumSquares;
+    uint32_t samples;
+    uint8_t buf[WAV_ENVELOPE_BLOCK * 3];  // 128 PCM frames of up to 6 bytes, or one ADPCM block
+    int16_t decoded[WAV_ENVELOPE_BLOCK];
+};
@@ -4,11 +4,28 @@
 #include <TFT_eSPI.h>
 #include <SD.h>
 #include <FS.h>
+#include <atomic>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
 
 // ESP8266Audio library for proper WAV playback
 #include "AudioFileSourceSD.h"
-#include "AudioGeneratorWAV.h"
 #include "AudioOutputI2S.h"
+#include "AudioGeneratorSynth.h"
+#include "AudioMixer.h"
+#include "AudioEngine.h"
+#include "PcmCache.h"
+#include "AudioFileSourceBank.h"
+#include "AudioFileSourceReadAhead.h"
+#include "UiRenderer.h"
+#include "TouchInput.h"
+#include "EventLog.h"
+#include "LatencyTrace.h"
+#include "SoundCatalog.h"
+#include "BootProfile.h"
+#include "HeapStats.h"
+#include "RemoteLink.h"
+#include "PowerGovernor.h"
 
 // ===== BOARD-SPECIFIC CONFIGURATION =====
 #if defined(BOARD_CYD_RESISTIVE)
@@ -39,7 +56,9 @@
   
   // Create second SPI bus for touch
   SPIClass touchSPI(HSPI);
-  XPT2046_Touchscreen ts(TOUCH_CS, TOUCH_IRQ);
+  XPT2046_Touchscreen ts(TOUCH_CS);  // PENIRQ is handled by TouchInput
+  #define TOUCH_IRQ_PIN  TOUCH_IRQ
+  #define TOUCH_IRQ_HELD true        // PENIRQ stays low while pressed
 
 #elif defined(BOARD_CYD_CAPACITIVE)
   // JC2432W328C (Guition) with CST816S Capacitive Touch (I2C)
@@ -51,6 +70,8 @@
   #define TOUCH_RST 25
   #define TFT_BACKLIGHT 27
   #define CST816S_ADDR 0x15
+  #define TOUCH_IRQ_PIN  TOUCH_INT
+  #define TOUCH_IRQ_HELD false       // INT pulses low when a touch is reported
   #define BOARD_NAME "JC2432W328C (Capacitive)"
   
   // SD Card pins - TODO: Verify for this board
@@ -98,6 +119,20 @@
 #define VOL_NUM_X        290
 #define VOL_NUM_Y        18
 
+// Level meter and playhead bars under the title, fed from the mixer's
+// snapshot at most every METER_REFRESH_MS while sounds play
+#define METER_X          10
+#define METER_W          (VOL_MINUS_X - 25)
+#define LEVEL_Y          28
+#define LEVEL_H          3
+#define PLAYHEAD_Y       32
+#define PLAYHEAD_H       2
+#ifndef METER_REFRESH_MS
+#define METER_REFRESH_MS 33          // ~30 updates/s
+#endif
+#define METER_RANGE_DB   48          // The level bar spans -48..0 dBFS
+#define METER_HOLD_MS    1000        // Peak marker holds this long before dropping
+
 // Scroll indicator positions
 #define SCROLL_Y         (SCREEN_HEIGHT - 28)
 #define SCROLL_UP_X      120
@@ -105,41 +140,178 @@
 #define SCROLL_BTN_W     40
 #define SCROLL_BTN_H     24
 
-// ===== SOUND DATA =====
-#define MAX_SOUNDS 20
-
-struct SoundEntry {
-  char filename[16];   // e.g., "0001.wav"
-  char title[32];      // e.g., "Achievement Bell"
+// List order and search buttons, either side of the scroll arrows
+#define ORDER_BTN_X      BUTTON_X
+#define FIND_BTN_X       (SCREEN_WIDTH - BUTTON_X - MODE_BTN_W)
+#define MODE_BTN_W       60
+
+// Letter strips: the A-Z jump bar under the list in A-Z order, and the
+// search keypad, whose two rows take the place of the third result row
+#define KEYS_X           4
+#define KEYS_W           (SCREEN_WIDTH - 2 * KEYS_X)
+#define JUMP_BAR_Y       (LIST_TOP + VISIBLE_BUTTONS * (BUTTON_HEIGHT + BUTTON_MARGIN))
+#define JUMP_BAR_H       (SCROLL_Y - 4 - JUMP_BAR_Y)
+#define SEARCH_ROWS      (VISIBLE_BUTTONS - 1)
+#define KEYPAD_Y         (LIST_TOP + SEARCH_ROWS * (BUTTON_HEIGHT + BUTTON_MARGIN))
+#define KEYPAD_ROW_H     ((SCROLL_Y - 4 - KEYPAD_Y) / 2)
+#define KEYPAD_TOP       "ABCDEFGHIJKLMN"
+#define KEYPAD_BOTTOM    "OPQRSTUVWXYZ'_"   // '_' types a space
+#define JUMP_LETTERS     "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+
+// Drag and fling scrolling of the list, off by default: taps on list
+// buttons then play on release, once it is clear the finger did not drag,
+// which adds the whole press (~100 ms for a quick tap) to tap-to-sound
+// latency. 0 plays them on touch-down and leaves the list to the page
+// buttons.
+#ifndef LIST_DRAG_SCROLL
+#define LIST_DRAG_SCROLL 0
+#endif
+#define ROW_PITCH        (BUTTON_HEIGHT + BUTTON_MARGIN)
+#define DRAG_SLOP_PX     8           // Travel before a press becomes a drag
+#define FLING_MIN_SPEED  0.05f       // px/ms; slower and the list settles on a row
+#define FLING_DECAY      0.996f      // Speed kept per ms of coasting
+#define FLING_STALE_MS   60          // Finger held still this long before release: no fling
+
+// Waveform thumbnails on the sound buttons, drawn from the envelope and
+// length kept in the catalog; 'w' on the console toggles them
+#ifndef SOUND_THUMBNAILS
+#define SOUND_THUMBNAILS 1
+#endif
+static_assert(UI_WAVE_COLUMNS == WAV_THUMB_COLUMNS, "Thumbnail widths differ");
+
+// Retained UI widgets, back to front (later ones paint over earlier ones)
+enum UiWidgetId {
+  UI_TITLE = 0,
+  UI_VOL_MINUS,
+  UI_VOL_PLUS,
+  UI_VOL_NUM,
+  UI_LEVEL_BAR,
+  UI_PLAYHEAD_BAR,
+  UI_EMPTY_MSG,
+  UI_EMPTY_HINT,
+  UI_SCROLL_UP,
+  UI_SCROLL_DOWN,
+  UI_PAGE,
+  UI_LIST_ORDER,    // "A-Z" toggle; "Del" while searching
+  UI_FIND,          // "Find"; "Done" while searching
+  UI_KEYS_TOP,      // Jump bar, or the keypad's top row
+  UI_KEYS_BOTTOM,
+  UI_SOUND_BUTTON,  // First of VISIBLE_BUTTONS
 };
+static_assert(UI_SOUND_BUTTON + VISIBLE_BUTTONS <= UI_MAX_WIDGETS, "Raise UI_MAX_WIDGETS");
 
-SoundEntry sounds[MAX_SOUNDS];
-int soundCount = 0;
+// ===== SOUND DATA =====
+// Built-ins, then the card's sounds through an on-card index; only the
+// window around the current page is in RAM
+#define CATALOG_PATH "/catalog.idx"
+SoundCatalog catalog;
 int scrollOffset = 0;
 int volume = 5;  // 0-10
 const int MAX_VOLUME = 10;
 bool sdCardOk = false;
 
+// ===== LIST VIEWS =====
+// The list in index.csv order, the same sounds A-Z (built-ins first), or
+// search results. A-Z and search pages come from the catalog's sorted
+// title table, so the page's sounds and titles are resolved once per page.
+enum ListView { VIEW_LIST, VIEW_AZ, VIEW_SEARCH };
+#define SEARCH_QUERY_LEN 10
+ListView listView = VIEW_LIST;
+ListView browseView = VIEW_LIST;     // View and offset to return to from search
+int browseOffset = 0;
+char searchQuery[SEARCH_QUERY_LEN] = "";
+int searchFirst = 0;                 // Title ranks [searchFirst, searchEnd) match
+int searchEnd = 0;
+bool jumpScrub = false;              // Touch went down on the jump bar
+char jumpLetter = '\0';
+int pageSound[VISIBLE_BUTTONS];      // Sound on each button of the page, -1 if none
+char pageTitle[VISIBLE_BUTTONS][CATALOG_TITLE_LEN];
+WavThumb pageThumb[VISIBLE_BUTTONS];
+bool showThumbnails = SOUND_THUMBNAILS;
+
+// List drag state (LIST_DRAG_SCROLL); the list is in the renderer's scroll
+// view from the first drag until it settles on a row
+bool listPressed = false;            // Finger went down on the list
+bool listDragging = false;           // ... and moved past DRAG_SLOP_PX
+bool listFlinging = false;           // Coasting, then settling, after release
+int pressX = 0, pressY = 0;
+uint32_t pressMicros = 0;            // Touch-down edge of the press
+float pressPos = 0;                  // List position when the drag (re)started
+float listPos = 0;                   // List pixels above the top of the view
+float flingSpeed = 0;                // px/ms, positive moves the list up
+int lastDragY = 0;
+uint32_t lastDragMicros = 0;
+uint32_t flingMicros = 0;
+
 // ===== GLOBAL OBJECTS =====
 TFT_eSPI tft = TFT_eSPI();
+UiRenderer ui;         // Widgets are state; loop() repaints what changed
 SPIClass sdSPI(VSPI);  // Use VSPI for SD card
 
+// Touch events come from the touch task, woken by the controller's interrupt
+TouchInput touch;
+
 // Touch debounce
 const unsigned long TOUCH_DEBOUNCE_MS = 200;
 unsigned long lastTouchMillis = 0;
+uint32_t tapMicros = 0;  // Touch-down time of the tap being handled (0 if none)
 
 // ===== AUDIO CONFIGURATION =====
-#define SPEAKER_DAC_PIN 26   // DAC output pin for audio (used for synthesized tones)
-#define BEEP_FREQ 1000       // Beep frequency in Hz
-#define BEEP_DURATION 200    // Beep duration in ms
+#define SPEAKER_DAC_PIN 26   // DAC output pin for audio (driven by AudioOutputI2S)
 
-// ESP8266Audio objects for WAV playback
-AudioGeneratorWAV *wav = nullptr;
-AudioFileSourceSD *file = nullptr;
+// Audio output and the mixer that feeds it (WAV and synth voices). The
+// engine runs both in tasks on the other core; loop() only posts commands.
 AudioOutputI2S *out = nullptr;
+AudioMixer mixer;
+AudioEngine audio;
+AudioFileSourceReadAhead voiceFiles[MIXER_VOICES];  // One reusable file source per voice
+AudioFileSource *voiceSources[MIXER_VOICES];
+PcmCache pcmCache;                               // Decoded heads of hot/visible sounds
+AudioFileSourceSD cacheFillFile;                 // Used by the cache's background fill
+
+// Silence-trim points and thumbnails of loose WAVs, analyzed once and
+// kept in the catalog
+AudioFileSourceSD trimFile;                      // Used by the idle analysis pass
+int trimNext = 0;                                // Next sound to check
+int analysisIndex = -1;                          // Sound whose envelope is being scanned
+char analysisName[CATALOG_NAME_LEN];
+uint32_t analysisFileSize = 0;
+uint32_t analysisMicros = 0;                     // Time spent on it so far
+uint16_t analysisSteps = 0;
+WavTrim analysisTrim;
+WavEnvelope envelope;
+
+// Packed sound bank (tools/build_bank.py); preferred over loose WAVs when present
+#define SOUND_BANK_PATH "/sounds.bnk"
+SoundBank soundBank;
+AudioFileSourceBank bankVoiceFiles[MIXER_VOICES];
+AudioFileSourceBank bankCacheFillFile;
 bool audioPlaying = false;
-int currentlyPlayingIndex = -1;  // Track which sound is playing for UI update
-uint32_t wavStopPosition = 0;    // Position in file to stop playback (for early cutoff)
+
+// Level meter state (loop() only)
+uint32_t meterMillis = 0;            // Last update
+int meterHold = 0;                   // Peak marker: columns lit at the last peak
+uint32_t meterHoldMillis = 0;
+
+// ===== POWER =====
+// The backlight is dimmed through a PWM channel once the display is up
+#define BACKLIGHT_LEDC_CHANNEL 7     // Nothing else uses the LEDC
+#define BACKLIGHT_PWM_HZ       5000
+#define BACKLIGHT_PWM_BITS     8
+
+// ===== SERIAL =====
+#define SERIAL_BYTES_PER_LOOP 64     // Console and remote bytes taken per loop()
+
+// ===== BOOT =====
+#ifndef BOOT_SERIAL_WAIT_MS
+#define BOOT_SERIAL_WAIT_MS 0        // e.g. 1000 to catch the first lines in a monitor
+#endif
+#define BOOT_TASK_CORE      0        // SD and catalog load, beside setup() on core 1
+#define BOOT_TASK_PRIORITY  2
+#define BOOT_TASK_STACK     6144
+std::atomic<bool> bootLoaded(false); // Boot task done with SD and the catalog
+bool soundListReady = false;         // loop() owns the catalog and drew the list
+uint32_t touchResetMillis = 0;       // End of the capacitive controller's reset
 
 // Hardcoded sound indices
 #define SOUND_BEEP   0
@@ -160,30 +332,80 @@ void drawHeader();
 void drawVolumeControls();
 void drawSoundButtons();
 void drawScrollIndicators();
-void drawButton(int x, int y, int w, int h, const char* label, uint16_t bgColor, uint16_t textColor);
+void drawList();
+void loadPage();
+int listLength();
+int pageRows();
+void setListView(ListView view);
+void beginSearch();
+void endSearch();
+void typeSearchKey(char key);
+void jumpToLetter(char letter);
+bool listTouch(const TouchEvent &event);
+void stepListScroll();
+bool startListScroll();
+void finishListScroll();
+int listSoundAt(int pos, char *title);
+void drawButton(int id, int x, int y, int w, int h, const char* label, uint16_t bgColor, uint16_t textColor);
 void playSound(int index);
-void resetPlayingButton();
-void playBeep();
-void playSiren();
-void playChime();
-void playLaser();
-void playTone(int freqHz, int durationMs, int vol);
-bool playWavFile(const char* filename);
+bool queueSound(int index, uint32_t gap);
+void drawSoundButton(int index);
+void formatDuration(uint32_t ms, char *dst, size_t len);
+void updateMeters();
+void drawMeters(const MixerMeter &m, uint32_t now);
+void prewarmVisibleSounds();
+const SynthPreset* builtinPreset(const char* filename);
+void applyVolume();
+void handleSerialCommand();
+void runConsoleCommand(int c);
+bool remotePlay(int index);
+void remoteStop(int index);
+void remoteVolume(int level);
+void remoteStatus(RemoteStatus &status);
+bool remoteQueue(int index, uint32_t gap);
 void reinitTouch();
 int getTouchedButton(int touchX, int touchY);
 bool initSDCard();
 bool parseIndexCSV();
+bool loadSoundBank();
+void analyzeNextSound();
 void addBeepSound();
+void bootTask(void*);
+void loadSounds();
+void showSoundList();
+void beginTouchController();
+void finishTouchController();
+uint32_t powerClock();
+void powerSetCpu(uint32_t mhz);
+void powerSetBacklight(uint8_t duty);
+uint8_t powerLightSleep(uint32_t maxMs);
 
 // ===== SETUP =====
+// Startup runs in parallel where the steps do not depend on each other:
+//
+//   core 1 (setup)   display, UI shell (first frame), touch controller
+//                    bring-up, audio output and tasks
+//   core 0 (boot)    SD mount and catalog load (index build if stale)
+//
+// The shell shows "Loading sounds..." until loop() sees the boot task
+// finish; it then wires the voices to the bank or loose files and draws
+// the list. The frame after that is the first interactive one. Every
+// phase lands in the boot timeline ('p' on the serial console).
 void setup() {
   Serial.begin(115200);
-  delay(1000);
+  delay(BOOT_SERIAL_WAIT_MS);
+  int phase = bootProfile.begin("serial + log");
   Serial.println("\n\n========================================");
   Serial.println("CYD Sound Board - Starting...");
   Serial.println(BOARD_NAME);
   Serial.println("========================================");
 
+  // Hot paths log through the deferred event log from here on
+  eventLog.begin();
+  remoteLink.begin(remotePlay, remoteStop, remoteVolume, remoteStatus, remoteQueue);
+  bootProfile.end(phase);
+
+  phase = bootProfile.begin("gpio");
   // Initialize backlight pin and turn it on
   pinMode(TFT_BACKLIGHT, OUTPUT);
   digitalWrite(TFT_BACKLIGHT, HIGH);
@@ -212,19 +434,130 @@ void setup() {
   pinMode(17, OUTPUT);
   digitalWrite(17, HIGH);
   Serial.println("RGB LEDs turned off (GPIOs 16, 17 = HIGH)");
+  bootProfile.end(phase);
 
   // Initialize display
+  phase = bootProfile.begin("display");
   tft.init();
   tft.setRotation(1);  // Landscape mode
   tft.fillScreen(COLOR_BLACK);
-  tft.setTextColor(COLOR_WHITE);
-  tft.setTextDatum(MC_DATUM);
-  tft.setTextSize(2);
+  // tft.init() drives the backlight pin as a plain GPIO; PWM from here on
+  ledcSetup(BACKLIGHT_LEDC_CHANNEL, BACKLIGHT_PWM_HZ, BACKLIGHT_PWM_BITS);
+  ledcAttachPin(TFT_BACKLIGHT, BACKLIGHT_LEDC_CHANNEL);
+  ledcWrite(BACKLIGHT_LEDC_CHANNEL, POWER_BACKLIGHT_FULL);
   Serial.println("Display initialized");
+  bootProfile.end(phase);
+
+  // The UI shell goes up before anything slow: header, volume and a
+  // loading message where the list will be
+  phase = bootProfile.begin("ui shell");
+  ui.begin(&tft, COLOR_BLACK);
+  drawUI();
+  ui.flush();
+  bootProfile.firstFrame();
+  bootProfile.end(phase);
+
+  // Built-ins first (always available, no SD needed), then the card's
+  // sounds from the boot task
+  addBeepSound();
+  for (int i = 0; i < MIXER_VOICES; i++) {
+    voiceFiles[i].reserve();           // Read-ahead buffers now, not on the first tap
+    voiceSources[i] = &voiceFiles[i];  // Until loop() knows whether a bank was found
+  }
+  if (xTaskCreatePinnedToCore(bootTask, "boot", BOOT_TASK_STACK, nullptr,
+                              BOOT_TASK_PRIORITY, nullptr, BOOT_TASK_CORE) != pdPASS) {
+    Serial.println("ERROR: Could not start boot task, loading sounds inline");
+    loadSounds();
+  }
+
+  phase = bootProfile.begin("touch reset");
+  beginTouchController();
+  bootProfile.end(phase);
+
+  // Initialize audio output using ESP32 internal DAC
+  // Internal DAC uses GPIO25 (left/channel 1) and GPIO26 (right/channel 2)
+  // NOTE: Resistive board uses GPIO25 for touch SPI clock, so we must use mono
+  // and output only to the right channel (GPIO26) to avoid conflict
+  phase = bootProfile.begin("audio");
+  out = new AudioOutputI2S(0, AudioOutputI2S::INTERNAL_DAC);
+  out->SetOutputModeMono(true);  // Use mono mode to avoid GPIO25 conflict
+  out->SetGain(1.0);  // Volume is applied by the mixer
+  mixer.begin(audio.output(), voiceSources);
+  PcmStream::reserveFilters(MIXER_SAMPLE_RATE);
+  if (pcmCache.begin(&cacheFillFile)) {
+    mixer.setCache(&pcmCache);
+  }
+  audio.begin(out, &mixer, &pcmCache);
+  applyVolume();
+  Serial.printf("Audio I2S output initialized (internal DAC, mono on GPIO26, %d voices)\n",
+                MIXER_VOICES);
+  bootProfile.end(phase);
+
+  phase = bootProfile.begin("touch");
+  finishTouchController();
+  // From here on the touch controller belongs to the touch task
+  touch.begin(readTouch, reinitTouch, TOUCH_IRQ_PIN, TOUCH_IRQ_HELD);
+  bootProfile.end(phase);
+
+  PowerHooks hooks = {powerClock, powerSetCpu, powerSetBacklight, powerLightSleep};
+  powerGovernor.begin(hooks);
+
+  Serial.println("Ready! Touch screen to interact.");
+}
+
+// ===== BOOT TASK =====
+void bootTask(void*) {
+  loadSounds();
+  vTaskDelete(nullptr);
+}
+
+// SD mount and catalog load, off the UI core. Touches nothing loop() uses
+// until bootLoaded is set; loop() takes the catalog over from there.
+void loadSounds() {
+  int phase = bootProfile.begin("sd mount");
+  bool mounted = initSDCard();
+  bootProfile.end(phase);
+
+  if (mounted) {
+    // Sound list: bank first, index.csv fallback
+    phase = bootProfile.begin("catalog");
+    if (!loadSoundBank()) {
+      parseIndexCSV();
+    }
+    bootProfile.end(phase);
+  }
 
-  tft.drawString("Initializing touch...", 160, 120);
+  if (catalog.count() == NUM_BUILTIN_SOUNDS) {  // Only built-in sounds available
+    Serial.println("Only built-in sounds available (no SD sounds loaded)");
+  }
+
+  bootLoaded.store(true, std::memory_order_release);
+}
+
+// loop(): the boot task is done. Point the voices and the cache fill at
+// what it found (no file play or cache request has been posted yet), then
+// draw the sound list.
+void showSoundList() {
+  int phase = bootProfile.begin("sound list");
+  if (soundBank.isOpen()) {
+    for (int i = 0; i < MIXER_VOICES; i++) {
+      voiceSources[i] = &bankVoiceFiles[i];
+    }
+    pcmCache.setFillSource(&bankCacheFillFile);
+  } else if (sdCardOk) {
+    AudioFileSourceReadAhead::startReader(AUDIO_TASK_CORE);
+  }
+
+  soundListReady = true;
+  drawSoundButtons();
+  drawScrollIndicators();
+  bootProfile.end(phase);
+}
 
-  // ===== TOUCH CONTROLLER INITIALIZATION =====
+// ===== TOUCH CONTROLLER BRING-UP =====
+// Split in two so the capacitive controller's ~100 ms boot time after its
+// reset overlaps audio init instead of being slept through
+void beginTouchController() {
 #if defined(BOARD_CYD_RESISTIVE)
   // XPT2046 Resistive Touch - uses SEPARATE SPI bus from display
   Serial.printf("Touch pins: CS=%d, IRQ=%d, SCLK=%d, MOSI=%d, MISO=%d\n", 
@@ -241,16 +574,25 @@ void setup() {
   Serial.printf("Touch pins: SDA=%d, SCL=%d, RST=%d, INT=%d\n", 
                 TOUCH_SDA, TOUCH_SCL, TOUCH_RST, TOUCH_INT);
   
-  // Configure RST pin and perform reset
+  // Configure RST pin and start a reset; finishTouchController() waits out
+  // the rest of the controller's boot
   pinMode(TOUCH_RST, OUTPUT);
   digitalWrite(TOUCH_RST, LOW);
   delay(20);
   digitalWrite(TOUCH_RST, HIGH);
-  delay(100);  // Wait for CST816S to boot
-  Serial.println("Touch controller reset complete");
+  touchResetMillis = millis();
 
   // Configure INT pin
   pinMode(TOUCH_INT, INPUT);
+#endif
+}
+
+void finishTouchController() {
+#if defined(BOARD_CYD_CAPACITIVE)
+  // Wait for CST816S to boot (100 ms from the end of the reset pulse)
+  uint32_t sinceReset = millis() - touchResetMillis;
+  if (sinceReset < 100) delay(100 - sinceReset);
+  Serial.println("Touch controller reset complete");
 
   // Initialize I2C for touch on correct pins (SDA=33, SCL=32)
   Wire.begin(TOUCH_SDA, TOUCH_SCL);
@@ -278,38 +620,6 @@ void setup() {
 #endif
 
   Serial.println("Touch controller ready");
-
-  tft.fillScreen(COLOR_BLACK);
-  tft.setTextColor(COLOR_WHITE);
-  tft.setTextDatum(MC_DATUM);
-  tft.setTextSize(2);
-  tft.drawString("Initializing SD card...", SCREEN_WIDTH/2, SCREEN_HEIGHT/2);
-
-  // Add the beep sound first (always available, no SD needed)
-  addBeepSound();
-
-  // Initialize SD card and load sound list
-  if (initSDCard()) {
-    parseIndexCSV();
-  }
-
-  if (soundCount == NUM_BUILTIN_SOUNDS) {  // Only built-in sounds available
-    Serial.println("Only built-in sounds available (no SD sounds loaded)");
-  }
-
-  // Initialize audio output using ESP32 internal DAC
-  // Internal DAC uses GPIO25 (left/channel 1) and GPIO26 (right/channel 2)
-  // NOTE: Resistive board uses GPIO25 for touch SPI clock, so we must use mono
-  // and output only to the right channel (GPIO26) to avoid conflict
-  out = new AudioOutputI2S(0, AudioOutputI2S::INTERNAL_DAC);
-  out->SetOutputModeMono(true);  // Use mono mode to avoid GPIO25 conflict
-  out->SetGain(0.5);  // Start at 50% gain
-  Serial.println("Audio I2S output initialized (internal DAC, mono on GPIO26)");
-
-  // Draw the main UI
-  drawUI();
-
-  Serial.println("Ready! Touch screen to interact.");
 }
 
 // ===== TOUCH READ FUNCTION =====
@@ -368,7 +678,8 @@ bool readTouch(int &screenX, int &screenY) {
 
 // Reinitialize touch controller after audio playback
 // This is needed on the resistive board because I2S internal DAC uses GPIO25
-// which conflicts with the touch SPI clock
+// which conflicts with the touch SPI clock. Runs in the touch task, via
+// touch.requestReinit()
 void reinitTouch() {
 #if defined(BOARD_CYD_RESISTIVE)
   // Reinitialize the HSPI bus for touch
@@ -377,81 +688,110 @@ void reinitTouch() {
   touchSPI.begin(TOUCH_SCLK, TOUCH_MISO, TOUCH_MOSI, TOUCH_CS);
   ts.begin(touchSPI);
   ts.setRotation(1);
-  Serial.println("Touch controller reinitialized");
+  LOG_DEBUG("Touch controller reinitialized");
 #endif
   // Capacitive touch uses I2C, no conflict with I2S DAC
 }
 
 // ===== MAIN LOOP =====
 void loop() {
-  // Handle audio playback - must be called frequently!
-  if (audioPlaying && wav != nullptr) {
-    if (wav->isRunning()) {
-      // Check if we should stop early (0.5 seconds before end to avoid trailing buzz)
-      if (file != nullptr && wavStopPosition > 0 && file->getPos() >= wavStopPosition) {
-        wav->stop();
-        audioPlaying = false;
-        resetPlayingButton();
-        reinitTouch();  // Reinit touch after audio (I2S may have affected GPIO25)
-        Serial.println("WAV playback stopped early (avoiding buzz)");
-      } else if (!wav->loop()) {
-        // Playback finished naturally
-        wav->stop();
-        audioPlaying = false;
-        resetPlayingButton();
-        reinitTouch();  // Reinit touch after audio (I2S may have affected GPIO25)
-        Serial.println("WAV playback complete");
-      }
-    } else {
-      audioPlaying = false;
-      resetPlayingButton();
-      reinitTouch();  // Reinit touch after audio
+  // The boot task is done with the card: take the catalog over, show the list
+  if (!soundListReady && bootLoaded.load(std::memory_order_acquire)) {
+    showSoundList();
+  }
+
+  // Button highlights follow voice start/end events from the audio task
+  AudioEvent event;
+  while (audio.pollEvent(event)) {
+    drawSoundButton(event.tag);
+    if (event.type == AUDIO_EVENT_START) {
+      remoteLink.voiceStarted(event.tag);
+      powerGovernor.soundStarted();
     }
   }
 
-  // Poll touch at ~20Hz
-  static unsigned long lastTouchRead = 0;
-  static bool wasTouched = false;
+  if (audioPlaying && !audio.isBusy()) {
+    // All voices finished and the output is stopped
+    audioPlaying = false;
+    touch.requestReinit();  // Reinit touch after audio (I2S may have affected GPIO25)
+    LOG_INFO("Playback complete");
+  }
 
-  if (millis() - lastTouchRead > 50) {
-    lastTouchRead = millis();
+  // Analyze new or changed WAVs, a step per pass, while nothing plays
+  if (!audioPlaying && soundListReady) analyzeNextSound();
+
+  handleSerialCommand();
+  remoteLink.service();
+
+  // Taps act on touch-down; moves only scrub the jump bar. Any touch
+  // brings the clock up before it is handled.
+  TouchEvent touchEvent;
+  while (touch.poll(touchEvent)) {
+    powerGovernor.activity();
+    if (touchEvent.type == TOUCH_UP) jumpScrub = false;
+    if (touchEvent.type == TOUCH_MOVE && jumpScrub) {
+      char letter = ui.keyAt(UI_KEYS_TOP, touchEvent.x, touchEvent.y);
+      if (letter != '\0') jumpToLetter(letter);
+    }
+    if (listTouch(touchEvent)) continue;
+    if (touchEvent.type != TOUCH_DOWN) continue;
+
+    unsigned long currentMillis = millis();
+    if (currentMillis - lastTouchMillis >= TOUCH_DEBOUNCE_MS) {
+      LOG_DEBUG("TOUCH: (%d, %d)", touchEvent.x, touchEvent.y);
+      tapMicros = touchEvent.micros;
+      handleTouch(touchEvent.x, touchEvent.y);
+      tapMicros = 0;
+      lastTouchMillis = currentMillis;
+    }
+  }
 
-    int screenX, screenY;
+  // Next scroll position once the previous one is on screen
+  stepListScroll();
 
-    if (readTouch(screenX, screenY)) {
-      if (!wasTouched) {  // New touch started
-        wasTouched = true;
+  // Level and playhead of what is playing
+  updateMeters();
 
-        unsigned long currentMillis = millis();
-        if (currentMillis - lastTouchMillis >= TOUCH_DEBOUNCE_MS) {
-          Serial.printf("TOUCH: (%d, %d)\n", screenX, screenY);
-          handleTouch(screenX, screenY);
-          lastTouchMillis = currentMillis;
-        }
-      }
-    } else {
-      wasTouched = false;
-    }
+  // Push whatever the events and touches above changed
+  ui.render();
+
+  if (soundListReady && !bootProfile.interactive()) {
+    // First frame with the list on screen (touch has run since setup())
+    ui.flush();
+    bootProfile.firstInteractive();
+    bootProfile.printTimeline();
+    heapStats.markSteady();
   }
 
+  // Clock and backlight follow use; once long idle this pass ends in a
+  // light sleep. A linked remote keeps the board out of it: the UART does
+  // not wake it, and bytes arriving asleep are lost.
+  bool busy = audioPlaying || audio.isBusy() || listPressed || listFlinging || remoteLink.waiting();
+  powerGovernor.service(busy, !remoteLink.connected());
+
   // Small delay - audio loop handles timing
   delay(1);
 }
 
 // ===== UI DRAWING =====
+// These only update widget state; ui.render() in loop() repaints the
+// rectangles that actually changed
 void drawUI() {
-  tft.fillScreen(COLOR_BLACK);
   drawHeader();
   drawSoundButtons();
   drawScrollIndicators();
+  ui.invalidateAll();
 }
 
 void drawHeader() {
-  // Title
-  tft.setTextColor(COLOR_WHITE);
-  tft.setTextDatum(TL_DATUM);
-  tft.setTextSize(2);
-  tft.drawString("Sound Board", 10, 10);
+  // Title, or the search query with a cursor
+  if (listView == VIEW_SEARCH) {
+    char title[UI_LABEL_LEN];
+    snprintf(title, sizeof(title), "Find %s_", searchQuery);
+    ui.setText(UI_TITLE, 10, 10, VOL_MINUS_X - 15, 16, title, COLOR_YELLOW, TL_DATUM, 2);
+  } else {
+    ui.setText(UI_TITLE, 10, 10, VOL_MINUS_X - 15, 16, "Sound Board", COLOR_WHITE, TL_DATUM, 2);
+  }
   
   // Volume controls
   drawVolumeControls();
@@ -459,81 +799,472 @@ void drawHeader() {
 
 void drawVolumeControls() {
   // Minus button
-  drawButton(VOL_MINUS_X, VOL_BTN_Y, VOL_BTN_SIZE, VOL_BTN_SIZE, "-", COLOR_DARKGRAY, COLOR_WHITE);
+  drawButton(UI_VOL_MINUS, VOL_MINUS_X, VOL_BTN_Y, VOL_BTN_SIZE, VOL_BTN_SIZE, "-", COLOR_DARKGRAY, COLOR_WHITE);
   
   // Plus button
-  drawButton(VOL_PLUS_X, VOL_BTN_Y, VOL_BTN_SIZE, VOL_BTN_SIZE, "+", COLOR_DARKGRAY, COLOR_WHITE);
+  drawButton(UI_VOL_PLUS, VOL_PLUS_X, VOL_BTN_Y, VOL_BTN_SIZE, VOL_BTN_SIZE, "+", COLOR_DARKGRAY, COLOR_WHITE);
   
-  // Volume number
-  tft.fillRect(VOL_NUM_X - 15, VOL_BTN_Y, 30, VOL_BTN_SIZE, COLOR_BLACK);
-  tft.setTextColor(COLOR_CYAN);
-  tft.setTextDatum(MC_DATUM);
-  tft.setTextSize(2);
+  // Volume number, centred on (VOL_NUM_X, VOL_NUM_Y)
   char volStr[4];
   snprintf(volStr, sizeof(volStr), "%d", volume);
-  tft.drawString(volStr, VOL_NUM_X, VOL_NUM_Y);
+  ui.setText(UI_VOL_NUM, VOL_NUM_X - 15, VOL_BTN_Y, 30, VOL_BTN_SIZE, volStr, COLOR_CYAN, MC_DATUM, 2);
+}
+
+// ===== LEVEL METER =====
+// The mixer publishes a snapshot per audio block without waiting for
+// anyone; this takes the newest one at a capped rate, and the bars repaint
+// only the columns that moved
+void updateMeters() {
+  uint32_t now = millis();
+  if (now - meterMillis < METER_REFRESH_MS) return;
+  meterMillis = now;
+  MixerMeter m;
+  mixer.readMeter(m);
+  drawMeters(m, now);
+}
+
+static int meterColumns(uint16_t level) {
+  if (level == 0) return 0;
+  float db = 20.0f * log10f(level / 32767.0f);
+  return constrain((int)((db + METER_RANGE_DB) * METER_W / METER_RANGE_DB), 0, METER_W);
+}
+
+void drawMeters(const MixerMeter &m, uint32_t now) {
+  if (m.level == 0 && m.tag < 0) {
+    ui.hide(UI_LEVEL_BAR);
+    ui.hide(UI_PLAYHEAD_BAR);
+    meterHold = 0;
+    return;
+  }
+
+  int lit = meterColumns(m.level);
+  if (lit >= meterHold || now - meterHoldMillis >= METER_HOLD_MS) {
+    meterHold = lit;
+    meterHoldMillis = now;
+  }
+  ui.setBar(UI_LEVEL_BAR, METER_X, LEVEL_Y, METER_W, LEVEL_H, lit, meterHold - 1,
+            COLOR_DARKGRAY, COLOR_GREEN);
+
+  if (m.tag < 0 || m.length == 0) {
+    ui.hide(UI_PLAYHEAD_BAR);
+  } else {
+    uint32_t played = m.played < m.length ? m.played : m.length;
+    ui.setBar(UI_PLAYHEAD_BAR, METER_X, PLAYHEAD_Y, METER_W, PLAYHEAD_H,
+              (int)((uint64_t)played * METER_W / m.length), -1, COLOR_DARKGRAY, COLOR_CYAN);
+  }
 }
 
 void drawSoundButtons() {
-  // Clear the button area
-  tft.fillRect(0, LIST_TOP, SCREEN_WIDTH, LIST_HEIGHT, COLOR_BLACK);
-  
-  if (soundCount == 0) {
+  int msgY = LIST_TOP + LIST_HEIGHT / 2 - 12;
+  if (!soundListReady) {
+    // The boot task is still mounting the card and loading the catalog
+    ui.setText(UI_EMPTY_MSG, 0, msgY - 8, SCREEN_WIDTH, 16,
+               "Loading sounds...", COLOR_WHITE, MC_DATUM, 2);
+    ui.hide(UI_EMPTY_HINT);
+    for (int i = 0; i < VISIBLE_BUTTONS; i++) ui.hide(UI_SOUND_BUTTON + i);
+    return;
+  }
+  if (catalog.count() == 0) {
     // Show error message
-    tft.setTextColor(COLOR_RED);
-    tft.setTextDatum(MC_DATUM);
-    tft.setTextSize(2);
-    if (!sdCardOk) {
-      tft.drawString("No SD Card", SCREEN_WIDTH / 2, LIST_TOP + LIST_HEIGHT / 2 - 12);
+    ui.setText(UI_EMPTY_MSG, 0, msgY - 8, SCREEN_WIDTH, 16,
+               sdCardOk ? "No sounds found" : "No SD Card", COLOR_RED, MC_DATUM, 2);
+    ui.setText(UI_EMPTY_HINT, 0, msgY + 24 - 4, SCREEN_WIDTH, 8,
+               "Insert SD with index.csv", COLOR_GRAY, MC_DATUM, 1);
+    for (int i = 0; i < VISIBLE_BUTTONS; i++) ui.hide(UI_SOUND_BUTTON + i);
+    return;
+  }
+  ui.hide(UI_EMPTY_MSG);
+  ui.hide(UI_EMPTY_HINT);
+
+  loadPage();
+  for (int i = 0; i < VISIBLE_BUTTONS; i++) {
+    if (pageSound[i] >= 0) {
+      drawSoundButton(pageSound[i]);
     } else {
-      tft.drawString("No sounds found", SCREEN_WIDTH / 2, LIST_TOP + LIST_HEIGHT / 2 - 12);
+      ui.hide(UI_SOUND_BUTTON + i);  // Past the end of the list
+    }
+  }
+  if (listView == VIEW_SEARCH && searchFirst == searchEnd) {
+    ui.setText(UI_EMPTY_MSG, 0, msgY - 8, SCREEN_WIDTH, 16, "No matches", COLOR_GRAY, MC_DATUM, 2);
+  }
+
+  prewarmVisibleSounds();
+}
+
+int pageRows() {
+  return listView == VIEW_SEARCH ? SEARCH_ROWS : VISIBLE_BUTTONS;
+}
+
+int listLength() {
+  if (listView == VIEW_SEARCH) return searchEnd - searchFirst;
+  return catalog.count();
+}
+
+// Resolve the sounds, titles and thumbnails of the current page: one
+// window prefetch in list order, one title-table read in A-Z order or
+// search (and a record read per thumbnail)
+void loadPage() {
+  int rows = pageRows();
+  for (int i = 0; i < VISIBLE_BUTTONS; i++) pageSound[i] = -1;
+
+  int pos = scrollOffset;
+  int row = 0;
+  if (listView == VIEW_LIST) {
+    catalog.prefetch(scrollOffset, rows);
+  }
+  for (; row < rows && pos < catalog.count() &&
+         (listView == VIEW_LIST || (listView == VIEW_AZ && pos < catalog.builtins()));
+       row++, pos++) {
+    const SoundEntry* sound = catalog.get(pos);
+    if (sound == nullptr) break;
+    pageSound[row] = pos;
+    snprintf(pageTitle[row], CATALOG_TITLE_LEN, "%s", sound->title);
+    pageThumb[row] = sound->thumb;
+  }
+  if (listView == VIEW_LIST) return;
+
+  // Title ranks: after the built-ins in A-Z order, from searchFirst in search
+  int rank = listView == VIEW_SEARCH ? searchFirst + pos : pos - catalog.builtins();
+  int want = min(rows - row, listLength() - pos);
+  CatalogTitle titles[VISIBLE_BUTTONS];
+  int got = want > 0 ? catalog.readTitles(rank, want, titles) : 0;
+  for (int i = 0; i < got; i++, row++) {
+    pageSound[row] = catalog.builtins() + titles[i].card;
+    memcpy(pageTitle[row], titles[i].title, CATALOG_TITLE_LEN);  // Same size, NUL kept
+    pageTitle[row][CATALOG_TITLE_LEN - 1] = '\0';
+    if (!showThumbnails || !catalog.readThumb(pageSound[row], pageThumb[row])) {
+      pageThumb[row].durationMs = 0;
     }
-    tft.setTextColor(COLOR_GRAY);
-    tft.setTextSize(1);
-    tft.drawString("Insert SD with index.csv", SCREEN_WIDTH / 2, LIST_TOP + LIST_HEIGHT / 2 + 12);
+  }
+}
+
+// Queue the WAV sounds on the current page for background decoding into
+// the PCM cache, so tapping them plays from RAM
+void prewarmVisibleSounds() {
+  for (int i = 0; i < VISIBLE_BUTTONS && pageSound[i] >= 0; i++) {
+    int index = pageSound[i];
+    SoundEntry sound;
+    if (!catalog.read(index, sound) || builtinPreset(sound.filename) != nullptr) continue;
+    char filepath[PCM_CACHE_PATH_LEN];
+    catalog.path(index, filepath, sizeof(filepath));
+    audio.requestCache(index, filepath, &sound.trim);
+  }
+}
+
+// Draw one sound button if it is on the current page (green while playing)
+void drawSoundButton(int index) {
+  if (ui.scrollViewActive()) {
+    ui.invalidateRows();  // Scrolling: which row holds it is not tracked
     return;
   }
-  
-  int y = LIST_TOP;
-  for (int i = 0; i < VISIBLE_BUTTONS && (scrollOffset + i) < soundCount; i++) {
-    int soundIndex = scrollOffset + i;
-    drawButton(BUTTON_X, y, BUTTON_WIDTH, BUTTON_HEIGHT, 
-               sounds[soundIndex].title, COLOR_BLUE, COLOR_WHITE);
-    y += BUTTON_HEIGHT + BUTTON_MARGIN;
+  for (int i = 0; i < pageRows(); i++) {
+    if (pageSound[i] != index) continue;
+    int y = LIST_TOP + i * (BUTTON_HEIGHT + BUTTON_MARGIN);
+    uint16_t bgColor = audio.isPlaying(index) ? COLOR_GREEN : COLOR_BLUE;
+    if (showThumbnails && pageThumb[i].durationMs > 0) {
+      char length[UI_DETAIL_LEN];
+      formatDuration(pageThumb[i].durationMs, length, sizeof(length));
+      ui.setWaveButton(UI_SOUND_BUTTON + i, BUTTON_X, y, BUTTON_WIDTH, BUTTON_HEIGHT,
+                       pageTitle[i], pageThumb[i].wave, length, bgColor, COLOR_WHITE);
+    } else {
+      drawButton(UI_SOUND_BUTTON + i, BUTTON_X, y, BUTTON_WIDTH, BUTTON_HEIGHT,
+                 pageTitle[i], bgColor, COLOR_WHITE);
+    }
+  }
+}
+
+// Length shown under a thumbnail: "4.2s", "42s", then "3:05"
+void formatDuration(uint32_t ms, char *dst, size_t len) {
+  if (ms < 10000) {
+    snprintf(dst, len, "%u.%us", ms / 1000, ms / 100 % 10);
+  } else if (ms < 60000) {
+    snprintf(dst, len, "%us", ms / 1000);
+  } else {
+    snprintf(dst, len, "%u:%02u", ms / 60000, ms / 1000 % 60);
   }
 }
 
 void drawScrollIndicators() {
   int y = SCROLL_Y;
+  int rows = pageRows();
   
   // Up arrow (enabled if we can scroll up)
   uint16_t upColor = (scrollOffset > 0) ? COLOR_GREEN : COLOR_DARKGRAY;
-  drawButton(SCROLL_UP_X, y, SCROLL_BTN_W, SCROLL_BTN_H, "^", upColor, COLOR_WHITE);
+  drawButton(UI_SCROLL_UP, SCROLL_UP_X, y, SCROLL_BTN_W, SCROLL_BTN_H, "^", upColor, COLOR_WHITE);
   
   // Down arrow (enabled if more items below)
-  bool canScrollDown = (scrollOffset + VISIBLE_BUTTONS) < soundCount;
+  int total = soundListReady ? listLength() : 0;
+  bool canScrollDown = (scrollOffset + rows) < total;
   uint16_t downColor = canScrollDown ? COLOR_GREEN : COLOR_DARKGRAY;
-  drawButton(SCROLL_DOWN_X, y, SCROLL_BTN_W, SCROLL_BTN_H, "v", downColor, COLOR_WHITE);
+  drawButton(UI_SCROLL_DOWN, SCROLL_DOWN_X, y, SCROLL_BTN_W, SCROLL_BTN_H, "v", downColor, COLOR_WHITE);
   
   // Page indicator
-  tft.setTextColor(COLOR_GRAY);
-  tft.setTextDatum(MC_DATUM);
-  tft.setTextSize(1);
-  char pageStr[16];
-  int currentPage = (scrollOffset / VISIBLE_BUTTONS) + 1;
-  int totalPages = ((soundCount - 1) / VISIBLE_BUTTONS) + 1;
-  snprintf(pageStr, sizeof(pageStr), "%d/%d", currentPage, totalPages);
-  tft.drawString(pageStr, SCREEN_WIDTH / 2, y + SCROLL_BTN_H / 2);
-}
-
-void drawButton(int x, int y, int w, int h, const char* label, uint16_t bgColor, uint16_t textColor) {
-  tft.fillRoundRect(x, y, w, h, 6, bgColor);
-  tft.drawRoundRect(x, y, w, h, 6, COLOR_WHITE);
-  
-  tft.setTextColor(textColor);
-  tft.setTextDatum(MC_DATUM);
-  tft.setTextSize(2);
-  tft.drawString(label, x + w/2, y + h/2);
+  char pageStr[24];  // Two ints and a slash
+  int currentPage = (scrollOffset + rows - 1) / rows + 1;
+  int totalPages = total > 0 ? ((total - 1) / rows) + 1 : 1;
+  snprintf(pageStr, sizeof(pageStr), "%d/%d", min(currentPage, totalPages), totalPages);
+  ui.setText(UI_PAGE, SCREEN_WIDTH / 2 - 20, y, 40, SCROLL_BTN_H, pageStr, COLOR_GRAY, MC_DATUM, 1);
+
+  // Order and search need card sounds (the title table)
+  if (!soundListReady || catalog.count() == catalog.builtins()) {
+    ui.hide(UI_LIST_ORDER);
+    ui.hide(UI_FIND);
+    ui.hide(UI_KEYS_TOP);
+    ui.hide(UI_KEYS_BOTTOM);
+    return;
+  }
+  if (listView == VIEW_SEARCH) {
+    drawButton(UI_LIST_ORDER, ORDER_BTN_X, y, MODE_BTN_W, SCROLL_BTN_H, "Del",
+               searchQuery[0] ? COLOR_ORANGE : COLOR_DARKGRAY, COLOR_WHITE);
+    drawButton(UI_FIND, FIND_BTN_X, y, MODE_BTN_W, SCROLL_BTN_H, "Done", COLOR_ORANGE, COLOR_WHITE);
+    ui.setKeys(UI_KEYS_TOP, KEYS_X, KEYPAD_Y, KEYS_W, KEYPAD_ROW_H - 2, KEYPAD_TOP,
+               COLOR_DARKGRAY, COLOR_WHITE, 2);
+    ui.setKeys(UI_KEYS_BOTTOM, KEYS_X, KEYPAD_Y + KEYPAD_ROW_H, KEYS_W, KEYPAD_ROW_H - 2,
+               KEYPAD_BOTTOM, COLOR_DARKGRAY, COLOR_WHITE, 2);
+    return;
+  }
+  drawButton(UI_LIST_ORDER, ORDER_BTN_X, y, MODE_BTN_W, SCROLL_BTN_H, "A-Z",
+             listView == VIEW_AZ ? COLOR_GREEN : COLOR_DARKGRAY, COLOR_WHITE);
+  drawButton(UI_FIND, FIND_BTN_X, y, MODE_BTN_W, SCROLL_BTN_H, "Find", COLOR_DARKGRAY, COLOR_WHITE);
+  if (listView == VIEW_AZ) {
+    ui.setKeys(UI_KEYS_TOP, KEYS_X, JUMP_BAR_Y, KEYS_W, JUMP_BAR_H, JUMP_LETTERS,
+               COLOR_DARKGRAY, COLOR_CYAN, 1);
+  } else {
+    ui.hide(UI_KEYS_TOP);
+  }
+  ui.hide(UI_KEYS_BOTTOM);
+}
+
+// Header, page and bottom row after a view change
+void drawList() {
+  drawHeader();
+  drawSoundButtons();
+  drawScrollIndicators();
+}
+
+// Sound at list position pos in the current view and its title, or -1
+int listSoundAt(int pos, char *title) {
+  if (pos < 0 || pos >= listLength()) return -1;
+  if (listView == VIEW_LIST || (listView == VIEW_AZ && pos < catalog.builtins())) {
+    const SoundEntry* sound = catalog.get(pos);
+    if (sound == nullptr) return -1;
+    snprintf(title, CATALOG_TITLE_LEN, "%s", sound->title);
+    return pos;
+  }
+  CatalogTitle t;
+  int rank = listView == VIEW_SEARCH ? searchFirst + pos : pos - catalog.builtins();
+  if (catalog.readTitles(rank, 1, &t) != 1) return -1;
+  snprintf(title, CATALOG_TITLE_LEN, "%s", t.title);
+  return catalog.builtins() + t.card;
+}
+
+// ===== DRAG SCROLLING =====
+// Row source of the scroll view: only rows newly exposed by a drag get here
+static bool listRow(int row, UiWidget &button) {
+  int index = listSoundAt(row, button.label);
+  if (index < 0) return false;
+  button.bg = audio.isPlaying(index) ? COLOR_GREEN : COLOR_BLUE;
+  button.fg = COLOR_WHITE;
+  WavThumb thumb;
+  if (showThumbnails && catalog.readThumb(index, thumb) && thumb.durationMs > 0) {
+    button.kind = UI_WAVE_BUTTON;
+    memcpy(button.wave, thumb.wave, sizeof(button.wave));
+    formatDuration(thumb.durationMs, button.detail, sizeof(button.detail));
+  }
+  return true;
+}
+
+static int maxListPos() {
+  return max(listLength() - pageRows(), 0) * ROW_PITCH;
+}
+
+#if LIST_DRAG_SCROLL
+static bool inList(int x, int y) {
+  return soundListReady && listLength() > 0 && x >= BUTTON_X && x < BUTTON_X + BUTTON_WIDTH &&
+         y >= LIST_TOP && y < LIST_TOP + pageRows() * ROW_PITCH;
+}
+#endif
+
+// The page's buttons become the scroll view at the same place
+bool startListScroll() {
+  listPos = scrollOffset * ROW_PITCH;
+  if (!ui.beginScrollView(BUTTON_X, LIST_TOP, BUTTON_WIDTH, pageRows() * ROW_PITCH - BUTTON_MARGIN,
+                          BUTTON_HEIGHT, ROW_PITCH, (int)listPos, listRow)) {
+    return false;
+  }
+  for (int i = 0; i < VISIBLE_BUTTONS; i++) ui.hide(UI_SOUND_BUTTON + i);
+  return true;
+}
+
+// Back to button widgets on the row the list settled on
+void finishListScroll() {
+  listFlinging = listDragging = false;
+  scrollOffset = constrain((int)lroundf(listPos / ROW_PITCH), 0, maxListPos() / ROW_PITCH);
+  ui.endScrollView();
+  drawSoundButtons();
+  drawScrollIndicators();
+  LOG_INFO("Scrolled to offset %d", scrollOffset);
+}
+
+// Presses on the list: a drag moves it with the finger, a release while
+// moving flings it, a release without a drag is a tap. Returns true if
+// the event was used.
+bool listTouch(const TouchEvent &event) {
+#if LIST_DRAG_SCROLL
+  switch (event.type) {
+    case TOUCH_DOWN:
+      if (!inList(event.x, event.y)) {
+        if (ui.scrollViewActive()) finishListScroll();  // Touching elsewhere stops a fling
+        return false;
+      }
+      listPressed = true;
+      pressX = event.x;
+      pressY = lastDragY = event.y;
+      pressMicros = event.micros;
+      lastDragMicros = event.micros;
+      flingSpeed = 0;
+      // Catching a fling holds the list where it is and drags from there
+      listDragging = listFlinging;
+      listFlinging = false;
+      pressPos = listPos;
+      return true;
+
+    case TOUCH_MOVE: {
+      if (!listPressed) return false;
+      if (!listDragging) {
+        if (abs(event.y - pressY) < DRAG_SLOP_PX) return true;
+        if (!startListScroll()) return true;
+        listDragging = true;
+        pressY = event.y;
+        pressPos = listPos;
+      }
+      float ms = (event.micros - lastDragMicros) / 1000.0f;
+      if (ms > 0) flingSpeed = 0.6f * (lastDragY - event.y) / ms + 0.4f * flingSpeed;
+      lastDragY = event.y;
+      lastDragMicros = event.micros;
+      listPos = constrain(pressPos + (pressY - event.y), 0.0f, (float)maxListPos());
+      return true;
+    }
+
+    case TOUCH_UP:
+      if (!listPressed) return false;
+      listPressed = false;
+      if (listDragging) {
+        listDragging = false;
+        if (event.micros - lastDragMicros > FLING_STALE_MS * 1000UL) flingSpeed = 0;
+        listFlinging = true;
+        flingMicros = micros();
+        return true;
+      }
+      if (millis() - lastTouchMillis >= TOUCH_DEBOUNCE_MS) {
+        // The tap's latency runs from the touch-down edge, so the press it
+        // waited out counts; the release read is the stage that ends it
+        latencyTrace.begin(TRACE_TOUCH_IRQ, pressMicros);
+        latencyTrace.markAt(TRACE_TOUCH_READ, event.micros);
+        tapMicros = pressMicros;
+        handleTouch(pressX, pressY);
+        tapMicros = 0;
+        lastTouchMillis = millis();
+      }
+      return true;
+  }
+#else
+  (void)event;
+#endif
+  return false;
+}
+
+// One scroll step per finished frame, at most one per UI_SCROLL_FRAME_MS:
+// follow the finger, or coast with decaying speed and then ease onto the
+// nearest row
+void stepListScroll() {
+  if (!ui.scrollViewActive() || !ui.idle() || !ui.scrollFrameDue()) return;
+  if (listFlinging) {
+    uint32_t now = micros();
+    float ms = (now - flingMicros) / 1000.0f;
+    flingMicros = now;
+    if (fabsf(flingSpeed) >= FLING_MIN_SPEED) {
+      listPos += flingSpeed * ms;
+      flingSpeed *= powf(FLING_DECAY, ms);
+      if (listPos <= 0 || listPos >= maxListPos()) {
+        listPos = constrain(listPos, 0.0f, (float)maxListPos());
+        flingSpeed = 0;
+      }
+    } else {
+      float target = constrain(lroundf(listPos / ROW_PITCH), 0L, (long)(maxListPos() / ROW_PITCH)) *
+                     (float)ROW_PITCH;
+      if (fabsf(target - listPos) <= 1.0f) {
+        listPos = target;
+        finishListScroll();
+        return;
+      }
+      listPos += (target - listPos) / 3;
+    }
+  }
+  ui.setScrollPos((int)lroundf(listPos));
+}
+
+// ===== SEARCH AND JUMP =====
+void setListView(ListView view) {
+  listView = view;
+  scrollOffset = 0;
+  jumpLetter = '\0';
+  drawList();
+  LOG_INFO("List view: %s", view == VIEW_AZ ? "A-Z" : view == VIEW_SEARCH ? "search" : "list");
+}
+
+void beginSearch() {
+  browseView = listView;
+  browseOffset = scrollOffset;
+  searchQuery[0] = '\0';
+  searchFirst = 0;
+  searchEnd = catalog.count() - catalog.builtins();
+  setListView(VIEW_SEARCH);
+}
+
+void endSearch() {
+  listView = browseView;
+  scrollOffset = browseOffset;
+  drawList();
+  LOG_INFO("Search done");
+}
+
+// A letter narrows the previous matches (they hold every longer match),
+// Del searches the whole title table again
+void typeSearchKey(char key) {
+  size_t len = strlen(searchQuery);
+  int lo = searchFirst, hi = searchEnd;
+  if (key == '\b') {
+    if (len == 0) return;
+    searchQuery[len - 1] = '\0';
+    lo = 0;
+    hi = catalog.count() - catalog.builtins();
+  } else {
+    if (len + 1 >= SEARCH_QUERY_LEN) return;
+    searchQuery[len] = key == '_' ? ' ' : key;
+    searchQuery[len + 1] = '\0';
+  }
+  catalog.findPrefix(searchQuery, lo, hi, searchFirst, searchEnd);
+  scrollOffset = 0;
+  drawList();
+  LOG_INFO("Find \"%s\": %d matches", searchQuery, searchEnd - searchFirst);
+}
+
+// Scroll the A-Z list to the first title at or after letter
+void jumpToLetter(char letter) {
+  if (letter == jumpLetter) return;  // Scrubbing within one key
+  jumpLetter = letter;
+  char prefix[2] = {letter, '\0'};
+  int first, end;
+  catalog.findPrefix(prefix, 0, catalog.count() - catalog.builtins(), first, end);
+  scrollOffset = min(catalog.builtins() + first, max(listLength() - VISIBLE_BUTTONS, 0));
+  drawSoundButtons();
+  drawScrollIndicators();
+  LOG_INFO("Jump to %c, offset: %d", letter, scrollOffset);
+}
+
+void drawButton(int id, int x, int y, int w, int h, const char* label, uint16_t bgColor, uint16_t textColor) {
+  ui.setButton(id, x, y, w, h, label, bgColor, textColor);
 }
 
 // ===== SD CARD FUNCTIONS =====
@@ -544,7 +1275,9 @@ bool initSDCard() {
   // Initialize SPI bus for SD card
   sdSPI.begin(SD_SCLK, SD_MISO, SD_MOSI, SD_CS);
   
-  if (!SD.begin(SD_CS, sdSPI)) {
+  // One file per mixer voice, plus the cache fill, trim analysis, catalog
+  // and index.csv
+  if (!SD.begin(SD_CS, sdSPI, 4000000, "/sd", MIXER_VOICES + 4)) {
     Serial.println("ERROR: SD card mount failed!");
     sdCardOk = false;
     return false;
@@ -569,313 +1302,372 @@ bool initSDCard() {
   return true;
 }
 
+// Open the catalog over index.csv; its index is rebuilt only when the CSV
+// changed since the last boot
 bool parseIndexCSV() {
   if (!sdCardOk) return false;
-  
-  File csvFile = SD.open("/index.csv", FILE_READ);
-  if (!csvFile) {
+  if (!SD.exists("/index.csv")) {
     Serial.println("ERROR: Could not open /index.csv");
     return false;
   }
-  
-  Serial.println("Parsing index.csv...");
-  // NOTE: Don't reset soundCount - beep is already at index 0
-  int startCount = soundCount;  // Remember how many we started with (beep)
-  bool headerSkipped = false;
-  
-  while (csvFile.available() && soundCount < MAX_SOUNDS) {
-    String line = csvFile.readStringUntil('\n');
-    line.trim();
-    
-    if (line.length() == 0) continue;
-    
-    // Skip header row
-    if (!headerSkipped) {
-      headerSkipped = true;
-      Serial.printf("  Header: %s\n", line.c_str());
-      continue;
-    }
-    
-    // Parse CSV line: filename,title
-    int commaPos = line.indexOf(',');
-    if (commaPos <= 0) {
-      Serial.printf("  Skipping invalid line: %s\n", line.c_str());
-      continue;
-    }
-    
-    String filename = line.substring(0, commaPos);
-    String title = line.substring(commaPos + 1);
-    filename.trim();
-    title.trim();
-    
-    // Store in sounds array
-    strncpy(sounds[soundCount].filename, filename.c_str(), sizeof(sounds[soundCount].filename) - 1);
-    sounds[soundCount].filename[sizeof(sounds[soundCount].filename) - 1] = '\0';
-    
-    strncpy(sounds[soundCount].title, title.c_str(), sizeof(sounds[soundCount].title) - 1);
-    sounds[soundCount].title[sizeof(sounds[soundCount].title) - 1] = '\0';
-    
-    Serial.printf("  [%d] %s -> %s\n", soundCount, sounds[soundCount].filename, sounds[soundCount].title);
-    soundCount++;
-  }
-  
-  csvFile.close();
-  
-  int loadedFromSD = soundCount - startCount;
-  if (loadedFromSD == 0) {
+
+  CatalogCsvSource source(SD, "/index.csv");
+  if (!catalog.open(SD, CATALOG_PATH, source)) {
     Serial.println("WARNING: No sounds found in index.csv (beep still available)");
     return false;
   }
-  
-  Serial.printf("Loaded %d sounds from SD card (total: %d with beep)\n", loadedFromSD, soundCount);
+
+  Serial.printf("Loaded %d sounds from SD card (total: %d with beep)\n",
+                catalog.count() - catalog.builtins(), catalog.count());
+  return true;
+}
+
+// Open the packed bank and a catalog over its table; all voices then read
+// from the bank's single open handle instead of opening WAV files per play
+bool loadSoundBank() {
+  if (!sdCardOk || !SD.exists(SOUND_BANK_PATH)) return false;
+  if (!soundBank.open(SD, SOUND_BANK_PATH)) return false;
+
+  if (soundBank.sampleRate() != AUDIO_SAMPLE_RATE) {
+    Serial.printf("WARNING: Bank rate %u Hz != output rate %d Hz (resampling on device)\n",
+                  soundBank.sampleRate(), AUDIO_SAMPLE_RATE);
+  }
+
+  for (int i = 0; i < MIXER_VOICES; i++) {
+    bankVoiceFiles[i].setBank(&soundBank);
+  }
+  bankCacheFillFile.setBank(&soundBank);
+
+  CatalogBankSource source(soundBank, SD, SOUND_BANK_PATH);
+  if (!catalog.open(SD, CATALOG_PATH, source)) return false;
+
+  Serial.printf("Loaded %d sounds from bank (total: %d with built-ins)\n",
+                catalog.count() - catalog.builtins(), catalog.count());
   return true;
 }
 
+// ===== SILENCE TRIM AND THUMBNAILS =====
+// Each loose WAV is analyzed once for its leading and trailing silence so
+// playback can start at the first audible sample and stop right after the
+// last one, and for the peak/RMS envelope and length its button thumbnail
+// is drawn from. Results are stored in the sound's catalog record with the
+// file size they were found for, so later boots only re-analyze files that
+// were added or replaced. The envelope reads the whole audible span, so it
+// is scanned WAV_ENVELOPE_STEP_FRAMES frames per loop() pass with the file
+// kept open in between. Bank sounds are trimmed and get their envelopes
+// from tools/build_bank.py and need no analysis.
+
+// One step per call: start the next sound that needs analysis (its trim
+// points, found at once), or scan more of the current one's envelope and
+// store both when it is done
+void analyzeNextSound() {
+  if (analysisIndex >= 0) {
+    uint32_t t0 = micros();
+    bool ok = envelope.step();
+    analysisMicros += micros() - t0;
+    analysisSteps++;
+    if (ok && !envelope.done()) return;
+
+    trimFile.close();
+    int index = analysisIndex;
+    analysisIndex = -1;
+    if (ok && catalog.setAnalysis(index, analysisTrim, envelope.thumb, analysisFileSize)) {
+      audio.invalidateCache(index);  // Head was decoded from the untrimmed start
+      LOG_INFO("Analyzed %s: frames %u-%u, %u ms (%u us in %u steps)", analysisName,
+               analysisTrim.startFrame, analysisTrim.endFrame, envelope.thumb.durationMs,
+               analysisMicros, analysisSteps);
+      for (int i = 0; i < VISIBLE_BUTTONS; i++) {
+        if (pageSound[i] == index) pageThumb[i] = envelope.thumb;
+      }
+      drawSoundButton(index);
+    }
+    if (trimNext == catalog.count()) prewarmVisibleSounds();  // Re-queue heads dropped above
+    return;
+  }
+  if (!sdCardOk || catalog.fromBank() || trimNext >= catalog.count()) return;
+
+  int index = trimNext++;
+  SoundEntry sound;  // Read past the window, so scanning does not page the UI's out
+  if (catalog.read(index, sound) && builtinPreset(sound.filename) == nullptr) {
+    char filepath[PCM_CACHE_PATH_LEN];
+    catalog.path(index, filepath, sizeof(filepath));
+
+    WavInfo info;
+    if (trimFile.open(filepath)) {
+      uint32_t size = trimFile.getSize();
+      if (sound.trim.endFrame == 0 || sound.trimFileSize != size) {
+        uint32_t t0 = micros();
+        if (parseWavHeader(&trimFile, info) && analyzeWavSilence(&trimFile, info, analysisTrim) &&
+            envelope.begin(&trimFile, info, analysisTrim)) {
+          analysisIndex = index;
+          analysisFileSize = size;
+          analysisMicros = micros() - t0;
+          analysisSteps = 0;
+          snprintf(analysisName, sizeof(analysisName), "%s", sound.filename);
+          return;  // The file stays open for the envelope steps
+        }
+      }
+      trimFile.close();
+    }
+  }
+
+  if (trimNext == catalog.count()) {
+    prewarmVisibleSounds();  // Re-queue heads dropped above
+  }
+}
+
 // ===== SOUND PLAYBACK =====
 
 // Add the beep as the first sound entry
 void addBeepSound() {
+  if (catalog.builtins() > 0) return;
+
   // Sound 0: Simple beep
-  strncpy(sounds[0].filename, "BEEP", sizeof(sounds[0].filename) - 1);
-  strncpy(sounds[0].title, "[Beep]", sizeof(sounds[0].title) - 1);
-  
+  catalog.addBuiltin("BEEP", "[Beep]");
+
   // Sound 1: Police siren
-  strncpy(sounds[1].filename, "SIREN", sizeof(sounds[1].filename) - 1);
-  strncpy(sounds[1].title, "[Siren]", sizeof(sounds[1].title) - 1);
-  
+  catalog.addBuiltin("SIREN", "[Siren]");
+
   // Sound 2: Success chime
-  strncpy(sounds[2].filename, "CHIME", sizeof(sounds[2].filename) - 1);
-  strncpy(sounds[2].title, "[Chime]", sizeof(sounds[2].title) - 1);
-  
+  catalog.addBuiltin("CHIME", "[Chime]");
+
   // Sound 3: Laser zap
-  strncpy(sounds[3].filename, "LASER", sizeof(sounds[3].filename) - 1);
-  strncpy(sounds[3].title, "[Laser]", sizeof(sounds[3].title) - 1);
-  
-  soundCount = NUM_BUILTIN_SOUNDS;
+  catalog.addBuiltin("LASER", "[Laser]");
+
   Serial.printf("Added %d built-in sounds\n", NUM_BUILTIN_SOUNDS);
 }
 
-// Helper: Play a tone at specified frequency and duration
-void playTone(int freqHz, int durationMs, int vol) {
-  if (freqHz <= 0 || vol <= 0) return;
-  
-  int amplitude = map(vol, 0, MAX_VOLUME, 0, 127);
-  int halfPeriodUs = 500000 / freqHz;  // Half period in microseconds
-  
-  unsigned long startTime = millis();
-  while (millis() - startTime < (unsigned long)durationMs) {
-    dacWrite(SPEAKER_DAC_PIN, 128 + amplitude);
-    delayMicroseconds(halfPeriodUs);
-    dacWrite(SPEAKER_DAC_PIN, 128 - amplitude);
-    delayMicroseconds(halfPeriodUs);
-  }
+// Volume 0-10 -> Q15 master gain; applies to sounds already playing too
+void applyVolume() {
+  audio.setVolume((uint32_t)volume * MIXER_UNITY_GAIN / MAX_VOLUME);
 }
 
-// Play a simple beep
-void playBeep() {
-  Serial.printf("Playing beep at volume %d\n", volume);
-  playTone(1000, 200, volume);
-  dacWrite(SPEAKER_DAC_PIN, 128);  // Silence
+// Built-in sounds are identified by their filename; returns nullptr for WAVs
+const SynthPreset* builtinPreset(const char* filename) {
+  if (strcmp(filename, "BEEP") == 0) return &SYNTH_PRESET_BEEP;
+  if (strcmp(filename, "SIREN") == 0) return &SYNTH_PRESET_SIREN;
+  if (strcmp(filename, "CHIME") == 0) return &SYNTH_PRESET_CHIME;
+  if (strcmp(filename, "LASER") == 0) return &SYNTH_PRESET_LASER;
+  return nullptr;
 }
 
-// Play a police siren (rising and falling)
-void playSiren() {
-  Serial.printf("Playing siren at volume %d\n", volume);
-  
-  // Two cycles of rising/falling siren
-  for (int cycle = 0; cycle < 2; cycle++) {
-    // Rising: 400Hz -> 800Hz
-    for (int freq = 400; freq <= 800; freq += 20) {
-      playTone(freq, 15, volume);
-    }
-    // Falling: 800Hz -> 400Hz
-    for (int freq = 800; freq >= 400; freq -= 20) {
-      playTone(freq, 15, volume);
-    }
+void playSound(int index) {
+  SoundEntry entry;
+  if (!catalog.read(index, entry)) return;
+  const SoundEntry* sound = &entry;
+  if (tapMicros != 0) touch.recordLatency(micros() - tapMicros);
+  latencyTrace.beginIfIdle(TRACE_PLAY_SOUND);  // Played from the serial console
+  latencyTrace.mark(TRACE_PLAY_SOUND);
+
+  const char* filename = sound->filename;
+  const SynthPreset* preset = builtinPreset(filename);
+
+  bool posted;
+  if (preset != nullptr) {
+    LOG_INFO("Playing %s at volume %d", preset->name, volume);
+    posted = audio.playSynth(index, preset, MIXER_UNITY_GAIN);
+  } else {
+    // Stream WAV file from SD card (non-blocking, mixed with other voices)
+    char filepath[PCM_CACHE_PATH_LEN];
+    catalog.path(index, filepath, sizeof(filepath));
+    LOG_INFO("Playing: %s (%s) at volume %d", sound->title, filename, volume);
+    posted = audio.playFile(index, filepath, MIXER_UNITY_GAIN, &sound->trim);
   }
-  dacWrite(SPEAKER_DAC_PIN, 128);  // Silence
-}
 
-// Play a success chime (ascending melody)
-void playChime() {
-  Serial.printf("Playing chime at volume %d\n", volume);
-  
-  // C-E-G-C (major arpeggio) - musical success sound
-  int notes[] = {523, 659, 784, 1047};  // C5, E5, G5, C6
-  int durations[] = {100, 100, 100, 250};
-  
-  for (int i = 0; i < 4; i++) {
-    playTone(notes[i], durations[i], volume);
-    delay(30);  // Small gap between notes
+  if (!posted) {
+    LOG_WARN("Playback failed: audio command queue full");
+    return;
   }
-  dacWrite(SPEAKER_DAC_PIN, 128);  // Silence
-}
 
-// Play a laser zap (descending sweep)
-void playLaser() {
-  Serial.printf("Playing laser at volume %d\n", volume);
-  
-  // Quick descending sweep from high to low
-  for (int freq = 2000; freq >= 200; freq -= 50) {
-    playTone(freq, 8, volume);
-  }
-  dacWrite(SPEAKER_DAC_PIN, 128);  // Silence
+  // The button turns green when the audio task reports the voice started
+  audioPlaying = true;
 }
 
-// Play a WAV file from SD card using ESP8266Audio library
-bool playWavFile(const char* filename) {
-  char filepath[32];
-  snprintf(filepath, sizeof(filepath), "/%s", filename);
+// Append a sound to the gapless sequence: it starts `gap` output samples
+// after the sounds queued before it have played, or now if none are
+bool queueSound(int index, uint32_t gap) {
+  SoundEntry entry;
+  if (!catalog.read(index, entry)) return false;
+  const SynthPreset* preset = builtinPreset(entry.filename);
 
-  Serial.printf("Opening WAV file: %s\n", filepath);
-
-  // Stop any currently playing audio
-  if (wav != nullptr && wav->isRunning()) {
-    wav->stop();
+  bool posted;
+  if (preset != nullptr) {
+    posted = audio.queueSynth(index, preset, MIXER_UNITY_GAIN, gap);
+  } else {
+    char filepath[PCM_CACHE_PATH_LEN];
+    catalog.path(index, filepath, sizeof(filepath));
+    posted = audio.queueFile(index, filepath, MIXER_UNITY_GAIN, &entry.trim, gap);
   }
-
-  // Clean up previous file source
-  if (file != nullptr) {
-    delete file;
-    file = nullptr;
+  if (!posted) {
+    LOG_WARN("Queue failed: audio command queue full");
+    return false;
   }
+  LOG_INFO("Queued: %s (gap %u samples)", entry.title, gap);
+  audioPlaying = true;
+  return true;
+}
 
-  // Clean up previous generator
-  if (wav != nullptr) {
-    delete wav;
-    wav = nullptr;
+// ===== SERIAL CONSOLE =====
+// Single-character diagnostic commands and remote-control frames on the
+// USB serial port. Bytes are taken as they arrive, at most
+// SERIAL_BYTES_PER_LOOP per pass (more than 115200 baud delivers in one).
+void handleSerialCommand() {
+  if (Serial.available() <= 0) return;
+  powerGovernor.activity();  // Full clock before a command runs
+  for (int n = 0; n < SERIAL_BYTES_PER_LOOP && Serial.available(); n++) {
+    int c = Serial.read();
+    if (c < 0) break;
+    if (!remoteLink.feed(c)) runConsoleCommand(c);
   }
+}
 
-  // Create new file source
-  file = new AudioFileSourceSD(filepath);
-  if (!file->isOpen()) {
-    Serial.printf("ERROR: Could not open %s\n", filepath);
-    delete file;
-    file = nullptr;
-    return false;
+void runConsoleCommand(int c) {
+  switch (c) {
+    case 'b':
+      audio.runBenchmark();
+      break;
+    case 'c':
+      pcmCache.printStats();
+      break;
+    case 'a':
+      audio.printStats();
+      break;
+    case 's':
+      AudioFileSourceReadAhead::printStats();
+      break;
+    case 'g':
+      powerGovernor.printStats();
+      break;
+    case 'h':
+      latencyTrace.printHistograms();
+      break;
+    case 'i':
+      if (soundListReady) catalog.printStats();
+      break;
+    case 'l':
+      eventLog.printStats();
+      break;
+    case 'm':
+      heapStats.printStats();
+      break;
+    case 'p':
+      bootProfile.printTimeline();
+      break;
+    case 'q':
+      mixer.printSequenceStats();
+      break;
+    case 'r':
+      remoteLink.printStats();
+      break;
+    case 't':
+      touch.printStats();
+      break;
+    case 'w':
+      showThumbnails = !showThumbnails;
+      Serial.printf("Waveform thumbnails %s\n", showThumbnails ? "on" : "off");
+      if (ui.scrollViewActive()) ui.invalidateRows();
+      else drawSoundButtons();
+      break;
+    case 'u':
+      // Stats, a highlight-sized redraw both ways, and per-frame logging on/off
+      ui.printStats();
+      ui.benchmark(soundListReady && catalog.count() > 0 ? UI_SOUND_BUTTON : UI_VOL_MINUS);
+      ui.setFrameLog(!ui.frameLogEnabled());
+      Serial.printf("UI frame log %s\n", ui.frameLogEnabled() ? "on" : "off");
+      break;
+    case '?':
+      Serial.println("Commands: a = audio task stats, b = mixer benchmark, c = PCM cache stats, "
+                     "g = power stats, h = tap latency histograms, i = catalog stats, "
+                     "l = event log stats, m = heap stats, p = boot timeline, q = sequence gaps, "
+                     "r = remote control stats, s = SD read stats, t = touch stats, "
+                     "u = UI render stats, w = waveform thumbnails on/off");
+      break;
+    default:
+      break;
   }
+}
 
-  // Read WAV header to calculate early stop position (0.5 seconds before end)
-  // WAV header structure: bytes 24-27 = sample rate, 34-35 = bits per sample
-  // bytes 22-23 = number of channels
-  uint8_t header[44];
-  file->read(header, 44);
-  file->seek(0, SEEK_SET);  // Reset to beginning for playback
-
-  uint32_t sampleRate = header[24] | (header[25] << 8) | (header[26] << 16) | (header[27] << 24);
-  uint16_t numChannels = header[22] | (header[23] << 8);
-  uint16_t bitsPerSample = header[34] | (header[35] << 8);
-  uint32_t fileSize = file->getSize();
-
-  // Calculate bytes per second: sampleRate * numChannels * (bitsPerSample / 8)
-  uint32_t bytesPerSecond = sampleRate * numChannels * (bitsPerSample / 8);
-
-  // Calculate position to stop (0.5 seconds = 500ms before end)
-  uint32_t cutoffBytes = bytesPerSecond / 2;  // 0.5 seconds worth of bytes
-
-  if (fileSize > cutoffBytes + 44) {  // Ensure we don't underflow (44 = header size)
-    wavStopPosition = fileSize - cutoffBytes;
-  } else {
-    wavStopPosition = 0;  // File too short, play whole thing
-  }
+// ===== POWER HOOKS =====
+// PowerGovernor's hardware: the clock, CPU frequency, backlight PWM and
+// light sleep woken by the touch interrupt line or a timer
+uint32_t powerClock() {
+  return micros();
+}
 
-  Serial.printf("WAV: %d Hz, %d ch, %d bit, stop at %d/%d bytes\n",
-                sampleRate, numChannels, bitsPerSample, wavStopPosition, fileSize);
+void powerSetCpu(uint32_t mhz) {
+  setCpuFrequencyMhz(mhz);
+}
 
-  // Set volume based on current volume setting (0-10 -> 0.0-1.0 gain)
-  float gain = (float)volume / (float)MAX_VOLUME;
-  out->SetGain(gain);
+void powerSetBacklight(uint8_t duty) {
+  ledcWrite(BACKLIGHT_LEDC_CHANNEL, duty);
+}
 
-  // Create WAV generator and start playback
-  wav = new AudioGeneratorWAV();
-  if (!wav->begin(file, out)) {
-    Serial.println("ERROR: Could not start WAV playback");
-    delete wav;
-    wav = nullptr;
-    delete file;
-    file = nullptr;
-    return false;
+uint8_t powerLightSleep(uint32_t maxMs) {
+  Serial.flush();  // The UART stops while asleep
+  // Wake on the line's level; its edge interrupt stays off meanwhile, or
+  // the level would keep firing it before the sleep starts
+  gpio_num_t pin = (gpio_num_t)TOUCH_IRQ_PIN;
+  gpio_intr_disable(pin);
+  gpio_wakeup_enable(pin, GPIO_INTR_LOW_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+  esp_sleep_enable_timer_wakeup((uint64_t)maxMs * 1000);
+  esp_light_sleep_start();
+  uint32_t woke = micros();
+  esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+  gpio_wakeup_disable(pin);
+  gpio_set_intr_type(pin, GPIO_INTR_NEGEDGE);
+  gpio_intr_enable(pin);
+
+  if (cause == ESP_SLEEP_WAKEUP_GPIO) {
+    touch.wake(woke);
+    return POWER_WAKE_TOUCH;
   }
+  return cause == ESP_SLEEP_WAKEUP_TIMER ? POWER_WAKE_TIMER : POWER_WAKE_OTHER;
+}
 
-  audioPlaying = true;
-  Serial.println("WAV playback started");
+// ===== SERIAL REMOTE =====
+// RemoteLink handlers; the catalog is loop()'s once the list is up
+bool remotePlay(int index) {
+  if (!soundListReady || index >= catalog.count()) return false;
+  playSound(index);
   return true;
 }
 
-// Reset the currently playing button back to normal color
-void resetPlayingButton() {
-  if (currentlyPlayingIndex >= 0 && currentlyPlayingIndex < soundCount) {
-    int visibleIndex = currentlyPlayingIndex - scrollOffset;
-    if (visibleIndex >= 0 && visibleIndex < VISIBLE_BUTTONS) {
-      int y = LIST_TOP + visibleIndex * (BUTTON_HEIGHT + BUTTON_MARGIN);
-      drawButton(BUTTON_X, y, BUTTON_WIDTH, BUTTON_HEIGHT,
-                 sounds[currentlyPlayingIndex].title, COLOR_BLUE, COLOR_WHITE);
-    }
-    currentlyPlayingIndex = -1;
+void remoteStop(int index) {
+  if (index == REMOTE_ALL_SOUNDS) {
+    audio.stopAll();
+  } else {
+    audio.stop(index);
   }
 }
 
-void playSound(int index) {
-  if (index < 0 || index >= soundCount) return;
-
-  // Reset any previously playing button
-  resetPlayingButton();
-
-  // Visual feedback - highlight the button
-  int visibleIndex = index - scrollOffset;
-  if (visibleIndex >= 0 && visibleIndex < VISIBLE_BUTTONS) {
-    int y = LIST_TOP + visibleIndex * (BUTTON_HEIGHT + BUTTON_MARGIN);
-    drawButton(BUTTON_X, y, BUTTON_WIDTH, BUTTON_HEIGHT,
-               sounds[index].title, COLOR_GREEN, COLOR_WHITE);
-  }
-
-  // Check for built-in sounds by filename
-  const char* filename = sounds[index].filename;
-  bool isBuiltIn = false;
-
-  if (strcmp(filename, "BEEP") == 0) {
-    playBeep();
-    isBuiltIn = true;
-  } else if (strcmp(filename, "SIREN") == 0) {
-    playSiren();
-    isBuiltIn = true;
-  } else if (strcmp(filename, "CHIME") == 0) {
-    playChime();
-    isBuiltIn = true;
-  } else if (strcmp(filename, "LASER") == 0) {
-    playLaser();
-    isBuiltIn = true;
-  } else {
-    // Play WAV file from SD card (non-blocking)
-    Serial.printf("Playing: %s (%s) at volume %d\n",
-                  sounds[index].title, filename, volume);
-    if (playWavFile(filename)) {
-      // Track which button is playing for later reset
-      currentlyPlayingIndex = index;
-    } else {
-      Serial.println("WAV playback failed!");
-    }
-  }
+void remoteVolume(int level) {
+  volume = constrain(level, 0, MAX_VOLUME);
+  applyVolume();
+  drawVolumeControls();
+  LOG_INFO("Volume: %d (remote)", volume);
+}
 
-  // For built-in sounds (blocking), reset button immediately
-  if (isBuiltIn) {
-    if (visibleIndex >= 0 && visibleIndex < VISIBLE_BUTTONS) {
-      int y = LIST_TOP + visibleIndex * (BUTTON_HEIGHT + BUTTON_MARGIN);
-      drawButton(BUTTON_X, y, BUTTON_WIDTH, BUTTON_HEIGHT,
-                 sounds[index].title, COLOR_BLUE, COLOR_WHITE);
-    }
-  }
+void remoteStatus(RemoteStatus &status) {
+  status.volume = volume;
+  status.voices = audio.voicesPlaying();
+  status.sounds = soundListReady ? catalog.count() : 0;
+}
+
+bool remoteQueue(int index, uint32_t gap) {
+  if (!soundListReady || index >= catalog.count()) return false;
+  return queueSound(index, gap);
 }
 
 // ===== TOUCH DETECTION =====
 int getTouchedButton(int touchX, int touchY) {
   // Check if touch is in the button list area
   if (touchY >= LIST_TOP && touchY < LIST_TOP + LIST_HEIGHT) {
-    for (int i = 0; i < VISIBLE_BUTTONS && (scrollOffset + i) < soundCount; i++) {
+    for (int i = 0; i < pageRows() && pageSound[i] >= 0; i++) {
       int btnY = LIST_TOP + i * (BUTTON_HEIGHT + BUTTON_MARGIN);
       if (touchX >= BUTTON_X && touchX <= BUTTON_X + BUTTON_WIDTH &&
           touchY >= btnY && touchY <= btnY + BUTTON_HEIGHT) {
-        return scrollOffset + i;
+        return pageSound[i];
       }
     }
   }
@@ -884,13 +1676,16 @@ int getTouchedButton(int touchX, int touchY) {
 
 // ===== TOUCH HANDLER =====
 void handleTouch(int touchX, int touchY) {
+  latencyTrace.mark(TRACE_HANDLE_TOUCH);
+
   // Check volume minus
   if (touchX >= VOL_MINUS_X && touchX <= VOL_MINUS_X + VOL_BTN_SIZE &&
       touchY >= VOL_BTN_Y && touchY <= VOL_BTN_Y + VOL_BTN_SIZE) {
     if (volume > 0) {
       volume--;
+      applyVolume();
       drawVolumeControls();
-      Serial.printf("Volume: %d\n", volume);
+      LOG_INFO("Volume: %d", volume);
     }
     return;
   }
@@ -900,21 +1695,53 @@ void handleTouch(int touchX, int touchY) {
       touchY >= VOL_BTN_Y && touchY <= VOL_BTN_Y + VOL_BTN_SIZE) {
     if (volume < MAX_VOLUME) {
       volume++;
+      applyVolume();
       drawVolumeControls();
-      Serial.printf("Volume: %d\n", volume);
+      LOG_INFO("Volume: %d", volume);
     }
     return;
   }
   
+  // The list is not up while the boot task loads it
+  if (!soundListReady) return;
+
+  // Letter strips: the jump bar (also scrubbed, see loop()) or the keypad
+  char key = ui.keyAt(UI_KEYS_TOP, touchX, touchY);
+  if (key == '\0') key = ui.keyAt(UI_KEYS_BOTTOM, touchX, touchY);
+  if (key != '\0') {
+    if (listView == VIEW_SEARCH) {
+      typeSearchKey(key);
+    } else {
+      jumpScrub = true;
+      jumpLetter = '\0';
+      jumpToLetter(key);
+    }
+    return;
+  }
+
+  // Check list order / search delete
+  if (ui.widgetAt(touchX, touchY) == UI_LIST_ORDER) {
+    if (listView == VIEW_SEARCH) typeSearchKey('\b');
+    else setListView(listView == VIEW_AZ ? VIEW_LIST : VIEW_AZ);
+    return;
+  }
+
+  // Check find / done
+  if (ui.widgetAt(touchX, touchY) == UI_FIND) {
+    if (listView == VIEW_SEARCH) endSearch();
+    else beginSearch();
+    return;
+  }
+
   // Check scroll up
   if (touchX >= SCROLL_UP_X && touchX <= SCROLL_UP_X + SCROLL_BTN_W &&
       touchY >= SCROLL_Y && touchY <= SCROLL_Y + SCROLL_BTN_H) {
     if (scrollOffset > 0) {
-      scrollOffset -= VISIBLE_BUTTONS;
+      scrollOffset -= pageRows();
       if (scrollOffset < 0) scrollOffset = 0;
       drawSoundButtons();
       drawScrollIndicators();
-      Serial.printf("Scroll up, offset: %d\n", scrollOffset);
+      LOG_INFO("Scroll up, offset: %d", scrollOffset);
     }
     return;
   }
@@ -922,11 +1749,11 @@ void handleTouch(int touchX, int touchY) {
   // Check scroll down
   if (touchX >= SCROLL_DOWN_X && touchX <= SCROLL_DOWN_X + SCROLL_BTN_W &&
       touchY >= SCROLL_Y && touchY <= SCROLL_Y + SCROLL_BTN_H) {
-    if (scrollOffset + VISIBLE_BUTTONS < soundCount) {
-      scrollOffset += VISIBLE_BUTTONS;
+    if (scrollOffset + pageRows() < listLength()) {
+      scrollOffset += pageRows();
       drawSoundButtons();
       drawScrollIndicators();
-      Serial.printf("Scroll down, offset: %d\n", scrollOffset);
+      LOG_INFO("Scroll down, offset: %d", scrollOffset);
     }
     return;
   }
@@ -938,5 +1765,5 @@ void handleTouch(int touchX, int touchY) {
     return;
   }
   
-  Serial.printf("Touch at (%d, %d) - no action\n", touchX, touchY);
+  LOG_DEBUG("Touch at (%d, %d) - no action", touchX, touchY);
 }
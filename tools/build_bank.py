@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+"""Compile index.csv and its WAV files into a single playback-ready sound bank.
+
+The bank holds every sound already downmixed to mono and resampled to the
+device output rate (16-bit signed PCM), so the board can play it straight
+from one open file handle without per-play opens or format conversion.
+Leading and trailing silence is trimmed here with the same threshold and
+margins the firmware uses for loose WAV files (src/WavParser.h), and each
+sound's button thumbnail envelope is computed here, as the firmware's idle
+analysis pass does for loose WAVs.
+
+Layout (little endian):
+
+  0x000  header, one 512-byte sector
+           char[4]  magic "SBNK"
+           u16      version (2)
+           u16      entry count
+           u32      sample rate
+           u16      bits per sample (16)
+           u16      channels (1)
+           u32      entry table offset
+           u32      string table offset
+           u32      string table size
+  ...    entry table, BANK_ENTRY_SIZE bytes per sound
+           u32      data offset (multiple of 512)
+           u32      data size in bytes
+           u32      title offset (into string table)
+           u16      title length
+           u16      flags (reserved)
+           char[16] source filename, NUL padded
+           u8[32]   thumbnail: per column, peak level << 4 | RMS level
+                    (0..15, 3 dB steps, 15 at full scale); not in version 1
+  ...    string table: NUL-terminated UTF-8 titles
+  ...    sample data, each sound starting on a 512-byte boundary
+
+Usage:
+  python3 tools/build_bank.py wavs -o sounds.bnk [--rate 22050] [--no-trim]
+
+Copy the resulting sounds.bnk to the root of the SD card next to index.csv.
+"""
+
+import argparse
+import csv
+import math
+import os
+import struct
+import sys
+from array import array
+
+SECTOR = 512
+BANK_VERSION = 2
+ENTRY_SIZE = 64
+HEADER_FMT = "<4sHHIHHIII"
+ENTRY_FMT = "<IIIHH16s32s"
+FILTER_TAPS = 32      # Taps per polyphase branch
+FILTER_PHASES = 64    # Fractional positions per input sample
+SILENCE_THRESHOLD = 256 / 32768.0   # WAV_SILENCE_THRESHOLD
+TRIM_PREROLL_MS = 5                 # WAV_TRIM_PREROLL_MS
+TRIM_TAIL_MS = 30                   # WAV_TRIM_TAIL_MS
+THUMB_COLUMNS = 32                  # WAV_THUMB_COLUMNS
+THUMB_DB_STEP = 3                   # WAV_THUMB_DB_STEP
+
+
+def read_wav(path):
+    """Return (sample_rate, mono samples as floats in [-1, 1))."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[0:4] != b"RIFF" or data[8:12] != b"WAVE":
+        raise ValueError("not a RIFF/WAVE file")
+
+    pos = 12
+    fmt = None
+    while pos + 8 <= len(data):
+        cid, size = struct.unpack_from("<4sI", data, pos)
+        pos += 8
+        if cid == b"fmt ":
+            tag, channels, rate, _, align, bits = struct.unpack_from("<HHIIHH", data, pos)
+            if tag == 0xFFFE and size >= 26:
+                tag = struct.unpack_from("<H", data, pos + 24)[0]
+            fmt = (tag, channels, rate, align, bits)
+        elif cid == b"data":
+            if fmt is None:
+                raise ValueError("data chunk before fmt chunk")
+            body = data[pos:pos + size]
+            break
+        pos += size + (size & 1)
+    else:
+        raise ValueError("no data chunk")
+
+    tag, channels, rate, align, bits = fmt
+    if tag != 1 or bits not in (8, 16, 24):
+        raise ValueError("unsupported format tag %d, %d bits" % (tag, bits))
+
+    width = bits // 8
+    frames = len(body) // align
+    if bits == 8:
+        raw = [(b - 128) / 128.0 for b in body[:frames * align]]
+    elif bits == 16:
+        a = array("h")
+        a.frombytes(body[:frames * align])
+        if sys.byteorder != "little":
+            a.byteswap()
+        raw = [s / 32768.0 for s in a]
+    else:
+        raw = [int.from_bytes(body[i:i + 3], "little", signed=True) / 8388608.0
+               for i in range(0, frames * align, width)]
+
+    if channels == 1:
+        return rate, raw
+    return rate, [sum(raw[i:i + channels]) / channels
+                  for i in range(0, len(raw), channels)]
+
+
+def trim_silence(samples, rate):
+    """Cut leading/trailing silence, keeping the firmware's margins."""
+    first = next((i for i, s in enumerate(samples) if abs(s) >= SILENCE_THRESHOLD), None)
+    if first is None:
+        return samples[:1]
+    last = next(i for i in range(len(samples) - 1, first - 1, -1)
+                if abs(samples[i]) >= SILENCE_THRESHOLD)
+    start = max(0, first - rate * TRIM_PREROLL_MS // 1000)
+    end = min(len(samples), last + 1 + rate * TRIM_TAIL_MS // 1000)
+    return samples[start:end]
+
+
+def thumb_level(magnitude):
+    """wavThumbLevel(): 0..15 on a 3 dB scale, 15 at full scale."""
+    if magnitude <= 0:
+        return 0
+    db = 20 * math.log10(magnitude / 32768.0)
+    return max(0, min(15, 15 + math.floor(db / THUMB_DB_STEP + 0.5)))
+
+
+def thumbnail(pcm):
+    """Peak and RMS level per column of 16-bit PCM, as src/WavParser.cpp."""
+    a = array("h")
+    a.frombytes(pcm)
+    if sys.byteorder != "little":
+        a.byteswap()
+    wave = bytearray(THUMB_COLUMNS)
+    for c in range(THUMB_COLUMNS):
+        column = a[c * len(a) // THUMB_COLUMNS:(c + 1) * len(a) // THUMB_COLUMNS]
+        if column:
+            peak = max(abs(s) for s in column)
+            rms = math.sqrt(sum(s * s for s in column) / len(column))
+            wave[c] = thumb_level(peak) << 4 | thumb_level(int(rms))
+    return bytes(wave)
+
+
+def make_filter(ratio):
+    """Windowed-sinc polyphase table; cutoff below the lower Nyquist."""
+    cutoff = 0.45 * min(1.0, ratio)
+    half = FILTER_TAPS // 2
+    table = []
+    for p in range(FILTER_PHASES):
+        frac = p / FILTER_PHASES
+        taps = []
+        for k in range(FILTER_TAPS):
+            x = k - half + 1 - frac
+            sinc = 2 * cutoff * (math.sin(2 * math.pi * cutoff * x) / (2 * math.pi * cutoff * x)
+                                 if x != 0 else 1.0)
+            window = 0.42 + 0.5 * math.cos(math.pi * x / half) + 0.08 * math.cos(2 * math.pi * x / half)
+            taps.append(sinc * window if abs(x) < half else 0.0)
+        gain = sum(taps)
+        table.append([t / gain for t in taps])
+    return table
+
+
+def resample(samples, in_rate, out_rate):
+    if in_rate == out_rate:
+        return samples
+    table = make_filter(out_rate / in_rate)
+    half = FILTER_TAPS // 2
+    padded = [0.0] * half + samples + [0.0] * FILTER_TAPS
+    step = in_rate / out_rate
+    out = []
+    n_out = int(len(samples) / step)
+    for n in range(n_out):
+        t = n * step
+        i = int(t)
+        taps = table[int((t - i) * FILTER_PHASES)]
+        window = padded[i + 1:i + 1 + FILTER_TAPS]
+        out.append(sum(map(float.__mul__, taps, window)))
+    return out
+
+
+def to_pcm16(samples):
+    a = array("h", (max(-32768, min(32767, int(round(s * 32767)))) for s in samples))
+    if sys.byteorder != "little":
+        a.byteswap()
+    return a.tobytes()
+
+
+def align(n):
+    return (n + SECTOR - 1) // SECTOR * SECTOR
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("folder", help="folder containing index.csv and the WAV files")
+    parser.add_argument("-o", "--output", default="sounds.bnk")
+    parser.add_argument("--rate", type=int, default=22050,
+                        help="device output rate (must match AUDIO_SAMPLE_RATE)")
+    parser.add_argument("--no-trim", action="store_true",
+                        help="keep leading and trailing silence")
+    args = parser.parse_args()
+
+    with open(os.path.join(args.folder, "index.csv"), newline="", encoding="utf-8") as f:
+        rows = [r for r in csv.reader(f) if r and r[0].strip()]
+    rows = rows[1:]  # Header row
+
+    entries = []
+    for row in rows:
+        filename, title = row[0].strip(), ",".join(row[1:]).strip()
+        if len(filename.encode()) > 15:
+            sys.exit("%s: filename longer than 15 bytes" % filename)
+        rate, mono = read_wav(os.path.join(args.folder, filename))
+        if not args.no_trim:
+            mono = trim_silence(mono, rate)
+        pcm = to_pcm16(resample(mono, rate, args.rate))
+        entries.append((filename, title, pcm))
+        print("  %-10s %-28s %6.2f s  %7d -> %7d bytes" % (
+            filename, title, len(pcm) / 2 / args.rate,
+            os.path.getsize(os.path.join(args.folder, filename)), len(pcm)))
+
+    strings = bytearray()
+    title_offsets = []
+    for _, title, _ in entries:
+        title_offsets.append(len(strings))
+        strings += title.encode() + b"\0"
+
+    table_offset = SECTOR
+    strings_offset = table_offset + ENTRY_SIZE * len(entries)
+    data_offset = align(strings_offset + len(strings))
+
+    header = struct.pack(HEADER_FMT, b"SBNK", BANK_VERSION, len(entries), args.rate, 16, 1,
+                         table_offset, strings_offset, len(strings))
+    out = bytearray(header.ljust(SECTOR, b"\0"))
+    offsets = []
+    for _, _, pcm in entries:
+        offsets.append(data_offset)
+        data_offset = align(data_offset + len(pcm))
+    for (filename, title, pcm), off, toff in zip(entries, offsets, title_offsets):
+        out += struct.pack(ENTRY_FMT, off, len(pcm), toff, len(title.encode()), 0,
+                           filename.encode(), thumbnail(pcm))
+    out += strings
+    for (_, _, pcm), off in zip(entries, offsets):
+        out += b"\0" * (off - len(out))
+        out += pcm
+    out += b"\0" * (align(len(out)) - len(out))
+
+    with open(args.output, "wb") as f:
+        f.write(out)
+    print("Wrote %s: %d sounds, %d bytes" % (args.output, len(entries), len(out)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,260 @@
+#!/usr/bin/env python3
+"""Encode a folder of WAV files as 4-bit IMA ADPCM WAVs for the SD card.
+
+Each file keeps its sample rate and channel count (or is downmixed with
+--mono) and takes a quarter of the space of 16-bit PCM, a sixth of 24-bit.
+The board decodes it in blocks (src/ImaAdpcm.h), so a sound reads about a
+quarter of the bytes from the card. index.csv is copied along, so the
+output folder is a complete card.
+
+Blocks hold BLOCK_FRAMES frames (128 bytes mono, 256 stereo), the most
+that fit the firmware's PCM_STREAM_IN_FRAMES decode buffer. Every file is
+decoded again after encoding and its SNR against the 16-bit source is
+printed. On the sample card it lands between 17 and 43 dB: tonal sounds
+score highest, while ones with most of their energy near the top of the
+band track worst (0006.wav, hiss-like, gives 16.8 dB). Files below
+SNR_WARN_DB are flagged; listen to them and keep them as PCM if the
+encoding is audible.
+
+Usage:
+  python3 tools/encode_adpcm.py wavs -o wavs_adpcm [--mono]
+"""
+
+import argparse
+import math
+import os
+import shutil
+import struct
+import sys
+from array import array
+
+BLOCK_FRAMES = 249    # 1 + 8 * 31, see imaBlockAlign() in src/ImaAdpcm.h
+SNR_WARN_DB = 20      # Below this the encoding noise may be heard
+
+STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767,
+]
+INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8]
+
+
+def read_wav(path):
+    """Return (sample_rate, channels, interleaved 16-bit samples)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[0:4] != b"RIFF" or data[8:12] != b"WAVE":
+        raise ValueError("not a RIFF/WAVE file")
+
+    pos = 12
+    fmt = None
+    while pos + 8 <= len(data):
+        cid, size = struct.unpack_from("<4sI", data, pos)
+        pos += 8
+        if cid == b"fmt ":
+            tag, channels, rate, _, align, bits = struct.unpack_from("<HHIIHH", data, pos)
+            if tag == 0xFFFE and size >= 26:
+                tag = struct.unpack_from("<H", data, pos + 24)[0]
+            fmt = (tag, channels, rate, align, bits)
+        elif cid == b"data":
+            if fmt is None:
+                raise ValueError("data chunk before fmt chunk")
+            body = data[pos:pos + size]
+            break
+        pos += size + (size & 1)
+    else:
+        raise ValueError("no data chunk")
+
+    tag, channels, rate, align, bits = fmt
+    if tag != 1 or bits not in (8, 16, 24) or channels not in (1, 2):
+        raise ValueError("unsupported format tag %d, %d bits, %d channels" % (tag, bits, channels))
+
+    # The top 16 bits of each sample, as the firmware plays PCM
+    width = bits // 8
+    body = body[:len(body) // align * align]
+    if bits == 8:
+        samples = array("h", ((b - 128) << 8 for b in body))
+    elif bits == 16:
+        samples = array("h")
+        samples.frombytes(body)
+        if sys.byteorder != "little":
+            samples.byteswap()
+    else:
+        samples = array("h", (int.from_bytes(body[i + 1:i + 3], "little", signed=True)
+                              for i in range(0, len(body), width)))
+    return rate, channels, samples
+
+
+def downmix(samples):
+    return array("h", ((samples[i] + samples[i + 1]) >> 1 for i in range(0, len(samples), 2)))
+
+
+def expand(state, nibble):
+    """Apply a nibble to [predictor, index] as the decoder does."""
+    step = STEP_TABLE[state[1]]
+    diff = step >> 3
+    if nibble & 4:
+        diff += step
+    if nibble & 2:
+        diff += step >> 1
+    if nibble & 1:
+        diff += step >> 2
+    pred = state[0] - diff if nibble & 8 else state[0] + diff
+    state[0] = max(-32768, min(32767, pred))
+    state[1] = max(0, min(88, state[1] + INDEX_TABLE[nibble]))
+    return state[0]
+
+
+def compress(state, sample):
+    step = STEP_TABLE[state[1]]
+    diff = sample - state[0]
+    nibble = 0
+    if diff < 0:
+        nibble = 8
+        diff = -diff
+    if diff >= step:
+        nibble |= 4
+        diff -= step
+    step >>= 1
+    if diff >= step:
+        nibble |= 2
+        diff -= step
+    step >>= 1
+    if diff >= step:
+        nibble |= 1
+    expand(state, nibble)
+    return nibble
+
+
+def encode(samples, channels):
+    """Return the data chunk: blocks of BLOCK_FRAMES frames, the last padded."""
+    frames = len(samples) // channels
+    index = [0] * channels
+    out = bytearray()
+    for start in range(0, frames, BLOCK_FRAMES):
+        n = min(BLOCK_FRAMES, frames - start)
+        groups = (n - 1 + 7) // 8
+        headers = bytearray()
+        body = [bytearray() for _ in range(channels)]
+        for ch in range(channels):
+            state = [samples[start * channels + ch], index[ch]]
+            headers += struct.pack("<hBB", state[0], state[1], 0)
+            for g in range(groups):
+                for k in range(0, 8, 2):
+                    i0 = min(1 + g * 8 + k, n - 1)
+                    i1 = min(i0 + 1, n - 1)
+                    lo = compress(state, samples[(start + i0) * channels + ch])
+                    hi = compress(state, samples[(start + i1) * channels + ch])
+                    body[ch].append(lo | (hi << 4))
+            index[ch] = state[1]
+        out += headers
+        for g in range(groups):
+            for ch in range(channels):
+                out += body[ch][g * 4:g * 4 + 4]
+    return out
+
+
+def decode(data, channels, frames):
+    """Decode the data chunk back to interleaved samples, for the SNR check."""
+    block_align = channels * (4 + (BLOCK_FRAMES - 1) // 2)
+    out = array("h")
+    for start in range(0, len(data), block_align):
+        block = data[start:start + block_align]
+        states = []
+        for ch in range(channels):
+            pred, idx, _ = struct.unpack_from("<hBB", block, ch * 4)
+            states.append([pred, min(idx, 88)])
+        decoded = [[s[0]] for s in states]
+        body = block[channels * 4:]
+        for g in range(0, len(body), 4 * channels):
+            for ch in range(channels):
+                for b in body[g + ch * 4:g + ch * 4 + 4]:
+                    decoded[ch].append(expand(states[ch], b & 15))
+                    decoded[ch].append(expand(states[ch], b >> 4))
+        for i in range(len(decoded[0])):
+            for ch in range(channels):
+                out.append(decoded[ch][i])
+    return out[:frames * channels]
+
+
+def snr_db(ref, test):
+    signal = sum(s * s for s in ref)
+    noise = sum((a - b) * (a - b) for a, b in zip(ref, test))
+    if noise == 0:
+        return float("inf")
+    return 10 * math.log10(max(signal, 1) / noise)
+
+
+def write_wav(path, rate, channels, frames, data):
+    block_align = channels * (4 + (BLOCK_FRAMES - 1) // 2)
+    byte_rate = rate * block_align // BLOCK_FRAMES
+    fmt = struct.pack("<HHIIHHHH", 0x0011, channels, rate, byte_rate, block_align, 4, 2,
+                      BLOCK_FRAMES)
+    body = (b"WAVE" + b"fmt " + struct.pack("<I", len(fmt)) + fmt +
+            b"fact" + struct.pack("<II", 4, frames) +
+            b"data" + struct.pack("<I", len(data)) + data)
+    if len(data) & 1:
+        body += b"\0"
+    with open(path, "wb") as f:
+        f.write(b"RIFF" + struct.pack("<I", len(body)) + body)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("folder", help="folder containing the WAV files (and index.csv)")
+    parser.add_argument("-o", "--output", default="wavs_adpcm")
+    parser.add_argument("--mono", action="store_true", help="downmix stereo files")
+    args = parser.parse_args()
+
+    if os.path.abspath(args.output) == os.path.abspath(args.folder):
+        sys.exit("output folder must differ from the input folder")
+    os.makedirs(args.output, exist_ok=True)
+    names = sorted(n for n in os.listdir(args.folder) if n.lower().endswith(".wav"))
+
+    total_in = total_out = 0
+    worst = None
+    low = []
+    for name in names:
+        src = os.path.join(args.folder, name)
+        try:
+            rate, channels, samples = read_wav(src)
+        except ValueError as e:
+            print("  %-10s skipped: %s" % (name, e))
+            continue
+        if args.mono and channels == 2:
+            samples = downmix(samples)
+            channels = 1
+        frames = len(samples) // channels
+        data = encode(samples, channels)
+        snr = snr_db(samples, decode(data, channels, frames))
+        write_wav(os.path.join(args.output, name), rate, channels, frames, data)
+
+        size_in = os.path.getsize(src)
+        size_out = os.path.getsize(os.path.join(args.output, name))
+        total_in += size_in
+        total_out += size_out
+        worst = snr if worst is None else min(worst, snr)
+        if snr < SNR_WARN_DB:
+            low.append(name)
+        print("  %-10s %6.2f s %s  %8d -> %7d bytes (%.2fx)  SNR %5.1f dB%s" % (
+            name, frames / rate, "stereo" if channels == 2 else "mono  ",
+            size_in, size_out, size_in / size_out, snr,
+            "  (low, check by ear)" if snr < SNR_WARN_DB else ""))
+
+    csv_path = os.path.join(args.folder, "index.csv")
+    if os.path.exists(csv_path):
+        shutil.copy(csv_path, os.path.join(args.output, "index.csv"))
+    if total_out:
+        print("Wrote %s: %d -> %d bytes (%.2fx), worst SNR %.1f dB" % (
+            args.output, total_in, total_out, total_in / total_out, worst))
+    if low:
+        print("Warning: SNR below %d dB for %s; keep the PCM original if it sounds rough" % (
+            SNR_WARN_DB, ", ".join(low)))
+
+
+if __name__ == "__main__":
+    main()
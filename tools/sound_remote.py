@@ -0,0 +1,264 @@
+#!/usr/bin/env python3
+"""Trigger sounds on the board over its USB serial port.
+
+Speaks the binary remote-control protocol of src/RemoteLink.h: frames of
+
+  0xA5 | length | seq | payload | CRC-16/CCITT-FALSE (little endian)
+
+whose payload is a batch of PLAY / STOP / VOLUME / STATUS commands, each
+with an optional delay from the frame's arrival, so a whole cue can go out
+in one frame. QUEUE commands append to the board's gapless sequence
+instead, each sound starting on the sample after the previous one ends
+(plus an optional gap in output samples). The board answers every frame with an ACK, and reports each
+voice start with STARTED; its log text on the same port is skipped.
+
+Opening the port can reset the board (DTR/RTS drive its reset circuit);
+commands are retried until it answers, so the first one may take the boot
+time. Standard library only (termios), so Linux and macOS.
+
+Usage:
+  python3 tools/sound_remote.py /dev/ttyUSB0 play 5
+  python3 tools/sound_remote.py /dev/ttyUSB0 cue 5@0 7@250 9@500
+  python3 tools/sound_remote.py /dev/ttyUSB0 queue 5 7 9+2205
+  python3 tools/sound_remote.py /dev/ttyUSB0 stop all
+  python3 tools/sound_remote.py /dev/ttyUSB0 volume 7
+  python3 tools/sound_remote.py /dev/ttyUSB0 status
+  python3 tools/sound_remote.py /dev/ttyUSB0 bench [--count 100]
+"""
+
+import argparse
+import os
+import select
+import struct
+import sys
+import termios
+import time
+
+SYNC = 0xA5
+MAX_PAYLOAD = 64
+ALL_SOUNDS = 0xFFFF
+
+PLAY, STOP, VOLUME, STATUS, QUEUE = 0x01, 0x02, 0x03, 0x04, 0x05
+ACK, STATUS_REPLY, STARTED = 0x81, 0x84, 0x85
+RESULTS = ["ok", "bad CRC", "bad command", "no such sound", "delay table full"]
+
+BAUDS = {9600: termios.B9600, 19200: termios.B19200, 38400: termios.B38400,
+         57600: termios.B57600, 115200: termios.B115200}
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def encode(seq, payload):
+    body = bytes([len(payload), seq]) + payload
+    return bytes([SYNC]) + body + struct.pack("<H", crc16(body))
+
+
+def play(index, delay_ms=0):
+    return struct.pack("<BHH", PLAY, index, delay_ms)
+
+
+def stop(index, delay_ms=0):
+    return struct.pack("<BHH", STOP, index, delay_ms)
+
+
+class Link:
+    def __init__(self, path, baud):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+        attrs = termios.tcgetattr(self.fd)
+        attrs[0] = 0                                   # iflag: raw
+        attrs[1] = 0                                   # oflag: raw
+        attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+        attrs[3] = 0                                   # lflag: no echo, no canonical mode
+        attrs[4] = attrs[5] = BAUDS[baud]
+        termios.tcsetattr(self.fd, termios.TCSANOW, attrs)
+        self.seq = 0
+        self.buf = bytearray()
+
+    def send(self, payload):
+        if len(payload) > MAX_PAYLOAD:
+            raise ValueError("batch over %d bytes" % MAX_PAYLOAD)
+        self.seq = (self.seq + 1) & 0xFF
+        os.write(self.fd, encode(self.seq, payload))
+        return self.seq
+
+    def receive(self, timeout):
+        """Next valid frame as (seq, payload), or None after timeout seconds."""
+        end = time.monotonic() + timeout
+        while True:
+            frame = self._parse()
+            if frame is not None:
+                return frame
+            left = end - time.monotonic()
+            if left <= 0:
+                return None
+            if select.select([self.fd], [], [], left)[0]:
+                self.buf += os.read(self.fd, 4096)
+
+    def _parse(self):
+        while True:
+            start = self.buf.find(bytes([SYNC]))
+            if start < 0:
+                self.buf.clear()                       # Log text
+                return None
+            del self.buf[:start]
+            if len(self.buf) < 2:
+                return None
+            length = self.buf[1]
+            if length > MAX_PAYLOAD:
+                del self.buf[:1]
+                continue
+            if len(self.buf) < length + 5:
+                return None
+            body = bytes(self.buf[1:3 + length])
+            crc = struct.unpack_from("<H", self.buf, 3 + length)[0]
+            if crc != crc16(body):
+                del self.buf[:1]                       # A 0xA5 in log text
+                continue
+            del self.buf[:length + 5]
+            return body[1], body[2:]
+
+    def request(self, payload, timeout=0.5, tries=10):
+        """Send a frame until it is acknowledged; returns the replies to it."""
+        for _ in range(tries):
+            seq = self.send(payload)
+            replies = []
+            end = time.monotonic() + timeout
+            while time.monotonic() < end:
+                frame = self.receive(end - time.monotonic())
+                if frame is None:
+                    break
+                if frame[0] == seq and frame[1][0] in (ACK, STATUS_REPLY):
+                    replies.append(frame[1])
+                    if frame[1][0] == ACK:
+                        return replies
+        sys.exit("no answer from the board")
+
+
+def check(replies):
+    result = replies[-1][1]
+    if result != 0:
+        print("board: %s" % (RESULTS[result] if result < len(RESULTS) else result))
+    return replies
+
+
+def cmd_status(link):
+    for r in check(link.request(bytes([STATUS]))):
+        if r[0] == STATUS_REPLY:
+            volume, voices, sounds, pending, frames, rejected = struct.unpack_from("<BBHHII", r, 1)
+            print("volume %d, %d voices playing, %d sounds, %d delayed commands waiting" % (
+                volume, voices, sounds, pending))
+            print("%d frames received, %d rejected" % (frames, rejected))
+
+
+def percentile(values, p):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(p * len(values)))] if values else 0
+
+
+def cmd_bench(link, count, sounds):
+    """Command-to-ACK and command-to-voice-start times, then batched throughput."""
+    link.request(bytes([VOLUME, 1]))                   # Quiet; makes the link active
+    acks, starts = [], []
+    for i in range(count):
+        index = i % sounds
+        t0 = time.monotonic()
+        seq = link.send(play(index))
+        acked = started = False
+        while not (acked and started):
+            frame = link.receive(1.0)
+            if frame is None:
+                break
+            seq_in, p = frame
+            if p[0] == ACK and seq_in == seq and not acked:
+                acked = True
+                acks.append((time.monotonic() - t0) * 1e3)
+            elif p[0] == STARTED and struct.unpack_from("<H", p, 1)[0] == index and not started:
+                started = True
+                starts.append((time.monotonic() - t0) * 1e3)
+        time.sleep(0.02)
+    print("%d plays: ACK p50 %.1f ms p99 %.1f ms, voice start p50 %.1f ms p99 %.1f ms" % (
+        count, percentile(acks, 0.5), percentile(acks, 0.99),
+        percentile(starts, 0.5), percentile(starts, 0.99)))
+
+    batch = b"".join(play(i % sounds) for i in range(12))
+    frames = max(count // 4, 10)
+    t0 = time.monotonic()
+    for _ in range(frames):
+        link.request(batch, timeout=1.0, tries=1)
+    seconds = time.monotonic() - t0
+    print("Sustained: %.0f commands/s in 12-command frames" % (frames * 12 / seconds))
+    link.request(stop(ALL_SOUNDS))
+
+
+def queue(index, gap=0):
+    return struct.pack("<BHH", QUEUE, index, gap)
+
+
+def parse_cue(items):
+    payload = b""
+    for item in items:
+        index, _, delay = item.partition("@")
+        payload += play(int(index), int(delay or 0))
+    return payload
+
+
+def parse_queue(items):
+    """QUEUE commands for INDEX[+GAP] items, as frames of at most MAX_PAYLOAD bytes."""
+    commands = []
+    for item in items:
+        index, _, gap = item.partition("+")
+        commands.append(queue(int(index), int(gap or 0)))
+    per_frame = MAX_PAYLOAD // len(commands[0])
+    return [b"".join(commands[i:i + per_frame]) for i in range(0, len(commands), per_frame)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("port", help="serial device, e.g. /dev/ttyUSB0")
+    parser.add_argument("--baud", type=int, default=115200, choices=sorted(BAUDS))
+    sub = parser.add_subparsers(dest="command", required=True)
+    p = sub.add_parser("play", help="play a sound by catalog index")
+    p.add_argument("index", type=int)
+    p.add_argument("--delay", type=int, default=0, help="ms after the frame arrives")
+    p = sub.add_parser("cue", help="several sounds in one frame: INDEX@MS ...")
+    p.add_argument("items", nargs="+")
+    p = sub.add_parser("queue", help="gapless sequence: INDEX[+GAP] ..., gap in output samples")
+    p.add_argument("items", nargs="+")
+    p = sub.add_parser("stop", help="stop a sound, or all")
+    p.add_argument("index")
+    p = sub.add_parser("volume", help="set the volume, 0-10")
+    p.add_argument("level", type=int)
+    sub.add_parser("status", help="volume, voices, sounds and link counters")
+    p = sub.add_parser("bench", help="latency and throughput")
+    p.add_argument("--count", type=int, default=100)
+    p.add_argument("--sounds", type=int, default=4, help="cycle through sounds 0..N-1")
+    args = parser.parse_args()
+
+    link = Link(args.port, args.baud)
+    if args.command == "play":
+        check(link.request(play(args.index, args.delay)))
+    elif args.command == "cue":
+        check(link.request(parse_cue(args.items)))
+    elif args.command == "queue":
+        for payload in parse_queue(args.items):
+            check(link.request(payload))
+    elif args.command == "stop":
+        check(link.request(stop(ALL_SOUNDS if args.index == "all" else int(args.index))))
+    elif args.command == "volume":
+        check(link.request(bytes([VOLUME, args.level])))
+    elif args.command == "status":
+        cmd_status(link)
+    elif args.command == "bench":
+        cmd_bench(link, args.count, args.sounds)
+
+
+if __name__ == "__main__":
+    main()